@@ -34,6 +34,24 @@ suffix. Valid values are (case insensitive) K = 1000, M = 1000000, G =
 contain only decimal digits and the optional suffix. Specified as
 &lt;memory&gt;100M&lt;/memory&gt; in the parameter file and as
 <tt>-memory=100M</tt> on the command line. </dd> 
+<dt>threads</dt>
+<dd> an integer value specifying the number of threads used to
+tokenize, parse and stem documents. With more than one thread, several
+input files are parsed at once while the main thread adds the parsed
+documents to the index. Files with offset annotations or offset metadata
+are always parsed on the main thread. Specified as
+&lt;threads&gt;4&lt;/threads&gt; in the parameter file and as
+<tt>-threads=4</tt> on the command line. Default 1</dd>
+<dt>orderDocuments</dt>
+<dd><tt>true</tt> to add documents parsed by several threads in the
+order of the input files, so that document ids are the same as with one
+thread, or <tt>false</tt> to have each thread add its documents to an
+in-memory index of its own as soon as they are parsed.
+Default <tt>true</tt></dd>
+<dt>shardBlockDocuments</dt>
+<dd>When <tt>orderDocuments</tt> is <tt>false</tt>, the number of document
+ids each thread reserves at a time. Ids a thread reserved but did not use
+when its index is written are left empty. Default 8192</dd>
 <dt>corpus</dt>
 <dd>a complex element containing parameters related to a corpus. This
 element can be specified multiple times. The parameters are 
@@ -165,6 +183,28 @@ optional parameter with the default of no stemming.
 <dd><tt>true</tt> to perform case normalization when indexing, false to 
 index with mixed case. Default <tt>true</tt>
 </dd>
+<dt>invertedListCodec</dt>
+<dd><tt>block</tt> to write inverted lists as bit-packed blocks of 128
+documents, which decode considerably faster at query time, or
+<tt>vbyte</tt> to write the original variable byte format. Repositories
+built with either codec can be opened and merged. Default <tt>block</tt>
+</dd>
+<dt>impactLists</dt>
+<dd><tt>true</tt> to also store, for each term found in at least 128
+documents, a copy of its document list grouped by the number of
+occurrences in each document.  Queries that are a flat #combine or
+#weight of terms are then scored a segment at a time from these lists.
+Default <tt>true</tt>
+</dd>
+<dt>phrases</dt>
+<dd>a complex element naming two-word phrases whose document lists are
+stored in each index, so that #1 queries for them read the stored list
+instead of matching term positions.  The subelement minimumCount stores
+every pair of adjacent terms found at least that many times in an index
+(only terms occurring more than 1000 times are counted); each phrase
+subelement names a phrase to store whatever its count, as in
+<tt>-phrases.phrase="new york"</tt> on the command line.  Default: none
+</dd>
 <dt>stopper</dt>
 <dd>a complex element containing one or more subelements named word,
 specifying the stopword list to use. Specified as
@@ -422,6 +462,24 @@ suffix. Valid values are (case insensitive) K = 1000, M = 1000000, G =
 contain only decimal digits and the optional suffix. Specified as
 &lt;memory&gt;100M&lt;/memory&gt; in the parameter file and as
 <tt>-memory=100M</tt> on the command line. </dd> 
+<dt>threads</dt>
+<dd> an integer value specifying the number of threads used to
+tokenize, parse and stem documents. With more than one thread, several
+input files are parsed at once while the main thread adds the parsed
+documents to the index. Files with offset annotations or offset metadata
+are always parsed on the main thread. Specified as
+&lt;threads&gt;4&lt;/threads&gt; in the parameter file and as
+<tt>-threads=4</tt> on the command line. Default 1</dd>
+<dt>orderDocuments</dt>
+<dd><tt>true</tt> to add documents parsed by several threads in the
+order of the input files, so that document ids are the same as with one
+thread, or <tt>false</tt> to have each thread add its documents to an
+in-memory index of its own as soon as they are parsed.
+Default <tt>true</tt></dd>
+<dt>shardBlockDocuments</dt>
+<dd>When <tt>orderDocuments</tt> is <tt>false</tt>, the number of document
+ids each thread reserves at a time. Ids a thread reserved but did not use
+when its index is written are left empty. Default 8192</dd>
 <dt>corpus</dt>
 <dd>a complex element containing parameters related to a corpus. This
 element can be specified multiple times. The parameters are 
@@ -551,6 +609,28 @@ optional parameter with the default of no stemming.
 <dd><tt>true</tt> to perform case normalization when indexing, false to 
 index with mixed case. Default <tt>true</tt>
 </dd>
+<dt>invertedListCodec</dt>
+<dd><tt>block</tt> to write inverted lists as bit-packed blocks of 128
+documents, which decode considerably faster at query time, or
+<tt>vbyte</tt> to write the original variable byte format. Repositories
+built with either codec can be opened and merged. Default <tt>block</tt>
+</dd>
+<dt>impactLists</dt>
+<dd><tt>true</tt> to also store, for each term found in at least 128
+documents, a copy of its document list grouped by the number of
+occurrences in each document.  Queries that are a flat #combine or
+#weight of terms are then scored a segment at a time from these lists.
+Default <tt>true</tt>
+</dd>
+<dt>phrases</dt>
+<dd>a complex element naming two-word phrases whose document lists are
+stored in each index, so that #1 queries for them read the stored list
+instead of matching term positions.  The subelement minimumCount stores
+every pair of adjacent terms found at least that many times in an index
+(only terms occurring more than 1000 times are counted); each phrase
+subelement names a phrase to store whatever its count, as in
+<tt>-phrases.phrase="new york"</tt> on the command line.  Default: none
+</dd>
 <dt>stopper</dt>
 <dd>a complex element containing one or more subelements named word,
 specifying the stopword list to use. Specified as
@@ -956,6 +1036,10 @@ int main(int argc, char * argv[]) {
     env.setNormalization( parameters.get("normalize", true));
     env.setInjectURL( parameters.get("injectURL", true));
     env.setStoreDocs( parameters.get("storeDocs", true));
+    env.setInvertedListCodec( parameters.get("invertedListCodec", "block") );
+    env.setImpactLists( parameters.get("impactLists", true) );
+    env.setThreads( parameters.get("threads", 1) );
+    env.setOrderDocuments( parameters.get("orderDocuments", true) );
 
     std::string blackList = parameters.get("blacklist", "");
     if( blackList.length() ) {
@@ -980,6 +1064,12 @@ int main(int argc, char * argv[]) {
     std::vector<std::string> stopwords;
     if( copy_parameters_to_string_vector( stopwords, parameters, "stopper.word" ) )
       env.setStopwords(stopwords);
+
+    std::vector<std::string> phrases;
+    copy_parameters_to_string_vector( phrases, parameters, "phrases.phrase" );
+    int phraseMinimumCount = parameters.get( "phrases.minimumCount", 0 );
+    if( phraseMinimumCount || phrases.size() )
+      env.setPhrases( phraseMinimumCount, phrases );
     // fields to include as metadata (unindexed)
     std::vector<std::string> metadata;
     // metadata fields that should have a forward lookup table.
@@ -20,6 +20,8 @@
 #include "indri/LocalQueryServer.hpp"
 #include "indri/ScopedLock.hpp"
 #include "indri/QueryEnvironment.hpp"
+#include "indri/DiskIndex.hpp"
+#include <map>
 #include <iostream>
 
 void print_document_expression_count( const std::string& indexName, const std::string& expression ) {
@@ -435,6 +437,62 @@ void print_repository_stats( indri::collection::Repository& r ) {
   std::cout << std::endl;
 }
 
+//
+// Prints, for each inverted list codec in use, how many disk indexes
+// and lists use it, their total size and the average bytes per posting.
+//
+
+struct codec_stats {
+  codec_stats() : indexes(0), lists(0), bytes(0), postings(0) {}
+  UINT64 indexes;
+  UINT64 lists;
+  UINT64 bytes;
+  UINT64 postings;
+};
+
+void print_list_codecs( indri::collection::Repository& r ) {
+  std::map<std::string, codec_stats> codecs;
+  indri::collection::Repository::index_state state = r.indexes();
+
+  for( size_t i=0; i<state->size(); i++ ) {
+    indri::index::DiskIndex* index = dynamic_cast<indri::index::DiskIndex*>( (*state)[i] );
+
+    // memory indexes have no on-disk lists
+    if( !index )
+      continue;
+
+    codec_stats& stats = codecs[ index->listCodec() ];
+    stats.indexes++;
+
+    indri::index::VocabularyIterator* iter = index->vocabularyIterator();
+    iter->startIteration();
+
+    while( !iter->finished() ) {
+      indri::index::DiskTermData* entry = iter->currentEntry();
+      stats.lists++;
+      stats.bytes += entry->length;
+      stats.postings += entry->termData->corpus.totalCount;
+      iter->nextEntry();
+    }
+
+    delete iter;
+  }
+
+  std::cout << "codec\tindexes\tlists\tbytes\tbytes/posting" << std::endl;
+
+  std::map<std::string, codec_stats>::iterator iter;
+  for( iter = codecs.begin(); iter != codecs.end(); ++iter ) {
+    codec_stats& stats = iter->second;
+    double perPosting = stats.postings ? double(stats.bytes) / double(stats.postings) : 0;
+
+    std::cout << iter->first << "\t"
+              << stats.indexes << "\t"
+              << stats.lists << "\t"
+              << stats.bytes << "\t"
+              << perPosting << std::endl;
+  }
+}
+
 void merge_repositories( const std::string& outputPath, int argc, char** argv ) {
   std::vector<std::string> inputs;
 
@@ -478,6 +536,7 @@ void usage() {
   std::cout << "    invlist (il)         None           Print the contents of all inverted lists" << std::endl;
   std::cout << "    vocabulary (v)       None           Print the vocabulary of the index" << std::endl;
   std::cout << "    stats (s)                           Print statistics for the Repository" << std::endl;
+  std::cout << "    listcodecs (lc)      None           Print inverted list sizes for each list codec in use" << std::endl;
   std::cout << "These commands change the data inside the repository:" << std::endl;
   std::cout << "    compact (c)          None           Compact the repository, releasing space used by deleted documents." << std::endl;
   std::cout << "    delete (del)         Document ID    Delete the specified document from the repository." << std::endl;
@@ -557,6 +616,9 @@ int main( int argc, char** argv ) {
       } else if( command == "s" || command == "stats" ) {
         REQUIRE_ARGS(3);
         print_repository_stats( r );
+      } else if( command == "lc" || command == "listcodecs" ) {
+        REQUIRE_ARGS(3);
+        print_list_codecs( r );
       } else {
         r.close();
         usage();
@@ -0,0 +1,167 @@
+/*==========================================================================
+ * Copyright (c) 2004 University of Massachusetts.  All Rights Reserved.
+ *
+ * Use of the Lemur Toolkit for Language Modeling and Information Retrieval
+ * is subject to the terms of the software license set forth in the LICENSE
+ * file included with this software, and also available at
+ * http://www.lemurproject.org/license.html
+ *
+ *==========================================================================
+ */
+
+
+//
+// BinaryMessage
+//
+// Bodies of the frames of the binary protocol between NetworkServerProxy
+// and NetworkServerStub.  A body is a sequence of fields in network byte
+// order: 4 and 8 byte integers, and strings written as a 4 byte
+// length followed by their bytes.  The fields of each kind of request
+// and reply are listed where NetworkServerStub handles them.
+//
+
+#ifndef INDRI_BINARYMESSAGE_HPP
+#define INDRI_BINARYMESSAGE_HPP
+
+#include "indri/indri-platform.h"
+#include "indri/Buffer.hpp"
+#include "lemur/lemur-compat.hpp"
+#include "lemur/Exception.hpp"
+#include <string>
+#include <string.h>
+
+namespace indri
+{
+  namespace net
+  {
+    class BinaryMessage {
+    public:
+      /// Kinds of request; a reply carries the kind of its request.
+      enum Kind {
+        QUERY = 1,
+        DOCUMENTS,
+        DOCUMENT_METADATA,
+        DOCUMENT_VECTORS,
+        DOCUMENT_IDS_FROM_METADATA,
+        DOCUMENTS_FROM_METADATA,
+        PATH_NAMES,
+        TERM_COUNT,
+        TERM_COUNT_TEXT,
+        TERM_COUNT_UNIQUE,
+        STEM_COUNT_TEXT,
+        TERM_NAME,
+        TERM_ID,
+        TERM_STEM,
+        TERM_FIELD_COUNT,
+        STEM_FIELD_COUNT,
+        FIELD_LIST,
+        DOCUMENT_LENGTH,
+        DOCUMENT_COUNT,
+        DOCUMENT_TERM_COUNT,
+        DOCUMENT_STEM_COUNT,
+        MAX_WILDCARD_TERMS
+      };
+
+      /// The version a server reports when a client asks for the binary protocol.
+      enum {
+        VERSION = 1
+      };
+    };
+
+    class BinaryMessageWriter {
+    private:
+      indri::utility::Buffer& _buffer;
+
+    public:
+      BinaryMessageWriter( indri::utility::Buffer& buffer ) :
+        _buffer(buffer)
+      {
+      }
+
+      void writeInt32( INT32 value ) {
+        UINT32 swapped = htonl( (UINT32) value );
+        memcpy( _buffer.write( sizeof(UINT32) ), &swapped, sizeof(UINT32) );
+      }
+
+      void writeInt64( INT64 value ) {
+        UINT64 swapped = lemur_compat::htonll( (UINT64) value );
+        memcpy( _buffer.write( sizeof(UINT64) ), &swapped, sizeof(UINT64) );
+      }
+
+      void writeBytes( const void* data, size_t length ) {
+        if( length )
+          memcpy( _buffer.write( length ), data, length );
+      }
+
+      /// @return room for length bytes, for the caller to fill in
+      char* reserve( size_t length ) {
+        return _buffer.write( length );
+      }
+
+      void writeString( const char* data, size_t length ) {
+        writeInt32( (INT32) length );
+        writeBytes( data, length );
+      }
+
+      void writeString( const std::string& value ) {
+        writeString( value.c_str(), value.length() );
+      }
+    };
+
+    class BinaryMessageReader {
+    private:
+      const char* _data;
+      size_t _length;
+      size_t _position;
+
+      const char* _read( size_t length ) {
+        if( length > _length - _position )
+          LEMUR_THROW( LEMUR_NETWORK_ERROR, "Malformed binary message: it ends in the middle of a field" );
+
+        const char* result = _data + _position;
+        _position += length;
+        return result;
+      }
+
+    public:
+      BinaryMessageReader( const void* data, size_t length ) :
+        _data( (const char*) data ),
+        _length(length),
+        _position(0)
+      {
+      }
+
+      INT32 readInt32() {
+        UINT32 value;
+        memcpy( &value, _read( sizeof(UINT32) ), sizeof(UINT32) );
+        return (INT32) ntohl( value );
+      }
+
+      INT64 readInt64() {
+        UINT64 value;
+        memcpy( &value, _read( sizeof(UINT64) ), sizeof(UINT64) );
+        return (INT64) lemur_compat::ntohll( value );
+      }
+
+      /// @return a pointer to the next length bytes, which stay valid as long as the message does
+      const char* readBytes( size_t length ) {
+        return _read( length );
+      }
+
+      /// @return the length of the next string, leaving data pointing at its bytes
+      size_t readString( const char*& data ) {
+        size_t length = (UINT32) readInt32();
+        data = _read( length );
+        return length;
+      }
+
+      std::string readString() {
+        const char* data;
+        size_t length = readString( data );
+        return std::string( data, length );
+      }
+    };
+  }
+}
+
+#endif // INDRI_BINARYMESSAGE_HPP
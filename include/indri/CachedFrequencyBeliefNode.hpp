@@ -39,6 +39,9 @@ namespace indri
       double _maximumBackgroundScore;
       double _maximumScore;
       std::string _name;
+      lemur::api::DOCID_T _lastDocument;
+
+      void _moveTo( lemur::api::DOCID_T documentID );
 
     public:
       CachedFrequencyBeliefNode( const std::string& name,
@@ -52,8 +55,8 @@ namespace indri
 
       double maximumBackgroundScore();
       double maximumScore();
-      const indri::utility::greedy_vector<indri::api::ScoredExtentResult>& score( lemur::api::DOCID_T documentID, int begin, int end, int documentLength );
-      void annotate( class Annotator& annotator, lemur::api::DOCID_T documentID, int begin, int end );
+      const indri::utility::greedy_vector<indri::api::ScoredExtentResult>& score( lemur::api::DOCID_T documentID, indri::index::Extent &extent, int documentLength );
+      void annotate( class Annotator& annotator, lemur::api::DOCID_T documentID, indri::index::Extent &extent );
       bool hasMatch( lemur::api::DOCID_T documentID );
       const indri::utility::greedy_vector<bool>& hasMatch( lemur::api::DOCID_T documentID, const indri::utility::greedy_vector<indri::index::Extent>& extents );
       
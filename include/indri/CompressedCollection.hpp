@@ -23,6 +23,7 @@
 #include "lemur/string-set.h"
 #include <string>
 #include <vector>
+#include <list>
 #include "lemur/Keyfile.hpp"
 #include "indri/Buffer.hpp"
 #include "indri/SequentialWriteBuffer.hpp"
@@ -30,6 +31,9 @@
 #include "indri/HashTable.hpp"
 #include "indri/File.hpp"
 #include "indri/Mutex.hpp"
+#include "indri/ReadersWritersLock.hpp"
+#include "indri/ReaderLockable.hpp"
+#include "indri/WriterLockable.hpp"
 #include "lemur/IndexTypes.hpp"
 #include "indri/DeletedDocumentList.hpp"
 
@@ -41,8 +45,58 @@ namespace indri
   {
     
     class CompressedCollection : public Collection {
+    public:
+      /// Counters for the decompressed document cache.
+      struct CacheStatistics {
+        /// documents found in the cache
+        UINT64 hits;
+        /// documents that had to be read and decompressed
+        UINT64 misses;
+        /// documents currently held
+        UINT64 documents;
+        /// bytes currently held
+        UINT64 memory;
+        /// the most bytes the cache may hold (collectionCacheMemory)
+        UINT64 maximumMemory;
+      };
+
     private:
+      // Readers never take _lock: they look up keys in one of the
+      // _shards, then read and inflate the document on their own.
+      // _lock orders writers, and _storageLock keeps readers out while
+      // the files are replaced or closed.
       indri::thread::Mutex _lock;
+      indri::thread::ReadersWritersLock _storageLock;
+      indri::thread::ReaderLockable _storageReadLock;
+      indri::thread::WriterLockable _storageWriteLock;
+
+      // A set of lookup handles, each used by one thread at a time.
+      // The first shard holds the collection's own keyfiles; a collection
+      // opened with openRead has extra read-only handles on the same files.
+      struct lookup_shard {
+        lookup_shard() : forwardLookups(16), reverseLookups(16) {}
+
+        indri::thread::Mutex lock;
+        lemur::file::Keyfile* lookup;
+        indri::utility::HashTable<const char*, lemur::file::Keyfile*> forwardLookups;
+        indri::utility::HashTable<const char*, lemur::file::Keyfile*> reverseLookups;
+        bool owned;
+      };
+
+      std::vector<lookup_shard*> _shards;
+
+      // Recently decompressed documents, most recently used first.
+      struct cached_document {
+        lemur::api::DOCID_T documentID;
+        char* data;
+        size_t length;
+        std::list<cached_document*>::iterator recent;
+      };
+
+      indri::thread::Mutex _cacheLock;
+      indri::utility::HashTable<lemur::api::DOCID_T, cached_document*> _cache;
+      std::list<cached_document*> _cacheRecent;
+      CacheStatistics _cacheStatistics;
 
       std::string _basePath;
       lemur::file::Keyfile _lookup;
@@ -62,6 +116,19 @@ namespace indri
       void _writeContentLength( indri::api::ParsedDocument* document, int& keyLength, int& valueLength );
 
       void _readPositions( indri::api::ParsedDocument* document, const void* positionData, int positionDataLength );
+      indri::api::ParsedDocument* _retrieve( lemur::api::DOCID_T documentID );
+      void _read( UINT64 offset, indri::utility::Buffer& output );
+      indri::api::ParsedDocument* _parse( indri::utility::Buffer& output );
+      bool _lookupOffset( lemur::api::DOCID_T documentID, UINT64& offset );
+
+      bool _cacheFind( lemur::api::DOCID_T documentID, indri::utility::Buffer& output );
+      void _cacheAdd( lemur::api::DOCID_T documentID, indri::utility::Buffer& output );
+      void _cacheRemove( cached_document* document );
+      void _cacheClear();
+      void _flush();
+
+      void _openShards( const std::string& fileName, int count );
+      void _closeShards();
 
       void _removeForwardLookups( indri::index::DeletedDocumentList& deletedList, lemur::file::Keyfile& keyfile );
       void _removeReverseLookups( indri::index::DeletedDocumentList& deletedList, lemur::file::Keyfile& keyfile );
@@ -107,9 +174,21 @@ namespace indri
       bool exists(lemur::api::DOCID_T documentID);
       indri::api::ParsedDocument* retrieve( lemur::api::DOCID_T documentID );
       std::string retrieveMetadatum( lemur::api::DOCID_T documentID, const std::string& attributeName );
+      /// Fetch one metadata field for many documents at once.  The documents
+      /// are read in storage order, so the reads are sequential.
+      /// @param documentIDs the documents to fetch
+      /// @param attributeName the metadata field to fetch
+      /// @return the field value of each document, in the order of documentIDs
+      std::vector<std::string> retrieveMetadata( const std::vector<lemur::api::DOCID_T>& documentIDs, const std::string& attributeName );
       std::vector<indri::api::ParsedDocument*> retrieveByMetadatum( const std::string& attributeName, const std::string& value );
       std::vector<lemur::api::DOCID_T> retrieveIDByMetadatum( const std::string& attributeName, const std::string& value );
 
+      /// Drop a document from the decompressed document cache, so that
+      /// later calls to retrieve read it from disk again.
+      void evict( lemur::api::DOCID_T documentID );
+      /// @return hit and miss counts of the decompressed document cache
+      CacheStatistics cacheStatistics();
+
       void addDocument( lemur::api::DOCID_T documentID, indri::api::ParsedDocument* document );
       void compact( indri::index::DeletedDocumentList& deletedList );
       void append( indri::collection::CompressedCollection& other, indri::index::DeletedDocumentList& deletedList, lemur::api::DOCID_T documentOffset );
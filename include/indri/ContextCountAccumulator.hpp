@@ -26,6 +26,7 @@
 #include "indri/EvaluatorNode.hpp"
 #include "indri/QuerySpec.hpp"
 #include "indri/DocumentCount.hpp"
+#include "indri/ListCache.hpp"
 namespace indri
 {
   namespace infnet
@@ -51,10 +52,22 @@ namespace indri
       
       EvaluatorNode::MResults _results;
 
+      // when caching, the per-document counts are collected in _list
+      // and handed to _cache once the counts are finished
+      indri::lang::ListCache* _cache;
+      indri::lang::ListCache::CachedList* _list;
+      bool _cached;
+
 public:
       ContextCountAccumulator( const std::string& name, ListIteratorNode* matches, ListIteratorNode* context );
+      /// Reports the counts of a previously computed list instead of evaluating one.
+      ContextCountAccumulator( const std::string& name, const indri::lang::ListCache::CachedList& list );
       ~ContextCountAccumulator();
 
+      /// Collects the counts of the expression raw into a list for the cache.
+      /// Only counts without a context are cached.
+      void setCache( indri::lang::ListCache& cache, indri::lang::Node* raw );
+
   double getOccurrences() const;
   double getContextSize() const;
 
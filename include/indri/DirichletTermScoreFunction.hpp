@@ -28,10 +28,15 @@ namespace indri
     
     class DirichletTermScoreFunction : public TermScoreFunction {
     private:
+      // most term counts in a document are small, so their logs are
+      // computed once when the function is made
+      enum { OCCURRENCE_TABLE_SIZE = 16 };
+
       double _mu;
       double _docmu;
       double _collectionFrequency;
       double _muTimesCollectionFrequency;
+      double _occurrenceScores[OCCURRENCE_TABLE_SIZE];
 
     public:
       DirichletTermScoreFunction( double mu, double collectionFrequency, double docmu=-1.0 ) {
@@ -39,6 +44,26 @@ namespace indri
         _mu = mu;
         _muTimesCollectionFrequency = _mu * _collectionFrequency;
         _docmu = docmu;
+
+        for( int i=0; i<OCCURRENCE_TABLE_SIZE; i++ )
+          _occurrenceScores[i] = log( double(i) + _muTimesCollectionFrequency );
+      }
+
+      bool splitsLength( double& lengthOffset ) {
+        //                       c(w;d) + mu * p(w|C)
+        //   score = log( ---------------------- ) = log( c(w;d) + mu * p(w|C) ) - log( |d| + mu )
+        //                           |d| + mu
+        lengthOffset = _mu;
+        return _docmu < 0;
+      }
+
+      double occurrenceScore( double occurrences ) {
+        int count = int(occurrences);
+
+        if( count == occurrences && count >= 0 && count < OCCURRENCE_TABLE_SIZE )
+          return _occurrenceScores[count];
+
+        return log( occurrences + _muTimesCollectionFrequency );
       }
 
       double scoreOccurrence( double occurrences, int contextSize ) {
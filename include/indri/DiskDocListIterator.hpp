@@ -20,11 +20,25 @@
 
 #include "indri/DocListIterator.hpp"
 #include "indri/SequentialReadBuffer.hpp"
+#include "indri/PostingBlockCache.hpp"
 #include "lemur/Keyfile.hpp"
 
 namespace indri { 
   namespace index {
     class DiskDocListIterator : public DocListIterator {
+    public:
+      // one skip table entry per block of a block-coded list
+      struct BlockSkip {
+        lemur::api::DOCID_T lastDocument;
+        UINT64 offset;
+        // entry with the largest count/length ratio, the largest count and the block's length range
+        UINT32 fractionCount;
+        UINT32 fractionLength;
+        UINT32 maximumCount;
+        UINT32 minimumLength;
+        UINT32 maximumLength;
+      };
+
     private:
       const char* _list;
       const char* _listEnd;
@@ -35,6 +49,38 @@ namespace indri {
       UINT64 _endOffset;
       bool _hasTopdocs;
       bool _isFrequent;
+      bool _isBlockCoded;
+      INT64 _postingsDecoded;
+
+      // decoded contents of the current block (block-coded lists only)
+      indri::utility::greedy_vector<UINT32> _blockDocuments;
+      indri::utility::greedy_vector<UINT32> _blockCounts;
+      // documents and counts of the current block, decoded above or held in the cache
+      const UINT32* _documents;
+      const UINT32* _counts;
+      int _blockEntries;
+      PostingBlockCache::Block* _cachedBlock;
+      indri::utility::greedy_vector<UINT32> _blockPositions;
+      const char* _blockPositionData;
+      bool _blockPositionsDecoded;
+      UINT64 _blockOffset;
+      int _blockIndex;
+      int _blockPositionIndex;
+
+      // skip table for long block-coded lists
+      indri::utility::greedy_vector<BlockSkip> _skipTable;
+      UINT64 _listDataOffset;
+      int _blockNumber;
+      bool _hasBlockBounds;
+
+      // decoded blocks shared with other iterators over the same index
+      PostingBlockCache* _blockCache;
+      UINT64 _cacheIndex;
+
+      // positions of the current entry are decoded on demand by currentEntry()
+      int _count;
+      int _entryPositionIndex;
+      bool _positionsPending;
 
       indri::utility::greedy_vector<TopDocument> _topdocs;
       DocumentData _data;
@@ -46,7 +92,15 @@ namespace indri {
       int _fieldCount;
 
       void _readEntry();
+      void _readBlockEntry();
       void _readSkip();
+      void _readBlock();
+      void _releaseBlock();
+      void _readSkipTable( bool hasBounds );
+      void _skipToBlock( lemur::api::DOCID_T documentID );
+      bool _nextBlockEntry( lemur::api::DOCID_T documentID );
+      void _decodePositions();
+      bool _batchFinished() const;
       void _readTopdocs();
       void _readTermData( int headerLength );
 
@@ -55,14 +109,23 @@ namespace indri {
       ~DiskDocListIterator();
       void setStartOffset( UINT64 startOffset, TermData* termData );
 
+      /// Finds decoded blocks in cache before decoding them, and adds the
+      /// ones it decodes.  index identifies the index that owns the list.
+      void setBlockCache( PostingBlockCache* cache, UINT64 index );
+
       const indri::utility::greedy_vector<TopDocument>& topDocuments();
 
       void startIteration();
       bool nextEntry();
       bool nextEntry( lemur::api::DOCID_T documentID );
       DocumentData* currentEntry();
+      lemur::api::DOCID_T currentDocument();
+      int currentCount();
+      bool blockBound( lemur::api::DOCID_T documentID, BlockBound& bound );
+      INT64 postingsDecoded();
       bool finished();
       bool isFrequent() const;
+      bool isBlockCoded() const;
       TermData* termData();
     };
   }
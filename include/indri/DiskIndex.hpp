@@ -27,8 +27,10 @@
 #include "indri/DiskTermData.hpp"
 #include <vector>
 #include <string>
+#include <map>
 #include "indri/BulkTree.hpp"
 #include "indri/SequentialReadBuffer.hpp"
+#include "indri/TermTable.hpp"
 
 namespace indri {
   namespace index {
@@ -46,6 +48,9 @@ namespace indri {
 
       indri::file::File _frequentTermsData;
 
+      // immutable vocabulary, read without _lock; indexes written before it existed don't have one
+      indri::index::TermTableReader _termTable;
+
       indri::file::File _documentLengths;
       indri::file::File _documentStatistics;
 
@@ -53,11 +58,24 @@ namespace indri {
       indri::file::File _directFile;
       indri::file::File _fieldsFile;
 
+      bool _impactLists;
+      indri::file::File _impactFile;
+      indri::file::BulkTreeReader _impactTerms;
+      indri::thread::Mutex _impactLock;
+
+      // byte offsets of the stored phrase lists, by phrase
+      std::map<std::string, UINT64> _phraseOffsets;
+      indri::file::File _phraseFile;
+
       indri::file::SequentialReadBuffer _lengthsBuffer;
 
       std::vector<FieldStatistics> _fieldData;
       lemur::api::DOCID_T  _documentBase;
       int _infrequentTermBase;
+      std::string _listCodec;
+
+      // names this index in the shared cache of decoded posting blocks
+      UINT64 _cacheID;
 
       indri::index::DiskTermData* _fetchTermData( lemur::api::TERMID_T termID );
       indri::index::DiskTermData* _fetchTermData( const char* termString );
@@ -66,14 +84,20 @@ namespace indri {
       void _readManifest( const std::string& manifestPath );
 
     public:
-      DiskIndex() : _lengthsBuffer(_documentLengths) {}
+      DiskIndex() : _impactLists(false), _cacheID(0), _lengthsBuffer(_documentLengths) {}
 
-      void open( const std::string& base, const std::string& relative );
+      /// Opens the index in directory relative of base.  If mapped is true,
+      /// the inverted, direct, fields and phrase files are mapped into memory
+      /// and lists are decoded from the mapping instead of copied into buffers.
+      void open( const std::string& base, const std::string& relative, bool mapped = false );
       void close();
 
       const std::string& path();
       lemur::api::DOCID_T documentBase();
 
+      /// @return the encoding of this index's inverted lists, "block" or "vbyte"
+      const std::string& listCodec();
+
       int field( const char* fieldName );
       int field( const std::string& fieldName );
       std::string field( int fieldID );
@@ -114,6 +138,8 @@ namespace indri {
       VocabularyIterator* infrequentVocabularyIterator();
 
       DocumentDataIterator* documentDataIterator();
+      ImpactList* impactList( const std::string& term );
+      DocExtentListIterator* phraseListIterator( const std::string& phrase );
 
       indri::thread::Lockable* iteratorLock();
       indri::thread::Lockable* statisticsLock();
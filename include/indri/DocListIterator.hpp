@@ -66,6 +66,19 @@ namespace indri {
         int count;
         int length;
       };
+
+      // upper bound data for the documents firstDocument..lastDocument of a list
+      struct BlockBound {
+        lemur::api::DOCID_T firstDocument;
+        lemur::api::DOCID_T lastDocument;
+        // the entry with the largest count/length ratio (count is 0 if no entry falls in the range)
+        int count;
+        int length;
+        // largest count, and the shortest and longest documents holding an entry in the range
+        int maximumCount;
+        int minimumLength;
+        int maximumLength;
+      };
       
       virtual ~DocListIterator() {};
 
@@ -90,6 +103,29 @@ namespace indri {
 
       // returns true if the iterator has no more entries
       virtual bool finished() = 0;
+
+      // return the document ID of the current entry; only valid if the iterator isn't finished.
+      virtual lemur::api::DOCID_T currentDocument() {
+        return currentEntry()->document;
+      }
+
+      // return the number of positions in the current entry; only valid if the iterator isn't finished.
+      // unlike currentEntry(), this does not require the positions themselves to be decoded.
+      virtual int currentCount() {
+        return (int)currentEntry()->positions.size();
+      }
+
+      // fill in bound data for the stretch of the list that holds documentID, without
+      // moving the iterator.  returns false if the list doesn't store block bounds.
+      virtual bool blockBound( lemur::api::DOCID_T documentID, BlockBound& bound ) {
+        return false;
+      }
+
+      // return the number of entries decoded since startIteration(), including
+      // entries that were decoded and then skipped over.
+      virtual INT64 postingsDecoded() {
+        return 0;
+      }
     };
   }
 }
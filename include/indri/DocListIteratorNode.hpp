@@ -36,6 +36,8 @@ namespace indri
       int _listID;
       indri::utility::greedy_vector<indri::index::Extent> _extents;
       std::string _name;
+      // the prepared document, while its positions have not been copied to _extents
+      lemur::api::DOCID_T _pending;
 
     public:
       DocListIteratorNode( const std::string& name, class InferenceNetwork& network, int listID );
@@ -46,6 +48,7 @@ namespace indri
 
       void prepare( lemur::api::DOCID_T documentID );
       const indri::utility::greedy_vector<indri::index::Extent>& extents();
+      bool hasExtents();
       const std::string& getName() const;  void annotate( Annotator& annotator, lemur::api::DOCID_T documentID, indri::index::Extent &extent );
     };
   }
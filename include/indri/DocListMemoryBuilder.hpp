@@ -49,6 +49,7 @@ namespace indri {
       const char* _list;
       const char* _listEnd;
       bool _finished;
+      INT64 _postingsDecoded;
 
       TermData* _termData;
 
@@ -64,6 +65,7 @@ namespace indri {
       bool nextEntry( lemur::api::DOCID_T documentID );
       bool nextEntry();
       TermData* termData();
+      INT64 postingsDecoded();
       DocListIterator::DocumentData* currentEntry();
       indri::utility::greedy_vector<DocListIterator::TopDocument>& topDocuments();
     };
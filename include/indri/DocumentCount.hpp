@@ -35,14 +35,14 @@ namespace indri
     };
 
     struct DocumentContextCount {
-      DocumentContextCount( lemur::api::DOCID_T document, int count, int contextSize ) {
+      DocumentContextCount( lemur::api::DOCID_T document, double count, int contextSize ) {
         this->document = document;
         this->count = count;
         this->contextSize = contextSize;
       }
 
       lemur::api::DOCID_T document;
-      int count;
+      double count;
       int contextSize;
     };
   }
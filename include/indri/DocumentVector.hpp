@@ -24,6 +24,7 @@
 #include <map>
 #include <vector>
 #include "indri/Index.hpp"
+#include "indri/HashTable.hpp"
 namespace indri 
 {
   /*! \brief Indri API classes for interacting with indri collections. */
@@ -50,6 +51,27 @@ namespace indri
         }
       };
 
+      /// The stems of a batch of vectors fetched together.  Vectors built
+      /// with a Dictionary have no stems of their own; their positions
+      /// are indices into the dictionary's stems, which are shared by
+      /// all of them.  As in an ordinary vector, stem 0 is [OOV].
+      class Dictionary {
+      private:
+        std::vector<std::string> _stems;
+        indri::utility::HashTable<std::string, int> _stemIDs;
+        // dictionary ids of the term ids of each index
+        std::map< indri::index::Index*, indri::utility::HashTable<int, int>* > _termIDs;
+
+      public:
+        Dictionary();
+        ~Dictionary();
+
+        /// @return the dictionary id of the term with termID in index
+        int id( indri::index::Index* index, int termID );
+
+        std::vector<std::string>& stems();
+      };
+
     private:
       std::vector<std::string> _stems;
       std::vector<int> _positions;
@@ -61,6 +83,9 @@ namespace indri
       DocumentVector();
       DocumentVector( indri::index::Index* index, const class indri::index::TermList* termList );
       DocumentVector( indri::index::Index* index, const class indri::index::TermList* termList, std::map<int,std::string>& termStringMap );
+      /// Builds a vector whose positions are ids in dictionary, adding
+      /// the terms of this document to it.
+      DocumentVector( indri::index::Index* index, const class indri::index::TermList* termList, Dictionary& dictionary );
 
       std::vector<std::string>& stems();
       const std::vector<std::string>& stems() const;
@@ -21,9 +21,14 @@ namespace indri
 #ifdef WIN32
       indri::thread::Mutex _mutex;
       HANDLE _handle;
+      HANDLE _mapping;
 #else
       int _handle;
 #endif
+      char* _mapped;
+      UINT64 _mappedLength;
+
+      void _unmap();
 
     public:
       File();
@@ -40,6 +45,18 @@ namespace indri
       size_t write( const void* buffer, UINT64 position, size_t length );
 
       UINT64 size();
+
+      /// Maps the whole file into memory, read only.  The mapping lasts
+      /// until the file is closed.
+      /// @return the mapped bytes, or 0 if the file couldn't be mapped, in which case it can still be read
+      const char* map();
+      /// @return the bytes mapped by map, or 0 if the file isn't mapped
+      const char* mapping() const;
+      /// @return the number of bytes mapped
+      UINT64 mappingLength() const;
+      /// Hints that a range of the file will be read soon, so the operating
+      /// system can start reading it in the background.
+      void willNeed( UINT64 position, UINT64 length );
     };
   }
 }
@@ -35,6 +35,8 @@ namespace indri
       bool _disqualifiedTree;
 
       ListCache* _listCache;
+      // lists found in the cache, held until the query is finished
+      std::vector<ListCache::CachedList*> _lists;
 
     public:
       FrequencyListCopier( ListCache* listCache ) : _listCache(listCache), _lastTerm(0), _disqualifiedTree(false) {}
@@ -49,6 +51,9 @@ namespace indri
 
       ~FrequencyListCopier() {
         indri::utility::delete_vector_contents<indri::lang::Node*>( _nodes );
+
+        for( size_t i=0; i<_lists.size(); i++ )
+          _listCache->release( _lists[i] );
       }
 
       void before( indri::lang::ExtentAnd* exAnd ) {
@@ -158,7 +163,9 @@ namespace indri
         } else if( !_disqualifiers.size() ) {
           ListCache::CachedList* list = 0; 
 
-          if( _listCache )
+          // only whole-document counts are cached; nested and shrinkage
+          // scorers need more than counts to score
+          if( _listCache && newNode->getContext() == NULL && newNode->typeName() == "RawScorerNode" )
             list = _listCache->find( newNode->getRawExtent(), newNode->getContext() );
       
           if( list ) {
@@ -166,7 +173,9 @@ namespace indri
             cachedNode = new indri::lang::CachedFrequencyScorerNode( newNode->getRawExtent(), newNode->getContext() );
             cachedNode->setNodeName( newNode->nodeName() );
             cachedNode->setSmoothing( newNode->getSmoothing() );
+            cachedNode->setStatistics( newNode->getOccurrences(), newNode->getContextSize(), newNode->getDocumentOccurrences(), newNode->getDocumentCount() );
             cachedNode->setList( list );
+            _lists.push_back( list );
 
             delete newNode;
             result = defaultAfter( oldNode, cachedNode );
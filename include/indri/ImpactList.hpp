@@ -0,0 +1,85 @@
+/*==========================================================================
+ * Copyright (c) 2004 University of Massachusetts.  All Rights Reserved.
+ *
+ * Use of the Lemur Toolkit for Language Modeling and Information Retrieval
+ * is subject to the terms of the software license set forth in the LICENSE
+ * file included with this software, and also available at
+ * http://www.lemurproject.org/license.html
+ *
+ *==========================================================================
+ */
+
+//
+// ImpactList
+//
+// The documents containing a term, grouped into segments by the number
+// of times the term occurs in them, largest count first.  Every score
+// function ranks a term's documents of equal length by that count, so
+// the segments are in impact order whatever the smoothing parameters
+// of the query are.
+//
+
+#ifndef INDRI_IMPACTLIST_HPP
+#define INDRI_IMPACTLIST_HPP
+
+#include "indri/indri-platform.h"
+#include "indri/greedy_vector"
+#include "indri/Buffer.hpp"
+#include "indri/File.hpp"
+#include "lemur/IndexTypes.hpp"
+
+namespace indri
+{
+  namespace index
+  {
+    class DocListIterator;
+
+    class ImpactList {
+    public:
+      enum {
+        /// Indexes store impact lists for terms found in at least this many
+        /// documents; shorter lists are grouped from the inverted list when needed.
+        MINIMUM_DOCUMENTS = 128
+      };
+
+      struct Entry {
+        UINT32 count;
+        lemur::api::DOCID_T document;
+      };
+
+      struct Segment {
+        /// occurrences of the term in each document of the segment
+        UINT32 count;
+        UINT32 documentCount;
+        /// encoded documents
+        const char* data;
+      };
+
+    private:
+      indri::utility::Buffer _data;
+      indri::utility::greedy_vector<Segment> _segments;
+      indri::utility::greedy_vector<UINT32> _values;
+
+      void _parse();
+
+    public:
+      /// Appends a list holding entries to output.  The entries must be in
+      /// document order; they are sorted into segments in place.
+      static void encode( indri::utility::Buffer& output, indri::utility::greedy_vector<Entry>& entries );
+
+      /// Reads a list written by encode from file.
+      void read( indri::file::File& file, UINT64 offset, UINT64 length );
+
+      /// Builds the list from the remaining entries of iterator.
+      void build( DocListIterator* iterator );
+
+      size_t size() const;
+      const Segment& segment( size_t index ) const;
+
+      /// Decodes the documents of a segment, in increasing order.
+      void documents( size_t index, indri::utility::greedy_vector<lemur::api::DOCID_T>& documents );
+    };
+  }
+}
+
+#endif // INDRI_IMPACTLIST_HPP
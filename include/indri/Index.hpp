@@ -35,6 +35,7 @@
 
 namespace indri {
   namespace index {
+    class ImpactList;
 
     class Index {
     public:
@@ -100,6 +101,10 @@ namespace indri {
       virtual const TermList* termList( lemur::api::DOCID_T documentID ) = 0;
       virtual TermListFileIterator* termListFileIterator() = 0;
       virtual DocumentDataIterator* documentDataIterator() = 0;
+      // impact-ordered copy of a term's document list, if the index stores one
+      virtual ImpactList* impactList( const std::string& term ) { return 0; }
+      // stored list of the extents of a two term phrase ("first second"), if the index has one
+      virtual DocExtentListIterator* phraseListIterator( const std::string& phrase ) { return 0; }
 
       // Vocabulary
       virtual VocabularyIterator* frequentVocabularyIterator() = 0;
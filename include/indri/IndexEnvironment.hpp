@@ -91,11 +91,35 @@ namespace indri
       int _documentsIndexed;
       int _documentsSeen;
 
+      // files parsed by worker threads, see setThreads
+      struct ingest_file;
+      struct ingest_worker;
+      struct ingest_pipeline;
+      ingest_pipeline* _pipeline;
+      int _threads;
+      bool _orderDocuments;
+
       void _getParsingContext( indri::parse::Parser** parser,
                                indri::parse::Tokenizer** tokenizer,
                                indri::parse::DocumentIterator** iterator,
                                indri::parse::Conflater** conflater,
                                const std::string& extension );
+      void _getParsingContext( std::map<std::string, indri::parse::FileClassEnvironment*>& environments,
+                               indri::parse::Parser** parser,
+                               indri::parse::Tokenizer** tokenizer,
+                               indri::parse::DocumentIterator** iterator,
+                               indri::parse::Conflater** conflater,
+                               const std::string& extension );
+
+      void _addFile( const std::string& fileName, const std::string& fileClass );
+
+      void _startPipeline();
+      static void _ingestStart( void* pointer );
+      void _ingest( ingest_worker* worker );
+      void _ingestFile( ingest_worker* worker, ingest_file* file );
+      void _writeDocuments( size_t pendingFiles );
+      void _finishFiles();
+      void _stopPipeline();
 
       std::vector<indri::parse::Transformation*> _createAnnotators( const std::string& fileName, 
                                                                     const std::string& fileClass, 
@@ -169,6 +193,7 @@ namespace indri
       /// Add a file class.
       /// @param spec The file class to add.
       void addFileClass( const indri::parse::FileClassEnvironmentFactory::Specification &spec ){
+        _finishFiles();
         _fileClassFactory.addFileClass(spec);
       }
   
@@ -211,6 +236,12 @@ namespace indri
       /// @param stopwords the list of stopwords
       void setStopwords( const std::vector<std::string>& stopwords );
 
+      /// set the two-term phrases whose document lists are stored, so that
+      /// #1 queries for them read the list instead of matching positions
+      /// @param minimumCount store every pair of adjacent frequent terms found at least this often in an index; 0 for none
+      /// @param phrases also store these phrases, each two words separated by a space
+      void setPhrases( int minimumCount, const std::vector<std::string>& phrases );
+
       /// set the stemmer to use
       /// @param stemmer the stemmer to use. One of krovetz, porter
       void setStemmer( const std::string& stemmer );
@@ -231,10 +262,34 @@ namespace indri
       /// @param flag true, if ParsedDocuments should be stored, false otherwise.
       void setStoreDocs( bool flag );
 
+      /// set the encoding used for inverted lists written to disk; default is "block"
+      /// @param codec "block" for bit-packed blocks of documents, "vbyte" for the original format
+      void setInvertedListCodec( const std::string& codec );
+
+      /// set writing of impact-ordered document lists alongside the inverted lists; default is true
+      /// @param flag true, if impact-ordered lists should be written, false otherwise.
+      void setImpactLists( bool flag );
+
       /// provides the indexer with the hint strategy to use for speed optimizations for indexing offset annotations
       /// @param hintType the int type (of OffsetAnnotationIndexHint enum type)
       void setOffsetAnnotationIndexHint(indri::parse::OffsetAnnotationIndexHint hintType);
 
+      /// Parse files on several threads.  With more than one thread, addFile
+      /// queues the file and returns; worker threads tokenize, parse,
+      /// annotate and stem whole files at once, while the calling thread
+      /// adds the finished documents to the repository.  Offset annotations
+      /// and offset metadata are only applied by the calling thread, so files
+      /// that use them are parsed without the workers.
+      /// @param threads the number of worker threads (default 1, no workers)
+      void setThreads( int threads );
+
+      /// With worker threads, choose whether documents keep the order of
+      /// the files passed to addFile.  In order, document IDs are the same as
+      /// they would be with one thread.  Otherwise each worker adds its
+      /// documents to a MemoryIndex of its own as soon as they are parsed.
+      /// @param flag true to keep documents in order (the default)
+      void setOrderDocuments( bool flag );
+
       /// create a new index and repository
       /// @param repositoryPath the path to the repository
       /// @param callback IndexStatus object to be notified of indexing progress.
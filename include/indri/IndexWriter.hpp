@@ -21,6 +21,7 @@
 #include <vector>
 #include <utility>
 #include <queue>
+#include <string>
 
 #include "lemur/lemur-compat.hpp"
 #include "indri/indri-platform.h"
@@ -38,6 +39,10 @@
 #include "indri/TermTranslator.hpp"
 #include "indri/DeletedDocumentList.hpp"
 #include "indri/BulkTree.hpp"
+#include "indri/DiskDocListIterator.hpp"
+#include "indri/ImpactList.hpp"
+#include "indri/HashTable.hpp"
+#include "indri/TermList.hpp"
 
 namespace indri {
   namespace index {
@@ -167,6 +172,39 @@ namespace indri {
       indri::file::File _fieldsFile;
 
       indri::file::SequentialWriteBuffer* _invertedOutput;
+      std::string _listCodec;
+
+      // pending entries for the current block, when writing block-coded lists
+      indri::utility::greedy_vector<UINT32> _blockDocuments;
+      indri::utility::greedy_vector<UINT32> _blockCounts;
+      indri::utility::greedy_vector<UINT32> _blockPositions;
+      indri::utility::greedy_vector<UINT32> _blockLengths;
+      indri::utility::greedy_vector<indri::index::DiskDocListIterator::BlockSkip> _blockSkips;
+
+      // impact-ordered copies of the inverted lists (see ImpactList)
+      bool _impactLists;
+      indri::file::File _impactFile;
+      indri::file::SequentialWriteBuffer* _impactOutput;
+      indri::file::BulkTreeWriter* _impactTerms;
+      indri::utility::greedy_vector<indri::index::ImpactList::Entry> _impactEntries;
+      indri::utility::Buffer _impactBuffer;
+
+      // document lists for adjacent term pairs (#1 phrases)
+      struct PhraseStatistics {
+        std::string name;
+        UINT64 byteOffset;
+        int documentCount;
+        UINT64 totalCount;
+      };
+
+      int _phraseMinimumCount;
+      std::vector<std::string> _phrases;
+      // frequent terms that may start or end a counted phrase, by termID-1
+      std::vector<std::string> _phraseTerms;
+      // occurrences of each pair of those terms, keyed by (first-1) * terms + (second-1)
+      indri::utility::HashTable<UINT64, UINT64>* _phraseCounts;
+      std::vector<PhraseStatistics> _phraseData;
+      indri::file::File _phraseFile;
 
       indri::utility::greedy_vector<indri::index::DiskTermData*> _topTerms;
       int _topTermsCount;
@@ -196,6 +234,9 @@ namespace indri {
       void _storeTermEntry( IndexWriter::keyfile_pair& pair, indri::index::DiskTermData* diskTermData );
       void _storeFrequentTerms();
       void _addInvertedListData( indri::utility::greedy_vector<WriterIndexContext*>& lists, indri::index::TermData* termData, indri::utility::Buffer& listBuffer, UINT64& endOffset );
+      void _encodeBlock( indri::utility::Buffer& listBuffer );
+      void _writeBlock( lemur::api::DOCID_T nextDocument, UINT64 dataStart, indri::utility::Buffer& listBuffer );
+      void _writeImpactList( indri::index::TermData* termData );
       void _storeMatchInformation( indri::utility::greedy_vector<WriterIndexContext*>& lists, int sequence, indri::index::TermData* termData, UINT64 startOffset, UINT64 endOffset );
 
       lemur::api::TERMID_T _lookupTermID( indri::file::BulkTreeReader& keyfile, const char* term );
@@ -204,6 +245,8 @@ namespace indri {
       void _buildIndexContexts( std::vector<WriterIndexContext*>& contexts, std::vector<indri::index::Index*>& indexes, std::vector<indri::index::DeletedDocumentList*>& deletedLists, const std::vector<lemur::api::DOCID_T>& documentOffsets );
       
       void _writeDirectLists( std::vector<WriterIndexContext*>& contexts );
+      void _countPhrases( const TermList& list );
+      void _writePhraseLists( std::vector<WriterIndexContext*>& contexts, const std::string& path );
       void _writeDirectLists( WriterIndexContext* context,
                               indri::file::SequentialWriteBuffer* directOutput,
                               indri::file::SequentialWriteBuffer* lengthsOutput,
@@ -212,6 +255,7 @@ namespace indri {
       void _constructFiles( const std::string& path );
       void _closeFiles( const std::string& path );
       void _openTermsReaders( const std::string& path );
+      void _writeTermTable( const std::string& path );
 
       indri::index::TermTranslator* _buildTermTranslator( indri::file::BulkTreeReader& newInfrequentTerms,
                                                           indri::file::BulkTreeReader& newFrequentTerms,
@@ -233,6 +277,22 @@ namespace indri {
 
     public:
       IndexWriter();
+
+      /// Choose the encoding for inverted lists written by this writer:
+      /// "block" (bit-packed blocks of documents, the default) or "vbyte"
+      /// (the original one-entry-at-a-time variable byte format).
+      void setListCodec( const std::string& codec );
+
+      /// Also write an impact-ordered copy of the document list of each term
+      /// found in at least ImpactList::MINIMUM_DOCUMENTS documents (the default).
+      void setImpactLists( bool flag );
+
+      /// Also write the document lists of two-term phrases, as matched by #1:
+      /// every pair of adjacent terms seen at least minimumCount times (0 counts
+      /// none; only pairs of terms that each occur more than 1000 times are
+      /// counted), and each of phrases, given as two index terms separated by a space.
+      void setPhrases( int minimumCount, const std::vector<std::string>& phrases );
+
       void write( indri::index::Index& index,
                   std::vector<indri::index::Index::FieldDescription>& fields,
                   indri::index::DeletedDocumentList& deletedList,
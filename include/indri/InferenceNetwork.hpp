@@ -27,6 +27,8 @@
 #include "indri/DeletedDocumentList.hpp"
 #include "indri/PriorListIterator.hpp"
 #include "indri/DocumentStructureHolderNode.hpp"
+#include "indri/ImpactList.hpp"
+#include "indri/QueryBudget.hpp"
 
 namespace indri
 {
@@ -36,6 +38,13 @@ namespace indri
     public:
       typedef std::map< std::string, EvaluatorNode::MResults > MAllResults;
 
+      /// A range of documents in one index, evaluated as a unit.
+      struct Partition {
+        indri::index::Index* index;
+        lemur::api::DOCID_T firstDocument;
+        lemur::api::DOCID_T lastDocument;
+      };
+
       //
       // MAllResults stores results indexed first by node name, then second by the node's 
       // result name.  For instance, to retrieve occurrence counts from a 
@@ -46,8 +55,10 @@ namespace indri
       std::vector<std::string> _termNames;
       std::vector<std::string> _fieldNames;
       std::vector<std::string> _priorNames;
+      std::vector<std::string> _phraseNames;
 
       std::vector<class indri::index::DocExtentListIterator*> _fieldIterators;
+      std::vector<class indri::index::DocExtentListIterator*> _phraseIterators;
       std::vector<class indri::index::DocListIterator*> _docIterators;
       std::vector<class indri::collection::PriorListIterator*> _priorIterators;
       std::vector<ListIteratorNode*> _listIteratorNodes;
@@ -64,6 +75,29 @@ namespace indri
       indri::collection::Repository& _repository;
       MAllResults _results;
 
+      // set when the query is a flat #combine or #weight of terms, which
+      // is evaluated from impact-ordered lists (see _evaluateImpacts)
+      class ScoredExtentAccumulator* _impactAccumulator;
+      std::vector<class TermFrequencyBeliefNode*> _impactTerms;
+      std::vector<double> _impactWeights;
+      INT64 _impactBudget;
+      // bytes of partial scores impact evaluation may allocate for one partition
+      INT64 _impactMemory;
+      bool _impactChecked;
+      // set when the current index is evaluated from impact lists
+      bool _impactIndex;
+      // impact lists for the current index, by list ID
+      std::vector<indri::index::ImpactList*> _impactLists;
+      indri::utility::greedy_vector<lemur::api::DOCID_T> _impactDocuments;
+
+      indri::api::QueryBudget _budget;
+      bool _budgeted;
+      UINT64 _deadline;
+      // the budget is next checked after this many documents are scored
+      INT64 _nextBudgetCheck;
+      indri::api::QueryWork _work;
+      UINT64 _workTime;
+
       void _indexChanged( indri::index::Index& index );
       void _indexFinished( indri::index::Index& index );
 
@@ -72,7 +106,12 @@ namespace indri
 
       lemur::api::DOCID_T _nextCandidateDocument( indri::index::DeletedDocumentList::read_transaction* deleted );
       void _evaluateDocument( indri::index::Index& index, lemur::api::DOCID_T document );
-      void _evaluateIndex( indri::index::Index& index );
+      void _evaluatePartition( const Partition& partition );
+
+      void _findImpactQuery();
+      bool _evaluateImpacts( const Partition& partition );
+
+      bool _overBudget( INT64 pendingDocuments = 0 );
 
     public:
       InferenceNetwork( indri::collection::Repository& repository );
@@ -82,10 +121,12 @@ namespace indri
 
       indri::index::DocListIterator* getDocIterator( int index );
       indri::index::DocExtentListIterator* getFieldIterator( int index );
+      indri::index::DocExtentListIterator* getPhraseIterator( int index );
       indri::collection::PriorListIterator* getPriorIterator( int index );
 
       int addDocIterator( const std::string& term );
       int addFieldIterator( const std::string& field );
+      int addPhraseIterator( const std::string& phrase );
       int addPriorIterator( const std::string& prior );
       
       void addListNode( ListIteratorNode* listNode );
@@ -95,6 +136,27 @@ namespace indri
       void addScoreFunction( indri::query::TermScoreFunction* scoreFunction );
       void addDocumentStructureHolderNode( DocumentStructureHolderNode* docStruct );
       const MAllResults& evaluate();
+
+      /// Evaluates the network against just the given document ranges.  Unlike
+      /// evaluate(), this doesn't count the query against the repository, so
+      /// several networks built from one query can split a repository between them.
+      const MAllResults& evaluate( const std::vector<Partition>& partitions );
+
+      /// Limits the work that evaluate() does from now on.  Once the budget
+      /// is spent, no more documents are scored, and the evaluators hold the
+      /// best results found so far.
+      void setBudget( const indri::api::QueryBudget& budget );
+
+      /// @return the work done by evaluate() so far; partial is set if the
+      /// budget ran out before every candidate document was scored
+      indri::api::QueryWork getWork() const;
+
+      /// Adds work to results, under a name that no query node uses, so that
+      /// servers can send it back along with the results of a query.
+      static void storeWork( MAllResults& results, const indri::api::QueryWork& work );
+
+      /// @return the sum of the work stored in results by every server
+      static indri::api::QueryWork loadWork( MAllResults& results );
     };
   }
 }
@@ -50,6 +50,7 @@ namespace indri
         return translation;
       }
 
+      std::string _phraseName( indri::lang::ODNode* odNode );
       indri::query::TermScoreFunction* _buildTermScoreFunction( const std::string& smoothing, double occurrences, double contextSize, int documentOccurrences, int documentCount ) const;
 
       void _after( indri::lang::NestedExtentInside* extentInside );
@@ -16,19 +16,36 @@
 //
 // Stores previously used precomputed lists.
 //
+// Every ListCache opened on the same repository path shares one
+// store of lists, so queries from different QueryEnvironments in a
+// process can reuse each other's work.  Lists are found by hashing the
+// query text of their raw and context expressions, and the least
+// recently used lists are evicted once the postings they hold exceed
+// the listCacheMemory parameter (in bytes).  A list is only returned
+// while the repository has the same documents it had when the list
+// was computed.
+//
 
 #ifndef INDRI_LISTCACHE_HPP
 #define INDRI_LISTCACHE_HPP
 
 #include <vector>
+#include <list>
+#include <string>
+#include "indri/QuerySpec.hpp"
 #include "indri/delete_range.hpp"
 #include "indri/SimpleCopier.hpp"
 #include "indri/DocumentCount.hpp"
-#include "indri/QuerySpec.hpp"
-#include "indri/TreePrinterWalker.hpp"
-#include "indri/Parameters.hpp"
+#include "indri/greedy_vector"
+#include "indri/atomic.hpp"
+
 namespace indri
 {
+  namespace collection
+  {
+    class Repository;
+  }
+
   namespace lang
   {
     
@@ -43,55 +60,74 @@ namespace indri
         indri::utility::greedy_vector<indri::index::DocumentContextCount> entries;
 
         // statistics about the entries
-        INT64 occurrences;
-        INT64 contextSize;
-        INT64 minimumContextSize;
-        INT64 maximumContextSize;
-        INT64 maximumOccurrences;
-        float maximumContextFraction;
+        double occurrences;
+        double contextSize;
+        int documentOccurrences;
+        int documentCount;
+
+        // repository contents the list was computed from
+        indri::atomic::value_type documentAdds;
+        size_t indexCount;
+        UINT64 deletedCount;
+
+        // cache bookkeeping, guarded by the store lock
+        std::string key;
+        std::list<CachedList*>::iterator recent;
+        int references;
+        bool evicted;
+
+        CachedList();
+        /// @return the number of bytes this list accounts for in the cache
+        size_t memorySize() const;
       };
 
+      struct Statistics {
+        UINT64 hits;
+        UINT64 misses;
+        UINT64 additions;
+        UINT64 evictions;
+        UINT64 lists;
+        UINT64 memory;
+        UINT64 maximumMemory;
+      };
+
+      // the lists shared by every ListCache on one repository path
+      struct Store;
+
     private:
-      std::vector<struct CachedList*> _lists;
+      indri::collection::Repository& _repository;
+      Store* _store;
+
+      static std::string _key( indri::lang::Node* raw, indri::lang::Node* context );
+      bool _current( CachedList* list );
 
     public:
-      ~ListCache() {
-        indri::utility::delete_vector_contents( _lists );
-      }
-
-      void add( CachedList* list ) {
-        if( _lists.size() > 100 ) {
-          delete _lists[0];
-          _lists.erase( _lists.begin() );
-        }
-
-        _lists.push_back( list );
-      }
-
-      CachedList* find( indri::lang::Node* raw, indri::lang::Node* context ) {
-        ListCache::CachedList* list = 0;
-        size_t i = 0;
-
-        // TODO: use a hash function to make this faster
-        for( i=0; i<_lists.size(); i++ ) {
-          indri::lang::Node* cachedRaw = _lists[i]->raw.root();
-          indri::lang::Node* cachedContext = _lists[i]->context.root();
-
-          if( *cachedRaw == *raw ) {
-            if( ( !cachedContext && !context ) ||
-                ( cachedContext && context && (*context == *cachedContext)) ) {
-              list = _lists[i];
-              break;
-            } 
-          }
-        }
-
-        return list;
-      }
+      ListCache( indri::collection::Repository& repository );
+      ~ListCache();
+
+      /// Allocates a list and stamps it with the current contents of
+      /// the repository.  Call this before evaluating the list's postings.
+      CachedList* newList();
+
+      /// Adds a list made by newList to the cache, which takes ownership of it.
+      /// The list is discarded if it is too large to cache or if an equivalent list is already cached.
+      void add( CachedList* list );
+
+      /// Finds a cached list for this expression.  The list stays valid until
+      /// it is passed to release, even if it is evicted in the meantime.
+      /// @return the list, or 0 if none is cached
+      CachedList* find( indri::lang::Node* raw, indri::lang::Node* context );
+
+      /// Releases a list returned by find.
+      void release( CachedList* list );
+
+      /// @return the largest number of bytes the cache will hold
+      UINT64 maximumMemory() const;
+
+      /// @return hit, miss and memory counters for the shared store
+      Statistics statistics();
     };
   }
 }
 
 #endif // INDRI_LISTCACHE_HPP
-
-
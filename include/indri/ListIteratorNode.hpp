@@ -88,6 +88,12 @@ namespace indri
       /// returns a list of intervals describing positions of children
       virtual const indri::utility::greedy_vector<indri::index::Extent>& extents() = 0;
 
+      /// returns true if extents() would be non-empty for the prepared document;
+      /// nodes that can answer without building their extents should override this
+      virtual bool hasExtents() {
+        return extents().size() > 0;
+      }
+
       /// annotate any results from this node from position begin to position end
       virtual void annotate( class Annotator& annotator, lemur::api::DOCID_T documentID, indri::index::Extent &extent ) = 0;
 
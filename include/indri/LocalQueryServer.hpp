@@ -28,6 +28,8 @@
 #include "indri/Repository.hpp"
 #include "indri/DocumentVector.hpp"
 #include "indri/ListCache.hpp"
+#include "indri/StatisticsCache.hpp"
+#include "indri/ThreadPool.hpp"
 namespace indri
 {
   /*! \brief Indri query server classes. */
@@ -42,16 +44,30 @@ namespace indri
       bool _optimizeParameter;
       indri::collection::Repository& _repository;
       indri::lang::ListCache _cache;
+      indri::lang::StatisticsCache _statistics;
 
       int _maxWildcardMatchesPerTerm;
 
+      // value of the Parameter queryThreads; when greater than one, ranked
+      // queries are split into document ranges that are scored on _queryPool
+      int _queryThreads;
+      indri::thread::ThreadPool* _queryPool;
+
+      // the queryBudget parameters; each ranked query gets at most this budget
+      indri::api::QueryBudget _budget;
+
       indri::index::Index* _indexWithDocument( indri::collection::Repository::index_state& state, lemur::api::DOCID_T documentID );
+      QueryServerResponse* _runQuery( std::vector<indri::lang::Node*>& roots, int resultsRequested, bool optimize,
+                                      const indri::api::QueryBudget& budget = indri::api::QueryBudget() );
+      QueryServerResponse* _runStatisticsQuery( std::vector<indri::lang::Node*>& roots, int resultsRequested, bool optimize );
 
     public:
       LocalQueryServer( indri::collection::Repository& repository );
+      ~LocalQueryServer();
 
       // query
-      QueryServerResponse* runQuery( std::vector<indri::lang::Node*>& roots, int resultsRequested, bool optimize );
+      QueryServerResponse* runQuery( std::vector<indri::lang::Node*>& roots, int resultsRequested, bool optimize,
+                                     const indri::api::QueryBudget& budget = indri::api::QueryBudget() );
 
       // single document queries
       indri::api::ParsedDocument* document( lemur::api::DOCID_T documentID );
@@ -87,7 +103,7 @@ namespace indri
       INT64 documentStemCount( const std::string& term );
 
       // vector
-      QueryServerVectorsResponse* documentVectors( const std::vector<lemur::api::DOCID_T>& documentIDs );
+      QueryServerVectorsResponse* documentVectors( const std::vector<lemur::api::DOCID_T>& documentIDs, bool sharedStems = false );
 
       ///
       /// \brief sets the maximum number of terms to be generated for a wildcard
@@ -95,6 +111,13 @@ namespace indri
       /// @param maxTerms the maximum number of terms
       void setMaxWildcardTerms(int maxTerms);
 
+      /// @return hit, miss and memory counters of the list cache shared by
+      /// every LocalQueryServer on this repository
+      indri::lang::ListCache::Statistics listCacheStatistics();
+
+      /// @return hit, miss and memory counters of the statistics cache shared by
+      /// every LocalQueryServer on this repository
+      indri::lang::StatisticsCache::Statistics statisticsCacheStatistics();
     };
   }
 }
@@ -178,6 +178,10 @@ namespace indri {
       indri::thread::Lockable* statisticsLock();
 
       lemur::api::DOCID_T addDocument( indri::api::ParsedDocument& document );
+      /// Fill every unused document ID below documentMaximum with an empty
+      /// document, so that the index covers a fixed range of IDs.  The empty
+      /// documents are not counted by documentCount().
+      void seal( lemur::api::DOCID_T documentMaximum );
       size_t memorySize();
     };
   }
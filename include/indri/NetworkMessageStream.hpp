@@ -15,6 +15,13 @@
 //
 // 23 March 2004 -- tds
 //
+// Messages are either a header line followed by a body (XREQ, XRPY,
+// BRPY, RFIN, ERR), or a binary frame: a 16 byte header holding a type
+// (PREQ, PRPY or PERR), then a request id, a request kind and the body
+// length as 4 byte integers in network byte order, followed by the body.
+// A binary reply carries the id of its request, so any number of binary
+// requests may be in flight on one stream and answered in any order.
+//
 
 #ifndef INDRI_NETWORKMESSAGESTREAM_HPP
 #define INDRI_NETWORKMESSAGESTREAM_HPP
@@ -36,6 +43,21 @@ namespace indri
       virtual void reply( const std::string& name, const void* buffer, unsigned int length ) = 0;
       virtual void replyDone() = 0;
       virtual void error( const std::string& e ) = 0;
+
+      /// A binary request frame; handlers that don't expect one report an error.
+      virtual void binaryRequest( UINT32 id, UINT32 kind, const void* buffer, unsigned int length ) {
+        error( "Unexpected binary request" );
+      }
+
+      /// A binary reply frame; handlers that don't expect one report an error.
+      virtual void binaryReply( UINT32 id, UINT32 kind, const void* buffer, unsigned int length ) {
+        error( "Unexpected binary reply" );
+      }
+
+      /// A binary request failed; handlers that don't expect one report the error.
+      virtual void binaryError( UINT32 id, const std::string& e ) {
+        error( e );
+      }
     };
 
     class XMLReplyReceiver : public MessageStreamHandler {
@@ -83,8 +105,14 @@ namespace indri
     };
 
     class NetworkMessageStream {
+    public:
+      enum {
+        FRAME_HEADER_SIZE = 16
+      };
+
     private:
       indri::thread::Mutex _lock;
+      indri::thread::Mutex _writeLock;
       indri::utility::Buffer _buffer;
       NetworkStream* _stream;
       int _readPosition;
@@ -93,6 +121,9 @@ namespace indri
       int _findEOL();
       void _cleanBuffer();
       int _bufferLength();
+      bool _fill( int length );
+      void _readFrame( MessageStreamHandler& handler );
+      void _writeFrame( const char* type, UINT32 id, UINT32 kind, const void* buffer, unsigned int length );
 
     public:
       NetworkMessageStream( NetworkStream* stream );
@@ -102,7 +133,13 @@ namespace indri
       void reply( const std::string& name, const void* buffer, unsigned int size );
       void replyDone();
       void error( const std::string& errorMessage );
+      /// Binary frames may be written by several threads at once.
+      void binaryRequest( UINT32 id, UINT32 kind, const void* buffer, unsigned int length );
+      void binaryReply( UINT32 id, UINT32 kind, const void* buffer, unsigned int length );
+      void binaryError( UINT32 id, UINT32 kind, const std::string& errorMessage );
       bool alive();
+      /// Called by both sides once they use binary frames; see NetworkStream::setNoDelay.
+      void setNoDelay();
       indri::thread::Lockable& mutex();
     };
   }
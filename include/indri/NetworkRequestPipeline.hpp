@@ -0,0 +1,80 @@
+/*==========================================================================
+ * Copyright (c) 2004 University of Massachusetts.  All Rights Reserved.
+ *
+ * Use of the Lemur Toolkit for Language Modeling and Information Retrieval
+ * is subject to the terms of the software license set forth in the LICENSE
+ * file included with this software, and also available at
+ * http://www.lemurproject.org/license.html
+ *
+ *==========================================================================
+ */
+
+
+//
+// NetworkRequestPipeline
+//
+// The client side of the binary protocol on one NetworkMessageStream.
+// Requests are sent as soon as they are made, each with a new id, and
+// any number of them may wait for replies at once.  Whichever waiting
+// thread holds the stream's mutex reads replies, setting aside those
+// meant for other requests until their owners ask for them.
+//
+
+#ifndef INDRI_NETWORKREQUESTPIPELINE_HPP
+#define INDRI_NETWORKREQUESTPIPELINE_HPP
+
+#include "indri/NetworkMessageStream.hpp"
+#include "indri/Mutex.hpp"
+#include <map>
+#include <set>
+#include <string>
+
+namespace indri
+{
+  namespace net
+  {
+    class NetworkRequestPipeline : public MessageStreamHandler {
+    private:
+      struct reply_type {
+        bool failed;
+        std::string body;
+      };
+
+      NetworkMessageStream* _stream;
+      // guards everything below
+      indri::thread::Mutex _lock;
+      UINT32 _nextID;
+      std::map<UINT32, reply_type*> _replies;
+      std::set<UINT32> _abandoned;
+      std::string _failure;
+
+      bool _take( UINT32 id, std::string& reply );
+
+    public:
+      NetworkRequestPipeline( NetworkMessageStream* stream );
+      ~NetworkRequestPipeline();
+
+      /// Sends a request and returns at once.
+      /// @return the id of the request, to be passed to receive or abandon
+      UINT32 send( UINT32 kind, const void* body, unsigned int length );
+
+      /// Waits for the reply to a request.  Throws if the server reports
+      /// that the request failed, or if the connection is lost.
+      void receive( UINT32 id, std::string& reply );
+
+      /// Discards the reply to a request, whenever it arrives.
+      void abandon( UINT32 id );
+
+      void binaryReply( UINT32 id, UINT32 kind, const void* buffer, unsigned int length );
+      void binaryError( UINT32 id, const std::string& e );
+
+      void request( indri::xml::XMLNode* node );
+      void reply( indri::xml::XMLNode* node );
+      void reply( const std::string& name, const void* buffer, unsigned int length );
+      void replyDone();
+      void error( const std::string& e );
+    };
+  }
+}
+
+#endif // INDRI_NETWORKREQUESTPIPELINE_HPP
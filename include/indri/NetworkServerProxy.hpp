@@ -25,6 +25,8 @@
 #include "indri/QueryServer.hpp"
 #include "indri/Packer.hpp"
 #include "indri/NetworkMessageStream.hpp"
+#include "indri/NetworkRequestPipeline.hpp"
+#include "indri/BinaryMessage.hpp"
 #include "indri/Buffer.hpp"
 namespace indri
 {
@@ -33,14 +35,31 @@ namespace indri
     class NetworkServerProxy : public QueryServer {
     private:
       indri::net::NetworkMessageStream* _stream;
+      // not 0 once the server takes binary requests
+      indri::net::NetworkRequestPipeline* _pipeline;
 
       INT64 _numericRequest( indri::xml::XMLNode* node );
       std::string _stringRequest( indri::xml::XMLNode* node );
 
+      UINT32 _binaryRequest( UINT32 kind, indri::utility::Buffer& body );
+      INT64 _binaryNumericRequest( UINT32 kind, indri::utility::Buffer& body );
+      std::string _binaryStringRequest( UINT32 kind, indri::utility::Buffer& body );
+
     public:
       NetworkServerProxy( indri::net::NetworkMessageStream* stream );
+      ~NetworkServerProxy();
+
+      /// Asks the server to take binary requests on this connection.  Binary
+      /// requests are pipelined: a response doesn't hold the connection until
+      /// it is deleted, so any number of requests, from any number of threads,
+      /// can be sent before their replies are read, and the server may answer
+      /// them concurrently.
+      /// @return true if the server agreed; servers that predate the binary
+      /// protocol answer with an error, which closes the connection
+      bool useBinaryProtocol();
 
-      QueryServerResponse* runQuery( std::vector<indri::lang::Node*>& roots, int resultsRequested, bool optimize );
+      QueryServerResponse* runQuery( std::vector<indri::lang::Node*>& roots, int resultsRequested, bool optimize,
+                                     const indri::api::QueryBudget& budget = indri::api::QueryBudget() );
       QueryServerDocumentsResponse* documents( const std::vector<lemur::api::DOCID_T>& documentIDs );
       QueryServerMetadataResponse* documentMetadata( const std::vector<lemur::api::DOCID_T>& documentIDs, const std::string& attributeName );
 
@@ -71,7 +90,7 @@ namespace indri
       INT64 documentStemCount( const std::string& term );
 
       // document vector
-      QueryServerVectorsResponse* documentVectors( const std::vector<lemur::api::DOCID_T>& documentIDs );
+      QueryServerVectorsResponse* documentVectors( const std::vector<lemur::api::DOCID_T>& documentIDs, bool sharedStems = false );
 
       void setMaxWildcardTerms(int maxTerms);
     };
@@ -23,21 +23,40 @@
 #include "indri/NetworkMessageStream.hpp"
 #include "indri/QueryServer.hpp"
 #include "indri/QueryResponsePacker.hpp"
+#include "indri/BinaryMessage.hpp"
+#include "indri/ThreadPool.hpp"
+#include "indri/Mutex.hpp"
+#include "indri/ConditionVariable.hpp"
 namespace indri
 {
   namespace net
   {
     
     class NetworkServerStub : public MessageStreamHandler {
+    public:
+      enum {
+        /// binary requests of one connection that may be queued or running
+        /// before the stub stops reading more from it
+        MAXIMUM_PENDING = 64
+      };
+
     private:
+      class BinaryRequestTask;
+
       indri::server::QueryServer* _server;
       NetworkMessageStream* _stream;
+      indri::thread::ThreadPool* _pool;
+
+      indri::thread::Mutex _pendingLock;
+      indri::thread::ConditionVariable _pendingChanged;
+      int _pending;
 
       indri::xml::XMLNode* _encodeDocument( const struct indri::api::ParsedDocument* document );
       void _decodeMetadataRequest( const class indri::xml::XMLNode* request,
                                    std::string& attributeName,
                                    std::vector<std::string>& attributeValues );
       void _sendDocumentsResponse( class indri::server::QueryServerDocumentsResponse* response );
+      void _encodeStems( indri::xml::XMLNode* stems, const std::vector<std::string>& stemsVector );
       void _sendNumericResponse( const char* responseName, UINT64 number );
 
       void _handleDocuments( indri::xml::XMLNode* input );
@@ -69,14 +88,32 @@ namespace indri
       void _handlePathNames( indri::xml::XMLNode* request );
 
       void _handleSetMaxWildcardTerms( indri::xml::XMLNode* request );
+      void _handleBinaryProtocol( indri::xml::XMLNode* request );
+
+      void _readDocumentIDs( BinaryMessageReader& request, std::vector<lemur::api::DOCID_T>& documentIDs );
+      void _readMetadataRequest( BinaryMessageReader& request, std::string& attributeName, std::vector<std::string>& attributeValues );
+      void _writeStrings( BinaryMessageWriter& reply, const std::vector<std::string>& strings );
+      void _writeDocuments( BinaryMessageWriter& reply, indri::server::QueryServerDocumentsResponse* response );
+
+      void _binaryQuery( BinaryMessageReader& request, BinaryMessageWriter& reply );
+      void _binaryDocumentVectors( BinaryMessageReader& request, BinaryMessageWriter& reply );
+      void _binaryPathNames( BinaryMessageReader& request, BinaryMessageWriter& reply );
+      void _handleBinaryRequest( UINT32 id, UINT32 kind, const char* body, unsigned int length );
+      void _finishBinaryRequest();
 
     public:
-      NetworkServerStub( indri::server::QueryServer* server, NetworkMessageStream* stream );
+      /// @param pool if not 0, binary requests run on it, so that one connection
+      /// can have several at once; otherwise they run as they are read
+      NetworkServerStub( indri::server::QueryServer* server, NetworkMessageStream* stream,
+                         indri::thread::ThreadPool* pool = 0 );
+      /// Waits for binary requests that are still running.
+      ~NetworkServerStub();
       void request( indri::xml::XMLNode* input );
       void reply( indri::xml::XMLNode* input );
       void reply( const std::string& name, const void* buffer, unsigned int length );
       void replyDone();
       void error( const std::string& error );
+      void binaryRequest( UINT32 id, UINT32 kind, const void* buffer, unsigned int length );
       void run();
     };
   }
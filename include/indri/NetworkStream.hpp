@@ -26,6 +26,9 @@
 #include "lemur/lemur-platform.h"
 #include "lemur/lemur-compat.hpp"
 #include "indri/indri-platform.h"
+#ifndef WIN32
+#include <netinet/tcp.h>
+#endif
 #include <string>
 
 namespace indri
@@ -116,6 +119,13 @@ namespace indri
         _socket = -1;
       }
 
+      /// Sends small writes at once instead of holding them until earlier
+      /// ones are acknowledged, which would stall pipelined requests.
+      void setNoDelay() {
+        int set = 1;
+        setsockopt( _socket, IPPROTO_TCP, TCP_NODELAY, (const char*) &set, sizeof(int) );
+      }
+
       int write( const void* buffer, size_t length ) {
 //        return ::send( _socket, (const char*) buffer, int(length), 0 );
         if (_socket == -1) return 0;
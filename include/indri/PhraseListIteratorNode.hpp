@@ -0,0 +1,60 @@
+/*==========================================================================
+ * Copyright (c) 2004 University of Massachusetts.  All Rights Reserved.
+ *
+ * Use of the Lemur Toolkit for Language Modeling and Information Retrieval
+ * is subject to the terms of the software license set forth in the LICENSE
+ * file included with this software, and also available at
+ * http://www.lemurproject.org/license.html
+ *
+ *==========================================================================
+ */
+
+
+//
+// PhraseListIteratorNode
+//
+// The extents of a #1 window of two terms.  When the index stores a
+// list for the phrase (see IndexWriter::setPhrases), the extents are
+// read from it; otherwise the ordered window is matched as usual.
+//
+
+#ifndef INDRI_PHRASELISTITERATORNODE_HPP
+#define INDRI_PHRASELISTITERATORNODE_HPP
+
+#include "indri/ListIteratorNode.hpp"
+#include "indri/DocExtentListIterator.hpp"
+namespace indri
+{
+  namespace infnet
+  {
+    
+    class PhraseListIteratorNode : public ListIteratorNode {
+    private:
+      class indri::index::DocExtentListIterator* _list;
+      int _listID;
+      // evaluates the phrase in indexes without a stored list; owned by this node
+      ListIteratorNode* _window;
+      // document the window was last prepared for, when a list is stored
+      lemur::api::DOCID_T _windowDocument;
+      indri::utility::greedy_vector<indri::index::Extent> _extents;
+      class InferenceNetwork& _network;
+      std::string _name;
+
+    public:
+      PhraseListIteratorNode( const std::string& name, class InferenceNetwork& network, int listID, ListIteratorNode* window );
+      ~PhraseListIteratorNode();
+
+      void prepare( lemur::api::DOCID_T documentID );
+      /// returns a list of intervals describing positions of children
+      const indri::utility::greedy_vector<indri::index::Extent>& extents(); 
+      bool hasExtents();
+      lemur::api::DOCID_T nextCandidateDocument();
+      void indexChanged( indri::index::Index& index );
+      const std::string& getName() const;
+      void annotate( class Annotator& annotator, lemur::api::DOCID_T documentID, indri::index::Extent &extent );
+    };
+  }
+}
+
+#endif // INDRI_PHRASELISTITERATORNODE_HPP
+
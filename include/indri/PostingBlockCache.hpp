@@ -0,0 +1,117 @@
+/*==========================================================================
+ * Copyright (c) 2004 University of Massachusetts.  All Rights Reserved.
+ *
+ * Use of the Lemur Toolkit for Language Modeling and Information Retrieval
+ * is subject to the terms of the software license set forth in the LICENSE
+ * file included with this software, and also available at
+ * http://www.lemurproject.org/license.html
+ *
+ *==========================================================================
+ */
+
+//
+// PostingBlockCache
+//
+// The decoded documents and counts of blocks of long inverted lists,
+// shared by every query in the process, so that concurrent queries on
+// the same head terms decode each block once.  Blocks are found by the
+// index they belong to and their byte offset in its inverted file.
+//
+// Cached blocks never change, and a hit takes a reference to one
+// without locking: readers announce themselves on a per-shard counter
+// for the current generation, and blocks removed from a shard are
+// freed only after every reader of their generation has left.  Adding
+// and evicting blocks takes the shard lock.  Blocks are evicted in
+// insertion order, skipping once those that were hit since the last
+// pass, when the cache exceeds the postingCacheMemory parameter (in
+// bytes).  Only lists found in at least postingCacheMinimumDocuments
+// documents are cached.
+//
+
+#ifndef INDRI_POSTINGBLOCKCACHE_HPP
+#define INDRI_POSTINGBLOCKCACHE_HPP
+
+#include "indri/indri-platform.h"
+#include "indri/greedy_vector"
+#include "indri/atomic.hpp"
+#include "lemur/IndexTypes.hpp"
+
+namespace indri
+{
+  namespace index
+  {
+    class PostingBlockCache {
+    public:
+      struct Statistics {
+        UINT64 hits;
+        UINT64 misses;
+        UINT64 additions;
+        UINT64 evictions;
+        UINT64 entries;
+        UINT64 memory;
+        UINT64 maximumMemory;
+      };
+
+      /// A decoded block, shared by every iterator that holds a reference to it.
+      struct Block {
+        UINT64 key;
+        int entries;
+        // bytes from the start of the encoded block to its positions
+        UINT32 positionsOffset;
+        const UINT32* documents;
+        const UINT32* counts;
+
+        // owned by the cache
+        Block* volatile next;
+        volatile bool used;
+        indri::atomic::value_type references;
+      };
+
+      enum {
+        SHARDS = 64,
+        BUCKETS = 1024
+      };
+
+      struct Shard;
+
+    private:
+      Shard* _shards;
+      UINT64 _maximumMemory;
+      UINT64 _minimumDocuments;
+
+      Shard& _shard( UINT64 key );
+
+      PostingBlockCache( UINT64 maximumMemory, UINT64 minimumDocuments );
+
+    public:
+      ~PostingBlockCache();
+
+      /// @return the cache shared by the process, or 0 if postingCacheMemory is 0
+      static PostingBlockCache* instance();
+
+      /// @return a number that identifies one opened index for as long as the process runs
+      static UINT64 indexID();
+
+      /// @return true if the blocks of a list found in this many documents should be cached
+      bool admits( UINT64 documentCount ) const;
+
+      /// Finds a block without taking a lock.  The caller must release() it.
+      /// @return the block, or 0 if it is not cached
+      Block* find( UINT64 index, UINT64 offset );
+
+      /// Drops a reference returned by find().
+      static void release( Block* block );
+
+      /// Adds a decoded block.
+      void add( UINT64 index, UINT64 offset,
+                const indri::utility::greedy_vector<UINT32>& documents,
+                const indri::utility::greedy_vector<UINT32>& counts,
+                UINT32 positionsOffset );
+
+      /// @return hit, miss and memory counters, summed over the shards
+      Statistics statistics();
+    };
+  }
+}
+
+#endif // INDRI_POSTINGBLOCKCACHE_HPP
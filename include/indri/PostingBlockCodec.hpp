@@ -0,0 +1,61 @@
+/*==========================================================================
+ * Copyright (c) 2004 University of Massachusetts.  All Rights Reserved.
+ *
+ * Use of the Lemur Toolkit for Language Modeling and Information Retrieval
+ * is subject to the terms of the software license set forth in the LICENSE
+ * file included with this software, and also available at
+ * http://www.lemurproject.org/license.html
+ *
+ *==========================================================================
+ */
+
+//
+// PostingBlockCodec
+//
+// Fixed-width bit packing for blocks of inverted list entries.
+//
+
+#ifndef INDRI_POSTINGBLOCKCODEC_HPP
+#define INDRI_POSTINGBLOCKCODEC_HPP
+
+#include "indri/indri-platform.h"
+#include "indri/Buffer.hpp"
+
+namespace indri
+{
+  namespace index
+  {
+    /*! Encodes runs of unsigned integers as a one-byte bit width followed
+     *  by the values packed least-significant-bit first into 32-bit words.
+     *  A run holds at most BLOCK_SIZE values; longer sequences are written
+     *  as a series of runs.  Decoding is done a whole run at a time with
+     *  kernels specialised for each bit width, and delta decoding uses an
+     *  SSE2 prefix sum where the compiler targets it.
+     */
+    class PostingBlockCodec {
+    public:
+      enum {
+        /// Number of documents in a block, and values in a packed run.
+        BLOCK_SIZE = 128
+      };
+
+      /// @return the number of bits needed to store the largest value
+      static int bitsRequired( const UINT32* values, int count );
+
+      /// Appends values to the buffer, split into runs of at most BLOCK_SIZE values.
+      static void encode( indri::utility::Buffer& output, const UINT32* values, int count );
+
+      /// Decodes count values written by encode.
+      /// @return a pointer to the first byte after the encoded values
+      static const char* decode( const char* input, UINT32* values, int count );
+
+      /// @return a pointer to the first byte after count encoded values, without decoding them
+      static const char* skip( const char* input, int count );
+
+      /// Replaces each value with the sum of itself, all earlier values and base.
+      static void prefixSum( UINT32* values, int count, UINT32 base );
+    };
+  }
+}
+
+#endif // INDRI_POSTINGBLOCKCODEC_HPP
@@ -0,0 +1,86 @@
+/*==========================================================================
+ * Copyright (c) 2004 University of Massachusetts.  All Rights Reserved.
+ *
+ * Use of the Lemur Toolkit for Language Modeling and Information Retrieval
+ * is subject to the terms of the software license set forth in the LICENSE
+ * file included with this software, and also available at
+ * http://www.lemurproject.org/license.html
+ *
+ *==========================================================================
+ */
+
+//
+// QueryBudget
+//
+// Limits on the work that scoring one query may do on a server, and
+// counts of the work it did.  A query that runs out of budget stops
+// scoring and returns the best documents found so far.
+//
+
+#ifndef INDRI_QUERYBUDGET_HPP
+#define INDRI_QUERYBUDGET_HPP
+
+#include "lemur/IndexTypes.hpp"
+
+namespace indri
+{
+  namespace api
+  {
+    /*! Limits on the work done to score a query; a limit of zero means
+      no limit.  The postings and documents limits apply to each server;
+      the time limit covers the whole query.
+    */
+    struct QueryBudget {
+      /// inverted list entries decoded
+      INT64 postings;
+      /// candidate documents scored
+      INT64 documents;
+      /// wall-clock time, in milliseconds
+      INT64 milliseconds;
+
+      QueryBudget() : postings(0), documents(0), milliseconds(0) {}
+
+      bool unlimited() const {
+        return !postings && !documents && !milliseconds;
+      }
+
+      /// Lowers each limit of this budget to the one in other, where other sets one.
+      void restrict( const QueryBudget& other ) {
+        postings = _tighter( postings, other.postings );
+        documents = _tighter( documents, other.documents );
+        milliseconds = _tighter( milliseconds, other.milliseconds );
+      }
+
+    private:
+      static INT64 _tighter( INT64 one, INT64 two ) {
+        if( !one || (two && two < one) )
+          return two;
+        return one;
+      }
+    };
+
+    /*! The work done to score a query, summed over all servers.
+     */
+    struct QueryWork {
+      /// inverted list entries decoded
+      INT64 postings;
+      /// candidate documents scored
+      INT64 documents;
+      /// time spent scoring, in milliseconds, summed over servers and query threads
+      INT64 milliseconds;
+      /// true if a server ran out of budget, so the results may be missing better documents
+      bool partial;
+
+      QueryWork() : postings(0), documents(0), milliseconds(0), partial(false) {}
+
+      void add( const QueryWork& other ) {
+        postings += other.postings;
+        documents += other.documents;
+        milliseconds += other.milliseconds;
+        partial = partial || other.partial;
+      }
+    };
+  }
+}
+
+#endif // INDRI_QUERYBUDGET_HPP
@@ -27,9 +27,11 @@
 #include "indri/Parameters.hpp"
 #include "indri/ParsedDocument.hpp"
 #include "indri/Repository.hpp"
+#include "indri/CompressedCollection.hpp"
 #include "indri/QueryAnnotation.hpp"
 #include "lemur/IndexTypes.hpp"
 #include "indri/ReformulateQuery.hpp"
+#include "indri/QueryBudget.hpp"
 
 namespace indri 
 {
@@ -50,7 +52,10 @@ namespace indri
         /// Generate an html snippet with matches in &lt;strong&gt; tags.
         HTMLSnippet = 1,
         /// Generate a text snippet with matches in upper case.
-        TextSnippet = 2
+        /// Any other value except NoSnippet, such as 0, does the same.
+        TextSnippet = 2,
+        /// Generate no snippets, which skips annotating the query.
+        NoSnippet = 3
       };
       /// the query to run
       std::string query;
@@ -66,6 +71,9 @@ namespace indri
       int startNum;
       /// snippet generation options
       enum Options options;
+      /// limits on the work done to score the query; the tighter of this
+      /// and the environment's budget (see setQueryBudget) is used
+      QueryBudget budget;
     } QueryRequest;
 
     /*! encapsulation of a metadata field and its value
@@ -105,7 +113,8 @@ namespace indri
     /*! Aggretate of the list of QueryResult elements for a QueryRequest,
       with estimated number of total matches, query parse time, query
       query execution time, and parsed document processing time 
-      (metadata retrieval and snippet generation).
+      (metadata retrieval and snippet generation).  The execution time
+      is also broken down into its statistics, scoring and annotation phases.
      */
     typedef struct QueryResults 
     {
@@ -113,10 +122,19 @@ namespace indri
       float parseTime;
       /// time to evaluate the query in milliseconds
       float executeTime;
+      /// part of executeTime spent collecting collection statistics for the query terms
+      float statisticsTime;
+      /// part of executeTime spent scoring documents
+      float scoreTime;
+      /// part of executeTime spent finding matches for snippets; zero when no snippets are requested
+      float annotateTime;
       /// time to retrieve metadata fields and generate snippets
       float documentsTime;
       /// estimated number of matches for the query
       int estimatedMatches;
+      /// work done to score the query; if work.partial is set, the query ran
+      /// out of budget and the results are the best found before it did
+      QueryWork work;
       /// the list of QueryResult elements.
       std::vector<QueryResult> results;
     } QueryResults;
@@ -145,6 +163,8 @@ namespace indri
 
       Parameters _parameters;
       bool _baseline;
+      QueryBudget _budget;
+      QueryWork _work;
       
       void _mergeQueryResults( indri::infnet::InferenceNetwork::MAllResults& results, std::vector<indri::server::QueryServerResponse*>& responses );
       void _copyStatistics( std::vector<indri::lang::RawScorerNode*>& scorerNodes, indri::infnet::InferenceNetwork::MAllResults& statisticsResults );
@@ -160,11 +180,13 @@ namespace indri
                                                              const std::vector<lemur::api::DOCID_T>* documentIDs,
                                                              QueryAnnotation** annotation,
                                                              const std::string &queryType = "indri" );
-      void _scoredQuery( indri::infnet::InferenceNetwork::MAllResults& results, indri::lang::Node* queryRoot, std::string& accumulatorName, int resultsRequested, const std::vector<lemur::api::DOCID_T>* documentSet );
+      void _scoredQuery( indri::infnet::InferenceNetwork::MAllResults& results, indri::lang::Node* queryRoot, std::string& accumulatorName, int resultsRequested, const std::vector<lemur::api::DOCID_T>* documentSet, const QueryBudget& budget );
 
       double _expCount( const std::string& expression,
                         const std::string& whichOccurrences,
                         const std::string &queryType = "indri" );
+      std::vector<double> _counterCounts( std::vector<indri::lang::Node*>& counters,
+                                          const std::string& whichOccurrences );
 
       QueryEnvironment( QueryEnvironment& other ) {}
 
@@ -174,6 +196,14 @@ namespace indri
       /// \brief Set the amount of memory to use.
       /// @param memory number of bytes to allocate
       void setMemory( UINT64 memory );
+      /// \brief Set whether indexes added later are mapped into memory, so
+      /// that inverted lists are decoded in place instead of copied into buffers.
+      /// @param mapped true to map the indexes
+      void setMappedIndexes( bool mapped );
+      /// \brief Set whether servers added later are sent binary, pipelined
+      /// requests, for servers that support them.  The default is true.
+      /// @param binary false to use only the XML protocol
+      void setBinaryProtocol( bool binary );
       /// \brief Set whether there should be one single background model or context sensitive models
       /// @param background true for one background model false for context sensitive models
       void setBaseline(const std::string &baseline);
@@ -311,6 +341,19 @@ namespace indri
       /// @param expression The expression to evaluate, probably an ordered or unordered window expression
       double documentExpressionCount( const std::string& expression,
                               const std::string &queryType = "indri" );
+      /// \brief Return the total number of times each expression appears in the collection.
+      /// The expressions are counted together, in one query to each server, so this is
+      /// much faster than calling expressionCount for each of them.
+      /// @param expressions the expressions to count, such as terms or window expressions
+      /// @return the count of each expression, in the same order
+      std::vector<double> expressionCounts( const std::vector<std::string>& expressions,
+                                            const std::string &queryType = "indri" );
+      /// \brief Return the total number of occurrences of each stem sequence in the collection.
+      /// A sequence of more than one stem is counted as an ordered window (#1).  Like
+      /// expressionCounts, all the sequences are counted in one query to each server.
+      /// @param stems the stem sequences to count
+      /// @return the count of each sequence, in the same order
+      std::vector<double> stemCounts( const std::vector< std::vector<std::string> >& stems );
       /// \brief Return all the occurrences of this expression in the collection.
       /// Note that the returned vector may be quite large for large collections, and therefore
       /// has the very real possibility of exhausting the memory of the machine.  Use this method
@@ -344,11 +387,37 @@ namespace indri
       /// @param documentIDs the vector of document ids.
       /// @return DocumentVector pointer for the specified document.
       std::vector<DocumentVector*> documentVectors( const std::vector<lemur::api::DOCID_T>& documentIDs );
+      /// \brief Fetch the document vectors for a list of documents, with one
+      /// list of stems shared by all of them.  The returned vectors have no stems;
+      /// their positions are indices into stems, and stem 0 is [OOV].  This
+      /// avoids copying and hashing the stems of every document separately.
+      /// Caller responsible for deleting the Vectors.
+      /// @param documentIDs the vector of document ids.
+      /// @param stems set to the stems of all the vectors
+      /// @return DocumentVector pointer for each specified document.
+      std::vector<DocumentVector*> documentVectors( const std::vector<lemur::api::DOCID_T>& documentIDs,
+                                                    std::vector<std::string>& stems );
+
+      /// \brief Return the hit and miss counts of the decompressed document
+      /// caches of the local repositories.  Remote servers are not included.
+      /// @return the counters of every local cache, added together
+      indri::collection::CompressedCollection::CacheStatistics collectionCacheStatistics();
 
       /// \brief set maximum number of wildcard terms to expand to.
       /// @param maxTerms the maximum number of terms to expand a wildcard
       /// operator argument (default 100).
       void setMaxWildcardTerms(int maxTerms);
+
+      /// \brief Limit the work each query may do to score documents.  A query
+      /// that runs out of budget returns the best documents found so far.
+      /// Servers may also limit queries with their queryBudget parameters.
+      /// @param budget the limits; zero limits are not enforced
+      void setQueryBudget( const QueryBudget& budget );
+
+      /// \brief Return the work done to score the most recent query, such as the
+      /// number of postings decoded and documents scored.
+      /// @return the work, summed over all servers
+      QueryWork lastQueryWork() const;
       
       /// \brief return the internal query servers.
       /// @return the local and network query servers.
@@ -20,6 +20,7 @@
 #define INDRI_QUERYRESPONSEPACKER_HPP
 
 #include "indri/InferenceNetwork.hpp"
+#include "indri/BinaryMessage.hpp"
 #include "lemur/lemur-compat.hpp"
 namespace indri
 {
@@ -31,11 +32,62 @@ namespace indri
       indri::infnet::InferenceNetwork::MAllResults& _results;
 
     public:
+      enum {
+        RESULT_SIZE = sizeof(INT32)*5 + sizeof(double) + sizeof(INT64)
+      };
+
       QueryResponsePacker( indri::infnet::InferenceNetwork::MAllResults& results ) :
         _results(results)
       {
       }
 
+      /// Writes one result in network byte order to RESULT_SIZE bytes at output.
+      static void encode( const indri::api::ScoredExtentResult& unswapped, char* output ) {
+        indri::api::ScoredExtentResult byteSwapped;
+
+        byteSwapped.begin = htonl(unswapped.begin);
+        byteSwapped.end = htonl(unswapped.end);
+        byteSwapped.document = htonl(unswapped.document );
+        byteSwapped.score = lemur_compat::htond(unswapped.score);
+        byteSwapped.number = lemur_compat::htonll(unswapped.number);
+        byteSwapped.ordinal = htonl(unswapped.ordinal);
+        byteSwapped.parentOrdinal = htonl(unswapped.parentOrdinal);
+
+        memcpy( output, &byteSwapped.score, sizeof(double) );
+        memcpy( output + 8, &byteSwapped.document, sizeof(INT32) );
+        memcpy( output + 12, &byteSwapped.begin, sizeof(INT32) );
+        memcpy( output + 16, &byteSwapped.end, sizeof(INT32) );
+        memcpy( output + 20, &byteSwapped.number, sizeof(INT64) );
+        memcpy( output + 28, &byteSwapped.ordinal, sizeof(INT32) );
+        memcpy( output + 32, &byteSwapped.parentOrdinal, sizeof(INT32) );
+      }
+
+      /// Writes the results as the body of a binary reply: the number of
+      /// nodes, then for each node its name and number of lists, then for
+      /// each list its name, its length and its encoded results.
+      void write( BinaryMessageWriter& writer ) {
+        indri::infnet::InferenceNetwork::MAllResults::iterator iter;
+        indri::infnet::EvaluatorNode::MResults::iterator nodeIter;
+
+        writer.writeInt32( (INT32)_results.size() );
+
+        for( iter = _results.begin(); iter != _results.end(); iter++ ) {
+          writer.writeString( iter->first );
+          writer.writeInt32( (INT32)iter->second.size() );
+
+          for( nodeIter = iter->second.begin(); nodeIter != iter->second.end(); nodeIter++ ) {
+            const std::vector<indri::api::ScoredExtentResult>& resultList = nodeIter->second;
+
+            writer.writeString( nodeIter->first );
+            writer.writeInt32( (INT32)resultList.size() );
+            char* output = writer.reserve( resultList.size() * RESULT_SIZE );
+
+            for( size_t i=0; i<resultList.size(); i++ )
+              encode( resultList[i], output + i*RESULT_SIZE );
+          }
+        }
+      }
+
       void write( NetworkMessageStream* stream ) {
         indri::infnet::InferenceNetwork::MAllResults::iterator iter;
         indri::infnet::EvaluatorNode::MResults::iterator nodeIter;
@@ -57,26 +109,8 @@ namespace indri
             while( resultList.size() > resultsSent ) {
               size_t sendChunk = lemur_compat::min<size_t>( resultList.size() - resultsSent, (size_t) 100 );
 
-              for( size_t i=0; i<sendChunk; i++ ) {
-                indri::api::ScoredExtentResult byteSwapped;
-                const indri::api::ScoredExtentResult& unswapped = resultList[i + resultsSent];
-
-                byteSwapped.begin = htonl(unswapped.begin);
-                byteSwapped.end = htonl(unswapped.end);
-                byteSwapped.document = htonl(unswapped.document );
-                byteSwapped.score = lemur_compat::htond(unswapped.score);
-                byteSwapped.number = lemur_compat::htonll(unswapped.number);
-                byteSwapped.ordinal = htonl(unswapped.ordinal);
-                byteSwapped.parentOrdinal = htonl(unswapped.parentOrdinal);
-
-                memcpy( networkResults + i*resultSize, &byteSwapped.score, sizeof(double) );
-                memcpy( networkResults + i*resultSize + 8, &byteSwapped.document, sizeof(INT32) );
-                memcpy( networkResults + i*resultSize + 12, &byteSwapped.begin, sizeof(INT32) );
-                memcpy( networkResults + i*resultSize + 16, &byteSwapped.end, sizeof(INT32) );
-                memcpy( networkResults + i*resultSize + 20, &byteSwapped.number, sizeof(INT64) );
-                memcpy( networkResults + i*resultSize + 28, &byteSwapped.ordinal, sizeof(INT32) );
-                memcpy( networkResults + i*resultSize + 32, &byteSwapped.parentOrdinal, sizeof(INT32) );
-              }
+              for( size_t i=0; i<sendChunk; i++ )
+                encode( resultList[i + resultsSent], networkResults + i*resultSize );
 
               stream->reply( resultName, networkResults, int(sendChunk * resultSize) );
               resultsSent += sendChunk;
@@ -21,6 +21,7 @@
 
 #include "indri/NetworkMessageStream.hpp"
 #include "indri/InferenceNetwork.hpp"
+#include "indri/BinaryMessage.hpp"
 #include "lemur/Exception.hpp"
 namespace indri
 {
@@ -40,6 +41,65 @@ namespace indri
       {
       }
 
+      /// Reads one result written by QueryResponsePacker::encode.
+      static indri::api::ScoredExtentResult decode( const char* p ) {
+        indri::api::ScoredExtentResult aligned;
+
+        // copy for alignment
+        memcpy( &aligned.score, p, sizeof(double) );
+        p += sizeof(double);
+
+        memcpy( &aligned.document, p, sizeof(INT32) );
+        p += sizeof(INT32);
+
+        memcpy( &aligned.begin, p, sizeof(INT32) );
+        p += sizeof(INT32);
+
+        memcpy( &aligned.end, p, sizeof(INT32) );
+        p += sizeof(INT32);
+
+        memcpy( &aligned.number, p, sizeof(UINT64) );
+        p += sizeof(INT64);
+
+        memcpy( &aligned.ordinal, p, sizeof(INT32) );
+        p += sizeof(INT32);
+
+        memcpy( &aligned.parentOrdinal, p, sizeof(INT32) );
+        p += sizeof(INT32);
+
+        aligned.begin = ntohl(aligned.begin);
+        aligned.end = ntohl(aligned.end);
+        aligned.document = ntohl(aligned.document);
+        aligned.score = lemur_compat::ntohd(aligned.score);
+        aligned.number = lemur_compat::ntohll(aligned.number);
+        aligned.ordinal = ntohl(aligned.ordinal);
+        aligned.parentOrdinal = ntohl(aligned.parentOrdinal);
+
+        return aligned;
+      }
+
+      /// Reads results written by QueryResponsePacker::write( BinaryMessageWriter& ).
+      static void read( BinaryMessageReader& reader, indri::infnet::InferenceNetwork::MAllResults& results ) {
+        const int resultSize = sizeof(INT32)*5 + sizeof(double) + sizeof(INT64);
+        int nodeCount = reader.readInt32();
+
+        for( int i=0; i<nodeCount; i++ ) {
+          indri::infnet::EvaluatorNode::MResults& nodeResults = results[reader.readString()];
+          int listCount = reader.readInt32();
+
+          for( int j=0; j<listCount; j++ ) {
+            std::vector<indri::api::ScoredExtentResult>& resultVector = nodeResults[reader.readString()];
+            int count = reader.readInt32();
+            const char* p = reader.readBytes( size_t(count) * resultSize );
+
+            resultVector.reserve( count );
+
+            for( int k=0; k<count; k++ )
+              resultVector.push_back( decode( p + k*resultSize ) );
+          }
+        }
+      }
+
       indri::infnet::InferenceNetwork::MAllResults& getResults() {
         while( !_done && _stream->alive() && !_exception.length() )
           _stream->read(*this);
@@ -61,44 +121,14 @@ namespace indri
         nodeName = name.substr( 0, name.find(':') );
         listName = name.substr( name.find(':')+1 );
     
-        indri::api::ScoredExtentResult aligned;
         int count = length / (sizeof(INT32)*5 + sizeof(double) + sizeof(INT64));
         std::vector<indri::api::ScoredExtentResult>& resultVector = _results[nodeName][listName];
     
         const char* p = (const char*) buffer;
 
         for( int i=0; i<count; i++ ) {
-          // copy for alignment
-          memcpy( &aligned.score, p, sizeof(double) );
-          p += sizeof(double);
-
-          memcpy( &aligned.document, p, sizeof(INT32) );
-          p += sizeof(INT32);
-
-          memcpy( &aligned.begin, p, sizeof(INT32) );
-          p += sizeof(INT32);
-
-          memcpy( &aligned.end, p, sizeof(INT32) );
-          p += sizeof(INT32);
-
-          memcpy( &aligned.number, p, sizeof(UINT64) );
-          p += sizeof(INT64);
-
-          memcpy( &aligned.ordinal, p, sizeof(INT32) );
-          p += sizeof(INT32);
-
-          memcpy( &aligned.parentOrdinal, p, sizeof(INT32) );
-          p += sizeof(INT32);
-
-          aligned.begin = ntohl(aligned.begin);
-          aligned.end = ntohl(aligned.end);
-          aligned.document = ntohl(aligned.document);
-          aligned.score = lemur_compat::ntohd(aligned.score);
-          aligned.number = lemur_compat::ntohll(aligned.number);
-          aligned.ordinal = ntohl(aligned.ordinal);
-          aligned.parentOrdinal = ntohl(aligned.parentOrdinal);
-
-          resultVector.push_back(aligned);
+          resultVector.push_back( decode( p ) );
+          p += sizeof(INT32)*5 + sizeof(double) + sizeof(INT64);
         }
       }
 
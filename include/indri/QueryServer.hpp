@@ -51,6 +51,8 @@ namespace indri
     public:
       virtual ~QueryServerVectorsResponse() {};
       virtual std::vector<indri::api::DocumentVector*>& getResults() = 0;
+      // the stems shared by the vectors, when they were fetched with sharedStems
+      virtual std::vector<std::string>& getStems() = 0;
     };
 
     class QueryServerDocumentIDsResponse {
@@ -63,7 +65,10 @@ namespace indri
     class QueryServer {
     public:
       virtual ~QueryServer() {};
-      virtual QueryServerResponse* runQuery( std::vector<indri::lang::Node*>& roots, int resultsRequested, bool optimize ) = 0;
+      // the budget limits the work done to score documents for a ranked query;
+      // the response holds the work done (see InferenceNetwork::storeWork)
+      virtual QueryServerResponse* runQuery( std::vector<indri::lang::Node*>& roots, int resultsRequested, bool optimize,
+                                             const indri::api::QueryBudget& budget = indri::api::QueryBudget() ) = 0;
       virtual QueryServerDocumentsResponse* documents( const std::vector<lemur::api::DOCID_T>& documentIDs ) = 0;
       virtual QueryServerMetadataResponse* documentMetadata( const std::vector<lemur::api::DOCID_T>& documentIDs, const std::string& attributeName ) = 0;
       virtual QueryServerDocumentsResponse* documentsFromMetadata( const std::string& attributeName, const std::vector<std::string>& attributeValues ) = 0;
@@ -91,8 +96,9 @@ namespace indri
       virtual INT64 documentCount( const std::string& term ) = 0;
       virtual INT64 documentStemCount( const std::string& term ) = 0;
   
-      // document vector
-      virtual QueryServerVectorsResponse* documentVectors( const std::vector<lemur::api::DOCID_T>& documentIDs ) = 0;
+      // document vector; with sharedStems, vector positions are ids in one
+      // DocumentVector::Dictionary returned by the response's getStems
+      virtual QueryServerVectorsResponse* documentVectors( const std::vector<lemur::api::DOCID_T>& documentIDs, bool sharedStems = false ) = 0;
 
       // max wildcard terms 
       virtual void setMaxWildcardTerms(int maxTerms) = 0;
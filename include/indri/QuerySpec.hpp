@@ -1648,13 +1648,22 @@ namespace indri {
       indri::lang::Node* _context;
       std::string _smoothing;
       void* _list;
+
+      double _occurrences;
+      double _contextSize;
+      int _documentOccurrences;
+      int _documentCount;
     
     public:
       CachedFrequencyScorerNode( indri::lang::Node* raw, indri::lang::Node* context )
         :
         _raw(raw),
         _context(context),
-        _list(0)
+        _list(0),
+        _occurrences(0),
+        _contextSize(0),
+        _documentOccurrences(0),
+        _documentCount(0)
       {
       }
 
@@ -1699,10 +1708,33 @@ namespace indri {
 
         indri::utility::GenericHash<const char*> hash;
         return _raw->hashCode() * 7 + 
-          _context->hashCode() + 
+          ( _context ? _context->hashCode() : 0 ) + 
           hash( _smoothing.c_str() );
       }
 
+      double getOccurrences() const {
+        return _occurrences;
+      }
+
+      double getContextSize() const {
+        return _contextSize;
+      }
+
+      int getDocumentOccurrences() const {
+        return _documentOccurrences;
+      }
+
+      int getDocumentCount() const {
+        return _documentCount;
+      }
+
+      void setStatistics( double occurrences, double contextSize, int documentOccurrences, int documentCount ) {
+        _occurrences = occurrences;
+        _contextSize = contextSize;
+        _documentOccurrences = documentOccurrences;
+        _documentCount = documentCount;
+      }
+
       void setSmoothing( const std::string& smoothing ) {
         _smoothing = smoothing;
       }
@@ -1728,10 +1760,9 @@ namespace indri {
       }
 
       void walk( Walker& walker ) {
+        // the raw and context expressions are not walked, since
+        // their counts come from the cached list instead
         walker.before(this);
-        _raw->walk( walker );
-        if( _context )
-          _context->walk( walker );
         walker.after(this);
       }
 
@@ -1749,6 +1780,7 @@ namespace indri {
         duplicate->setNodeName( nodeName() );
         duplicate->setSmoothing( _smoothing );
         duplicate->setList( getList() );
+        duplicate->setStatistics( _occurrences, _contextSize, _documentOccurrences, _documentCount );
 
         return copier.after( this, duplicate );
       }
@@ -124,6 +124,7 @@ namespace indri {
       std::vector<lemur::api::DOCID_T> _documentIDs;
       std::vector<Gram*> _grams;
       std::vector<indri::api::DocumentVector*> _vectors;
+      std::vector<std::string> _stems;
 
       void _countGrams();
       void _scoreGrams();
@@ -53,7 +53,8 @@ namespace indri
           return _malloced.back();
         }
     
-        bytes = (bytes+7) & ~7; // round up
+        // round up to 16 bytes; the compiler may use aligned SSE stores on objects placed here
+        bytes = (bytes+15) & ~15;
     
         if( _buffers.size() && _buffers.back()->remaining() >= bytes ) {
           return _buffers.back()->write( bytes );
@@ -91,6 +91,14 @@ namespace indri {
         indri::utility::greedy_vector< std::pair< int, int > > counts;
       };
 
+      // a gram is found by the number of the gram made of all but its
+      // last term (0 for none) and the stem id of that last term
+      struct gram_key_hash {
+        int operator() ( UINT64 key ) const {
+          return int( (key >> 32) * 2654435761U + UINT32(key) );
+        }
+      };
+
       indri::api::QueryEnvironment& _environment;
       int _maxGrams;
       std::string _smoothing;
@@ -103,6 +111,7 @@ namespace indri {
       std::vector<lemur::api::DOCID_T> _documentIDs;
       std::vector<Gram*> _grams;
       std::vector<indri::api::DocumentVector*> _vectors;
+      std::vector<std::string> _stems;
 
       void _countGrams();
       void _scoreGrams();
@@ -77,17 +77,35 @@ namespace indri
 
       indri::thread::Mutex _addLock; /// protects addDocument
 
+      // an active MemoryIndex owned by one adding thread, holding
+      // the document IDs below end
+      struct memory_shard {
+        indri::thread::Mutex lock;
+        indri::index::MemoryIndex* index;
+        lemur::api::DOCID_T end;
+      };
+
+      indri::thread::Mutex _shardLock; /// protects _memoryShards
+      std::vector<memory_shard*> _memoryShards;
+      lemur::api::DOCID_T _blockEnd; /// end of the last reserved document ID block, or 0
+      int _blockDocuments;
+
       class CompressedCollection* _collection;
       indri::index::DeletedDocumentList _deletedList;
 
       indri::api::Parameters _parameters;
       std::vector<indri::parse::Transformation*> _transformations;
+      std::vector<std::string> _transientStopwords;
+      // phrases to store lists for, in index terms (see _buildPhrases)
+      std::vector<std::string> _phrases;
       std::vector<Field> _fields;
       std::vector<indri::index::Index::FieldDescription> _indexFields;
       std::map<std::string, indri::file::File*> _priorFiles;
 
       std::string _path;
       bool _readOnly;
+      // map the files of disk indexes into memory
+      bool _mappedIndexes;
 
       INT64 _memory;
 
@@ -98,6 +116,8 @@ namespace indri
 
       indri::atomic::value_type _queryLoad[ LOAD_MINUTES * LOAD_MINUTE_FRACTION ];
       indri::atomic::value_type _documentLoad[ LOAD_MINUTES * LOAD_MINUTE_FRACTION ];
+      // documents added since the repository was opened
+      indri::atomic::value_type _documentAdds;
 
       static std::vector<std::string> _fieldNames( indri::api::Parameters& parameters );
       static std::string _stemmerName( indri::api::Parameters& parameters );
@@ -125,8 +145,16 @@ namespace indri
       void _buildFields();
       void _buildChain( indri::api::Parameters& parameters,
                         indri::api::Parameters *options );
+      void _createChain( std::vector<indri::parse::Transformation*>& chain,
+                         indri::api::Parameters& parameters );
+      int _addTransformedDocument( indri::api::ParsedDocument* document, bool inCollection );
+      int _addShardDocument( indri::api::ParsedDocument* document, bool inCollection, int shard );
+      memory_shard* _memoryShard( int shard );
+      void _openBlock( memory_shard* shard );
+      void _closeShards();
 
       void _copyParameters( indri::api::Parameters& options );
+      void _buildPhrases();
 
       void _removeStates( std::vector<index_state>& toRemove );
       void _remove( const std::string& path );
@@ -155,14 +183,18 @@ namespace indri
 
       void _setThrashing( bool flag );
       UINT64 _timeSinceThrashing();
-      void _addMemoryIndex();
+      index_state _addMemoryIndex( bool afterBlocks = false );
 
     public:
       Repository() {
         _collection = 0;
         _readOnly = false;
+        _mappedIndexes = false;
+        _blockEnd = 0;
+        _blockDocuments = 0;
         _lastThrashTime = 0;
         _thrashing = false;
+        _documentAdds = 0;
         memset( (void*) _documentLoad, 0, sizeof(indri::atomic::value_type)*LOAD_MINUTES*LOAD_MINUTE_FRACTION );
         memset( (void*) _queryLoad, 0, sizeof(indri::atomic::value_type)*LOAD_MINUTES*LOAD_MINUTE_FRACTION );
       }
@@ -174,6 +206,21 @@ namespace indri
       /// @param document the document to add.
       /// @param inCollection if true, add the document to the CompressedCollection.
       int addDocument( indri::api::ParsedDocument* document, bool inCollection  = true );
+      /// Make a private copy of the transformations addDocument applies
+      /// (normalization, stopping, stemming), so that a thread can transform
+      /// documents without holding the repository lock.  The caller
+      /// deletes the transformations.
+      std::vector<indri::parse::Transformation*> createTransformations();
+      /// add a parsed document that has already been through a chain
+      /// made by createTransformations.
+      /// @param document the document to add.
+      /// @param inCollection if true, add the document to the CompressedCollection.
+      /// @param shard if not negative, add the document to a MemoryIndex owned by
+      /// this shard, so that threads adding to different shards do not wait on
+      /// each other.  Each shard takes document IDs in blocks, so documents are
+      /// not numbered in the order they were added.  Calls with and without a
+      /// shard must not be made at the same time.
+      int addTransformedDocument( indri::api::ParsedDocument* document, bool inCollection = true, int shard = -1 );
       /// delete a document from the repository
       /// @param documentID the internal ID of the document to delete
       void deleteDocument( int documentID );
@@ -189,6 +236,8 @@ namespace indri
       std::string processTerm( const std::string& term );
       /// @return the compressed document collection
       class CompressedCollection* collection();
+      /// @return the directory this repository was opened from
+      const std::string& path() const;
       /// Create a new empty repository.
       /// @param path the directory to create the repository in
       /// @param options additional parameters
@@ -241,6 +290,10 @@ namespace indri
 
       /// Returns the average number of documents added each minute in the last 1, 5 and 15 minutes
       Load documentLoad();
+
+      /// Returns a count that changes after every document add, to any index;
+      /// caches compare it to notice that collection statistics have changed
+      indri::atomic::value_type documentAdds();
     };
   }
 }
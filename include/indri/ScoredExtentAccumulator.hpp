@@ -20,7 +20,7 @@
 #define INDRI_SCOREDEXTENTACCUMULATOR_HPP
 
 #include "indri/SkippingCapableNode.hpp"
-#include <queue>
+#include "indri/TopResults.hpp"
 namespace indri
 {
   namespace infnet
@@ -30,8 +30,8 @@ namespace indri
     private:
       BeliefNode* _belief;
       SkippingCapableNode* _skipping;
-      std::priority_queue<indri::api::ScoredExtentResult> _scores;
-      std::vector<indri::api::ScoredExtentResult> _finalScores;
+      indri::utility::TopResults _scores;
+      double _threshold;
       int _resultsRequested;
       std::string _name;
       EvaluatorNode::MResults _results;
@@ -41,7 +41,9 @@ namespace indri
         _belief(belief),
         _resultsRequested(resultsRequested),
         _name(name),
-        _skipping(0)
+        _skipping(0),
+        _scores(resultsRequested),
+        _threshold(-DBL_MAX)
       {
         if( indri::api::Parameters::instance().get( "skipping", 1 ) )
           _skipping = dynamic_cast<SkippingCapableNode*>(belief);
@@ -56,15 +58,23 @@ namespace indri
             _scores.push( documentScores[i] );
           }
 
-          while( int(_scores.size()) > _resultsRequested && _resultsRequested > 0 ) {
-            _scores.pop();
-            if( _skipping ) {
-              double worstScore = _scores.top().score;
-              _skipping->setThreshold( worstScore - DBL_MIN );
-            }
+          // the threshold only rises, and the skipping node only needs to hear when it does
+          if( _skipping && _scores.threshold() > _threshold ) {
+            _threshold = _scores.threshold();
+            _skipping->setThreshold( _threshold - DBL_MIN );
           }
         }
       }
+
+      /// Adds a result scored without calling evaluate, such as by the
+      /// inference network's impact-ordered evaluation.
+      void addResult( const indri::api::ScoredExtentResult& result ) {
+        _scores.push( result );
+      }
+
+      BeliefNode* getBelief() {
+        return _belief;
+      }
   
       lemur::api::DOCID_T nextCandidateDocument() {
         return _belief->nextCandidateDocument();
@@ -79,18 +89,9 @@ namespace indri
 
         if( !_scores.size() )
           return _results;
-    
-        // making a copy of the heap here so the method can be const
-        std::priority_queue<indri::api::ScoredExtentResult> heapCopy = _scores;
-        std::vector<indri::api::ScoredExtentResult>& scoreVec = _results["scores"];
 
         // puts scores into the vector in descending order
-        scoreVec.reserve( heapCopy.size() );
-        for( int i=heapCopy.size()-1; i>=0; i-- ) {
-          scoreVec.push_back( heapCopy.top() );
-          heapCopy.pop();
-        }
-
+        _scores.sorted( _results["scores"] );
         return _results;
       }
 
@@ -22,43 +22,102 @@
 #include "indri/File.hpp"
 #include "indri/InternalFileBuffer.hpp"
 #include "lemur/Exception.hpp"
+#include "lemur/lemur-compat.hpp"
 
 namespace indri
 {
   namespace file
   {
     
+    // If the file is mapped (see File::map), reads return pointers into
+    // the mapping, and no buffer is allocated or copied into.
     class SequentialReadBuffer {
     private:
       File& _file;
       UINT64 _position;
+      const char* _mapped;
+      UINT64 _mappedLength;
+      UINT64 _readAheadEnd;
+      UINT64 _hintedEnd;
+      size_t _window;
       InternalFileBuffer _current;
 
+      // hints the next window of a mapped file, starting at position
+      void _hint( UINT64 position ) {
+        UINT64 length = lemur_compat::min<UINT64>( _window, _readAheadEnd - position );
+        _file.willNeed( position, length );
+        _hintedEnd = position + length;
+      }
+
     public:
       SequentialReadBuffer( File& file ) :
         _file(file),
         _position(0),
-        _current( 1024*1024 )
+        _mapped( file.mapping() ),
+        _mappedLength( file.mappingLength() ),
+        _readAheadEnd(0),
+        _hintedEnd(0),
+        _window(1024*1024),
+        _current( _mapped ? 0 : 1024*1024 )
       {
       }
 
       SequentialReadBuffer( File& file, size_t length ) :
         _file(file),
         _position(0),
-        _current( length )
+        _mapped( file.mapping() ),
+        _mappedLength( file.mappingLength() ),
+        _readAheadEnd(0),
+        _hintedEnd(0),
+        _window(length),
+        _current( _mapped ? 0 : length )
       {
       }
 
       void cache( UINT64 position, size_t length ) {
+        if( _mapped )
+          return;
+
         _current.buffer.clear();
         _current.filePosition = position;
         _current.buffer.grow( length );
 
         size_t actual = _file.read( _current.buffer.write( length ), _position, length );
         _current.buffer.unwrite( length - actual );
+
+        // ask for the next buffer while this one is decoded
+        UINT64 next = _position + actual;
+
+        if( next < _readAheadEnd )
+          _file.willNeed( next, lemur_compat::min<UINT64>( length, _readAheadEnd - next ) );
+      }
+
+      // Hints that reading will start at position and go on sequentially
+      // until end.  The first buffer is requested now; each later one is
+      // requested when the buffer before it is read.  A mapped file has no
+      // buffers, so it is requested a buffer's length at a time instead,
+      // the next one once reading is halfway through the last; data that
+      // is skipped over is never requested.
+      void readAhead( UINT64 position, UINT64 end = MAX_UINT64 ) {
+        if( end <= position )
+          return;
+
+        _readAheadEnd = end;
+
+        if( _mapped ) {
+          _hint( position );
+          return;
+        }
+
+        _file.willNeed( position, lemur_compat::min<UINT64>( _current.buffer.size(), end - position ) );
       }
 
       size_t read( void* buffer, UINT64 position, size_t length ) {
+        if( _mapped ) {
+          seek(position);
+          return read( buffer, length );
+        }
+
         if( position >= _current.filePosition && (position + length) <= _current.filePosition + _current.buffer.position() ) {
           memcpy( buffer, _current.buffer.front() + position - _current.filePosition, length );
           return length;
@@ -75,6 +134,16 @@ namespace indri
 
       const void* peek( size_t length ) {
         const void* result = 0;
+
+        if( _mapped ) {
+          if( _position + length > _mappedLength )
+            LEMUR_THROW(LEMUR_IO_ERROR, "read fewer bytes than expected.");
+
+          if( _hintedEnd < _readAheadEnd && _position + length + _window/2 > _hintedEnd )
+            _hint( lemur_compat::max<UINT64>( _position, _hintedEnd ) );
+
+          return _mapped + _position;
+        }
       
         if( _position < _current.filePosition || (_position + length) > _current.filePosition + _current.buffer.position() ) {
           // data isn't in the current buffer
@@ -0,0 +1,101 @@
+/*==========================================================================
+ * Copyright (c) 2004 University of Massachusetts.  All Rights Reserved.
+ *
+ * Use of the Lemur Toolkit for Language Modeling and Information Retrieval
+ * is subject to the terms of the software license set forth in the LICENSE
+ * file included with this software, and also available at
+ * http://www.lemurproject.org/license.html
+ *
+ *==========================================================================
+ */
+
+//
+// StatisticsCache
+//
+// Stores the collection statistics computed for query expressions
+// by the statistics pass (ContextCounterNode queries), so that a
+// repeated term or phrase is not counted again.
+//
+// Like the ListCache, every StatisticsCache opened on the same
+// repository path shares one store.  Entries are found by the query
+// text of their raw and context expressions, and the least recently
+// used entries are evicted once they exceed the statisticsCacheMemory
+// parameter (in bytes).  An entry is only returned while the
+// repository has the same documents it had when it was counted.
+//
+
+#ifndef INDRI_STATISTICSCACHE_HPP
+#define INDRI_STATISTICSCACHE_HPP
+
+#include <string>
+#include "indri/QuerySpec.hpp"
+#include "lemur/IndexTypes.hpp"
+#include "indri/atomic.hpp"
+
+namespace indri
+{
+  namespace collection
+  {
+    class Repository;
+  }
+
+  namespace lang
+  {
+    class StatisticsCache {
+    public:
+      struct Counts {
+        double occurrences;
+        double contextSize;
+        int documentOccurrences;
+        int documentCount;
+      };
+
+      // repository contents that counts were computed from
+      struct Stamp {
+        indri::atomic::value_type documentAdds;
+        size_t indexCount;
+        UINT64 deletedCount;
+      };
+
+      struct Statistics {
+        UINT64 hits;
+        UINT64 misses;
+        UINT64 additions;
+        UINT64 evictions;
+        UINT64 entries;
+        UINT64 memory;
+        UINT64 maximumMemory;
+      };
+
+      // the entries shared by every StatisticsCache on one repository path
+      struct Store;
+
+    private:
+      indri::collection::Repository& _repository;
+      Store* _store;
+
+      static std::string _key( indri::lang::ContextCounterNode* counter );
+
+    public:
+      StatisticsCache( indri::collection::Repository& repository );
+      ~StatisticsCache();
+
+      /// Records the current contents of the repository.  Take a stamp
+      /// before evaluating counts, then pass it to add.
+      Stamp stamp();
+
+      /// Adds the counts for this expression.  They are discarded if the
+      /// repository has changed since the stamp was taken.
+      void add( indri::lang::ContextCounterNode* counter, const Counts& counts, const Stamp& stamp );
+
+      /// Finds the counts for this expression.
+      /// @return true if counts computed from the current repository contents were found
+      bool find( indri::lang::ContextCounterNode* counter, Counts& counts );
+
+      /// @return hit, miss and memory counters for the shared store
+      Statistics statistics();
+    };
+  }
+}
+
+#endif // INDRI_STATISTICSCACHE_HPP
@@ -39,6 +39,11 @@ namespace indri
       double _maximumBackgroundScore;
       double _maximumScore;
       std::string _name;
+
+      // cached bound for the block of the list that was asked about last
+      lemur::api::DOCID_T _blockFirstDocument;
+      lemur::api::DOCID_T _blockLastDocument;
+      double _blockMaximumScore;
       int _listID;
 
       indri::utility::greedy_vector<indri::index::DocListIterator::TopDocument> _emptyTopdocs;
@@ -56,11 +61,30 @@ namespace indri
       void indexChanged( indri::index::Index& index );
       double maximumBackgroundScore();
       double maximumScore();
+      double blockMaximumScore( lemur::api::DOCID_T documentID, lemur::api::DOCID_T& lastDocument );
       const indri::utility::greedy_vector<indri::api::ScoredExtentResult>& score( lemur::api::DOCID_T documentID, indri::index::Extent &extent, int documentLength );
       void annotate( class Annotator& annotator, lemur::api::DOCID_T documentID, indri::index::Extent &extent );
       bool hasMatch( lemur::api::DOCID_T documentID );
       const indri::utility::greedy_vector<bool>& hasMatch( lemur::api::DOCID_T documentID, const indri::utility::greedy_vector<indri::index::Extent>& extents );
       const std::string& getName() const;
+
+      /// @return the number of times the term occurs in documentID; the list
+      /// must not have moved past documentID
+      int count( lemur::api::DOCID_T documentID ) {
+        if( _list && !_list->finished() && _list->currentDocument() == documentID )
+          return _list->currentCount();
+
+        return 0;
+      }
+
+      indri::query::TermScoreFunction& scoreFunction() {
+        return _function;
+      }
+
+      /// @return the network's index for this term's document list
+      int listID() const {
+        return _listID;
+      }
     };
   }
 }
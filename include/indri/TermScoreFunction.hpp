@@ -33,6 +33,18 @@ namespace indri
     public:
       virtual double scoreOccurrence( double occurrences, int contextLength ) = 0;
       virtual double scoreOccurrence( double occurrences, int contextLength, double documentOccurrences, int documentLength ) = 0;
+
+      /// Rules that can be written as
+      ///   scoreOccurrence( occurrences, contextLength ) = occurrenceScore( occurrences ) - log( contextLength + lengthOffset )
+      /// return true and set lengthOffset.  A node scoring several terms in the
+      /// same document can then take the log of the length once for all terms
+      /// with the same offset.  The split score differs from scoreOccurrence by
+      /// a few units in the last place, well under 1e-12.
+      virtual bool splitsLength( double& lengthOffset ) { return false; }
+
+      /// @return the part of the score that depends only on the occurrences,
+      /// for rules where splitsLength returns true
+      virtual double occurrenceScore( double occurrences ) { return 0; }
     };
   }
 }
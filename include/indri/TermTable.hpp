@@ -0,0 +1,116 @@
+/*==========================================================================
+ * Copyright (c) 2004 University of Massachusetts.  All Rights Reserved.
+ *
+ * Use of the Lemur Toolkit for Language Modeling and Information Retrieval
+ * is subject to the terms of the software license set forth in the LICENSE
+ * file included with this software, and also available at
+ * http://www.lemurproject.org/license.html
+ *
+ *==========================================================================
+ */
+
+//
+// TermTable
+//
+// The vocabulary of a disk index in a form that never changes once
+// written, so that any number of threads can look terms up without a
+// lock.  IndexWriter writes it after the frequent and infrequent term
+// trees, which are still written and read by older code.
+//
+// File format:
+//      magic (4b), version (4b)
+//      termCount (8b)
+//      bucketCount (8b)  (a power of two)
+//      recordsLength (8b)
+//      records: for each termID, the RVLCompressed DiskTermData with
+//               its string and offsets, as stored in the ID trees,
+//               padded at the end to a multiple of 8 bytes
+//      offsets: termCount+1 record offsets (8b each), by termID-1
+//      buckets: bucketCount entries of
+//               termID (4b)  (0 for an empty bucket)
+//               check (4b)   (high 32 bits of the term's hash)
+//
+// A term string is found by hashing it and probing the buckets
+// linearly from its hash until an empty bucket is reached.
+//
+
+#ifndef INDRI_TERMTABLE_HPP
+#define INDRI_TERMTABLE_HPP
+
+#include "indri/File.hpp"
+#include "indri/SequentialWriteBuffer.hpp"
+#include "indri/DiskTermData.hpp"
+#include <vector>
+#include <string>
+
+namespace indri
+{
+  namespace index
+  {
+    class TermTable {
+    public:
+      enum {
+        MAGIC = 0x31545449, // "ITT1"
+        VERSION = 1,
+        HEADER_SIZE = 32
+      };
+
+      struct Bucket {
+        UINT32 termID;
+        UINT32 check;
+      };
+
+      /// FNV-1a hash of a term string
+      static UINT64 hash( const char* term );
+    };
+
+    class TermTableWriter {
+    private:
+      indri::file::File _file;
+      indri::file::SequentialWriteBuffer* _output;
+      std::vector<UINT64> _offsets;
+      std::vector<UINT64> _hashes;
+
+    public:
+      TermTableWriter();
+      ~TermTableWriter();
+
+      void create( const std::string& path );
+      /// Adds the next term; terms must be added in termID order, starting at 1.
+      /// @param record the term's compressed DiskTermData, with its string and offsets
+      void add( lemur::api::TERMID_T termID, const char* term, const char* record, int length );
+      void close();
+    };
+
+    class TermTableReader {
+    private:
+      indri::file::File _file;
+      char* _buffer;
+      int _fieldCount;
+
+      UINT64 _termCount;
+      UINT64 _bucketCount;
+      const char* _records;
+      const UINT64* _offsets;
+      const TermTable::Bucket* _buckets;
+
+      indri::index::DiskTermData* _decode( lemur::api::TERMID_T termID ) const;
+
+    public:
+      TermTableReader();
+      ~TermTableReader();
+
+      /// Opens the table, mapping it into memory if possible and reading it whole if not.
+      void openRead( const std::string& path, int fieldCount );
+      void close();
+      bool isOpen() const;
+
+      /// @return the term's data, to be freed with disktermdata_delete, or 0 if there is no such term
+      indri::index::DiskTermData* get( lemur::api::TERMID_T termID ) const;
+      /// @return the term's data, to be freed with disktermdata_delete, or 0 if there is no such term
+      indri::index::DiskTermData* get( const char* term ) const;
+    };
+  }
+}
+
+#endif // INDRI_TERMTABLE_HPP
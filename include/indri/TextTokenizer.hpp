@@ -35,13 +35,13 @@ namespace indri {
     class TextTokenizer : public Tokenizer {
 
     public:
-      TextTokenizer( bool tokenize_markup = true, bool tokenize_entire_words = true ) : _handler(0) {
+      TextTokenizer( bool tokenize_markup = true, bool tokenize_entire_words = true ) : _handler(0), _scanner(0) {
 
         _tokenize_markup = tokenize_markup;
         _tokenize_entire_words = tokenize_entire_words;
       }
 
-      ~TextTokenizer() {}
+      ~TextTokenizer();
   
       TokenizedDocument* tokenize( UnparsedDocument* document );
 
@@ -63,6 +63,13 @@ namespace indri {
       ObjectHandler<TokenizedDocument>* _handler;
       TokenizedDocument _document;
 
+      // this tokenizer's flex scanner (a yyscan_t), so tokenizers can run on separate threads
+      void* _scanner;
+      long _bytePosition;
+      // the text and length of the current match
+      char* _token;
+      int _tokenLength;
+
       void writeToken( char* token, int token_len, int extent_begin, 
                        int extent_end );
     };
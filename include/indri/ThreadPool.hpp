@@ -0,0 +1,81 @@
+/*==========================================================================
+ * Copyright (c) 2005 University of Massachusetts.  All Rights Reserved.
+ *
+ * Use of the Lemur Toolkit for Language Modeling and Information Retrieval
+ * is subject to the terms of the software license set forth in the LICENSE
+ * file included with this software, and also available at
+ * http://www.lemurproject.org/license.html
+ *
+ *==========================================================================
+ */
+
+//
+// ThreadPool
+//
+// A fixed set of worker threads that run batches of tasks, or single
+// tasks that nobody waits for.
+//
+
+#ifndef INDRI_THREADPOOL_HPP
+#define INDRI_THREADPOOL_HPP
+
+#include <vector>
+#include <deque>
+#include "indri/Thread.hpp"
+#include "indri/Mutex.hpp"
+#include "indri/ConditionVariable.hpp"
+
+namespace indri
+{
+  namespace thread
+  {
+    class ThreadPool {
+    public:
+      /// A unit of work for the pool.
+      class Task {
+      public:
+        virtual ~Task() {};
+        virtual void run() = 0;
+      };
+
+    private:
+      struct batch_type;
+
+      struct queue_entry {
+        Task* task;
+        batch_type* batch;
+      };
+
+      std::vector<Thread*> _threads;
+      std::deque<queue_entry> _queue;
+      Mutex _lock;
+      ConditionVariable _workAvailable;
+      ConditionVariable _workFinished;
+      bool _quit;
+
+      static void _start( void* pointer );
+      void _run();
+
+    public:
+      /// Starts threadCount worker threads.
+      ThreadPool( int threadCount );
+      /// Waits for queued work to finish, then stops the worker threads.
+      ~ThreadPool();
+
+      /// Runs every task in the batch on the pool and returns once they have all finished.
+      /// Any number of threads may call execute at once.  If a task throws, the
+      /// first exception is rethrown here as a lemur::api::Exception after the
+      /// batch completes.
+      void execute( const std::vector<Task*>& tasks );
+
+      /// Queues one task and returns at once.  The pool deletes the task after
+      /// it has run; the task must report its own errors, since nothing waits for it.
+      void post( Task* task );
+
+      /// @return the number of worker threads
+      int size() const;
+    };
+  }
+}
+
+#endif // INDRI_THREADPOOL_HPP
@@ -0,0 +1,148 @@
+/*==========================================================================
+ * Copyright (c) 2004 University of Massachusetts.  All Rights Reserved.
+ *
+ * Use of the Lemur Toolkit for Language Modeling and Information Retrieval
+ * is subject to the terms of the software license set forth in the LICENSE
+ * file included with this software, and also available at
+ * http://www.lemurproject.org/license.html
+ *
+ *==========================================================================
+ */
+
+//
+// TopResults
+//
+// Keeps the best results pushed into it, up to a fixed capacity.  The
+// heap holds packed (score, document, slot) entries, with the worst kept
+// result at the front; the results themselves stay in fixed slots, so a
+// push moves 16 byte entries and copies at most one result.  Results are
+// ranked as ScoredExtentResult::score_greater ranks them.
+//
+
+#ifndef INDRI_TOPRESULTS_HPP
+#define INDRI_TOPRESULTS_HPP
+
+#include "indri/ScoredExtentResult.hpp"
+#include <vector>
+#include <algorithm>
+#include <float.h>
+
+namespace indri
+{
+  namespace utility
+  {
+    class TopResults {
+    private:
+      struct entry {
+        double score;
+        lemur::api::DOCID_T document;
+        UINT32 slot;
+      };
+
+      // true if one ranks before two; as a heap comparison, puts the worst entry in front
+      struct entry_better {
+        const std::vector<indri::api::ScoredExtentResult>* results;
+
+        entry_better( const std::vector<indri::api::ScoredExtentResult>* r ) : results(r) {}
+
+        bool operator() ( const entry& one, const entry& two ) const {
+          if( one.score != two.score )
+            return one.score > two.score;
+
+          if( one.document != two.document )
+            return one.document > two.document;
+
+          return indri::api::ScoredExtentResult::score_greater()( (*results)[one.slot], (*results)[two.slot] );
+        }
+      };
+
+      size_t _capacity;
+      std::vector<entry> _heap;
+      std::vector<indri::api::ScoredExtentResult> _results;
+      mutable std::vector<entry> _sorted;
+
+    public:
+      /// Keeps the best capacity results; a capacity of zero or less keeps them all.
+      TopResults( int capacity = 0 ) {
+        _capacity = capacity > 0 ? capacity : 0;
+
+        if( _capacity ) {
+          _heap.reserve( _capacity );
+          _results.reserve( _capacity );
+        }
+      }
+
+      void clear() {
+        _heap.clear();
+        _results.clear();
+      }
+
+      size_t size() const {
+        return _heap.size();
+      }
+
+      bool full() const {
+        return _capacity && _heap.size() == _capacity;
+      }
+
+      /// The score a result must beat to be kept, or -DBL_MAX while there is room.
+      double threshold() const {
+        if( !full() )
+          return -DBL_MAX;
+
+        return _heap.front().score;
+      }
+
+      /// Adds result if it ranks among the best kept so far; returns true if it was kept.
+      bool push( const indri::api::ScoredExtentResult& result ) {
+        entry e;
+        e.score = result.score;
+        e.document = result.document;
+
+        if( !_capacity ) {
+          e.slot = UINT32(_results.size());
+          _results.push_back( result );
+          _heap.push_back( e );
+          return true;
+        }
+
+        entry_better better( &_results );
+
+        if( _heap.size() < _capacity ) {
+          e.slot = UINT32(_results.size());
+          _results.push_back( result );
+          _heap.push_back( e );
+          std::push_heap( _heap.begin(), _heap.end(), better );
+          return true;
+        }
+
+        // cheap rejection on score alone, before looking at the slot of the worst entry
+        if( e.score < _heap.front().score )
+          return false;
+
+        e.slot = _heap.front().slot;
+
+        if( !indri::api::ScoredExtentResult::score_greater()( result, _results[e.slot] ) )
+          return false;
+
+        std::pop_heap( _heap.begin(), _heap.end(), better );
+        _results[e.slot] = result;
+        _heap.back() = e;
+        std::push_heap( _heap.begin(), _heap.end(), better );
+        return true;
+      }
+
+      /// Replaces the contents of output with the kept results, best first.
+      void sorted( std::vector<indri::api::ScoredExtentResult>& output ) const {
+        _sorted.assign( _heap.begin(), _heap.end() );
+        std::sort( _sorted.begin(), _sorted.end(), entry_better( &_results ) );
+
+        output.resize( _sorted.size() );
+        for( size_t i=0; i<_sorted.size(); i++ )
+          output[i] = _results[ _sorted[i].slot ];
+      }
+    };
+  }
+}
+
+#endif // INDRI_TOPRESULTS_HPP
@@ -56,6 +56,12 @@ namespace indri
       std::string _name;
       bool _childrenAlreadySorted;
 
+      // reused by prepare for each document
+      indri::utility::greedy_vector<term_position> _allPositions;
+      indri::utility::greedy_vector<int> _lastPositions;
+      indri::utility::greedy_vector<const indri::utility::greedy_vector<indri::index::Extent>*> _childExtents;
+      indri::utility::greedy_vector<size_t> _mergeCursors;
+
     public:
       UnorderedWindowNode( const std::string& name, std::vector<ListIteratorNode*>& children );
       UnorderedWindowNode( const std::string& name, std::vector<ListIteratorNode*>& children, int windowSize );
@@ -45,13 +45,22 @@ namespace indri
         };
 
         BeliefNode* node;
+        class TermFrequencyBeliefNode* termNode;
         double weight;
         double maximumWeightedScore;
         double backgroundWeightedScore;
+
+        // set when termNode's score function splits off the length
+        // (see TermScoreFunction::splitsLength)
+        bool splitsLength;
+        double lengthOffset;
       };
 
       std::vector<child_type> _children;
       indri::utility::greedy_vector<indri::api::ScoredExtentResult> _scores;
+      // per-document scratch space for score()
+      indri::utility::greedy_vector<double> _termScores;
+      indri::utility::greedy_vector< indri::utility::greedy_vector<indri::api::ScoredExtentResult> > _childScores;
       indri::utility::greedy_vector<bool> _matches;
       std::string _name;
 
@@ -61,11 +70,14 @@ namespace indri
       double _threshold;
       double _recomputeThreshold;
       int _quorumIndex;
+      bool _blockMax;
       void _computeQuorum();
       double _computeMaxScore( unsigned int start );
+      double _computeBlockMaxScore( lemur::api::DOCID_T documentID, lemur::api::DOCID_T& lastDocument );
+      lemur::api::DOCID_T _skipBlocks( lemur::api::DOCID_T candidate );
 
     public:
-      WeightedAndNode( const std::string& name ) : _name(name), _threshold(-DBL_MAX), _quorumIndex(0), _recomputeThreshold(-DBL_MAX) {}
+      WeightedAndNode( const std::string& name ) : _name(name), _threshold(-DBL_MAX), _quorumIndex(0), _recomputeThreshold(-DBL_MAX), _blockMax(false) {}
 
       void addChild( double weight, BeliefNode* node );
       void doneAddingChildren();
@@ -76,6 +88,12 @@ namespace indri
       // SkippingCapableNode
       void setThreshold( double threshold );
 
+      /// If every child is a term whose score function splits off the
+      /// length (a flat #combine or #weight of terms), fills in the terms
+      /// and their weights divided by the sum of absolute weights.
+      /// @return true if every child is such a term
+      bool termChildren( std::vector<class TermFrequencyBeliefNode*>& terms, std::vector<double>& weights );
+
       // InferenceNetworkNode interface
       lemur::api::DOCID_T nextCandidateDocument();
       void indexChanged( indri::index::Index& index );
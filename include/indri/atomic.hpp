@@ -40,10 +40,16 @@ namespace indri {
     inline void decrement( value_type& variable ) {
       ::InterlockedDecrement( &variable );
     }
+
+    /// @return true if the variable reached zero, for the last holder of a reference
+    inline bool decrement_and_test( value_type& variable ) {
+      return ::InterlockedDecrement( &variable ) == 0;
+    }
 #else
     // GCC 3.4+ declares these in the __gnu_cxx namespace, 3.3- does not.
     #if P_NEEDS_GNU_CXX_NAMESPACE
     #define __atomic_add __gnu_cxx::__atomic_add
+    #define __exchange_and_add __gnu_cxx::__exchange_and_add
     #endif
     typedef _Atomic_word value_type;
 
@@ -54,6 +60,11 @@ namespace indri {
     inline void decrement( value_type& variable ) {
       __atomic_add( &variable, -1 );
     }
+
+    /// @return true if the variable reached zero, for the last holder of a reference
+    inline bool decrement_and_test( value_type& variable ) {
+      return __exchange_and_add( &variable, -1 ) == 1;
+    }
 #endif
   }
 }
@@ -32,6 +32,15 @@ as <tt>-index=/path/to/repository</tt> on the command line.
 <dd> an integer value specifying the port number to use.Specified as
 &lt;port&gt;number&lt;/port&gt; in the parameter file and as
 <tt>-port=number</tt> on the command line. </dd> 
+<dt>requestThreads</dt>
+<dd> an integer value specifying the number of threads, shared by all
+connections, that process binary requests.  A client using the binary
+protocol may send many requests on one connection without waiting for
+replies, and they are processed concurrently.  XML requests are always
+processed one at a time by the thread of their connection.  Specified as
+&lt;requestThreads&gt;number&lt;/requestThreads&gt; in the parameter file
+and as <tt>-requestThreads=number</tt> on the command line.  The default is
+4; 0 processes binary requests on the thread of their connection too.</dd>
 </dl>
  */
 
@@ -45,6 +54,7 @@ as <tt>-index=/path/to/repository</tt> on the command line.
 #include "lemur/Exception.hpp"
 #include "indri/Mutex.hpp"
 #include "indri/ScopedLock.hpp"
+#include "indri/ThreadPool.hpp"
 #include <time.h>
 
 //
@@ -83,6 +93,7 @@ struct connection_info {
   indri::thread::Thread* thread;
   indri::net::NetworkStream* stream;
   indri::server::LocalQueryServer* server;
+  indri::thread::ThreadPool* pool;
 };
 
 //
@@ -93,7 +104,7 @@ void connection_thread( void* c ) {
   connection_info* info = (connection_info*) c;
 
   indri::net::NetworkMessageStream messageStream( info->stream );
-  indri::net::NetworkServerStub stub( info->server, &messageStream );
+  indri::net::NetworkServerStub stub( info->server, &messageStream, info->pool );
   std::string peer = info->stream->peer();
 
   log_message( peer.c_str(), "connected" );
@@ -112,11 +123,12 @@ void connection_thread( void* c ) {
 // build_connection
 //
 
-connection_info* build_connection( indri::net::NetworkStream* stream, indri::server::LocalQueryServer* server ) {
+connection_info* build_connection( indri::net::NetworkStream* stream, indri::server::LocalQueryServer* server, indri::thread::ThreadPool* pool ) {
   connection_info* info = new connection_info;
   
   info->stream = stream;
   info->server = server;
+  info->pool = pool;
   info->active = true;
 
   indri::thread::Thread* thread = new indri::thread::Thread( connection_thread, info );
@@ -182,6 +194,13 @@ int main( int argc, char* argv[] ) {
     repository->openRead( repositoryPath, &parameters );
     indri::server::LocalQueryServer server( *repository );
 
+    // binary requests of every connection are processed here
+    int requestThreads = parameters.get( "requestThreads", 4 );
+    indri::thread::ThreadPool* pool = 0;
+
+    if( requestThreads > 0 )
+      pool = new indri::thread::ThreadPool( requestThreads );
+
     // open for business
     listener.listen( port );
     indri::net::NetworkStream* connection;
@@ -191,13 +210,14 @@ int main( int argc, char* argv[] ) {
     // this handles the threading issue by only allowing one
     // connection at a time; for our current uses this is fine
     while( (connection = listener.accept()) ) {
-      connection_info* info = build_connection( connection, &server );
+      connection_info* info = build_connection( connection, &server, pool );
       connections.push_back( info );
 
       clean_connections( connections );
     }
 
     wait_connections( connections );
+    delete pool;
     repository->close();
     delete repository;
     return 0;
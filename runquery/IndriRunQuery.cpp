@@ -38,6 +38,16 @@ include an optional port number to connect to, using the form
 <tt>hostname:portnum</tt>. This element
 can be specified multiple times to combine servers.
 </dd>
+<dt>binaryProtocol</dt>
+<dd>
+<i>(optional)</i> <tt>false</tt> to send servers only the XML protocol.  By
+default servers are sent requests in a compact binary form, with an id on
+each request so that several can be in flight on one connection and be
+answered concurrently; servers too old to accept them are sent XML instead.
+Specified as &lt;binaryProtocol&gt;false&lt;/binaryProtocol&gt; in the
+parameter file and as <tt>-binaryProtocol=false</tt> on the command line.
+The default is true.
+</dd>
 <dt>count</dt>
 <dd>an integer value specifying the maximum number of results to
 return for a given query. Specified as
@@ -127,6 +137,129 @@ be generated for a synonym list for this query or set of queries. If this limit
 is reached for a wildcard term, an exception will be thrown. If this parameter
 is not specified, a default of 100 will be used.
 </dd>
+<dt>queryThreads</dt>
+<dd>
+<i>(optional)</i> An integer specifying the number of threads used to evaluate
+a single ranked query.  When greater than one, the documents of a local
+repository are split into ranges that are scored in parallel, and the best
+results from each range are merged.  Specified as
+&lt;queryThreads&gt;number&lt;/queryThreads&gt; in the parameter file and
+as <tt>-queryThreads=number</tt> on the command line.  The default is 1.
+</dd>
+<dt>mappedIndexes</dt>
+<dd>
+<i>(optional)</i> <tt>true</tt> to map the inverted, direct and field files of
+each index into memory.  Lists are then decoded where they lie in the
+operating system's page cache, instead of being copied into a buffer for
+every query term, and concurrent queries share one copy of each list.
+Specified as &lt;mappedIndexes&gt;true&lt;/mappedIndexes&gt; in the parameter
+file and as <tt>-mappedIndexes=true</tt> on the command line.  The default is
+false.
+</dd>
+<dt>postingCacheMemory</dt>
+<dd>
+<i>(optional)</i> Bytes of memory used to keep the decoded document numbers
+and counts of inverted list blocks, shared by every query the process runs,
+so that queries over the same frequent terms do not decode the same blocks
+again.  The least recently used blocks are dropped when the cache is full.
+Specified as &lt;postingCacheMemory&gt;number&lt;/postingCacheMemory&gt; in
+the parameter file and as <tt>-postingCacheMemory=number</tt> on the command
+line.  The default is 67108864 (64MB); 0 turns the cache off.
+</dd>
+<dt>postingCacheMinimumDocuments</dt>
+<dd>
+<i>(optional)</i> Only the lists of terms found in at least this many
+documents are kept in the posting cache.  Specified as
+&lt;postingCacheMinimumDocuments&gt;number&lt;/postingCacheMinimumDocuments&gt;
+in the parameter file and as <tt>-postingCacheMinimumDocuments=number</tt> on
+the command line.  The default is 1024.
+</dd>
+<dt>queryBudget</dt>
+<dd>
+<i>(optional)</i> Limits on the work done to score each ranked query:
+<tt>postings</tt>, the number of inverted list entries decoded;
+<tt>documents</tt>, the number of candidate documents scored; and
+<tt>milliseconds</tt>, the time spent scoring.  A query that reaches a limit
+stops and returns the best documents found so far.  A limit of 0 is not
+enforced.  Specified as
+&lt;queryBudget&gt;&lt;documents&gt;number&lt;/documents&gt;&lt;/queryBudget&gt;
+in the parameter file and as <tt>-queryBudget.documents=number</tt> on the
+command line.  An IndriDaemon started with these parameters applies them to
+every query it serves.  By default queries are not limited.
+</dd>
+<dt>impactEvaluation</dt>
+<dd>
+<i>(optional)</i> <tt>true</tt> to score queries that are a flat #combine or
+#weight of terms, using Dirichlet smoothing, from the impact-ordered lists
+stored with each index (see the <tt>impactLists</tt> parameter of
+IndriBuildIndex).  Each term's documents are read a segment of equal term
+counts at a time, largest contributions first, instead of scoring one
+document at a time.  Indexes without impact lists, such as documents not yet
+written to disk, are scored as before.  Specified as
+&lt;impactEvaluation&gt;true&lt;/impactEvaluation&gt; in the parameter file and
+as <tt>-impactEvaluation=true</tt> on the command line.  The default is true.
+</dd>
+<dt>impactBudget</dt>
+<dd>
+<i>(optional)</i> An integer limiting the number of postings read from each
+index by impact-ordered evaluation.  No new segment is started once the
+limit is reached, so the ranking is approximate and favors the documents
+with the largest term contributions.  Specified as
+&lt;impactBudget&gt;number&lt;/impactBudget&gt; in the parameter file and
+as <tt>-impactBudget=number</tt> on the command line.  The default is 0,
+which reads every posting and gives the same ranking as document-at-a-time
+evaluation.
+</dd>
+<dt>impactMemory</dt>
+<dd>
+<i>(optional)</i> An integer specifying the number of bytes impact-ordered
+evaluation may use for the partial scores of one index.  Scores are kept
+for blocks of 65536 documents, allocated only once a document in the block
+is reached.  A query that reaches more blocks than fit is scored a document
+at a time instead.  Specified as
+&lt;impactMemory&gt;number&lt;/impactMemory&gt; in the parameter file and
+as <tt>-impactMemory=number</tt> on the command line.  The default is
+67108864 (64MB).
+</dd>
+<dt>listCacheMemory</dt>
+<dd>
+<i>(optional)</i> An integer specifying the number of bytes used to keep the
+per-document counts of complex expressions, such as #od and #uw windows, so that
+later queries containing the same expression do not evaluate it again.  The
+cache is shared by all queries on the same repository.  Specified as
+&lt;listCacheMemory&gt;bytes&lt;/listCacheMemory&gt; in the parameter file and
+as <tt>-listCacheMemory=bytes</tt> on the command line.  The default is 67108864;
+0 turns the cache off.
+</dd>
+<dt>statisticsCacheMemory</dt>
+<dd>
+<i>(optional)</i> An integer specifying the number of bytes used to keep the
+collection counts of query terms and expressions, so that later queries
+containing the same term or expression skip counting it before scoring.
+Counts are discarded whenever documents are added to or deleted from the
+repository.  Specified as
+&lt;statisticsCacheMemory&gt;bytes&lt;/statisticsCacheMemory&gt; in the
+parameter file and as <tt>-statisticsCacheMemory=bytes</tt> on the command
+line.  The default is 8388608; 0 turns the cache off.
+</dd>
+<dt>collectionShards</dt>
+<dd>
+<i>(optional)</i> An integer specifying the number of lookup handles opened on
+the document collection of a read-only repository.  Threads fetching documents
+or metadata use different handles, so they do not wait on each other.
+Specified as &lt;collectionShards&gt;number&lt;/collectionShards&gt; in the
+parameter file and as <tt>-collectionShards=number</tt> on the command line.
+The default is 8.
+</dd>
+<dt>collectionCacheMemory</dt>
+<dd>
+<i>(optional)</i> An integer specifying the number of bytes used to keep
+recently decompressed documents, so that printing metadata, document text or
+snippets for the same documents again does not read and inflate them from
+disk.  Specified as &lt;collectionCacheMemory&gt;bytes&lt;/collectionCacheMemory&gt;
+in the parameter file and as <tt>-collectionCacheMemory=bytes</tt> on the
+command line.  The default is 0, which turns the cache off.
+</dd>
 </dl>
 
 <H4>Baseline (non-LM) retrieval</H4>
@@ -552,6 +685,12 @@ public:
     if( copy_parameters_to_string_vector( smoothingRules, _parameters, "rule" ) )
       _environment.setScoringRules( smoothingRules );
 
+    if( _parameters.exists( "mappedIndexes" ) )
+      _environment.setMappedIndexes( _parameters.get( "mappedIndexes", false ) );
+
+    if( _parameters.exists( "binaryProtocol" ) )
+      _environment.setBinaryProtocol( _parameters.get( "binaryProtocol", true ) );
+
    if( _parameters.exists( "index" ) ) {
       indri::api::Parameters indexes = _parameters["index"];
 
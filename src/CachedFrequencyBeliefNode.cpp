@@ -21,13 +21,34 @@ indri::infnet::CachedFrequencyBeliefNode::CachedFrequencyBeliefNode( const std::
   _list(list),
   _function(scoreFunction),
   _maximumBackgroundScore(maximumBackgroundScore),
-  _maximumScore(maximumScore)
+  _maximumScore(maximumScore),
+  _lastDocument(0)
 {
   _iter = _list->entries.begin();
 }
 
+//
+// _moveTo
+//
+// Nothing moves this node between documents, so it catches up
+// with the document being looked at whenever it is asked about one.
+//
+
+void indri::infnet::CachedFrequencyBeliefNode::_moveTo( lemur::api::DOCID_T documentID ) {
+  while( _iter < _list->entries.end() && _iter->document < documentID )
+    _iter++;
+
+  _lastDocument = documentID;
+}
+
 lemur::api::DOCID_T indri::infnet::CachedFrequencyBeliefNode::nextCandidateDocument() {
-  return _iter < _list->entries.end() ? _iter->document : MAX_INT32;
+  indri::utility::greedy_vector<indri::index::DocumentContextCount>::iterator iter = _iter;
+
+  // the last document asked about has already been evaluated
+  if( iter < _list->entries.end() && iter->document <= _lastDocument )
+    iter++;
+
+  return iter < _list->entries.end() ? iter->document : MAX_INT32;
 }
 
 double indri::infnet::CachedFrequencyBeliefNode::maximumBackgroundScore() {
@@ -38,34 +59,30 @@ double indri::infnet::CachedFrequencyBeliefNode::maximumScore() {
   return _maximumScore;
 }
 
-const indri::utility::greedy_vector<indri::api::ScoredExtentResult>& indri::infnet::CachedFrequencyBeliefNode::score( lemur::api::DOCID_T documentID, int begin, int end, int documentLength ) {
-  assert( begin == 0 && end == documentLength ); // FrequencyListCopier ensures this condition
-  const indri::index::DocumentContextCount* entry = _iter < _list->entries.end() ? _iter : 0;
+const indri::utility::greedy_vector<indri::api::ScoredExtentResult>& indri::infnet::CachedFrequencyBeliefNode::score( lemur::api::DOCID_T documentID, indri::index::Extent &extent, int documentLength ) {
+  assert( extent.begin == 0 && extent.end == documentLength ); // FrequencyListCopier ensures this condition
+  _moveTo( documentID );
   _extents.clear();
 
-  int count = 0;
-  int contextSize = 0;
-
-  if( entry && entry->document == documentID ) {
-    count = entry->count;
-    contextSize = entry->contextSize;
+  double count = 0;
+  int contextSize = extent.end - extent.begin;
 
-    // advance this pointer so we're looking at the next document
-    _iter++;
-  } else {
-    count = 0;
-    contextSize = documentLength;
-  }
+  if( _iter < _list->entries.end() && _iter->document == documentID )
+    count = _iter->count;
 
-  double score = _function.scoreOccurrence( count, contextSize );
+  // score the same way a ListBeliefNode scores a context-free list
+  double score = _function.scoreOccurrence( count, contextSize, count, documentLength );
 
-  assert( score <= _maximumScore );
-  _extents.push_back( indri::api::ScoredExtentResult( score, documentID, begin, end ) );
+  indri::api::ScoredExtentResult result(extent);
+  result.score=score;
+  result.document=documentID;
+  _extents.push_back( result );
 
   return _extents;
 }
 
 bool indri::infnet::CachedFrequencyBeliefNode::hasMatch( lemur::api::DOCID_T documentID ) {
+  _moveTo( documentID );
   return ( _iter < _list->entries.end() && _iter->document == documentID );
 }
 
@@ -79,12 +96,10 @@ const std::string& indri::infnet::CachedFrequencyBeliefNode::getName() const {
   return _name;
 }
 
-void indri::infnet::CachedFrequencyBeliefNode::annotate( indri::infnet::Annotator& annotator, lemur::api::DOCID_T documentID, int begin, int end ) {
+void indri::infnet::CachedFrequencyBeliefNode::annotate( indri::infnet::Annotator& annotator, lemur::api::DOCID_T documentID, indri::index::Extent &extent ) {
   // can't annotate -- don't have position info
 }
 
 void indri::infnet::CachedFrequencyBeliefNode::indexChanged( indri::index::Index& index ) {
   // do nothing
 }
-
-
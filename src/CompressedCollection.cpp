@@ -37,6 +37,7 @@ const char POSITIONS_KEY[] = "#POSITIONS#";
 const char TEXT_KEY[] = "#TEXT#";
 const char CONTENT_KEY[] = "#CONTENT#";
 const char CONTENTLENGTH_KEY[] = "#CONTENTLENGTH#";
+const int SHARD_CACHE_SIZE = 256*1024;
 
 //
 // zlib_alloc
@@ -301,7 +302,11 @@ void indri::collection::CompressedCollection::_readPositions( indri::api::Parsed
 // CompressedCollection
 //
 
-indri::collection::CompressedCollection::CompressedCollection() {
+indri::collection::CompressedCollection::CompressedCollection() :
+  _storageReadLock( _storageLock ),
+  _storageWriteLock( _storageLock ),
+  _cache( 1024 )
+{
   _stream = new z_stream_s;
   _stream->zalloc = zlib_alloc;
   _stream->zfree = zlib_free;
@@ -312,6 +317,9 @@ indri::collection::CompressedCollection::CompressedCollection() {
 
   _strings = string_set_create();
   _output = 0;
+
+  memset( &_cacheStatistics, 0, sizeof(CacheStatistics) );
+  _cacheStatistics.maximumMemory = indri::api::Parameters::instance().get( "collectionCacheMemory", INT64(0) );
 }
 
 //
@@ -395,9 +403,11 @@ void indri::collection::CompressedCollection::create( const std::string& fileNam
   }
 
   manifest.writeFile( manifestName );
+  _openShards( fileName, 1 );
 }
 
 void indri::collection::CompressedCollection::reopen( const std::string& fileName ) {
+  indri::thread::ScopedLock storageLock( _storageWriteLock );
   indri::thread::ScopedLock l( _lock );
   close();
   open(fileName);
@@ -457,6 +467,7 @@ void indri::collection::CompressedCollection::open( const std::string& fileName
     }
   }
 
+  _openShards( fileName, 1 );
 }
 
 //
@@ -508,6 +519,112 @@ void indri::collection::CompressedCollection::openRead( const std::string& fileN
       _reverseLookups.insert( key, metalookup );
     }
   }
+
+  // extra lookup handles let threads find documents without waiting on each other
+  int shards = indri::api::Parameters::instance().get( "collectionShards", 8 );
+  _openShards( fileName, shards );
+}
+
+//
+// open_shard_lookups
+//
+// Opens a read-only handle on each of the named lookup files.
+//
+
+static void open_shard_lookups( const std::string& fileName,
+                                indri::api::Parameters& manifest,
+                                const std::string& direction,
+                                String_set* strings,
+                                indri::utility::HashTable<const char*, lemur::file::Keyfile*>& lookups ) {
+  if( !manifest.exists( direction + ".field" ) )
+    return;
+
+  indri::api::Parameters fields = manifest[ direction + ".field" ];
+
+  for( size_t i=0; i<fields.size(); i++ ) {
+    std::stringstream metalookupName;
+    metalookupName << direction << "Lookup" << (int)i;
+
+    std::string metalookupPath = indri::file::Path::combine( fileName, metalookupName.str() );
+    lemur::file::Keyfile* metalookup = new lemur::file::Keyfile;
+    metalookup->openRead( metalookupPath, SHARD_CACHE_SIZE );
+
+    std::string fieldName = fields[i];
+    const char* key = string_set_add( fieldName.c_str(), strings );
+    lookups.insert( key, metalookup );
+  }
+}
+
+//
+// _openShards
+//
+
+void indri::collection::CompressedCollection::_openShards( const std::string& fileName, int count ) {
+  indri::utility::HashTable<const char*, lemur::file::Keyfile*>::iterator iter;
+
+  // the first shard uses the collection's own lookups
+  lookup_shard* shard = new lookup_shard;
+  shard->lookup = &_lookup;
+  shard->owned = false;
+
+  for( iter = _forwardLookups.begin(); iter != _forwardLookups.end(); iter++ )
+    shard->forwardLookups.insert( *iter->first, *iter->second );
+
+  for( iter = _reverseLookups.begin(); iter != _reverseLookups.end(); iter++ )
+    shard->reverseLookups.insert( *iter->first, *iter->second );
+
+  _shards.push_back( shard );
+
+  if( count <= 1 )
+    return;
+
+  std::string lookupName = indri::file::Path::combine( fileName, "lookup" );
+  std::string manifestName = indri::file::Path::combine( fileName, "manifest" );
+
+  indri::api::Parameters manifest;
+  manifest.loadFile( manifestName );
+
+  for( int i=1; i<count; i++ ) {
+    shard = new lookup_shard;
+    shard->lookup = new lemur::file::Keyfile;
+    shard->lookup->openRead( lookupName, SHARD_CACHE_SIZE );
+    shard->owned = true;
+
+    open_shard_lookups( fileName, manifest, "forward", _strings, shard->forwardLookups );
+    open_shard_lookups( fileName, manifest, "reverse", _strings, shard->reverseLookups );
+    _shards.push_back( shard );
+  }
+}
+
+//
+// _closeShards
+//
+
+void indri::collection::CompressedCollection::_closeShards() {
+  indri::utility::HashTable<const char*, lemur::file::Keyfile*>::iterator iter;
+
+  for( size_t i=0; i<_shards.size(); i++ ) {
+    lookup_shard* shard = _shards[i];
+
+    if( shard->owned ) {
+      shard->lookup->close();
+      delete shard->lookup;
+
+      for( iter = shard->forwardLookups.begin(); iter != shard->forwardLookups.end(); iter++ ) {
+        (*iter->second)->close();
+        delete (*iter->second);
+      }
+
+      for( iter = shard->reverseLookups.begin(); iter != shard->reverseLookups.end(); iter++ ) {
+        (*iter->second)->close();
+        delete (*iter->second);
+      }
+    }
+
+    delete shard;
+  }
+
+  _shards.clear();
 }
 
 //
@@ -515,6 +632,8 @@ void indri::collection::CompressedCollection::openRead( const std::string& fileN
 //
 
 void indri::collection::CompressedCollection::close() {
+  _cacheClear();
+  _closeShards();
   _lookup.close();
   if( _output ) {
     _output->flush();
@@ -599,6 +718,9 @@ void indri::collection::CompressedCollection::addDocument( lemur::api::DOCID_T d
   // record the file position of the start point and index it
   // in the metadata indexes for later retrieval
 
+  // readers of the lookups hold the first shard's lock
+  indri::thread::ScopedLock lookups( _shards[0]->lock );
+
   // first, write the metadata, storing in metalookups as necessary
   for( size_t i=0; i<document->metadata.size(); i++ ) {
     if ( _storeDocs )
@@ -687,38 +809,105 @@ void indri::collection::CompressedCollection::addDocument( lemur::api::DOCID_T d
 }
 
 
-bool indri::collection::CompressedCollection::exists( lemur::api::DOCID_T documentID) {
-  indri::thread::ScopedLock l( _lock );
+//
+// _lookupOffset
+//
+// Finds the storage offset of a document, using the lookup
+// shard that belongs to its document ID.
+//
+
+bool indri::collection::CompressedCollection::_lookupOffset( lemur::api::DOCID_T documentID, UINT64& offset ) {
+  lookup_shard* shard = _shards[ documentID % _shards.size() ];
+  indri::thread::ScopedLock l( shard->lock );
 
-  UINT64 offset;
   int actual;
-  return _lookup.get( documentID, &offset, actual, sizeof offset );
+  return shard->lookup->get( documentID, &offset, actual, sizeof offset );
 }
 
-indri::api::ParsedDocument* indri::collection::CompressedCollection::retrieve( lemur::api::DOCID_T documentID ) {
+//
+// _flush
+//
+// Flush the output buffer so that all stored documents are on disk.
+//
+
+void indri::collection::CompressedCollection::_flush() {
+  if( !_output )
+    return;
+
   indri::thread::ScopedLock l( _lock );
+  _output->flush();
+}
+
+//
+// exists
+//
+
+bool indri::collection::CompressedCollection::exists( lemur::api::DOCID_T documentID) {
+  indri::thread::ScopedLock storage( _storageReadLock );
 
   UINT64 offset;
-  int actual;
+  return _lookupOffset( documentID, offset );
+}
+
+//
+// retrieve
+//
+
+indri::api::ParsedDocument* indri::collection::CompressedCollection::retrieve( lemur::api::DOCID_T documentID ) {
+  indri::thread::ScopedLock storage( _storageReadLock );
+  return _retrieve( documentID );
+}
+
+//
+// _retrieve
+//
+// Returns the cached copy of a document if there is one; otherwise
+// reads the document from disk and caches it.
+//
+
+indri::api::ParsedDocument* indri::collection::CompressedCollection::_retrieve( lemur::api::DOCID_T documentID ) {
+  indri::utility::Buffer output;
+
+  if( !_cacheFind( documentID, output ) ) {
+    UINT64 offset;
   
-  if( !_lookup.get( documentID, &offset, actual, sizeof offset ) ) {
-    LEMUR_THROW( LEMUR_IO_ERROR, "Unable to find document " + i64_to_string(documentID) + " in the collection." );
+    if( !_lookupOffset( documentID, offset ) ) {
+      LEMUR_THROW( LEMUR_IO_ERROR, "Unable to find document " + i64_to_string(documentID) + " in the collection." );
+    }
+
+    _flush();
+    _read( offset, output );
+    _cacheAdd( documentID, output );
   }
 
-  // flush output buffer; make sure all data is on disk
-  if( _output )
-    _output->flush();
+  return _parse( output );
+}
 
-  // decompress the data
-  indri::utility::Buffer output;
+//
+// _read
+//
+// Reads and decompresses the document stored at offset.  This
+// uses no shared state, so any number of threads may call it at once.
+//
+
+void indri::collection::CompressedCollection::_read( UINT64 offset, indri::utility::Buffer& output ) {
   z_stream_s stream;
   stream.zalloc = zlib_alloc;
   stream.zfree = zlib_free;
 
   inflateInit( &stream );
-
   zlib_read_document( stream, _storage, offset, output );
-  int decompressedSize = stream.total_out;
+}
+
+//
+// _parse
+//
+// Turns decompressed document data, which follows space for a
+// ParsedDocument at the front of output, into a ParsedDocument.
+//
+
+indri::api::ParsedDocument* indri::collection::CompressedCollection::_parse( indri::utility::Buffer& output ) {
+  int decompressedSize = (int) (output.position() - sizeof(indri::api::ParsedDocument));
 
   // initialize the buffer as a ParsedDocument
   indri::api::ParsedDocument* document = (indri::api::ParsedDocument*) output.front();
@@ -786,50 +975,140 @@ indri::api::ParsedDocument* indri::collection::CompressedCollection::retrieve( l
   return document;
 }
 
+//
+// document_metadatum
+//
+// Returns the last value stored for a field in the document, which
+// matches the value a forward lookup table would hold.
+//
+
+static std::string document_metadatum( indri::api::ParsedDocument* document, const std::string& attributeName ) {
+  std::string result;
+  indri::utility::greedy_vector<indri::parse::MetadataPair>::iterator iter;
+
+  for( iter=document->metadata.begin(); iter !=  document->metadata.end();
+       iter++ ) 
+    if(!strcmp((*iter).key, attributeName.c_str() ) )
+      result = (char*) iter->value;
+
+  return result;
+}
+
+//
+// forward_lookup_get
+//
+
+static std::string forward_lookup_get( lemur::file::Keyfile* metalookup, lemur::api::DOCID_T documentID ) {
+  std::string result;
+  char* resultBuffer = 0;
+  int length = 0;
+  bool success = metalookup->get( documentID, &resultBuffer, length );
+
+  if( success ) {
+    // assuming result is of a string type
+    result.assign( resultBuffer, length-1 );
+  }
+
+  delete[] resultBuffer;
+  return result;
+}
+
 //
 // retrieveMetadatum
 //
 
 std::string indri::collection::CompressedCollection::retrieveMetadatum( lemur::api::DOCID_T documentID, const std::string& attributeName ) {
-  indri::thread::ScopedLock l( _lock );
+  indri::thread::ScopedLock storage( _storageReadLock );
 
-  lemur::file::Keyfile** metalookup = _forwardLookups.find( attributeName.c_str() );
-  std::string result;
+  lookup_shard* shard = _shards[ documentID % _shards.size() ];
+  indri::thread::ScopedLock l( shard->lock );
+
+  lemur::file::Keyfile** metalookup = shard->forwardLookups.find( attributeName.c_str() );
+
+  if( metalookup )
+    return forward_lookup_get( *metalookup, documentID );
+
+  l.unlock();
+
+  indri::api::ParsedDocument* document = _retrieve( documentID );
+  std::string result = document_metadatum( document, attributeName );
+  delete document;
+
+  return result;
+}
+
+//
+// retrieveMetadata
+//
+
+std::vector<std::string> indri::collection::CompressedCollection::retrieveMetadata( const std::vector<lemur::api::DOCID_T>& documentIDs, const std::string& attributeName ) {
+  indri::thread::ScopedLock storage( _storageReadLock );
+  std::vector<std::string> results( documentIDs.size() );
+
+  if( documentIDs.size() == 0 )
+    return results;
+
+  // visit the documents in ID order, which is the order of the lookup files
+  std::vector< std::pair<lemur::api::DOCID_T, size_t> > order;
+
+  for( size_t i=0; i<documentIDs.size(); i++ )
+    order.push_back( std::make_pair( documentIDs[i], i ) );
+
+  std::sort( order.begin(), order.end() );
+
+  lookup_shard* shard = _shards[ order[0].first % _shards.size() ];
+  indri::thread::ScopedLock l( shard->lock );
+
+  lemur::file::Keyfile** metalookup = shard->forwardLookups.find( attributeName.c_str() );
 
   if( metalookup ) {
-    char* resultBuffer = 0;
-    int length = 0;
-    bool success = (*metalookup)->get( documentID, &resultBuffer, length );
+    for( size_t i=0; i<order.size(); i++ )
+      results[ order[i].second ] = forward_lookup_get( *metalookup, order[i].first );
+
+    return results;
+  }
+
+  // otherwise each document has to be decompressed; use cached copies
+  // where possible, and read the rest in storage order
+  std::vector< std::pair<UINT64, size_t> > offsets;
+
+  for( size_t i=0; i<order.size(); i++ ) {
+    indri::utility::Buffer output;
 
-    if( success ) {
-      // assuming result is of a string type
-      result.assign( resultBuffer, length-1 );
+    if( _cacheFind( order[i].first, output ) ) {
+      indri::api::ParsedDocument* document = _parse( output );
+      results[ order[i].second ] = document_metadatum( document, attributeName );
+      delete document;
+      continue;
     }
 
-    delete[] resultBuffer;
-  } else {
-    l.unlock();
-    indri::api::ParsedDocument* document = retrieve( documentID );
-    //This returns the first occurence, rather than the last
-    // one gets if a forward lookup table is used.
-    /*
-      indri::utility::greedy_vector<indri::parse::MetadataPair>::iterator iter = std::find_if( document->metadata.begin(),
-      document->metadata.end(),
-      indri::parse::MetadataPair::key_equal( attributeName.c_str() ) );
-    
-      if( iter != document->metadata.end() ) {
-      result = (char*) iter->value;
-      }
-    */
-    indri::utility::greedy_vector<indri::parse::MetadataPair>::iterator iter;
-    for( iter=document->metadata.begin(); iter !=  document->metadata.end();
-         iter++ ) 
-      if(!strcmp((*iter).key, attributeName.c_str() ) )
-        result = (char*) iter->value;
+    UINT64 offset;
+    int actual;
+
+    if( !shard->lookup->get( order[i].first, &offset, actual, sizeof offset ) ) {
+      LEMUR_THROW( LEMUR_IO_ERROR, "Unable to find document " + i64_to_string(order[i].first) + " in the collection." );
+    }
+
+    offsets.push_back( std::make_pair( offset, i ) );
+  }
+
+  l.unlock();
+  std::sort( offsets.begin(), offsets.end() );
+  _flush();
+
+  for( size_t i=0; i<offsets.size(); i++ ) {
+    indri::utility::Buffer output;
+    const std::pair<lemur::api::DOCID_T, size_t>& entry = order[ offsets[i].second ];
+
+    _read( offsets[i].first, output );
+    _cacheAdd( entry.first, output );
+
+    indri::api::ParsedDocument* document = _parse( output );
+    results[ entry.second ] = document_metadatum( document, attributeName );
     delete document;
   }
 
-  return result;
+  return results;
 }
 
 //
@@ -837,15 +1116,18 @@ std::string indri::collection::CompressedCollection::retrieveMetadatum( lemur::a
 //
 
 std::vector<lemur::api::DOCID_T> indri::collection::CompressedCollection::retrieveIDByMetadatum( const std::string& attributeName, const std::string& value ) {
-  indri::thread::ScopedLock l( _lock );
+  indri::thread::ScopedLock storage( _storageReadLock );
+
+  indri::utility::GenericHash<const char*> hash;
+  lookup_shard* shard = _shards[ hash( value.c_str() ) % _shards.size() ];
+  indri::thread::ScopedLock l( shard->lock );
 
   // find the lookup associated with this field
-  lemur::file::Keyfile** metalookup = _reverseLookups.find( attributeName.c_str() );
+  lemur::file::Keyfile** metalookup = shard->reverseLookups.find( attributeName.c_str() );
   std::vector<lemur::api::DOCID_T> results;
 
   // if we have a lookup, find the associated documentIDs for this value
   if( metalookup && value.size() > 0 && value.size() < lemur::file::Keyfile::MAX_KEY_LENGTH ) {
-    int actual = 0;
     int dataSize = (*metalookup)->getSize( value.c_str() );
 
     if( dataSize > 0 ) {
@@ -859,6 +1141,120 @@ std::vector<lemur::api::DOCID_T> indri::collection::CompressedCollection::retrie
   return results;
 }
 
+//
+// _cacheFind
+//
+// Copies a cached document into output, leaving space for a
+// ParsedDocument at the front, as _read does.
+//
+
+bool indri::collection::CompressedCollection::_cacheFind( lemur::api::DOCID_T documentID, indri::utility::Buffer& output ) {
+  if( _cacheStatistics.maximumMemory == 0 )
+    return false;
+
+  indri::thread::ScopedLock l( _cacheLock );
+  cached_document** cached = _cache.find( documentID );
+
+  if( !cached ) {
+    _cacheStatistics.misses++;
+    return false;
+  }
+
+  _cacheRecent.splice( _cacheRecent.begin(), _cacheRecent, (*cached)->recent );
+  _cacheStatistics.hits++;
+
+  output.grow( sizeof(indri::api::ParsedDocument) + (*cached)->length );
+  output.write( sizeof(indri::api::ParsedDocument) );
+  memcpy( output.write( (*cached)->length ), (*cached)->data, (*cached)->length );
+  return true;
+}
+
+//
+// _cacheAdd
+//
+
+void indri::collection::CompressedCollection::_cacheAdd( lemur::api::DOCID_T documentID, indri::utility::Buffer& output ) {
+  if( _cacheStatistics.maximumMemory == 0 )
+    return;
+
+  size_t length = output.position() - sizeof(indri::api::ParsedDocument);
+  size_t memory = sizeof(cached_document) + length;
+
+  indri::thread::ScopedLock l( _cacheLock );
+
+  if( memory > _cacheStatistics.maximumMemory || _cache.find( documentID ) )
+    return;
+
+  // evict least recently used documents until this one fits
+  while( _cacheRecent.size() &&
+         _cacheStatistics.memory + memory > _cacheStatistics.maximumMemory ) {
+    _cacheRemove( _cacheRecent.back() );
+  }
+
+  cached_document* cached = new cached_document;
+  cached->documentID = documentID;
+  cached->length = length;
+  cached->data = new char[length];
+  memcpy( cached->data, output.front() + sizeof(indri::api::ParsedDocument), length );
+
+  _cacheRecent.push_front( cached );
+  cached->recent = _cacheRecent.begin();
+  _cache.insert( documentID, cached );
+
+  _cacheStatistics.memory += memory;
+  _cacheStatistics.documents++;
+}
+
+//
+// _cacheRemove
+//
+
+void indri::collection::CompressedCollection::_cacheRemove( cached_document* cached ) {
+  _cacheRecent.erase( cached->recent );
+  _cache.remove( cached->documentID );
+
+  _cacheStatistics.memory -= sizeof(cached_document) + cached->length;
+  _cacheStatistics.documents--;
+
+  delete[] cached->data;
+  delete cached;
+}
+
+//
+// _cacheClear
+//
+
+void indri::collection::CompressedCollection::_cacheClear() {
+  indri::thread::ScopedLock l( _cacheLock );
+
+  while( _cacheRecent.size() )
+    _cacheRemove( _cacheRecent.back() );
+}
+
+//
+// evict
+//
+
+void indri::collection::CompressedCollection::evict( lemur::api::DOCID_T documentID ) {
+  if( _cacheStatistics.maximumMemory == 0 )
+    return;
+
+  indri::thread::ScopedLock l( _cacheLock );
+  cached_document** cached = _cache.find( documentID );
+
+  if( cached )
+    _cacheRemove( *cached );
+}
+
+//
+// cacheStatistics
+//
+
+indri::collection::CompressedCollection::CacheStatistics indri::collection::CompressedCollection::cacheStatistics() {
+  indri::thread::ScopedLock l( _cacheLock );
+  return _cacheStatistics;
+}
+
 //
 // retrieveByMetadatum
 //
@@ -1155,7 +1551,9 @@ void indri::collection::CompressedCollection::compact( indri::index::DeletedDocu
   }
 
   indri::utility::HashTable<const char*, lemur::file::Keyfile*>::iterator iter;
+  indri::thread::ScopedLock storageLock( _storageWriteLock );
   indri::thread::ScopedLock l( _lock );
+  _cacheClear();
 
   // remove the forward lookups for each document
   for( iter = _forwardLookups.begin(); iter != _forwardLookups.end(); iter++ ) {
@@ -1220,6 +1618,7 @@ void indri::collection::CompressedCollection::append( indri::collection::Compres
   }
 
   indri::utility::HashTable<const char*, lemur::file::Keyfile*>::iterator iter;
+  indri::thread::ScopedLock storageLock( _storageWriteLock );
   indri::thread::ScopedLock l( _lock );
   _output->flush();
 
@@ -30,11 +30,42 @@ indri::infnet::ContextCountAccumulator::ContextCountAccumulator( const std::stri
   _occurrences(0),
   _contextSize(0),
   _documentOccurrences(0),
-  _documentCount(0)
+  _documentCount(0),
+  _cache(0),
+  _list(0),
+  _cached(false)
+{
+}
+
+indri::infnet::ContextCountAccumulator::ContextCountAccumulator( const std::string& name, const indri::lang::ListCache::CachedList& list ) :
+  _name(name),
+  _matches(0),
+  _context(0),
+  _occurrences(list.occurrences),
+  _contextSize(list.contextSize),
+  _documentOccurrences(list.documentOccurrences),
+  _documentCount(list.documentCount),
+  _cache(0),
+  _list(0),
+  _cached(true)
 {
 }
 
 indri::infnet::ContextCountAccumulator::~ContextCountAccumulator() {
+  delete _list;
+}
+
+//
+// setCache
+//
+
+void indri::infnet::ContextCountAccumulator::setCache( indri::lang::ListCache& cache, indri::lang::Node* raw ) {
+  if( _context || _cached )
+    return;
+
+  _cache = &cache;
+  _list = cache.newList();
+  raw->copy( _list->raw );
 }
 
 const std::string& indri::infnet::ContextCountAccumulator::getName() const {
@@ -59,6 +90,16 @@ int indri::infnet::ContextCountAccumulator::getDocumentCount() const {
     
 const indri::infnet::EvaluatorNode::MResults& indri::infnet::ContextCountAccumulator::getResults() {
   // we must be finished, so now is a good time to add our results to the ListCache
+  if( _list ) {
+    _list->occurrences = _occurrences;
+    _list->contextSize = _contextSize;
+    _list->documentOccurrences = _documentOccurrences;
+    _list->documentCount = _documentCount;
+
+    _cache->add( _list );
+    _list = 0;
+  }
+
   _results.clear();
 
   _results[ "occurrences" ].push_back( indri::api::ScoredExtentResult( _occurrences, 0 ) );
@@ -94,6 +135,16 @@ void indri::infnet::ContextCountAccumulator::evaluate( lemur::api::DOCID_T docum
     if (_matches->extents().size() > 0)
       _documentOccurrences++;
     _occurrences += documentOccurrences;
+
+    if( _list && documentOccurrences > 0 ) {
+      // give up on lists too large to cache
+      if( (_list->entries.size() + 1) * sizeof(indri::index::DocumentContextCount) > _cache->maximumMemory() ) {
+        delete _list;
+        _list = 0;
+      } else {
+        _list->entries.push_back( indri::index::DocumentContextCount( documentID, documentOccurrences, documentLength ) );
+      }
+    }
   } else {
 
     const indri::utility::greedy_vector<indri::index::Extent>& matches = _matches->extents();
@@ -151,6 +202,9 @@ void indri::infnet::ContextCountAccumulator::evaluate( lemur::api::DOCID_T docum
 
 
 lemur::api::DOCID_T indri::infnet::ContextCountAccumulator::nextCandidateDocument() {
+  if( _cached )
+    return MAX_INT32;
+
   lemur::api::DOCID_T candidate = _matches->nextCandidateDocument();
 
   if( _context ) {
@@ -165,6 +219,10 @@ lemur::api::DOCID_T indri::infnet::ContextCountAccumulator::nextCandidateDocumen
 //
 
 void indri::infnet::ContextCountAccumulator::indexChanged( indri::index::Index& index ) {
+  // cached counts already cover every index
+  if( _cached )
+    return;
+
   if( ! _context ) {
     _contextSize += index.termCount();
   }
@@ -16,6 +16,7 @@
 //
 
 #include "indri/DiskDocListIterator.hpp"
+#include "indri/PostingBlockCodec.hpp"
 #include "lemur/RVLCompress.hpp"
 
 //
@@ -26,12 +27,24 @@
 //         RVLCompressed section (size is headerLength)
 //            termString
 //            termData (indri::index::TermData structure)
-//      byte (1b)   controlByte   (0x01 = hasTopdocs, 0x02 = isFrequent)
+//      byte (1b)   controlByte   (0x01 = hasTopdocs, 0x02 = isFrequent, 0x04 = isBlockCoded,
+//                                 0x08 = hasSkipTable, 0x10 = hasBlockBounds)
 //      topdocsCount (4b)  (if hasTopdocs)
 //         for each topdoc:
 //         docID (4b)
 //         count (4b)
 //         length (4b)
+//      skipCount (4b)  (if hasSkipTable)
+//      reservedCount (4b)
+//         for each of reservedCount entries (only skipCount are used):
+//         lastDocument (4b)
+//         offset (8b)
+//         (if hasBlockBounds)
+//         fractionCount (4b)
+//         fractionLength (4b)
+//         maximumCount (4b)
+//         minimumLength (4b)
+//         maximumLength (4b)
 //      raw inverted list data:
 //        skip: (if hasSkips)
 //          (4b) document
@@ -42,6 +55,41 @@
 //            position count
 //            delta encoded positions
 //
+// -------------------
+// Block-coded lists:
+// -------------------
+//
+// When the control byte has isBlockCoded set, each skip is followed
+// by a single block of at most PostingBlockCodec::BLOCK_SIZE documents
+// instead of a batch of RVLCompressed entries:
+//      byte (1b)   entryCount
+//      firstDocument (4b)
+//      packed document gaps (entryCount-1 values)
+//      packed position counts (entryCount values)
+//      positionsLength (4b)
+//      packed position gaps (delta encoded within each document)
+//
+// Document IDs and counts for the whole block are decoded at once
+// when its skip is read.  Positions are only decoded when currentEntry()
+// is called for a document in the block, so frequency-only scoring
+// (which uses currentDocument() and currentCount()) never touches them;
+// positionsLength lets the iterator step over them without decoding.
+//
+// Block-coded lists longer than one block also carry a skip table in
+// the list header, with the last document of every block and the
+// offset of the block's skip record, measured from the end of the table.
+// nextEntry(documentID) binary searches the table to jump straight to
+// the block that may hold the document, then scans the decoded
+// document IDs of that block, never touching the positions of
+// documents it passes over.
+//
+// With hasBlockBounds set, each skip table entry also records the
+// count and length of the block's entry with the largest count/length
+// ratio, the largest count, and the shortest and longest documents in
+// the block.  These
+// are exposed through blockBound() so query evaluation can bound the
+// score of every document in a block without reading the block itself.
+//
 // ----------------------------
 // More explanation about skips:
 // ----------------------------
@@ -63,6 +111,16 @@ indri::index::DiskDocListIterator::DiskDocListIterator( indri::file::SequentialR
   :
   _file(buffer),
   _startOffset(startOffset),
+  _isBlockCoded(false),
+  _postingsDecoded(0),
+  _documents(0),
+  _counts(0),
+  _blockEntries(0),
+  _cachedBlock(0),
+  _hasBlockBounds(false),
+  _blockCache(0),
+  _cacheIndex(0),
+  _positionsPending(false),
   _fieldCount(fieldCount),
   _termData(0),
   _ownTermData(false)
@@ -74,11 +132,21 @@ indri::index::DiskDocListIterator::DiskDocListIterator( indri::file::SequentialR
 //
 
 indri::index::DiskDocListIterator::~DiskDocListIterator() {
+  _releaseBlock();
   delete _file;
   if( _ownTermData )
     free(_termData);
 }
 
+//
+// setBlockCache
+//
+
+void indri::index::DiskDocListIterator::setBlockCache( PostingBlockCache* cache, UINT64 index ) {
+  _blockCache = cache;
+  _cacheIndex = index;
+}
+
 //
 // setEndpoints
 //
@@ -143,27 +211,40 @@ void indri::index::DiskDocListIterator::startIteration() {
 
   _hasTopdocs = (control & 0x01) ? true : false;
   _isFrequent = (control & 0x02) ? true : false;
+  _isBlockCoded = (control & 0x04) ? true : false;
   
   // clear out all the internal data
   _data.document = 0;
   _data.positions.clear();
+  _count = 0;
+  _positionsPending = false;
   _skipDocument = -1;
   _list = _listEnd = 0;
+  _releaseBlock();
+  _blockIndex = 0;
+  _blockNumber = -1;
+  _postingsDecoded = 0;
 
   // read in the term data, if necessary
 
   // read in the topdocs information
   _readTopdocs();
 
+  // read in the skip table
+  _skipTable.clear();
+  _hasBlockBounds = false;
+  if( control & 0x08 )
+    _readSkipTable( (control & 0x10) ? true : false );
+
   // read in skip data
   _readSkip();
   
   // read the first entry, unless there's nothing here
-  if( _list == _listEnd ) {
+  if( _batchFinished() ) {
     _result = 0;
   } else {
-  _readEntry();
-  _result = &_data;
+    _readEntry();
+    _result = &_data;
   }
 }
 
@@ -172,7 +253,7 @@ void indri::index::DiskDocListIterator::startIteration() {
 //
 
 bool indri::index::DiskDocListIterator::nextEntry() {
-  if( _list == _listEnd ) {
+  if( _batchFinished() ) {
     if( _skipDocument > 0 ) {
       // need to read the next segment of this list
       _readSkip();
@@ -181,6 +262,7 @@ bool indri::index::DiskDocListIterator::nextEntry() {
     } else {
       // all done
       _result = 0;
+      _positionsPending = false;
       return false;
     }
   }
@@ -194,6 +276,13 @@ bool indri::index::DiskDocListIterator::nextEntry() {
 //
 
 bool indri::index::DiskDocListIterator::nextEntry( lemur::api::DOCID_T documentID ) {
+  if( _isBlockCoded ) {
+    if( _skipTable.size() )
+      _skipToBlock( documentID );
+
+    return _nextBlockEntry( documentID );
+  }
+
   // skip ahead as much as possible
   while( _skipDocument > 0 && _skipDocument <= documentID ) {
     _readSkip();
@@ -209,14 +298,137 @@ bool indri::index::DiskDocListIterator::nextEntry( lemur::api::DOCID_T documentI
   return true;
 }
 
+//
+// _skipToBlock
+//
+
+void indri::index::DiskDocListIterator::_skipToBlock( lemur::api::DOCID_T documentID ) {
+  // nothing to do if the document can only be in the current block
+  if( _skipDocument <= 0 || _skipDocument > documentID )
+    return;
+
+  // find the first block that ends at or after this document
+  int low = _blockNumber + 1;
+  int high = (int)_skipTable.size() - 1;
+
+  while( low < high ) {
+    int middle = (low + high) / 2;
+
+    if( _skipTable[middle].lastDocument < documentID )
+      low = middle + 1;
+    else
+      high = middle;
+  }
+
+  // if every block ends before this document, the last one finishes the list
+  _file->seek( _listDataOffset + _skipTable[low].offset );
+  _blockNumber = low - 1;
+  _readSkip();
+}
+
+//
+// _nextBlockEntry
+//
+
+bool indri::index::DiskDocListIterator::_nextBlockEntry( lemur::api::DOCID_T documentID ) {
+  if( !_result )
+    return false;
+
+  while( _data.document < documentID ) {
+    int entries = _blockEntries;
+
+    // step over the documents before this one without decoding their positions
+    while( _blockIndex < entries && (lemur::api::DOCID_T)_documents[_blockIndex] < documentID ) {
+      _blockPositionIndex += _counts[_blockIndex];
+      _blockIndex++;
+    }
+
+    if( _blockIndex < entries ) {
+      _readBlockEntry();
+    } else if( _skipDocument > 0 ) {
+      _readSkip();
+    } else {
+      _result = 0;
+      _positionsPending = false;
+      return false;
+    }
+  }
+
+  return true;
+}
+
 //
 // currentEntry
 //
 
 indri::index::DiskDocListIterator::DocumentData* indri::index::DiskDocListIterator::currentEntry() {
+  if( _positionsPending )
+    _decodePositions();
+
   return _result;
 }
 
+//
+// currentDocument
+//
+
+lemur::api::DOCID_T indri::index::DiskDocListIterator::currentDocument() {
+  return _data.document;
+}
+
+//
+// currentCount
+//
+
+int indri::index::DiskDocListIterator::currentCount() {
+  return _count;
+}
+
+//
+// blockBound
+//
+
+bool indri::index::DiskDocListIterator::blockBound( lemur::api::DOCID_T documentID, BlockBound& bound ) {
+  if( !_hasBlockBounds )
+    return false;
+
+  // find the first block that ends at or after this document
+  int low = 0;
+  int high = (int)_skipTable.size();
+
+  while( low < high ) {
+    int middle = (low + high) / 2;
+
+    if( _skipTable[middle].lastDocument < documentID )
+      low = middle + 1;
+    else
+      high = middle;
+  }
+
+  bound.firstDocument = low ? _skipTable[low-1].lastDocument + 1 : 0;
+
+  if( low == (int)_skipTable.size() ) {
+    // past the end of the list; nothing here contains the term
+    bound.lastDocument = MAX_INT32;
+    bound.count = 0;
+    bound.length = 1;
+    bound.maximumCount = 0;
+    bound.minimumLength = 1;
+    bound.maximumLength = 1;
+  } else {
+    const BlockSkip& skip = _skipTable[low];
+
+    bound.lastDocument = skip.lastDocument;
+    bound.count = skip.fractionCount;
+    bound.length = skip.fractionLength;
+    bound.maximumCount = skip.maximumCount;
+    bound.minimumLength = skip.minimumLength;
+    bound.maximumLength = skip.maximumLength;
+  }
+
+  return true;
+}
+
 //
 // finished
 //
@@ -252,6 +464,45 @@ void indri::index::DiskDocListIterator::_readTopdocs() {
   }
 }
 
+//
+// _readSkipTable
+//
+
+void indri::index::DiskDocListIterator::_readSkipTable( bool hasBounds ) {
+  UINT32 skipCount;
+  UINT32 reservedCount;
+
+  _file->read( &skipCount, sizeof(UINT32) );
+  _file->read( &reservedCount, sizeof(UINT32) );
+
+  const size_t boundsSize = hasBounds ? 5*sizeof(UINT32) : 0;
+  const size_t entrySize = sizeof(lemur::api::DOCID_T) + sizeof(UINT64) + boundsSize;
+  const char* table = static_cast<const char*>( _file->read( reservedCount * entrySize ) );
+
+  _skipTable.resize( skipCount );
+
+  for( UINT32 i=0; i<skipCount; i++ ) {
+    const char* entry = table + i*entrySize;
+
+    memcpy( &_skipTable[i].lastDocument, entry, sizeof(lemur::api::DOCID_T) );
+    entry += sizeof(lemur::api::DOCID_T);
+    memcpy( &_skipTable[i].offset, entry, sizeof(UINT64) );
+    entry += sizeof(UINT64);
+
+    if( hasBounds ) {
+      memcpy( &_skipTable[i].fractionCount, entry, sizeof(UINT32) );
+      memcpy( &_skipTable[i].fractionLength, entry + sizeof(UINT32), sizeof(UINT32) );
+      memcpy( &_skipTable[i].maximumCount, entry + 2*sizeof(UINT32), sizeof(UINT32) );
+      memcpy( &_skipTable[i].minimumLength, entry + 3*sizeof(UINT32), sizeof(UINT32) );
+      memcpy( &_skipTable[i].maximumLength, entry + 4*sizeof(UINT32), sizeof(UINT32) );
+    }
+  }
+
+  _hasBlockBounds = hasBounds && skipCount > 0;
+
+  _listDataOffset = _file->position();
+}
+
 //
 // _readSkip
 //
@@ -265,9 +516,146 @@ inline void indri::index::DiskDocListIterator::_readSkip() {
   assert( _skipDocument > -2 );
   assert( skipLength >= 0 );
 
+  _blockOffset = _file->position();
   _list = static_cast<const char*>(_file->read( skipLength ));
   _listEnd = _list + skipLength;
   _data.document = 0;
+
+  if( _isBlockCoded ) {
+    _blockNumber++;
+    _readBlock();
+  }
+}
+
+//
+// _readBlock
+//
+
+void indri::index::DiskDocListIterator::_readBlock() {
+  _blockIndex = 0;
+  _blockPositionIndex = 0;
+  _releaseBlock();
+
+  if( _list == _listEnd )
+    return;
+
+  const char* blockStart = _list;
+
+  // a cached block is read in place, and held until the next block is read
+  if( _blockCache && (_cachedBlock = _blockCache->find( _cacheIndex, _blockOffset )) ) {
+    int entries = _cachedBlock->entries;
+    _documents = _cachedBlock->documents;
+    _counts = _cachedBlock->counts;
+    _blockEntries = entries;
+
+    UINT32 totalPositions = 0;
+    for( int i=0; i<entries; i++ )
+      totalPositions += _counts[i];
+
+    _postingsDecoded += entries;
+    _blockPositions.resize( totalPositions );
+    _blockPositionData = blockStart + _cachedBlock->positionsOffset;
+    _blockPositionsDecoded = false;
+    _list = _listEnd;
+    return;
+  }
+
+  int entries = (UINT8) *_list++;
+  UINT32 firstDocument;
+  memcpy( &firstDocument, _list, sizeof(UINT32) );
+  _list += sizeof(UINT32);
+
+  _postingsDecoded += entries;
+  _blockDocuments.resize( entries );
+  _blockDocuments[0] = firstDocument;
+  _list = PostingBlockCodec::decode( _list, &_blockDocuments[0] + 1, entries - 1 );
+  PostingBlockCodec::prefixSum( &_blockDocuments[0] + 1, entries - 1, firstDocument );
+
+  _blockCounts.resize( entries );
+  _list = PostingBlockCodec::decode( _list, &_blockCounts[0], entries );
+
+  _documents = &_blockDocuments[0];
+  _counts = &_blockCounts[0];
+  _blockEntries = entries;
+
+  UINT32 totalPositions = 0;
+  for( int i=0; i<entries; i++ )
+    totalPositions += _blockCounts[i];
+
+  UINT32 positionsLength;
+  memcpy( &positionsLength, _list, sizeof(UINT32) );
+  _list += sizeof(UINT32);
+
+  // leave the positions packed until somebody asks for them
+  _blockPositions.resize( totalPositions );
+  _blockPositionData = _list;
+  _blockPositionsDecoded = false;
+
+  _list += positionsLength;
+  assert( _list == _listEnd );
+
+  if( _blockCache )
+    _blockCache->add( _cacheIndex, _blockOffset, _blockDocuments, _blockCounts, UINT32(_blockPositionData - blockStart) );
+}
+
+//
+// _releaseBlock
+//
+
+void indri::index::DiskDocListIterator::_releaseBlock() {
+  if( _cachedBlock ) {
+    PostingBlockCache::release( _cachedBlock );
+    _cachedBlock = 0;
+  }
+
+  _blockEntries = 0;
+}
+
+//
+// _decodePositions
+//
+
+void indri::index::DiskDocListIterator::_decodePositions() {
+  if( !_blockPositionsDecoded ) {
+    int totalPositions = (int)_blockPositions.size();
+    PostingBlockCodec::decode( _blockPositionData, totalPositions ? &_blockPositions[0] : 0, totalPositions );
+    _blockPositionsDecoded = true;
+  }
+
+  _data.positions.clear();
+
+  if( _count ) {
+    UINT32* positions = &_blockPositions[0] + _entryPositionIndex;
+    PostingBlockCodec::prefixSum( positions, _count, 0 );
+    _data.positions.append( positions, positions + _count );
+  }
+
+  _positionsPending = false;
+}
+
+//
+// _batchFinished
+//
+
+inline bool indri::index::DiskDocListIterator::_batchFinished() const {
+  if( _isBlockCoded )
+    return _blockIndex == _blockEntries;
+
+  return _list == _listEnd;
+}
+
+//
+// _readBlockEntry
+//
+
+inline void indri::index::DiskDocListIterator::_readBlockEntry() {
+  _count = _counts[_blockIndex];
+  _data.document = _documents[_blockIndex];
+  _entryPositionIndex = _blockPositionIndex;
+  _positionsPending = true;
+
+  _blockPositionIndex += _count;
+  _blockIndex++;
 }
 
 //
@@ -275,7 +663,13 @@ inline void indri::index::DiskDocListIterator::_readSkip() {
 //
 
 inline void indri::index::DiskDocListIterator::_readEntry() {
+  if( _isBlockCoded ) {
+    _readBlockEntry();
+    return;
+  }
+
   _data.positions.clear();
+  _postingsDecoded++;
   
   int deltaDocument;
   _list = lemur::utility::RVLCompress::decompress_int( _list, deltaDocument );
@@ -283,6 +677,7 @@ inline void indri::index::DiskDocListIterator::_readEntry() {
 
   int numPositions;
   _list = lemur::utility::RVLCompress::decompress_int( _list, numPositions );
+  _count = numPositions;
 
   int lastPosition = 0;
   int deltaPosition;
@@ -294,6 +689,14 @@ inline void indri::index::DiskDocListIterator::_readEntry() {
   }
 }
 
+//
+// postingsDecoded
+//
+
+INT64 indri::index::DiskDocListIterator::postingsDecoded() {
+  return _postingsDecoded;
+}
+
 //
 // isFrequent
 //
@@ -302,6 +705,14 @@ bool indri::index::DiskDocListIterator::isFrequent() const {
   return _isFrequent;
 }
 
+//
+// isBlockCoded
+//
+
+bool indri::index::DiskDocListIterator::isBlockCoded() const {
+  return _isBlockCoded;
+}
+
 //
 // termData
 //
@@ -28,6 +28,9 @@
 #include "indri/DiskFrequentVocabularyIterator.hpp"
 #include "indri/DiskKeyfileVocabularyIterator.hpp"
 #include "indri/DiskTermListFileIterator.hpp"
+#include "indri/ImpactList.hpp"
+#include "indri/PostingBlockCache.hpp"
+#include "indri/ScopedLock.hpp"
 
 void indri::index::DiskIndex::_readManifest( const std::string& path ) {
   indri::api::Parameters manifest;
@@ -53,6 +56,10 @@ void indri::index::DiskIndex::_readManifest( const std::string& path ) {
       } 
   }
   
+  // indexes written before block coding was added have no codec entry
+  _listCodec = manifest.get( "inverted-list-codec", "vbyte" );
+  _impactLists = manifest.get( "impact-lists", false );
+
   indri::api::Parameters corpus = manifest["corpus"];
 
   _corpusStatistics.totalDocuments = (int) corpus["total-documents"];
@@ -81,14 +88,30 @@ void indri::index::DiskIndex::_readManifest( const std::string& path ) {
       }
     }
   }
+
+  if( manifest.exists("phrases") ) {
+    indri::api::Parameters phrases = manifest["phrases"];
+
+    if( phrases.exists("phrase") ) {
+      indri::api::Parameters phrase = phrases["phrase"];
+
+      for( size_t i=0; i<phrase.size(); i++ ) {
+        std::string name = phrase[i].get( "name", "" );
+        INT64 byteOffset = phrase[i].get( "byte-offset", INT64(0) );
+
+        _phraseOffsets[name] = byteOffset;
+      }
+    }
+  }
 }
 
 //
 // open
 //
 
-void indri::index::DiskIndex::open( const std::string& base, const std::string& relative ) {
+void indri::index::DiskIndex::open( const std::string& base, const std::string& relative, bool mapped ) {
   _path = relative;
+  _cacheID = indri::index::PostingBlockCache::indexID();
 
   std::string path = indri::file::Path::combine( base, relative );
 
@@ -103,9 +126,13 @@ void indri::index::DiskIndex::open( const std::string& base, const std::string&
   std::string directFilePath = indri::file::Path::combine( path, "directFile" );
   std::string fieldsFilePath = indri::file::Path::combine( path, "fieldsFile" );
   std::string manifestPath = indri::file::Path::combine( path, "manifest" );
+  std::string termTablePath = indri::file::Path::combine( path, "termTable" );
 
   _readManifest( manifestPath );
 
+  if( indri::file::Path::isFile( termTablePath ) )
+    _termTable.openRead( termTablePath, (int)_fieldData.size() );
+
   _frequentStringToTerm.openRead( frequentStringPath );
   _infrequentStringToTerm.openRead( infrequentStringPath );
 
@@ -119,6 +146,25 @@ void indri::index::DiskIndex::open( const std::string& base, const std::string&
   _invertedFile.openRead( invertedFilePath );
   _directFile.openRead( directFilePath );
   _fieldsFile.openRead( fieldsFilePath );
+
+  if( _impactLists ) {
+    _impactFile.openRead( indri::file::Path::combine( path, "impactFile" ) );
+    _impactTerms.openRead( indri::file::Path::combine( path, "impactTerms" ) );
+  }
+
+  if( _phraseOffsets.size() )
+    _phraseFile.openRead( indri::file::Path::combine( path, "phraseFile" ) );
+
+  // a file that can't be mapped is read through buffers as usual
+  if( mapped ) {
+    _invertedFile.map();
+    _directFile.map();
+    _fieldsFile.map();
+
+    if( _phraseOffsets.size() )
+      _phraseFile.map();
+  }
+
   // this is not thread-safe.
   //  size_t cacheSize = lemur_compat::min<size_t>(_documentLengths.size(), MAX_DOCLENGTHS_CACHE);
   //_lengthsBuffer.cache( 0, cacheSize );
@@ -130,6 +176,7 @@ void indri::index::DiskIndex::open( const std::string& base, const std::string&
 //
 
 void indri::index::DiskIndex::close() {
+  _termTable.close();
   _frequentStringToTerm.close();
   _infrequentStringToTerm.close();
 
@@ -143,6 +190,16 @@ void indri::index::DiskIndex::close() {
 
   _invertedFile.close();
   _directFile.close();
+
+  if( _impactLists ) {
+    _impactFile.close();
+    _impactTerms.close();
+  }
+
+  if( _phraseOffsets.size() ) {
+    _phraseFile.close();
+    _phraseOffsets.clear();
+  }
 }
 
 //
@@ -150,6 +207,9 @@ void indri::index::DiskIndex::close() {
 //
 
 indri::index::DiskTermData* indri::index::DiskIndex::_fetchTermData( lemur::api::TERMID_T termID ) {
+  if( _termTable.isOpen() )
+    return _termTable.get( termID );
+
   int dataSize = ::disktermdata_size((int)_fieldData.size());
   char *buffer = new char [dataSize];
   int actual;
@@ -179,6 +239,9 @@ indri::index::DiskTermData* indri::index::DiskIndex::_fetchTermData( lemur::api:
 //
 
 indri::index::DiskTermData* indri::index::DiskIndex::_fetchTermData( const char* term ) {
+  if( _termTable.isOpen() )
+    return _termTable.get( term );
+
   int dataSize = ::disktermdata_size((int)_fieldData.size());
   char *buffer = new char [dataSize];
   int actual;
@@ -223,6 +286,14 @@ lemur::api::DOCID_T indri::index::DiskIndex::documentBase() {
   return _corpusStatistics.baseDocument;
 }
 
+//
+// listCodec
+//
+
+const std::string& indri::index::DiskIndex::listCodec() {
+  return _listCodec;
+}
+
 //
 // term
 //
@@ -270,7 +341,7 @@ int indri::index::DiskIndex::documentLength( lemur::api::DOCID_T documentID ) {
   unsigned int documentOffset = documentID - _corpusStatistics.baseDocument;
 
   if( documentID < _corpusStatistics.baseDocument ||
-      _corpusStatistics.totalDocuments <= documentOffset ) 
+      documentID >= _corpusStatistics.maximumDocument ) 
     return 0;
 
   int length;
@@ -453,12 +524,20 @@ indri::index::DocListIterator* indri::index::DiskIndex::docListIterator( lemur::
 
   INT64 startOffset = data->startOffset;
   INT64 length = data->length;
+  UINT64 documentCount = data->termData->corpus.documentCount;
   ::disktermdata_delete( data );
 
   // truncate the length argument at 1MB, use it to pick a size for the readbuffer
-  length = lemur_compat::min<INT64>( length, 1024*1024 );
+  indri::file::SequentialReadBuffer* buffer = new indri::file::SequentialReadBuffer( _invertedFile, lemur_compat::min<INT64>( length, 1024*1024 ) );
+  buffer->readAhead( startOffset, startOffset + length );
+
+  DiskDocListIterator* iterator = new DiskDocListIterator( buffer, startOffset, 0 );
+  indri::index::PostingBlockCache* cache = indri::index::PostingBlockCache::instance();
+
+  if( cache && cache->admits( documentCount ) )
+    iterator->setBlockCache( cache, _cacheID );
 
-  return new DiskDocListIterator( new indri::file::SequentialReadBuffer( _invertedFile, length ), startOffset, 0 );
+  return iterator;
 }
 
 //
@@ -475,12 +554,20 @@ indri::index::DocListIterator* indri::index::DiskIndex::docListIterator( const s
 
   INT64 startOffset = data->startOffset;
   INT64 length = data->length;
+  UINT64 documentCount = data->termData->corpus.documentCount;
   ::disktermdata_delete( data );
 
   // truncate the length argument at 1MB, use it to pick a size for the readbuffer
-  length = lemur_compat::min<INT64>( length, 1024*1024 );
+  indri::file::SequentialReadBuffer* buffer = new indri::file::SequentialReadBuffer( _invertedFile, lemur_compat::min<INT64>( length, 1024*1024 ) );
+  buffer->readAhead( startOffset, startOffset + length );
 
-  return new DiskDocListIterator( new indri::file::SequentialReadBuffer( _invertedFile, length ), startOffset, (int)_fieldData.size() );
+  DiskDocListIterator* iterator = new DiskDocListIterator( buffer, startOffset, (int)_fieldData.size() );
+  indri::index::PostingBlockCache* cache = indri::index::PostingBlockCache::instance();
+
+  if( cache && cache->admits( documentCount ) )
+    iterator->setBlockCache( cache, _cacheID );
+
+  return iterator;
 }
 
 //
@@ -501,7 +588,10 @@ indri::index::DocExtentListIterator* indri::index::DiskIndex::fieldListIterator(
   }
 
   UINT64 byteOffset = _fieldData[fieldID-1].byteOffset;
-  return new DiskDocExtentListIterator( new indri::file::SequentialReadBuffer( _fieldsFile ), byteOffset );
+  indri::file::SequentialReadBuffer* buffer = new indri::file::SequentialReadBuffer( _fieldsFile );
+  buffer->readAhead( byteOffset );
+
+  return new DiskDocExtentListIterator( buffer, byteOffset );
 }
 
 //
@@ -528,6 +618,12 @@ const indri::index::TermList* indri::index::DiskIndex::termList( lemur::api::DOC
   _documentStatistics.read( &documentData, (documentID-1)*sizeof(DocumentData), sizeof(DocumentData) );
   
   TermList* termList = new TermList;
+
+  if( _directFile.mapping() && documentData.offset + documentData.byteLength <= _directFile.mappingLength() ) {
+    termList->read( _directFile.mapping() + documentData.offset, documentData.byteLength );
+    return termList;
+  }
+
   char* buffer = new char[documentData.byteLength];
 
   _directFile.read( buffer, documentData.offset, documentData.byteLength );
@@ -580,6 +676,46 @@ indri::index::DocumentDataIterator* indri::index::DiskIndex::documentDataIterato
   return new indri::index::DiskDocumentDataIterator( _documentStatistics );
 }
 
+//
+// impactList
+//
+// The impact term tree has a block cache of its own, so this takes a
+// lock even when the statistics lock isn't needed.
+//
+
+indri::index::ImpactList* indri::index::DiskIndex::impactList( const std::string& term ) {
+  if( !_impactLists )
+    return 0;
+
+  indri::thread::ScopedLock lock( _impactLock );
+  UINT64 location[2];
+  int actual;
+
+  if( !_impactTerms.get( term.c_str(), (char*) location, actual, sizeof(location) ) )
+    return 0;
+
+  assert( actual == sizeof(location) );
+  ImpactList* list = new ImpactList;
+  list->read( _impactFile, location[0], location[1] );
+  return list;
+}
+
+//
+// phraseListIterator
+//
+
+indri::index::DocExtentListIterator* indri::index::DiskIndex::phraseListIterator( const std::string& phrase ) {
+  std::map<std::string, UINT64>::iterator iter = _phraseOffsets.find( phrase );
+
+  if( iter == _phraseOffsets.end() )
+    return 0;
+
+  indri::file::SequentialReadBuffer* buffer = new indri::file::SequentialReadBuffer( _phraseFile );
+  buffer->readAhead( iter->second );
+
+  return new DiskDocExtentListIterator( buffer, iter->second );
+}
+
 //
 // iteratorLock
 //
@@ -593,6 +729,10 @@ indri::thread::Lockable* indri::index::DiskIndex::iteratorLock() {
 //
 
 indri::thread::Lockable* indri::index::DiskIndex::statisticsLock() {
+  // with a term table, vocabulary lookups read only memory that never changes
+  if( _termTable.isOpen() )
+    return 0;
+
   return &_lock;
 }
 
@@ -24,7 +24,8 @@
 indri::infnet::DocListIteratorNode::DocListIteratorNode( const std::string& name, class InferenceNetwork& network, int listID ) :
   _name(name),
   _network(network),
-  _listID(listID)
+  _listID(listID),
+  _pending(0)
 {
 }
 
@@ -39,6 +40,14 @@ lemur::api::DOCID_T indri::infnet::DocListIteratorNode::nextCandidateDocument()
   return MAX_INT32;
 }
 
+//
+// prepare
+//
+// Positions are not copied (or, for disk lists, decoded) until
+// extents() is called, so a window whose other terms are missing
+// from the document never pays for them.
+//
+
 void indri::infnet::DocListIteratorNode::prepare( lemur::api::DOCID_T documentID ) {
   // initialize the child / sibling pointer
   initpointer();
@@ -46,23 +55,42 @@ void indri::infnet::DocListIteratorNode::prepare( lemur::api::DOCID_T documentID
   _extents.clear();
   _lastExtent.begin = -1;
   _lastExtent.end = -1;
+  _pending = 0;
 
-  if( !_list )
+  if( !_list || _list->finished() )
     return;
 
-  indri::index::DocListIterator::DocumentData* info = _list->currentEntry();
+  if( _list->currentDocument() == documentID )
+    _pending = documentID;
+}
 
-  if( !info || info->document != documentID )
-    return;
-  
-  indri::utility::greedy_vector<int>& positions = info->positions;
+//
+// hasExtents
+//
 
-  for( size_t i = 0; i < positions.size(); i++ ) {
-    _extents.push_back( indri::index::Extent( positions[i], positions[i]+1 ) );
-  }
+bool indri::infnet::DocListIteratorNode::hasExtents() {
+  return _pending != 0 || _extents.size() > 0;
 }
 
+//
+// extents
+//
+
 const indri::utility::greedy_vector<indri::index::Extent>& indri::infnet::DocListIteratorNode::extents() {
+  if( _pending ) {
+    indri::index::DocListIterator::DocumentData* info = _list->currentEntry();
+
+    if( info && info->document == _pending ) {
+      indri::utility::greedy_vector<int>& positions = info->positions;
+
+      for( size_t i = 0; i < positions.size(); i++ ) {
+        _extents.push_back( indri::index::Extent( positions[i], positions[i]+1 ) );
+      }
+    }
+
+    _pending = 0;
+  }
+
   return _extents;
 }
 
@@ -75,12 +103,14 @@ void indri::infnet::DocListIteratorNode::annotate( Annotator& annotator, lemur::
     // if the last extent we annotated contains this one, there is no work
     // to do.
     _lastExtent = extent;
+    extents();
     annotator.addMatches( _extents, this, documentID, extent );
   }
 }
 
 void indri::infnet::DocListIteratorNode::indexChanged( indri::index::Index& index ) {
   _list = _network.getDocIterator( _listID );
+  _pending = 0;
   _lastExtent.begin = -1;
   _lastExtent.end = -1;
 }
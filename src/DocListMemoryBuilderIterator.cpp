@@ -34,6 +34,7 @@ void indri::index::DocListMemoryBuilderIterator::startIteration() {
   
   _data.document = 0;
   _data.positions.clear();
+  _postingsDecoded = 0;
 
   nextEntry();
 }
@@ -67,6 +68,7 @@ void indri::index::DocListMemoryBuilderIterator::reset( const indri::utility::gr
   _data.positions.clear();
   _finished = false;
   _termData = termData;
+  _postingsDecoded = 0;
 
   nextEntry();
 }
@@ -113,6 +115,7 @@ bool indri::index::DocListMemoryBuilderIterator::nextEntry() {
     _list = lemur::utility::RVLCompress::decompress_int( _list, deltaDocument );
     _data.document += deltaDocument;
     _data.positions.clear();
+    _postingsDecoded++;
 
     _list = lemur::utility::RVLCompress::decompress_int( _list, extents );
 
@@ -179,3 +182,11 @@ indri::utility::greedy_vector<indri::index::DocListIterator::TopDocument>& indri
 indri::index::TermData* indri::index::DocListMemoryBuilderIterator::termData() {
   return _termData;
 }
+
+//
+// postingsDecoded
+//
+
+INT64 indri::index::DocListMemoryBuilderIterator::postingsDecoded() {
+  return _postingsDecoded;
+}
@@ -77,6 +77,22 @@ void indri::api::DocumentVector::_init( indri::index::Index* index, const indri:
 indri::api::DocumentVector::DocumentVector() {
 }
 
+indri::api::DocumentVector::DocumentVector( indri::index::Index* index, const indri::index::TermList* termList, Dictionary& dictionary ) {
+  const indri::utility::greedy_vector<int>& terms = termList->terms();
+  const indri::utility::greedy_vector<indri::index::FieldExtent>& fields = termList->fields();
+
+  _positions.resize( terms.size() );
+
+  for( size_t i=0; i<terms.size(); i++ )
+    _positions[i] = terms[i] ? dictionary.id( index, terms[i] ) : 0;
+
+  for( size_t i=0; i<fields.size(); i++ ) {
+    Field f(fields[i]);
+    f.name = index->field(fields[i].id);
+    _fields.push_back(f);
+  }
+}
+
 indri::api::DocumentVector::DocumentVector( indri::index::Index* index, const indri::index::TermList* termList ) {
   _init( index, termList, 0 );
 }
@@ -109,3 +125,66 @@ std::vector<indri::api::DocumentVector::Field>& indri::api::DocumentVector::fiel
   return _fields;
 }
 
+
+//
+// Dictionary
+//
+
+indri::api::DocumentVector::Dictionary::Dictionary() :
+  _stemIDs( 1<<18 )
+{
+  _stems.push_back( "[OOV]" );
+}
+
+//
+// ~Dictionary
+//
+
+indri::api::DocumentVector::Dictionary::~Dictionary() {
+  std::map< indri::index::Index*, indri::utility::HashTable<int, int>* >::iterator iter;
+
+  for( iter = _termIDs.begin(); iter != _termIDs.end(); iter++ )
+    delete iter->second;
+}
+
+//
+// id
+//
+// Term ids are only unique within one index, so each index has its
+// own table; the same stem found in two indexes gets one id.
+//
+
+int indri::api::DocumentVector::Dictionary::id( indri::index::Index* index, int termID ) {
+  indri::utility::HashTable<int, int>*& termIDs = _termIDs[index];
+
+  if( !termIDs )
+    termIDs = new indri::utility::HashTable<int, int>( 1<<18 );
+
+  int* found = termIDs->find( termID );
+
+  if( found )
+    return *found;
+
+  std::string stem = index->term( termID );
+  int* stemID = _stemIDs.find( stem );
+  int result;
+
+  if( stemID ) {
+    result = *stemID;
+  } else {
+    result = (int)_stems.size();
+    _stems.push_back( stem );
+    _stemIDs.insert( stem, result );
+  }
+
+  termIDs->insert( termID, result );
+  return result;
+}
+
+//
+// stems
+//
+
+std::vector<std::string>& indri::api::DocumentVector::Dictionary::stems() {
+  return _stems;
+}
@@ -22,9 +22,12 @@
 #ifndef WIN32
 #include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #endif
 
 #include "lemur/Exception.hpp"
+#include "lemur/lemur-compat.hpp"
 #include "indri/ScopedLock.hpp"
 
 //
@@ -33,10 +36,13 @@
 
 indri::file::File::File() :
 #ifdef WIN32
-  _handle(INVALID_HANDLE_VALUE)
+  _handle(INVALID_HANDLE_VALUE),
+  _mapping(NULL),
 #else
-  _handle(-1)
+  _handle(-1),
 #endif
+  _mapped(0),
+  _mappedLength(0)
 {
 }
 
@@ -222,6 +228,8 @@ size_t indri::file::File::write( const void* buffer, UINT64 position, size_t len
 }
 
 void indri::file::File::close() {
+  _unmap();
+
 #ifdef WIN32
   if( _handle != INVALID_HANDLE_VALUE ) {
     ::CloseHandle( _handle );
@@ -258,3 +266,112 @@ UINT64 indri::file::File::size() {
 #endif
 }
 
+
+//
+// map
+//
+
+const char* indri::file::File::map() {
+  if( _mapped )
+    return _mapped;
+
+  UINT64 length = size();
+
+  // an empty file has nothing to map, and a file too large for the
+  // address space is read as before
+  if( length == 0 || length != UINT64(size_t(length)) )
+    return 0;
+
+#ifdef WIN32
+  _mapping = ::CreateFileMapping( _handle, NULL, PAGE_READONLY, 0, 0, NULL );
+
+  if( _mapping == NULL )
+    return 0;
+
+  _mapped = (char*) ::MapViewOfFile( _mapping, FILE_MAP_READ, 0, 0, 0 );
+
+  if( !_mapped ) {
+    ::CloseHandle( _mapping );
+    _mapping = NULL;
+    return 0;
+  }
+#else // POSIX
+  void* mapped = ::mmap( 0, size_t(length), PROT_READ, MAP_SHARED, _handle, 0 );
+
+  if( mapped == MAP_FAILED )
+    return 0;
+
+  _mapped = (char*) mapped;
+
+#ifdef MADV_RANDOM
+  // lists are read from scattered places in the file; read ahead only when asked to
+  ::madvise( _mapped, size_t(length), MADV_RANDOM );
+#endif
+#endif
+
+  _mappedLength = length;
+  return _mapped;
+}
+
+//
+// _unmap
+//
+
+void indri::file::File::_unmap() {
+  if( !_mapped )
+    return;
+
+#ifdef WIN32
+  ::UnmapViewOfFile( _mapped );
+  ::CloseHandle( _mapping );
+  _mapping = NULL;
+#else
+  ::munmap( _mapped, size_t(_mappedLength) );
+#endif
+
+  _mapped = 0;
+  _mappedLength = 0;
+}
+
+//
+// mapping
+//
+
+const char* indri::file::File::mapping() const {
+  return _mapped;
+}
+
+//
+// mappingLength
+//
+
+UINT64 indri::file::File::mappingLength() const {
+  return _mappedLength;
+}
+
+//
+// willNeed
+//
+
+void indri::file::File::willNeed( UINT64 position, UINT64 length ) {
+#ifndef WIN32
+  if( !_mapped ) {
+#ifdef POSIX_FADV_WILLNEED
+    // starts the read in the background; the data waits in the page cache
+    ::posix_fadvise( _handle, off_t(position), off_t(length), POSIX_FADV_WILLNEED );
+#endif
+    return;
+  }
+
+#ifdef MADV_WILLNEED
+  if( position >= _mappedLength )
+    return;
+
+  static const UINT64 pageSize = UINT64( ::sysconf( _SC_PAGESIZE ) );
+  UINT64 begin = position - position % pageSize;
+  UINT64 end = lemur_compat::min<UINT64>( position + length, _mappedLength );
+
+  ::madvise( _mapped + begin, size_t(end - begin), MADV_WILLNEED );
+#endif
+#endif
+}
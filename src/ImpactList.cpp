@@ -0,0 +1,178 @@
+/*==========================================================================
+ * Copyright (c) 2004 University of Massachusetts.  All Rights Reserved.
+ *
+ * Use of the Lemur Toolkit for Language Modeling and Information Retrieval
+ * is subject to the terms of the software license set forth in the LICENSE
+ * file included with this software, and also available at
+ * http://www.lemurproject.org/license.html
+ *
+ *==========================================================================
+ */
+
+//
+// ImpactList
+//
+// List format:
+//   (4b) segment count
+//   segment headers: (4b count, 4b document count)*
+//   for each segment: (4b) first document, then the gaps between the
+//     remaining documents packed by PostingBlockCodec
+//
+
+#include "indri/ImpactList.hpp"
+#include "indri/DocListIterator.hpp"
+#include "indri/PostingBlockCodec.hpp"
+#include "lemur/Exception.hpp"
+#include <algorithm>
+
+//
+// entry_count_greater
+//
+
+struct entry_count_greater {
+  bool operator() ( const indri::index::ImpactList::Entry& one, const indri::index::ImpactList::Entry& two ) const {
+    return one.count > two.count;
+  }
+};
+
+//
+// encode
+//
+
+void indri::index::ImpactList::encode( indri::utility::Buffer& output, indri::utility::greedy_vector<Entry>& entries ) {
+  // documents stay in increasing order within each count
+  std::stable_sort( entries.begin(), entries.end(), entry_count_greater() );
+
+  size_t countPosition = output.position();
+  output.write( sizeof(UINT32) );
+  UINT32 segmentCount = 0;
+
+  for( size_t i=0; i<entries.size(); ) {
+    size_t end = i;
+    while( end < entries.size() && entries[end].count == entries[i].count )
+      end++;
+
+    UINT32 header[2];
+    header[0] = entries[i].count;
+    header[1] = UINT32(end - i);
+    memcpy( output.write( sizeof(header) ), header, sizeof(header) );
+
+    segmentCount++;
+    i = end;
+  }
+
+  memcpy( output.front() + countPosition, &segmentCount, sizeof(UINT32) );
+
+  indri::utility::greedy_vector<UINT32> gaps;
+
+  for( size_t i=0; i<entries.size(); ) {
+    size_t end = i;
+    while( end < entries.size() && entries[end].count == entries[i].count )
+      end++;
+
+    UINT32 first = entries[i].document;
+    memcpy( output.write( sizeof(UINT32) ), &first, sizeof(UINT32) );
+
+    gaps.clear();
+    for( size_t j=i+1; j<end; j++ )
+      gaps.push_back( entries[j].document - entries[j-1].document );
+
+    PostingBlockCodec::encode( output, gaps.size() ? &gaps[0] : 0, (int)gaps.size() );
+    i = end;
+  }
+}
+
+//
+// _parse
+//
+
+void indri::index::ImpactList::_parse() {
+  const char* data = _data.front();
+  UINT32 segmentCount;
+  memcpy( &segmentCount, data, sizeof(UINT32) );
+  data += sizeof(UINT32);
+
+  _segments.resize( segmentCount );
+
+  for( UINT32 i=0; i<segmentCount; i++ ) {
+    memcpy( &_segments[i].count, data, sizeof(UINT32) );
+    memcpy( &_segments[i].documentCount, data + sizeof(UINT32), sizeof(UINT32) );
+    data += 2*sizeof(UINT32);
+  }
+
+  for( UINT32 i=0; i<segmentCount; i++ ) {
+    _segments[i].data = data;
+    data = PostingBlockCodec::skip( data + sizeof(UINT32), _segments[i].documentCount - 1 );
+  }
+
+  assert( data <= _data.front() + _data.position() );
+}
+
+//
+// read
+//
+
+void indri::index::ImpactList::read( indri::file::File& file, UINT64 offset, UINT64 length ) {
+  _data.clear();
+  size_t actual = file.read( _data.write( length ), offset, length );
+
+  if( actual != length )
+    LEMUR_THROW( LEMUR_IO_ERROR, "Couldn't read an impact list" );
+
+  _parse();
+}
+
+//
+// build
+//
+
+void indri::index::ImpactList::build( DocListIterator* iterator ) {
+  indri::utility::greedy_vector<Entry> entries;
+
+  for( ; !iterator->finished(); iterator->nextEntry() ) {
+    Entry entry;
+    entry.count = iterator->currentCount();
+    entry.document = iterator->currentDocument();
+    entries.push_back( entry );
+  }
+
+  _data.clear();
+  encode( _data, entries );
+  _parse();
+}
+
+//
+// size
+//
+
+size_t indri::index::ImpactList::size() const {
+  return _segments.size();
+}
+
+//
+// segment
+//
+
+const indri::index::ImpactList::Segment& indri::index::ImpactList::segment( size_t index ) const {
+  return _segments[index];
+}
+
+//
+// documents
+//
+
+void indri::index::ImpactList::documents( size_t index, indri::utility::greedy_vector<lemur::api::DOCID_T>& documents ) {
+  const Segment& segment = _segments[index];
+  UINT32 first;
+
+  memcpy( &first, segment.data, sizeof(UINT32) );
+  _values.resize( segment.documentCount );
+  _values[0] = first;
+
+  PostingBlockCodec::decode( segment.data + sizeof(UINT32), &_values[0] + 1, segment.documentCount - 1 );
+  PostingBlockCodec::prefixSum( &_values[0] + 1, segment.documentCount - 1, first );
+
+  documents.resize( segment.documentCount );
+  for( UINT32 i=0; i<segment.documentCount; i++ )
+    documents[i] = _values[i];
+}
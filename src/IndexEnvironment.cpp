@@ -24,13 +24,238 @@
 #include "indri/IndriTokenizer.hpp"
 #include "indri/Path.hpp"
 #include "indri/Conflater.hpp"
+#include "indri/Thread.hpp"
+#include "indri/Mutex.hpp"
+#include "indri/ConditionVariable.hpp"
+#include "indri/ScopedLock.hpp"
+#include "indri/delete_range.hpp"
+#include "indri/Buffer.hpp"
 #include <iostream>
+#include <deque>
+
+// bytes of parsed documents a worker may queue for one file
+static const size_t INGEST_FILE_MEMORY = 8*1024*1024;
+
+//
+// ingest_document
+//
+// A parsed document copied into memory of its own.  Parsers, annotators
+// and stemmers reuse their buffers for the next document, so a worker
+// copies each document before moving on.
+//
+
+struct ingest_document {
+  ingest_document() : indexed(false) {}
+
+  indri::api::ParsedDocument document;
+  std::vector<indri::parse::TagExtent> tags;
+  indri::utility::Buffer strings;
+  // the worker already added the document to its repository shard
+  bool indexed;
+
+  size_t memorySize() const {
+    return sizeof(ingest_document) + strings.size() +
+      tags.size() * sizeof(indri::parse::TagExtent) +
+      document.terms.size() * sizeof(char*) +
+      document.positions.size() * sizeof(indri::parse::TermExtent) +
+      document.metadata.size() * sizeof(indri::parse::MetadataPair);
+  }
+};
+
+//
+// ingest_file
+//
+
+struct indri::api::IndexEnvironment::ingest_file {
+  ingest_file( const std::string& name, const std::string& fileClass,
+               const std::string& documentRoot, const std::string& anchorTextRoot ) :
+    fileName(name),
+    fileClass(fileClass),
+    documentRoot(documentRoot),
+    anchorTextRoot(anchorTextRoot),
+    memory(0),
+    started(false),
+    opened(false),
+    finished(false),
+    skipped(false),
+    failed(false)
+  {
+  }
+
+  std::string fileName;
+  std::string fileClass;
+  std::string documentRoot;
+  std::string anchorTextRoot;
+
+  // parsed documents waiting to be added; a null entry is a document
+  // that was seen but not indexed
+  std::deque<ingest_document*> documents;
+  size_t memory;
+
+  bool started;  // the worker opened the file
+  bool opened;   // FileOpen was reported
+  bool finished; // the worker is done with the file
+  bool skipped;
+  bool failed;
+  std::string error;
+};
+
+//
+// ingest_worker
+//
+
+struct indri::api::IndexEnvironment::ingest_worker {
+  IndexEnvironment* environment;
+  indri::thread::Thread* thread;
+  int shard;
+  std::map<std::string, indri::parse::FileClassEnvironment*> environments;
+  std::vector<indri::parse::Transformation*> transformations;
+  indri::parse::AnchorTextAnnotator annotator;
+};
+
+//
+// ingest_pipeline
+//
+
+struct indri::api::IndexEnvironment::ingest_pipeline {
+  indri::thread::Mutex lock;
+  // signalled when a file is queued, or the workers should quit
+  indri::thread::ConditionVariable fileReady;
+  // signalled when a document is queued or a file is finished
+  indri::thread::ConditionVariable documentReady;
+  // signalled when documents are taken from a file
+  indri::thread::ConditionVariable spaceReady;
+
+  // every file not yet written, in the order given to addFile
+  std::deque<ingest_file*> files;
+  // files no worker has started
+  std::deque<ingest_file*> pending;
+
+  std::vector<ingest_worker*> workers;
+  bool quit;
+};
+
+//
+// copy_string
+//
+
+static char* copy_string( indri::utility::Buffer& strings, const char* text, size_t length ) {
+  char* copy = strings.write( length );
+  memcpy( copy, text, length );
+  return copy;
+}
+
+//
+// copy_document
+//
+
+static void copy_document( indri::api::ParsedDocument* document, ingest_document* copy ) {
+  indri::api::ParsedDocument& result = copy->document;
+  bool contentInText = document->content >= document->text &&
+                       document->content + document->contentLength <= document->text + document->textLength;
+
+  // find the space needed, so the strings never move
+  size_t length = document->textLength;
+
+  if( !contentInText )
+    length += document->contentLength;
+
+  for( size_t i=0; i<document->terms.size(); i++ ) {
+    if( document->terms[i] )
+      length += strlen( document->terms[i] ) + 1;
+  }
+
+  for( size_t i=0; i<document->tags.size(); i++ ) {
+    indri::parse::TagExtent* tag = document->tags[i];
+    length += strlen( tag->name ) + 1;
+
+    for( size_t j=0; j<tag->attributes.size(); j++ ) {
+      length += strlen( tag->attributes[j].attribute ) + 1;
+      length += strlen( tag->attributes[j].value ) + 1;
+    }
+  }
+
+  for( size_t i=0; i<document->metadata.size(); i++ ) {
+    length += strlen( document->metadata[i].key ) + 1;
+    length += document->metadata[i].valueLength;
+  }
+
+  copy->strings.grow( length );
+
+  result.text = copy_string( copy->strings, document->text, document->textLength );
+  result.textLength = document->textLength;
+
+  if( contentInText )
+    result.content = result.text + ( document->content - document->text );
+  else
+    result.content = copy_string( copy->strings, document->content, document->contentLength );
+  result.contentLength = document->contentLength;
+
+  for( size_t i=0; i<document->terms.size(); i++ ) {
+    char* term = document->terms[i];
+
+    if( term )
+      term = copy_string( copy->strings, term, strlen( term ) + 1 );
+
+    result.terms.push_back( term );
+  }
+
+  result.positions = document->positions;
+
+  for( size_t i=0; i<document->metadata.size(); i++ ) {
+    indri::parse::MetadataPair pair = document->metadata[i];
+    pair.key = copy_string( copy->strings, pair.key, strlen( pair.key ) + 1 );
+    pair.value = copy_string( copy->strings, (const char*) pair.value, pair.valueLength );
+    result.metadata.push_back( pair );
+  }
+
+  // tags point at their parents, so copy them all before linking
+  std::map<indri::parse::TagExtent*, size_t> tagIndex;
+  copy->tags.resize( document->tags.size() );
+
+  for( size_t i=0; i<document->tags.size(); i++ ) {
+    indri::parse::TagExtent* tag = document->tags[i];
+    indri::parse::TagExtent& tagCopy = copy->tags[i];
+
+    tagCopy = *tag;
+    tagCopy.name = copy_string( copy->strings, tag->name, strlen( tag->name ) + 1 );
+
+    for( size_t j=0; j<tagCopy.attributes.size(); j++ ) {
+      indri::parse::AttributeValuePair& pair = tagCopy.attributes[j];
+      pair.attribute = copy_string( copy->strings, pair.attribute, strlen( pair.attribute ) + 1 );
+      pair.value = copy_string( copy->strings, pair.value, strlen( pair.value ) + 1 );
+    }
+
+    tagIndex[tag] = i;
+  }
+
+  for( size_t i=0; i<copy->tags.size(); i++ ) {
+    indri::parse::TagExtent& tagCopy = copy->tags[i];
+
+    if( tagCopy.parent ) {
+      std::map<indri::parse::TagExtent*, size_t>::iterator parent = tagIndex.find( tagCopy.parent );
+      tagCopy.parent = ( parent == tagIndex.end() ) ? 0 : &copy->tags[parent->second];
+    }
+
+    result.tags.push_back( &tagCopy );
+  }
+}
+
 
 void indri::api::IndexEnvironment::_getParsingContext( indri::parse::Parser** parser,
                                                        indri::parse::Tokenizer** tokenizer,
                                                        indri::parse::DocumentIterator** iterDoc,
                                                        indri::parse::Conflater** conflater,
                                                        const std::string& className ) {
+  _getParsingContext( _environments, parser, tokenizer, iterDoc, conflater, className );
+}
+
+void indri::api::IndexEnvironment::_getParsingContext( std::map<std::string, indri::parse::FileClassEnvironment*>& environments,
+                                                       indri::parse::Parser** parser,
+                                                       indri::parse::Tokenizer** tokenizer,
+                                                       indri::parse::DocumentIterator** iterDoc,
+                                                       indri::parse::Conflater** conflater,
+                                                       const std::string& className ) {
   std::string parserName;
   std::string iteratorName;
 
@@ -41,9 +266,9 @@ void indri::api::IndexEnvironment::_getParsingContext( indri::parse::Parser** pa
 
   // look for an already-built environment
   std::map<std::string, indri::parse::FileClassEnvironment*>::iterator iter;
-  iter = _environments.find(className);
+  iter = environments.find(className);
 
-  if( iter != _environments.end() ) {
+  if( iter != environments.end() ) {
     *parser = iter->second->parser;
     *tokenizer = iter->second->tokenizer;
     *iterDoc = iter->second->iterator;
@@ -54,7 +279,7 @@ void indri::api::IndexEnvironment::_getParsingContext( indri::parse::Parser** pa
   indri::parse::FileClassEnvironment* fce = _fileClassFactory.get( className );
 
   if( fce ) {
-    _environments[className] = fce;
+    environments[className] = fce;
     *parser = fce->parser;
     *tokenizer = fce->tokenizer;
     *iterDoc = fce->iterator;
@@ -133,7 +358,10 @@ indri::api::IndexEnvironment::IndexEnvironment() :
   _callback(0),
   _options(0),
   _documentsIndexed(0),
-  _documentsSeen(0)
+  _documentsSeen(0),
+  _pipeline(0),
+  _threads(1),
+  _orderDocuments(true)
 {
 }
 
@@ -167,6 +395,14 @@ void indri::api::IndexEnvironment::setStoreDocs( bool flag ) {
   _parameters.set( "storeDocs", flag );
 }
 
+void indri::api::IndexEnvironment::setInvertedListCodec( const std::string& codec ) {
+  _parameters.set( "invertedListCodec", codec );
+}
+
+void indri::api::IndexEnvironment::setImpactLists( bool flag ) {
+  _parameters.set( "impactLists", flag );
+}
+
 void indri::api::IndexEnvironment::setInjectURL( bool flag ) {
   _parameters.set( "injectURL", flag );
 }
@@ -175,6 +411,17 @@ void indri::api::IndexEnvironment::setMemory( UINT64 memory ) {
   _parameters.set("memory", memory);
 }
 
+void indri::api::IndexEnvironment::setThreads( int threads ) {
+  _finishFiles();
+  _stopPipeline();
+  _threads = threads;
+}
+
+void indri::api::IndexEnvironment::setOrderDocuments( bool flag ) {
+  _finishFiles();
+  _orderDocuments = flag;
+}
+
 void indri::api::IndexEnvironment::setOffsetAnnotationsPath( const std::string& offsetAnnotationsRoot ) {
   _offsetAnnotationsRoot = offsetAnnotationsRoot;
 }
@@ -199,6 +446,15 @@ void indri::api::IndexEnvironment::setStopwords( const std::vector<std::string>&
   }
 }
 
+void indri::api::IndexEnvironment::setPhrases( int minimumCount, const std::vector<std::string>& phrases ) {
+  _parameters.set("phrases","");
+  Parameters p = _parameters.get("phrases");
+  p.set("minimumCount", minimumCount);
+  for( unsigned int i=0; i<phrases.size(); i++ ) {
+    p.append("phrase").set(phrases[i]);
+  }
+}
+
 void indri::api::IndexEnvironment::setStemmer( const std::string& stemmer ) {
   _parameters.set("stemmer.name", stemmer);
 }
@@ -355,6 +611,7 @@ void indri::api::IndexEnvironment::open( const std::string& repositoryPath, indr
 //
 
 void indri::api::IndexEnvironment::close() {
+  _stopPipeline();
   _repository.close();
 }
 
@@ -372,6 +629,35 @@ void indri::api::IndexEnvironment::addFile( const std::string& fileName ) {
 //
 
 void indri::api::IndexEnvironment::addFile( const std::string& fileName, const std::string& fileClass ) {
+  if( _threads <= 1 || _offsetAnnotationsRoot.length() || _offsetMetadataRoot.length() ) {
+    _finishFiles();
+    _addFile( fileName, fileClass );
+    return;
+  }
+
+  if( !_pipeline )
+    _startPipeline();
+
+  ingest_file* file = new ingest_file( fileName, fileClass, _documentRoot, _anchorTextRoot );
+
+  {
+    indri::thread::ScopedLock lock( _pipeline->lock );
+    _pipeline->files.push_back( file );
+    _pipeline->pending.push_back( file );
+    _pipeline->fileReady.notifyOne();
+  }
+
+  // let the workers run ahead by a few files
+  _writeDocuments( 2 * _threads );
+}
+
+//
+// _addFile
+//
+// Parses and adds a file on the calling thread.
+//
+
+void indri::api::IndexEnvironment::_addFile( const std::string& fileName, const std::string& fileClass ) {
   indri::parse::Parser* parser = 0;
   indri::parse::Tokenizer* tokenizer = 0;
   indri::parse::DocumentIterator* iterator = 0;
@@ -442,11 +728,332 @@ void indri::api::IndexEnvironment::addFile( const std::string& fileName, const s
   }
 }
 
+//
+// _startPipeline
+//
+
+void indri::api::IndexEnvironment::_startPipeline() {
+  _pipeline = new ingest_pipeline;
+  _pipeline->quit = false;
+
+  for( int i=0; i<_threads; i++ ) {
+    ingest_worker* worker = new ingest_worker;
+    worker->environment = this;
+    worker->shard = i;
+    worker->transformations = _repository.createTransformations();
+    worker->thread = new indri::thread::Thread( _ingestStart, worker );
+    _pipeline->workers.push_back( worker );
+  }
+}
+
+//
+// _stopPipeline
+//
+
+void indri::api::IndexEnvironment::_stopPipeline() {
+  if( !_pipeline )
+    return;
+
+  _writeDocuments( 0 );
+
+  {
+    indri::thread::ScopedLock lock( _pipeline->lock );
+    _pipeline->quit = true;
+    _pipeline->fileReady.notifyAll();
+  }
+
+  for( size_t i=0; i<_pipeline->workers.size(); i++ ) {
+    ingest_worker* worker = _pipeline->workers[i];
+    worker->thread->join();
+
+    delete worker->thread;
+    indri::utility::delete_vector_contents( worker->transformations );
+    indri::utility::delete_map_contents<std::string, indri::parse::FileClassEnvironment>( worker->environments );
+    delete worker;
+  }
+
+  delete _pipeline;
+  _pipeline = 0;
+}
+
+//
+// _finishFiles
+//
+// Waits until every queued file has been added to the repository.
+//
+
+void indri::api::IndexEnvironment::_finishFiles() {
+  if( _pipeline )
+    _writeDocuments( 0 );
+}
+
+//
+// _ingestStart
+//
+
+void indri::api::IndexEnvironment::_ingestStart( void* pointer ) {
+  ingest_worker* worker = (ingest_worker*) pointer;
+  worker->environment->_ingest( worker );
+}
+
+//
+// _ingest
+//
+// Runs on a worker thread: parses files until the pipeline stops.
+//
+
+void indri::api::IndexEnvironment::_ingest( ingest_worker* worker ) {
+  _pipeline->lock.lock();
+
+  while( true ) {
+    while( !_pipeline->quit && _pipeline->pending.empty() )
+      _pipeline->fileReady.wait( _pipeline->lock );
+
+    if( _pipeline->pending.empty() )
+      break;
+
+    ingest_file* file = _pipeline->pending.front();
+    _pipeline->pending.pop_front();
+    _pipeline->lock.unlock();
+
+    _ingestFile( worker, file );
+
+    _pipeline->lock.lock();
+    file->finished = true;
+    _pipeline->documentReady.notifyAll();
+  }
+
+  _pipeline->lock.unlock();
+}
+
+//
+// _ingestFile
+//
+// Runs on a worker thread: parses, annotates and transforms each
+// document of a file, then queues a copy for _writeDocuments.
+//
+
+void indri::api::IndexEnvironment::_ingestFile( ingest_worker* worker, ingest_file* file ) {
+  indri::parse::Parser* parser = 0;
+  indri::parse::Tokenizer* tokenizer = 0;
+  indri::parse::DocumentIterator* iterator = 0;
+  indri::parse::Conflater* conflater = 0;
+
+  _getParsingContext( worker->environments, &parser, &tokenizer, &iterator, &conflater, file->fileClass );
+
+  if( !parser || !iterator ) {
+    indri::thread::ScopedLock lock( _pipeline->lock );
+    file->skipped = true;
+    return;
+  }
+
+  try {
+    indri::parse::UnparsedDocument* document;
+    std::vector<indri::parse::Transformation*> annotators;
+
+    iterator->open( file->fileName );
+
+    if( file->anchorTextRoot.length() ) {
+      std::string relativePath = indri::file::Path::relative( file->documentRoot, file->fileName );
+      std::string anchorTextPath;
+      if( relativePath.length() > 0 )
+        anchorTextPath = indri::file::Path::combine( file->anchorTextRoot, relativePath );
+      else
+        anchorTextPath = file->anchorTextRoot;
+      worker->annotator.open( anchorTextPath );
+      annotators.push_back( &worker->annotator );
+    }
+
+    {
+      indri::thread::ScopedLock lock( _pipeline->lock );
+      file->started = true;
+    }
+
+    while( (document = iterator->nextDocument()) ) {
+      indri::parse::TokenizedDocument* tokenized = tokenizer->tokenize( document );
+      ParsedDocument* parsed = parser->parse( tokenized );
+      parsed = _applyAnnotators( annotators, parsed );
+
+      std::string docIDStr = "";
+      for( size_t i=0; i<parsed->metadata.size(); i++ ) {
+        const char * key = parsed->metadata[i].key;
+        if( !strcmp( key, "docno" ) ) {
+          docIDStr = (const char *)parsed->metadata[i].value;
+          break;
+        }
+      }
+
+      ingest_document* copy = 0;
+      size_t memory = 0;
+
+      if( _blackedDocs.find(docIDStr) == _blackedDocs.end() ) {
+        for( size_t i=0; i<worker->transformations.size(); i++ )
+          parsed = worker->transformations[i]->transform( parsed );
+
+        if( _orderDocuments ) {
+          copy = new ingest_document;
+          copy_document( parsed, copy );
+          memory = copy->memorySize();
+        } else if( _repository.collection()->retrieveIDByMetadatum( "docno", docIDStr ).size() == 0 ) {
+          // when order doesn't matter, each worker adds to its own shard
+          _repository.addTransformedDocument( parsed, true, worker->shard );
+          copy = new ingest_document;
+          copy->indexed = true;
+          memory = copy->memorySize();
+        }
+      }
+
+      indri::thread::ScopedLock lock( _pipeline->lock );
+
+      while( file->memory > INGEST_FILE_MEMORY && !file->failed )
+        _pipeline->spaceReady.wait( _pipeline->lock );
+
+      // the writer gave up on this file
+      if( file->failed ) {
+        delete copy;
+        break;
+      }
+
+      file->documents.push_back( copy );
+      file->memory += memory;
+      _pipeline->documentReady.notifyAll();
+    }
+
+    iterator->close();
+  } catch( lemur::api::Exception& e ) {
+    iterator->close();
+
+    indri::thread::ScopedLock lock( _pipeline->lock );
+    if( !file->failed ) {
+      file->failed = true;
+      file->error = e.what();
+    }
+  }
+}
+
+//
+// _writeDocuments
+//
+// Runs on the calling thread: adds parsed documents to the repository
+// until no more than pendingFiles files are left unwritten.  When
+// documents are kept in order, only the oldest file is written from.
+//
+
+void indri::api::IndexEnvironment::_writeDocuments( size_t pendingFiles ) {
+  _pipeline->lock.lock();
+
+  while( true ) {
+    ingest_file* file = 0;
+    size_t index;
+
+    for( index=0; index<_pipeline->files.size(); index++ ) {
+      ingest_file* candidate = _pipeline->files[index];
+
+      if( candidate->documents.size() || candidate->finished ) {
+        file = candidate;
+        break;
+      }
+
+      if( _orderDocuments )
+        break;
+    }
+
+    if( !file ) {
+      if( _pipeline->files.size() <= pendingFiles )
+        break;
+
+      _pipeline->documentReady.wait( _pipeline->lock );
+      continue;
+    }
+
+    if( file->documents.empty() ) {
+      // the file is finished and written
+      _pipeline->files.erase( _pipeline->files.begin() + index );
+      _pipeline->lock.unlock();
+
+      if( file->skipped ) {
+        _documentsSeen++;
+        if( _callback ) (*_callback) ( indri::api::IndexStatus::FileSkip, file->fileName, _error, _documentsIndexed, _documentsSeen );
+      } else {
+        if( file->started && !file->opened ) {
+          if( _callback ) (*_callback)( indri::api::IndexStatus::FileOpen, file->fileName, _error, _documentsIndexed, _documentsSeen );
+        }
+
+        if( file->failed ) {
+          if( _callback ) (*_callback)( indri::api::IndexStatus::FileError, file->fileName, file->error, _documentsIndexed, _documentsSeen );
+        } else {
+          if( _callback ) (*_callback)( indri::api::IndexStatus::FileClose, file->fileName, _error, _documentsIndexed, _documentsSeen );
+        }
+      }
+
+      delete file;
+      _pipeline->lock.lock();
+      continue;
+    }
+
+    ingest_document* document = file->documents.front();
+    file->documents.pop_front();
+    if( document )
+      file->memory -= document->memorySize();
+    _pipeline->spaceReady.notifyAll();
+    _pipeline->lock.unlock();
+
+    if( !file->opened ) {
+      file->opened = true;
+      if( _callback ) (*_callback)( indri::api::IndexStatus::FileOpen, file->fileName, _error, _documentsIndexed, _documentsSeen );
+    }
+
+    _documentsSeen++;
+
+    if( document && document->indexed ) {
+      _documentsIndexed++;
+      delete document;
+    } else if( document ) {
+      try {
+        std::string docIDStr = "";
+        for( size_t i=0; i<document->document.metadata.size(); i++ ) {
+          if( !strcmp( document->document.metadata[i].key, "docno" ) ) {
+            docIDStr = (const char *)document->document.metadata[i].value;
+            break;
+          }
+        }
+
+        // look up the id.
+        std::vector<lemur::api::DOCID_T> ids = _repository.collection()->retrieveIDByMetadatum("docno", docIDStr);
+        // if not found, add the document.
+        if (ids.size() == 0)  {
+          _repository.addTransformedDocument( &document->document );
+          _documentsIndexed++;
+        }
+      } catch( lemur::api::Exception& e ) {
+        // drop the rest of this file, as _addFile would
+        indri::thread::ScopedLock lock( _pipeline->lock );
+        file->failed = true;
+        file->error = e.what();
+
+        for( size_t i=0; i<file->documents.size(); i++ )
+          delete file->documents[i];
+        file->documents.clear();
+        file->memory = 0;
+        _pipeline->spaceReady.notifyAll();
+      }
+
+      delete document;
+    }
+
+    if( _callback ) (*_callback)( indri::api::IndexStatus::DocumentCount, file->fileName, _error, _documentsIndexed, _documentsSeen );
+    _pipeline->lock.lock();
+  }
+
+  _pipeline->lock.unlock();
+}
+
 //
 // addString
 //
 
 lemur::api::DOCID_T indri::api::IndexEnvironment::addString( const std::string& documentString, const std::string& fileClass, const std::vector<indri::parse::MetadataPair>& metadata ) {
+  _finishFiles();
   indri::parse::UnparsedDocument document;
   indri::parse::Parser* parser;
   indri::parse::Tokenizer* tokenizer;
@@ -483,6 +1090,7 @@ lemur::api::DOCID_T indri::api::IndexEnvironment::addString( const std::string&
 //
 lemur::api::DOCID_T indri::api::IndexEnvironment::addString( const std::string& documentString, const std::string&
                                              fileClass, const std::vector<indri::parse::MetadataPair>& metadata, const std::vector<indri::parse::TagExtent *> &tags ) {
+  _finishFiles();
   indri::parse::UnparsedDocument document;
   indri::parse::Parser* parser;
   indri::parse::Tokenizer* tokenizer;
@@ -533,6 +1141,7 @@ lemur::api::DOCID_T indri::api::IndexEnvironment::addString( const std::string&
 //
 
 lemur::api::DOCID_T indri::api::IndexEnvironment::addParsedDocument( ParsedDocument* document ) {
+  _finishFiles();
   std::string nothing;
 
   _documentsSeen++;
@@ -548,6 +1157,7 @@ lemur::api::DOCID_T indri::api::IndexEnvironment::addParsedDocument( ParsedDocum
 //
 
 void indri::api::IndexEnvironment::deleteDocument( lemur::api::DOCID_T documentID ) {
+  _finishFiles();
   _repository.deleteDocument( documentID );
 }
 
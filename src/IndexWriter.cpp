@@ -28,11 +28,15 @@
 #include "indri/DiskTermData.hpp"
 #include "indri/TermBitmap.hpp"
 #include "indri/DiskDocListIterator.hpp"
+#include "indri/DiskTermListFileIterator.hpp"
 #include "indri/DiskIndex.hpp"
 #include "indri/DocumentDataIterator.hpp"
 #include "indri/MemoryIndex.hpp"
 #include "indri/BulkTree.hpp"
 #include "indri/DeletedDocumentList.hpp"
+#include "indri/PostingBlockCodec.hpp"
+#include "indri/TermTable.hpp"
+#include "lemur/Exception.hpp"
 
 #include "indri/IndriTimer.hpp"
 const int KEYFILE_MEMORY_SIZE = 128*1024;
@@ -53,10 +57,52 @@ indri::utility::IndriTimer g_t;
 // IndexWriter constructor
 //
 
-IndexWriter::IndexWriter()
+IndexWriter::IndexWriter() :
+  _listCodec( "block" ),
+  _impactLists( true ),
+  _impactOutput( 0 ),
+  _impactTerms( 0 ),
+  _phraseMinimumCount( 0 ),
+  _phraseCounts( 0 )
 {
 }
 
+//
+// setListCodec
+//
+
+void IndexWriter::setListCodec( const std::string& codec ) {
+  if( codec != "block" && codec != "vbyte" )
+    LEMUR_THROW( LEMUR_BAD_PARAMETER_ERROR, "Unknown inverted list codec: " + codec );
+
+  _listCodec = codec;
+}
+
+//
+// setImpactLists
+//
+
+void IndexWriter::setImpactLists( bool flag ) {
+  _impactLists = flag;
+}
+
+//
+// setPhrases
+//
+
+void IndexWriter::setPhrases( int minimumCount, const std::vector<std::string>& phrases ) {
+  for( size_t i=0; i<phrases.size(); i++ ) {
+    size_t split = phrases[i].find( ' ' );
+
+    if( split == 0 || split == std::string::npos || split+1 == phrases[i].size() ||
+        phrases[i].find( ' ', split+1 ) != std::string::npos )
+      LEMUR_THROW( LEMUR_BAD_PARAMETER_ERROR, "A phrase must be two terms separated by a space: " + phrases[i] );
+  }
+
+  _phraseMinimumCount = minimumCount;
+  _phrases = phrases;
+}
+
 //
 // _writeSkip
 //
@@ -89,6 +135,8 @@ void IndexWriter::_writeManifest( const std::string& path ) {
   manifest.set( "type", "DiskIndex" );
   manifest.set( "code-build-date", __DATE__ );
   manifest.set( "indri-distribution", INDRI_DISTRIBUTION );
+  manifest.set( "inverted-list-codec", _listCodec );
+  manifest.set( "impact-lists", _impactLists );
 
   manifest.set( "corpus", "" );
   indri::api::Parameters corpus = manifest["corpus"];
@@ -117,6 +165,21 @@ void IndexWriter::_writeManifest( const std::string& path ) {
     field[i].set("byte-offset", (UINT64) _fieldData[i].byteOffset);
   }
 
+  if( _phraseData.size() ) {
+    manifest.set( "phrases", "" );
+    indri::api::Parameters phrases = manifest["phrases"];
+
+    for( size_t i=0; i<_phraseData.size(); i++ ) {
+      phrases.append("phrase");
+      indri::api::Parameters phrase = phrases["phrase"];
+
+      phrase[i].set("name", _phraseData[i].name);
+      phrase[i].set("total-documents", (UINT64) _phraseData[i].documentCount);
+      phrase[i].set("total-terms", (UINT64) _phraseData[i].totalCount);
+      phrase[i].set("byte-offset", (UINT64) _phraseData[i].byteOffset);
+    }
+  }
+
   manifest.writeFile( path );
 }
 
@@ -159,6 +222,16 @@ void IndexWriter::_constructFiles( const std::string& path ) {
   _fieldsFile.create( fieldsFilePath );
 
   _invertedOutput = new indri::file::SequentialWriteBuffer( _invertedFile, OUTPUT_BUFFER_SIZE );
+
+  if( _impactLists ) {
+    std::string impactFilePath = indri::file::Path::combine( path, "impactFile" );
+    std::string impactTermsPath = indri::file::Path::combine( path, "impactTerms" );
+
+    _impactFile.create( impactFilePath );
+    _impactOutput = new indri::file::SequentialWriteBuffer( _impactFile, OUTPUT_BUFFER_SIZE );
+    _impactTerms = new indri::file::BulkTreeWriter();
+    _impactTerms->create( impactTermsPath );
+  }
 }
 
 //
@@ -186,6 +259,7 @@ void IndexWriter::_closeFiles( const std::string& path ) {
   _invertedFile.close();
   _directFile.close();
   _fieldsFile.close();
+  _impactFile.close();
 
   // write a manifest file
   _writeManifest( manifestPath );
@@ -203,6 +277,48 @@ void IndexWriter::_openTermsReaders( const std::string& path ) {
   _frequentTermsReader.openRead( frequentStringPath );
 }
 
+//
+// _writeTermTable
+//
+// Copies the frequent and infrequent ID trees, in termID order, into a
+// TermTable that DiskIndex can read without locking.
+//
+
+void IndexWriter::_writeTermTable( const std::string& path ) {
+  const char* trees[] = { "frequentID", "infrequentID" };
+  // infrequent termIDs follow the frequent ones
+  lemur::api::TERMID_T bases[] = { 0, _topTermsCount };
+
+  indri::index::TermTableWriter table;
+  table.create( indri::file::Path::combine( path, "termTable" ) );
+
+  for( int i=0; i<2; i++ ) {
+    indri::file::BulkTreeReader reader;
+    reader.openRead( indri::file::Path::combine( path, trees[i] ) );
+    indri::file::BulkTreeIterator* iterator = reader.iterator();
+
+    for( iterator->startIteration(); !iterator->finished(); iterator->nextEntry() ) {
+      UINT32 termID;
+      int actual;
+
+      if( !iterator->get( termID, _compressedData, _dataSize, actual ) )
+        continue;
+
+      indri::utility::RVLDecompressStream stream( _compressedData, actual );
+      indri::index::DiskTermData* diskTermData = ::disktermdata_decompress( stream, _uncompressedData, (int)_fields.size(),
+                                                                            indri::index::DiskTermData::WithString |
+                                                                            indri::index::DiskTermData::WithOffsets );
+
+      table.add( bases[i] + termID, diskTermData->termData->term, _compressedData, actual );
+    }
+
+    delete iterator;
+    reader.close();
+  }
+
+  table.close();
+}
+
 //
 // write
 //
@@ -239,6 +355,7 @@ void IndexWriter::write( std::vector<Index*>& indexes,
   LOGMESSAGE( "Writing Inverted Lists" );
   _writeInvertedLists( contexts );
   LOGMESSAGE( "Inverted Lists Complete" );
+  _writeTermTable( path );
   _writeFieldLists( contexts, path );
   LOGMESSAGE( "Fields Complete" );
 
@@ -246,6 +363,7 @@ void IndexWriter::write( std::vector<Index*>& indexes,
 
   _writeDirectLists( contexts );
   LOGMESSAGE( "Direct Lists Complete" );
+  _writePhraseLists( contexts, path );
 
   delete[](_compressedData);
   delete[](_uncompressedData);
@@ -278,12 +396,14 @@ void IndexWriter::write( std::vector<indri::index::Index*>& indexes,
   LOGMESSAGE( "Writing Inverted Lists" );
   _writeInvertedLists( contexts );
   LOGMESSAGE( "Inverted Lists Complete" );
+  _writeTermTable( path );
   _writeFieldLists( contexts, path );
   LOGMESSAGE( "Fields Complete" );
 
   _openTermsReaders( path );
   _writeDirectLists( contexts );
   LOGMESSAGE( "Direct Lists Complete" );
+  _writePhraseLists( contexts, path );
 
   delete[](_compressedData);
   delete[](_uncompressedData);
@@ -507,16 +627,126 @@ void IndexWriter::_writeFieldList( indri::file::SequentialWriteBuffer& output,
   _writeBatch( &output, -1, (int)dataBuffer.position(), dataBuffer );
 }
 
+//
+// _encodeBlock
+//
+// Block-coded batch is:
+//   (1b) entry count
+//   (4b) first document
+//   packed document gaps (entry count - 1 of them)
+//   packed position counts
+//   (4b) byte length of the positions section
+//   packed position gaps, delta encoded within each document
+//
+
+void IndexWriter::_encodeBlock( indri::utility::Buffer& listBuffer ) {
+  UINT8 entries = (UINT8) _blockDocuments.size();
+
+  if( !entries )
+    return;
+
+  *listBuffer.write(1) = entries;
+  memcpy( listBuffer.write( sizeof(UINT32) ), &_blockDocuments[0], sizeof(UINT32) );
+
+  for( int i=entries-1; i>0; i-- )
+    _blockDocuments[i] -= _blockDocuments[i-1];
+
+  PostingBlockCodec::encode( listBuffer, &_blockDocuments[0] + 1, entries - 1 );
+  PostingBlockCodec::encode( listBuffer, &_blockCounts[0], entries );
+
+  size_t lengthPosition = listBuffer.position();
+  listBuffer.write( sizeof(UINT32) );
+  PostingBlockCodec::encode( listBuffer, _blockPositions.size() ? &_blockPositions[0] : 0, (int)_blockPositions.size() );
+  UINT32 positionsLength = (UINT32) (listBuffer.position() - lengthPosition - sizeof(UINT32));
+  memcpy( listBuffer.front() + lengthPosition, &positionsLength, sizeof(UINT32) );
+
+  _blockDocuments.clear();
+  _blockCounts.clear();
+  _blockPositions.clear();
+}
+
+//
+// _writeBlock
+//
+// Writes the pending block behind a skip to nextDocument, and records
+// where it went, and bounds on its scores, in the skip table.
+//
+
+void IndexWriter::_writeBlock( lemur::api::DOCID_T nextDocument, UINT64 dataStart, indri::utility::Buffer& listBuffer ) {
+  if( _blockDocuments.size() ) {
+    DiskDocListIterator::BlockSkip skip;
+    skip.lastDocument = _blockDocuments.back();
+    skip.offset = _invertedOutput->tell() - dataStart;
+    skip.fractionCount = 0;
+    skip.fractionLength = 1;
+    skip.maximumCount = 0;
+    skip.minimumLength = 0;
+    skip.maximumLength = 0;
+
+    // score bounds for the block; lengths are only gathered for lists with a skip table
+    for( size_t i=0; i<_blockLengths.size(); i++ ) {
+      UINT32 count = _blockCounts[i];
+      UINT32 length = _blockLengths[i];
+
+      if( UINT64(count) * skip.fractionLength > UINT64(skip.fractionCount) * length ) {
+        skip.fractionCount = count;
+        skip.fractionLength = length;
+      }
+
+      if( count > skip.maximumCount )
+        skip.maximumCount = count;
+
+      if( i == 0 || length < skip.minimumLength )
+        skip.minimumLength = length;
+      if( length > skip.maximumLength )
+        skip.maximumLength = length;
+    }
+
+    _blockSkips.push_back( skip );
+    _blockLengths.clear();
+
+    _encodeBlock( listBuffer );
+  }
+
+  _writeBatch( _invertedOutput, nextDocument, (int)listBuffer.position(), listBuffer );
+}
+
+//
+// _writeImpactList
+//
+// Writes the impact-ordered copy of the list gathered in _impactEntries
+// to the impact file, and records where it went under the term's name.
+//
+
+void IndexWriter::_writeImpactList( indri::index::TermData* termData ) {
+  if( _impactEntries.size() >= ImpactList::MINIMUM_DOCUMENTS ) {
+    UINT64 location[2];
+
+    _impactBuffer.clear();
+    ImpactList::encode( _impactBuffer, _impactEntries );
+
+    location[0] = _impactOutput->tell();
+    location[1] = _impactBuffer.position();
+    _impactOutput->write( _impactBuffer.front(), _impactBuffer.position() );
+    _impactTerms->put( termData->term, (const char*) location, sizeof(location) );
+  }
+
+  _impactEntries.clear();
+}
+
 //
 // _addInvertedListData
 //
 // Inverted list is:
 //   termData (as written by _writeStatistics)
-//   control byte -- hasTopdocs(0x1)
+//   control byte -- hasTopdocs(0x1), isFrequent(0x2), isBlockCoded(0x4), hasSkipTable(0x8), hasBlockBounds(0x10)
 //   optional topdocs list: topdocsCount + (document/count/length)+
+//   optional skip table: skipCount + reservedCount +
+//     (lastDocument/offset/fractionCount/fractionLength/maximumCount/minimumLength/maximumLength)*reservedCount
 //   ( [skip: document/skipLength] (doc/positionCount/positions+)+ )
 // (-1) signifies there's no more skips
-// 
+//
+// Block-coded lists put exactly one block (see _encodeBlock) after each skip.
 //
 
 void IndexWriter::_addInvertedListData( indri::utility::greedy_vector<WriterIndexContext*>& lists,
@@ -532,18 +762,30 @@ void IndexWriter::_addInvertedListData( indri::utility::greedy_vector<WriterInde
   bool isFrequent = termData->corpus.totalCount > FREQUENT_TERM_COUNT;
   int topdocsCount = hasTopdocs ? int(termData->corpus.documentCount * 0.01) : 0;
   int topdocsSpace = hasTopdocs ? (topdocsCount*(sizeof(lemur::api::DOCID_T) + (2*sizeof(UINT32))) + sizeof(int)) : 0;
+  bool isBlockCoded = (_listCodec == "block");
+
+  // block-coded lists that span more than one block get a skip table; the
+  // document count may include deleted documents, so this is an upper bound
+  int reservedSkips = isBlockCoded ? int((termData->corpus.documentCount + PostingBlockCodec::BLOCK_SIZE - 1) / PostingBlockCodec::BLOCK_SIZE) : 0;
+  bool hasSkipTable = reservedSkips > 1;
+  int skipTableSpace = hasSkipTable ? (2*sizeof(UINT32) + reservedSkips*(sizeof(lemur::api::DOCID_T) + sizeof(UINT64) + 5*sizeof(UINT32))) : 0;
 
-  // write a control byte
-  char control = (hasTopdocs ? 0x01 : 0) | (isFrequent ? 0x02 : 0);
+  // write a control byte; skip tables always carry block bounds
+  char control = (hasTopdocs ? 0x01 : 0) | (isFrequent ? 0x02 : 0) | (isBlockCoded ? 0x04 : 0) | (hasSkipTable ? 0x18 : 0);
   _invertedOutput->write( &control, 1 );
 
   UINT64 initialPosition = _invertedOutput->tell();
+  UINT64 skipTablePosition = initialPosition + topdocsSpace;
+  UINT64 dataStart = skipTablePosition + skipTableSpace;
 
-  // leave some room for the topdocs list
-  if( hasTopdocs ) {
-    _invertedOutput->seek( topdocsSpace + initialPosition );
+  // leave some room for the topdocs list and skip table
+  if( hasTopdocs || hasSkipTable ) {
+    _invertedOutput->seek( dataStart );
   }
 
+  _blockSkips.clear();
+  _blockLengths.clear();
+
   // maintain a list of top documents
   std::priority_queue<DocListIterator::TopDocument,
     std::vector<DocListIterator::TopDocument>,
@@ -582,9 +824,17 @@ void IndexWriter::_addInvertedListData( indri::utility::greedy_vector<WriterInde
       // add to document counter
       docs++; listDocs++;
 
+      if( _impactLists ) {
+        ImpactList::Entry entry;
+        entry.count = (UINT32) documentData->positions.size();
+        entry.document = storedDocument;
+        _impactEntries.push_back( entry );
+      }
+
+      int length = ( hasTopdocs || hasSkipTable ) ? index->documentLength( documentData->document ) : 0;
+
       // update the topdocs list
       if( hasTopdocs ) {
-        int length = index->documentLength( documentData->document );
         int count = (int)documentData->positions.size();
 
         // compute DocListIterator::TopDocument::greater (current, top())
@@ -607,6 +857,30 @@ void IndexWriter::_addInvertedListData( indri::utility::greedy_vector<WriterInde
         }
       }
       
+      if( isBlockCoded ) {
+        if( _blockDocuments.size() == PostingBlockCodec::BLOCK_SIZE ) {
+          _writeBlock( storedDocument, dataStart, listBuffer );
+        }
+
+        assert( _blockDocuments.size() == 0 || storedDocument > (lemur::api::DOCID_T) _blockDocuments.back() );
+
+        _blockDocuments.push_back( storedDocument );
+        _blockCounts.push_back( (UINT32) documentData->positions.size() );
+        if( hasSkipTable )
+          _blockLengths.push_back( (UINT32) length );
+
+        int lastPosition = 0;
+
+        for( size_t i=0; i<documentData->positions.size(); i++ ) {
+          _blockPositions.push_back( documentData->positions[i] - lastPosition );
+          lastPosition = documentData->positions[i];
+          positions++; listPositions++;
+        }
+
+        iterator->nextEntry();
+        continue;
+      }
+
       if( listBuffer.position() > minimumSkip ) {
         // time to write in a skip
         _writeBatch( _invertedOutput, storedDocument, (int)listBuffer.position(), listBuffer );
@@ -634,10 +908,39 @@ void IndexWriter::_addInvertedListData( indri::utility::greedy_vector<WriterInde
     }
   }
 
+  if( _impactLists )
+    _writeImpactList( termData );
+
   // write in the final skip info
-  _writeBatch( _invertedOutput, -1, (int)listBuffer.position(), listBuffer );
+  if( isBlockCoded )
+    _writeBlock( -1, dataStart, listBuffer );
+  else
+    _writeBatch( _invertedOutput, -1, (int)listBuffer.position(), listBuffer );
   UINT64 finalPosition = _invertedOutput->tell();
 
+  if( hasSkipTable ) {
+    // if the reservation was somehow too small, write an empty table;
+    // readers fall back to following the skips one at a time
+    UINT32 skipCount = ( (int)_blockSkips.size() <= reservedSkips ) ? (UINT32)_blockSkips.size() : 0;
+    UINT32 reservedCount = reservedSkips;
+
+    _invertedOutput->seek( skipTablePosition );
+    _invertedOutput->write( &skipCount, sizeof(UINT32) );
+    _invertedOutput->write( &reservedCount, sizeof(UINT32) );
+
+    for( UINT32 i=0; i<skipCount; i++ ) {
+      _invertedOutput->write( &_blockSkips[i].lastDocument, sizeof(lemur::api::DOCID_T) );
+      _invertedOutput->write( &_blockSkips[i].offset, sizeof(UINT64) );
+      _invertedOutput->write( &_blockSkips[i].fractionCount, sizeof(UINT32) );
+      _invertedOutput->write( &_blockSkips[i].fractionLength, sizeof(UINT32) );
+      _invertedOutput->write( &_blockSkips[i].maximumCount, sizeof(UINT32) );
+      _invertedOutput->write( &_blockSkips[i].minimumLength, sizeof(UINT32) );
+      _invertedOutput->write( &_blockSkips[i].maximumLength, sizeof(UINT32) );
+    }
+
+    _invertedOutput->seek( finalPosition );
+  }
+
   if( hasTopdocs ) {
     _invertedOutput->seek( initialPosition );
     _invertedOutput->write( &topdocsCount, sizeof(int) );
@@ -718,6 +1021,12 @@ void IndexWriter::_storeFrequentTerms() {
     _topTerms[i]->termID = termID;
     _storeIdEntry( _frequentTerms, _topTerms[i] );
 
+    // a pair can't occur more often than either of its terms, so only
+    // the most frequent terms (the first termIDs) are counted
+    if( _phraseMinimumCount > 0 &&
+        _topTerms[i]->termData->corpus.totalCount >= (UINT64) _phraseMinimumCount )
+      _phraseTerms.push_back( _topTerms[i]->termData->term );
+
     ::disktermdata_compress( stream,
                              _topTerms[i],
                              (int)_fields.size(),
@@ -729,6 +1038,12 @@ void IndexWriter::_storeFrequentTerms() {
     intermediateBuffer.clear();
   }
 
+  if( _phraseTerms.size() ) {
+    // about a bucket for every pair that could be counted, up to a million
+    size_t buckets = std::min<size_t>( _phraseTerms.size() * _phraseTerms.size(), 1<<20 );
+    _phraseCounts = new indri::utility::HashTable<UINT64, UINT64>( buckets * sizeof(void*) );
+  }
+
   // now, sort in alpha order
   std::sort( _topTerms.begin(), _topTerms.end(), disktermdata_alpha_less() );
 
@@ -876,6 +1191,16 @@ void IndexWriter::_writeInvertedLists( std::vector<WriterIndexContext*>& context
   _invertedOutput->flush();
   delete _invertedOutput;
   _invertedFile.close();
+
+  if( _impactLists ) {
+    _impactOutput->flush();
+    delete _impactOutput;
+    _impactOutput = 0;
+    _impactTerms->close();
+    delete _impactTerms;
+    _impactTerms = 0;
+    _impactFile.close();
+  }
 }
 
 //
@@ -1053,6 +1378,9 @@ void IndexWriter::_writeDirectLists( WriterIndexContext* context,
     for( size_t i=0; i<fieldCount; i++ ) {
       writeList.addField( fields[i] );
     }
+
+    if( _phraseCounts )
+      _countPhrases( writeList );
     }
   
     // record the start position
@@ -1129,3 +1457,211 @@ void IndexWriter::_writeDirectLists( std::vector<WriterIndexContext*>& contexts
   delete dataBuffer;
 }
 
+
+//
+// _countPhrases
+//
+// Counts the adjacent pairs of frequent terms in a document, in
+// new termIDs.  Pairs are keyed by their position in a
+// frequent term by frequent term matrix.
+//
+
+void IndexWriter::_countPhrases( const TermList& list ) {
+  const indri::utility::greedy_vector<lemur::api::TERMID_T>& terms = list.terms();
+  lemur::api::TERMID_T termCount = (lemur::api::TERMID_T) _phraseTerms.size();
+
+  for( size_t i=1; i<terms.size(); i++ ) {
+    lemur::api::TERMID_T first = terms[i-1];
+    lemur::api::TERMID_T second = terms[i];
+
+    if( first <= 0 || first > termCount || second <= 0 || second > termCount )
+      continue;
+
+    UINT64 key = UINT64(first-1) * termCount + UINT64(second-1);
+    UINT64* count = _phraseCounts->find( key );
+
+    if( count )
+      (*count)++;
+    else
+      _phraseCounts->insert( key, 1 );
+  }
+}
+
+//
+// phrase_list_buffer
+//
+// A phrase list being built in memory: its finished batches (skip
+// header and data), and the documents of the batch in progress.
+//
+
+struct phrase_list_buffer {
+  indri::utility::Buffer batches;
+  indri::utility::Buffer pending;
+  lemur::api::DOCID_T lastDocument;
+
+  phrase_list_buffer() : lastDocument(0) {}
+};
+
+//
+// _writePhraseLists
+//
+// Phrase lists have the field list format (see _writeFieldList), with
+// a two term extent for each place the first term is followed by the
+// second.  They are found in one pass over the direct lists just
+// written, so all of them are held in memory until the pass is done.
+//
+
+void IndexWriter::_writePhraseLists( std::vector<WriterIndexContext*>& contexts, const std::string& path ) {
+  std::vector<std::string> phrases = _phrases;
+
+  if( _phraseCounts ) {
+    indri::utility::HashTable<UINT64, UINT64>::iterator iter;
+    UINT64 termCount = _phraseTerms.size();
+
+    for( iter = _phraseCounts->begin(); iter != _phraseCounts->end(); iter++ ) {
+      if( *iter->second < (UINT64) _phraseMinimumCount )
+        continue;
+
+      UINT64 key = *iter->first;
+      phrases.push_back( _phraseTerms[key / termCount] + " " + _phraseTerms[key % termCount] );
+    }
+
+    delete _phraseCounts;
+    _phraseCounts = 0;
+  }
+
+  _phraseTerms.clear();
+
+  if( phrases.size() == 0 )
+    return;
+
+  std::sort( phrases.begin(), phrases.end() );
+  phrases.erase( std::unique( phrases.begin(), phrases.end() ), phrases.end() );
+
+  // find each phrase by the new termIDs of its terms, keyed like the
+  // counts; a phrase with a term missing from this index gets an empty list
+  UINT64 termCount = UINT64(_corpus.uniqueTerms) + 1;
+  indri::utility::HashTable<UINT64, size_t> phraseKeys( std::max<size_t>( 16384, 2 * phrases.size() * sizeof(void*) ) );
+  std::vector<phrase_list_buffer*> lists;
+
+  for( size_t i=0; i<phrases.size(); i++ ) {
+    size_t split = phrases[i].find( ' ' );
+    std::string terms[2] = { phrases[i].substr( 0, split ), phrases[i].substr( split+1 ) };
+    lemur::api::TERMID_T termIDs[2];
+
+    for( int j=0; j<2; j++ ) {
+      termIDs[j] = _lookupTermID( _frequentTermsReader, terms[j].c_str() );
+
+      if( termIDs[j] <= 0 )
+        termIDs[j] = _lookupTermID( _infrequentTermsReader, terms[j].c_str() );
+    }
+
+    if( termIDs[0] > 0 && termIDs[1] > 0 )
+      phraseKeys.insert( UINT64(termIDs[0]) * termCount + UINT64(termIDs[1]), i );
+
+    PhraseStatistics phrase;
+    phrase.name = phrases[i];
+    phrase.byteOffset = 0;
+    phrase.documentCount = 0;
+    phrase.totalCount = 0;
+
+    _phraseData.push_back( phrase );
+    lists.push_back( new phrase_list_buffer );
+  }
+
+  indri::file::File directFile;
+  directFile.openRead( indri::file::Path::combine( path, "directFile" ) );
+  DiskTermListFileIterator* iterator = new DiskTermListFileIterator( directFile );
+  iterator->startIteration();
+
+  // (phrase index, begin) for each match in a document
+  indri::utility::greedy_vector< std::pair<size_t, int> > matches;
+  const int minimumSkip = 1<<12; //4k
+
+  for( size_t i=0; i<contexts.size(); i++ ) {
+    Index* index = contexts[i]->index;
+
+    // the direct file has an entry for every document of every index,
+    // with no terms for deleted documents
+    for( lemur::api::DOCID_T document = index->documentBase(); document < index->documentMaximum(); document++ ) {
+      assert( !iterator->finished() );
+      const indri::utility::greedy_vector<lemur::api::TERMID_T>& terms = iterator->currentEntry()->terms();
+      matches.clear();
+
+      for( size_t j=1; j<terms.size(); j++ ) {
+        size_t* phraseIndex = phraseKeys.find( UINT64(terms[j-1]) * termCount + UINT64(terms[j]) );
+
+        if( phraseIndex )
+          matches.push_back( std::make_pair( *phraseIndex, (int)j-1 ) );
+      }
+
+      iterator->nextEntry();
+
+      if( matches.size() == 0 )
+        continue;
+
+      std::sort( matches.begin(), matches.end() );
+      lemur::api::DOCID_T storedDocument = document + contexts[i]->documentOffset;
+
+      for( size_t j=0; j<matches.size(); ) {
+        size_t end = j;
+        while( end < matches.size() && matches[end].first == matches[j].first )
+          end++;
+
+        PhraseStatistics& phrase = _phraseData[matches[j].first];
+        phrase_list_buffer* list = lists[matches[j].first];
+
+        if( list->pending.position() > minimumSkip ) {
+          int length = (int)list->pending.position();
+
+          memcpy( list->batches.write( sizeof(lemur::api::DOCID_T) ), &storedDocument, sizeof(lemur::api::DOCID_T) );
+          memcpy( list->batches.write( sizeof(int) ), &length, sizeof(int) );
+          memcpy( list->batches.write( length ), list->pending.front(), length );
+          list->pending.clear();
+          list->lastDocument = 0;
+        }
+
+        // document difference, extent count, then (begin, length) pairs
+        indri::utility::RVLCompressStream stream( list->pending );
+        stream << ( storedDocument - list->lastDocument );
+        list->lastDocument = storedDocument;
+        stream << (int)(end - j);
+
+        int lastStart = 0;
+
+        for( size_t k=j; k<end; k++ ) {
+          stream << (matches[k].second - lastStart);
+          lastStart = matches[k].second;
+          stream << 2;
+        }
+
+        phrase.documentCount++;
+        phrase.totalCount += (end - j);
+        j = end;
+      }
+    }
+  }
+
+  delete iterator;
+  directFile.close();
+
+  _phraseFile.create( indri::file::Path::combine( path, "phraseFile" ) );
+  indri::file::SequentialWriteBuffer* output = new indri::file::SequentialWriteBuffer( _phraseFile, OUTPUT_BUFFER_SIZE );
+
+  for( size_t i=0; i<lists.size(); i++ ) {
+    _phraseData[i].byteOffset = output->tell();
+
+    UINT8 control = 0;
+    output->write( &control, sizeof(UINT8) );
+
+    if( lists[i]->batches.position() )
+      output->write( lists[i]->batches.front(), lists[i]->batches.position() );
+
+    _writeBatch( output, -1, (int)lists[i]->pending.position(), lists[i]->pending );
+    delete lists[i];
+  }
+
+  output->flush();
+  delete output;
+  _phraseFile.close();
+}
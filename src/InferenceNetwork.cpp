@@ -21,12 +21,94 @@
 
 #include "indri/DocListIterator.hpp"
 #include "indri/DocExtentListIterator.hpp"
+#include "indri/ScoredExtentAccumulator.hpp"
+#include "indri/WeightedAndNode.hpp"
+#include "indri/TermFrequencyBeliefNode.hpp"
 
 #include "indri/ScopedLock.hpp"
+#include "indri/Parameters.hpp"
 #include "indri/Thread.hpp"
+#include "indri/IndriTimer.hpp"
 #include "lemur/Exception.hpp"
+#include <algorithm>
+#include <math.h>
 
 const static int CLOSE_ITERATOR_RANGE = 5000;
+// documents scored between looks at the postings count and the clock
+const static int BUDGET_CHECK_INTERVAL = 64;
+// results entry holding the work done for a query; node names never start with '#'
+const static char* WORK_NAME = "#work";
+
+//
+// impact_segment
+//
+
+struct impact_segment {
+  double impact;
+  indri::index::ImpactList* list;
+  size_t index;
+
+  struct greater {
+    bool operator() ( const impact_segment& one, const impact_segment& two ) const {
+      return one.impact > two.impact;
+    }
+  };
+};
+
+//
+// impact_accumulator
+//
+// Partial scores of the documents in one partition, kept in pages of the
+// document range that are allocated only once a document in them is
+// reached, and only up to a memory limit.
+//
+
+class impact_accumulator {
+public:
+  enum { PAGE_DOCUMENTS = 64*1024 };
+
+  struct page {
+    double scores[PAGE_DOCUMENTS];
+    char reached[PAGE_DOCUMENTS];
+  };
+
+private:
+  std::vector<page*> _pages;
+  size_t _allocated;
+  size_t _maximumPages;
+
+public:
+  impact_accumulator( size_t range, INT64 memory ) :
+    _pages( (range + PAGE_DOCUMENTS - 1) / PAGE_DOCUMENTS, (page*) 0 ),
+    _allocated(0),
+    _maximumPages( size_t( lemur_compat::max<INT64>( memory, 0 ) / sizeof(page) ) )
+  {
+  }
+
+  ~impact_accumulator() {
+    for( size_t i=0; i<_pages.size(); i++ )
+      free( _pages[i] );
+  }
+
+  // @return the page holding offset, or 0 if it would exceed the memory limit or can't be allocated
+  page* find( size_t offset ) {
+    page*& result = _pages[ offset / PAGE_DOCUMENTS ];
+
+    if( !result ) {
+      if( _allocated >= _maximumPages )
+        return 0;
+
+      result = (page*) calloc( 1, sizeof(page) );
+
+      if( !result )
+        return 0;
+
+      _allocated++;
+    }
+
+    return result;
+  }
+};
 
 //
 // _moveDocListIterators
@@ -51,12 +133,19 @@ inline void indri::infnet::InferenceNetwork::_moveDocListIterators( lemur::api::
         (*iter)->nextEntry( candidate );
 
         if( !(*iter)->finished() &&
-            (*iter)->currentEntry()->document < _closeIteratorBound ) {
+            (*iter)->currentDocument() < _closeIteratorBound ) {
           _closeIterators.push_back( *iter );
         }
       }
     }
   }
+
+  // stored phrase lists stand in for windows, so they move with the terms
+  std::vector<indri::index::DocExtentListIterator*>::iterator piter;
+  for( piter = _phraseIterators.begin(); piter != _phraseIterators.end(); piter++ ) {
+    if( *piter )
+      (*piter)->nextEntry( candidate );
+  }
 }
 
 //
@@ -100,14 +189,25 @@ void indri::infnet::InferenceNetwork::_moveToDocument( lemur::api::DOCID_T candi
 //
 
 void indri::infnet::InferenceNetwork::_indexFinished( indri::index::Index& index ) {
+  for( size_t i=0; i<_docIterators.size(); i++ ) {
+    if( _docIterators[i] )
+      _work.postings += _docIterators[i]->postingsDecoded();
+  }
+
   // doc iterators
   indri::utility::delete_vector_contents<indri::index::DocListIterator*>( _docIterators );
 
   // field iterators
   indri::utility::delete_vector_contents<indri::index::DocExtentListIterator*>( _fieldIterators );
+
+  // phrase iterators
+  indri::utility::delete_vector_contents<indri::index::DocExtentListIterator*>( _phraseIterators );
   
   // prior iterators
   indri::utility::delete_vector_contents<indri::collection::PriorListIterator*>( _priorIterators );
+
+  // impact lists
+  indri::utility::delete_vector_contents<indri::index::ImpactList*>( _impactLists );
 }
 
 //
@@ -118,24 +218,55 @@ void indri::infnet::InferenceNetwork::_indexChanged( indri::index::Index& index
   _closeIterators.clear();
   _closeIteratorBound = -1;
 
+  // open every list before reading any of them: a disk index asks for
+  // the start of each list as it opens it, so the reads overlap instead
+  // of waiting on one another
+
   // doc iterators
-  for( size_t i=0; i<_termNames.size(); i++ ) {
-    indri::index::DocListIterator* iterator = index.docListIterator( _termNames[i] );
-    if( iterator )
-      iterator->startIteration();
+  for( size_t i=0; i<_termNames.size(); i++ )
+    _docIterators.push_back( index.docListIterator( _termNames[i] ) );
+
+  // field iterators
+  for( size_t i=0; i<_fieldNames.size(); i++ )
+    _fieldIterators.push_back( index.fieldListIterator( _fieldNames[i] ) );
+
+  // phrase iterators; indexes without a stored list match the window instead
+  for( size_t i=0; i<_phraseNames.size(); i++ )
+    _phraseIterators.push_back( index.phraseListIterator( _phraseNames[i] ) );
 
-    _docIterators.push_back( iterator );
+  for( size_t i=0; i<_docIterators.size(); i++ ) {
+    if( _docIterators[i] )
+      _docIterators[i]->startIteration();
   }
 
-  // field iterators
-  for( size_t i=0; i<_fieldNames.size(); i++ ) {
-    indri::index::DocExtentListIterator* iterator = index.fieldListIterator( _fieldNames[i] );
-    if( iterator )
-      iterator->startIteration();
+  for( size_t i=0; i<_fieldIterators.size(); i++ ) {
+    if( _fieldIterators[i] )
+      _fieldIterators[i]->startIteration();
+  }
 
-    _fieldIterators.push_back( iterator );
+  for( size_t i=0; i<_phraseIterators.size(); i++ ) {
+    if( _phraseIterators[i] )
+      _phraseIterators[i]->startIteration();
   }
-  
+
+  // impact lists; indexes without them (such as memory indexes) are
+  // evaluated a document at a time, unless every term is rare enough
+  // to group on the fly
+  _impactIndex = false;
+
+  if( _impactAccumulator ) {
+    _impactIndex = true;
+
+    for( size_t i=0; i<_termNames.size(); i++ ) {
+      indri::index::ImpactList* impacts = index.impactList( _termNames[i] );
+      _impactLists.push_back( impacts );
+
+      if( !impacts && _docIterators[i] &&
+          _docIterators[i]->termData()->corpus.documentCount >= indri::index::ImpactList::MINIMUM_DOCUMENTS )
+        _impactIndex = false;
+    }
+  }
+
   // prior iterators
   for( size_t i=0; i<_priorNames.size(); i++ ) {
     // TODO: this is wasteful, since the prior is associated with the whole collection,
@@ -208,7 +339,16 @@ void indri::infnet::InferenceNetwork::_evaluateDocument( indri::index::Index& in
 indri::infnet::InferenceNetwork::InferenceNetwork( indri::collection::Repository& repository ) :
   _repository(repository),
   _closeIteratorBound(-1),
-  _documentStructureHolderNode(0)
+  _documentStructureHolderNode(0),
+  _impactAccumulator(0),
+  _impactBudget(0),
+  _impactMemory(0),
+  _impactChecked(false),
+  _impactIndex(false),
+  _budgeted(false),
+  _deadline(0),
+  _nextBudgetCheck(0),
+  _workTime(0)
 {
 }
 
@@ -218,8 +358,10 @@ indri::infnet::InferenceNetwork::InferenceNetwork( indri::collection::Repository
 
 indri::infnet::InferenceNetwork::~InferenceNetwork() {
   indri::utility::delete_vector_contents<indri::index::DocExtentListIterator*>( _fieldIterators );
+  indri::utility::delete_vector_contents<indri::index::DocExtentListIterator*>( _phraseIterators );
   indri::utility::delete_vector_contents<indri::index::DocListIterator*>( _docIterators );
   indri::utility::delete_vector_contents<indri::collection::PriorListIterator*>( _priorIterators );
+  indri::utility::delete_vector_contents<indri::index::ImpactList*>( _impactLists );
   indri::utility::delete_vector_contents<indri::infnet::ListIteratorNode*>( _listIteratorNodes );
   indri::utility::delete_vector_contents<indri::infnet::BeliefNode*>( _beliefNodes );
   indri::utility::delete_vector_contents<indri::query::TermScoreFunction*>( _scoreFunctions );
@@ -235,6 +377,10 @@ indri::index::DocExtentListIterator* indri::infnet::InferenceNetwork::getFieldIt
   return _fieldIterators[index];
 }
 
+indri::index::DocExtentListIterator* indri::infnet::InferenceNetwork::getPhraseIterator( int index ) {
+  return _phraseIterators[index];
+}
+
 indri::collection::PriorListIterator* indri::infnet::InferenceNetwork::getPriorIterator( int index ) {
   return _priorIterators[index];
 }
@@ -249,6 +395,11 @@ int indri::infnet::InferenceNetwork::addFieldIterator( const std::string& fieldN
   return (int)_fieldNames.size()-1;
 }
 
+int indri::infnet::InferenceNetwork::addPhraseIterator( const std::string& phrase ) {
+  _phraseNames.push_back( phrase );
+  return (int)_phraseNames.size()-1;
+}
+
 int indri::infnet::InferenceNetwork::addPriorIterator( const std::string& priorName ) {
   _priorNames.push_back( priorName );
   return (int)_priorNames.size()-1;
@@ -282,14 +433,321 @@ const std::vector<indri::infnet::EvaluatorNode*>& indri::infnet::InferenceNetwor
   return _evaluators;
 }
 
-void indri::infnet::InferenceNetwork::_evaluateIndex( indri::index::Index& index ) {
+//
+// setBudget
+//
+
+void indri::infnet::InferenceNetwork::setBudget( const indri::api::QueryBudget& budget ) {
+  _budget = budget;
+  _budgeted = !budget.unlimited();
+  _deadline = indri::utility::IndriTimer::currentTime() + UINT64(budget.milliseconds) * 1000;
+  _nextBudgetCheck = 0;
+}
+
+//
+// getWork
+//
+
+indri::api::QueryWork indri::infnet::InferenceNetwork::getWork() const {
+  indri::api::QueryWork work = _work;
+  work.milliseconds = INT64(_workTime / 1000);
+  return work;
+}
+
+//
+// storeWork
+//
+
+void indri::infnet::InferenceNetwork::storeWork( MAllResults& results, const indri::api::QueryWork& work ) {
+  EvaluatorNode::MResults& lists = results[ WORK_NAME ];
+
+  lists[ "postings" ].push_back( indri::api::ScoredExtentResult( double(work.postings), 0 ) );
+  lists[ "documents" ].push_back( indri::api::ScoredExtentResult( double(work.documents), 0 ) );
+  lists[ "milliseconds" ].push_back( indri::api::ScoredExtentResult( double(work.milliseconds), 0 ) );
+  lists[ "partial" ].push_back( indri::api::ScoredExtentResult( work.partial ? 1.0 : 0.0, 0 ) );
+}
+
+//
+// loadWork
+//
+
+indri::api::QueryWork indri::infnet::InferenceNetwork::loadWork( MAllResults& results ) {
+  indri::api::QueryWork total;
+  MAllResults::iterator entry = results.find( WORK_NAME );
+
+  if( entry == results.end() )
+    return total;
+
+  EvaluatorNode::MResults& lists = entry->second;
+  std::vector<indri::api::ScoredExtentResult>& postings = lists[ "postings" ];
+  std::vector<indri::api::ScoredExtentResult>& documents = lists[ "documents" ];
+  std::vector<indri::api::ScoredExtentResult>& milliseconds = lists[ "milliseconds" ];
+  std::vector<indri::api::ScoredExtentResult>& partial = lists[ "partial" ];
+
+  for( size_t i=0; i<postings.size() && i<documents.size() && i<milliseconds.size() && i<partial.size(); i++ ) {
+    indri::api::QueryWork work;
+
+    work.postings = INT64(postings[i].score);
+    work.documents = INT64(documents[i].score);
+    work.milliseconds = INT64(milliseconds[i].score);
+    work.partial = partial[i].score != 0;
+
+    total.add( work );
+  }
+
+  return total;
+}
+
+//
+// _overBudget
+//
+// pendingDocuments have been reached but not counted in _work yet.
+// The iterators of the current index haven't been counted either.
+//
+
+bool indri::infnet::InferenceNetwork::_overBudget( INT64 pendingDocuments ) {
+  INT64 documents = _work.documents + pendingDocuments;
+  _nextBudgetCheck = _work.documents + BUDGET_CHECK_INTERVAL;
+
+  if( _budget.documents ) {
+    if( documents >= _budget.documents )
+      return true;
+
+    _nextBudgetCheck = lemur_compat::min( _nextBudgetCheck, _budget.documents );
+  }
+
+  if( _budget.postings ) {
+    INT64 postings = _work.postings;
+
+    for( size_t i=0; i<_docIterators.size(); i++ ) {
+      if( _docIterators[i] )
+        postings += _docIterators[i]->postingsDecoded();
+    }
+
+    if( postings >= _budget.postings )
+      return true;
+  }
+
+  if( _budget.milliseconds && indri::utility::IndriTimer::currentTime() >= _deadline )
+    return true;
+
+  return false;
+}
+
+//
+// _findImpactQuery
+//
+// A query whose only evaluator ranks a flat #combine or #weight of terms,
+// each scored by a function that splits off the document length, can be
+// scored a term segment at a time instead of a document at a time.
+//
+
+void indri::infnet::InferenceNetwork::_findImpactQuery() {
+  _impactChecked = true;
+
+  if( !indri::api::Parameters::instance().get( "impactEvaluation", true ) )
+    return;
+
+  if( _evaluators.size() != 1 || _complexEvaluators.size() != 1 ||
+      _fieldNames.size() || _priorNames.size() || _documentStructureHolderNode )
+    return;
+
+  ScoredExtentAccumulator* accumulator = dynamic_cast<ScoredExtentAccumulator*>( _complexEvaluators[0] );
+  if( !accumulator )
+    return;
+
+  WeightedAndNode* root = dynamic_cast<WeightedAndNode*>( accumulator->getBelief() );
+  if( !root || !root->termChildren( _impactTerms, _impactWeights ) )
+    return;
+
+  _impactAccumulator = accumulator;
+  _impactBudget = indri::api::Parameters::instance().get( "impactBudget", INT64(0) );
+  _impactMemory = indri::api::Parameters::instance().get( "impactMemory", INT64(64*1024*1024) );
+}
+
+//
+// _evaluateImpacts
+//
+// Score-at-a-time evaluation.  A term's score in a document splits into
+// occurrenceScore(count) - log(length + offset), so a document's score is
+//
+//   sum of w * occurrenceScore(0) - w * log(length + offset)  over all terms
+//   + sum of w * (occurrenceScore(count) - occurrenceScore(0))  over matching terms
+//
+// The second sum is accumulated from the segments of the terms' impact
+// lists, the segments with the largest contributions first; the first is
+// added once for each document that was reached.  If impactBudget is set,
+// no more segments are started once that many postings have been read, so
+// the ranking holds the documents with the largest contributions so far.
+//
+// Returns false, having added no results, if the partial scores would need
+// more than impactMemory bytes or can't be allocated; the partition must
+// then be scored a document at a time.
+//
+
+bool indri::infnet::InferenceNetwork::_evaluateImpacts( const Partition& partition ) {
+  indri::index::Index& index = *partition.index;
+
+  if( index.documentMaximum() == index.documentBase() )
+    return true;
+
+  lemur::api::DOCID_T firstDocument = partition.firstDocument;
+  lemur::api::DOCID_T lastDocument = lemur_compat::min( index.documentMaximum(), partition.lastDocument );
+
+  if( lastDocument < firstDocument )
+    return true;
+
+  std::vector<impact_segment> segments;
+  std::vector< std::pair<double, double> > lengthWeights;
+  double backgroundScore = 0;
+
+  for( size_t i=0; i<_impactTerms.size(); i++ ) {
+    indri::query::TermScoreFunction& function = _impactTerms[i]->scoreFunction();
+    int listID = _impactTerms[i]->listID();
+    double weight = _impactWeights[i];
+    double offset = 0;
+    double background = function.occurrenceScore( 0 );
+
+    function.splitsLength( offset );
+    backgroundScore += weight * background;
+
+    size_t j;
+    for( j=0; j<lengthWeights.size() && lengthWeights[j].first != offset; j++ )
+      ;
+    if( j == lengthWeights.size() )
+      lengthWeights.push_back( std::make_pair( offset, 0.0 ) );
+    lengthWeights[j].second += weight;
+
+    // terms without a stored impact list are grouped from their inverted lists
+    if( !_impactLists[listID] && _docIterators[listID] ) {
+      _impactLists[listID] = new indri::index::ImpactList;
+      _impactLists[listID]->build( _docIterators[listID] );
+    }
+
+    indri::index::ImpactList* list = _impactLists[listID];
+    if( !list )
+      continue;
+
+    for( j=0; j<list->size(); j++ ) {
+      impact_segment segment;
+      segment.impact = weight * ( function.occurrenceScore( list->segment(j).count ) - background );
+      segment.list = list;
+      segment.index = j;
+      segments.push_back( segment );
+    }
+  }
+
+  std::stable_sort( segments.begin(), segments.end(), impact_segment::greater() );
+
+  size_t range = size_t( lastDocument - firstDocument ) + 1;
+  impact_accumulator accumulator( range, _impactMemory );
+  indri::utility::greedy_vector<lemur::api::DOCID_T> documents;
+  INT64 postings = 0;
+  INT64 documentLimit = MAX_INT64;
+
+  if( _budgeted && _budget.documents )
+    documentLimit = _budget.documents - _work.documents;
+
+  for( size_t i=0; i<segments.size(); i++ ) {
+    if( _impactBudget > 0 && postings >= _impactBudget )
+      break;
+
+    if( _budgeted && _overBudget( documents.size() ) ) {
+      _work.partial = true;
+      break;
+    }
+
+    segments[i].list->documents( segments[i].index, _impactDocuments );
+    postings += _impactDocuments.size();
+    _work.postings += _impactDocuments.size();
+
+    lemur::api::DOCID_T* document = std::lower_bound( _impactDocuments.begin(), _impactDocuments.end(), firstDocument );
+    double impact = segments[i].impact;
+
+    for( ; document != _impactDocuments.end() && *document <= lastDocument; document++ ) {
+      size_t offset = size_t( *document - firstDocument );
+      impact_accumulator::page* page = accumulator.find( offset );
+
+      if( !page )
+        return false;
+
+      offset %= impact_accumulator::PAGE_DOCUMENTS;
+
+      if( !page->reached[offset] ) {
+        // the documents of a segment have equal impact, so any may be left out
+        if( INT64(documents.size()) >= documentLimit ) {
+          _work.partial = true;
+          continue;
+        }
+
+        page->reached[offset] = 1;
+        documents.push_back( *document );
+      }
+
+      page->scores[offset] += impact;
+    }
+  }
+
+  std::sort( documents.begin(), documents.end() );
+  _work.documents += documents.size();
+  indri::index::DeletedDocumentList::read_transaction* deleted = _repository.deletedList().getReadTransaction();
+
+  for( size_t i=0; i<documents.size(); i++ ) {
+    lemur::api::DOCID_T document = documents[i];
+
+    if( deleted->isDeleted( document ) )
+      continue;
+
+    int length = index.documentLength( document );
+    double score = backgroundScore;
+
+    for( size_t j=0; j<lengthWeights.size(); j++ )
+      score -= lengthWeights[j].second * log( double(length) + lengthWeights[j].first );
+
+    size_t offset = size_t( document - firstDocument );
+    impact_accumulator::page* page = accumulator.find( offset );
+
+    indri::index::Extent extent( 0, length );
+    indri::api::ScoredExtentResult result( extent );
+    result.score = score + page->scores[ offset % impact_accumulator::PAGE_DOCUMENTS ];
+    result.document = document;
+    _impactAccumulator->addResult( result );
+  }
+
+  delete deleted;
+  return true;
+}
+
+//
+// _evaluatePartition
+//
+
+void indri::infnet::InferenceNetwork::_evaluatePartition( const Partition& partition ) {
+  indri::index::Index& index = *partition.index;
+
+  if( _impactIndex ) {
+    indri::api::QueryWork work = _work;
+
+    if( _evaluateImpacts( partition ) )
+      return;
+
+    // too many documents reached to keep their partial scores; start
+    // the lists over, since some may have been read to build impact lists
+    _work = work;
+
+    for( size_t i=0; i<_docIterators.size(); i++ ) {
+      if( _docIterators[i] )
+        _docIterators[i]->startIteration();
+    }
+  }
+
   // don't need to do anything unless there are some
   // evaluators in the network that need full evaluation
 
   if( _complexEvaluators.size() ) {
-    lemur::api::DOCID_T maximumDocument = index.documentMaximum();
+    lemur::api::DOCID_T maximumDocument = lemur_compat::min( index.documentMaximum(), partition.lastDocument );
     
-    if (maximumDocument == index.documentBase()) {
+    if (index.documentMaximum() == index.documentBase()) {
       // empty memory index, nothing to score.
       return;
     }
@@ -300,12 +758,36 @@ void indri::infnet::InferenceNetwork::_evaluateIndex( indri::index::Index& index
     indri::index::DeletedDocumentList::read_transaction* deleted;
     deleted = _repository.deletedList().getReadTransaction();
 
+    // a partition may start partway through the index
+    if( partition.firstDocument > index.documentBase() ) {
+      _moveToDocument( partition.firstDocument );
+      lastCandidate = partition.firstDocument;
+    }
+
     while(1) {
       // ask the root node for a candidate document
       // this asks the whole inference network for the
       // first document that might possibly produce a
       // usable (above the max score threshold) score
       candidate = _nextCandidateDocument( deleted );
+      if( candidate < partition.firstDocument ) {
+        candidate = deleted->nextCandidateDocument( partition.firstDocument );
+      }
+
+      // conjunctive nodes (windows, #band, #filreq) only offer the largest
+      // document among their children, which some of the lists may not
+      // contain.  Skip the doc lists forward to the candidate and ask again,
+      // until no list moves the candidate any further; no positions are
+      // decoded and no node is prepared for the documents skipped here.
+      while( candidate != lastCandidate && candidate <= maximumDocument ) {
+        _moveDocListIterators( candidate );
+        lemur::api::DOCID_T next = _nextCandidateDocument( deleted );
+
+        if( next <= candidate )
+          break;
+        candidate = next;
+      }
+
       if (candidate < index.documentBase()) {
         std::cerr << candidate << " < index.documentBase()" << std::endl;
         break;
@@ -327,6 +809,12 @@ void indri::infnet::InferenceNetwork::_evaluateIndex( indri::index::Index& index
       // ask all the evaluators to evaluate this document
       _evaluateDocument( index, candidate );
       scoredDocuments++;
+      _work.documents++;
+
+      if( _budgeted && _work.documents >= _nextBudgetCheck && _overBudget() ) {
+        _work.partial = true;
+        break;
+      }
 
       // if that was the last document, we can quit now
       if( candidate+1 > maximumDocument )
@@ -351,22 +839,50 @@ const indri::infnet::InferenceNetwork::MAllResults& indri::infnet::InferenceNetw
 
   // fetch the current index state
   indri::collection::Repository::index_state indexes = _repository.indexes();
+  std::vector<Partition> partitions;
   
   for( size_t i=0; i<indexes->size(); i++ ) {
-    indri::index::Index& index = *(*indexes)[i];
+    Partition partition;
+    partition.index = (*indexes)[i];
+    partition.firstDocument = partition.index->documentBase();
+    partition.lastDocument = partition.index->documentMaximum();
+    partitions.push_back( partition );
+  }
+
+  return evaluate( partitions );
+}
+
+//
+// evaluate
+//
+
+const indri::infnet::InferenceNetwork::MAllResults& indri::infnet::InferenceNetwork::evaluate( const std::vector<Partition>& partitions ) {
+  if( !_impactChecked )
+    _findImpactQuery();
+
+  UINT64 start = indri::utility::IndriTimer::currentTime();
+
+  for( size_t i=0; i<partitions.size(); i++ ) {
+    // out of budget in an earlier partition
+    if( _work.partial )
+      break;
+
+    indri::index::Index& index = *partitions[i].index;
     indri::thread::ScopedLock iterators( index.iteratorLock() );
 
     indri::thread::ScopedLock statistics( index.statisticsLock() );
     _indexChanged( index );
     statistics.unlock();
 
-    // evaluate query against the index
-    _evaluateIndex( index );
+    // evaluate query against the partition
+    _evaluatePartition( partitions[i] );
 
     // remove all the iterators
     _indexFinished( index );
   }
 
+  _workTime += indri::utility::IndriTimer::currentTime() - start;
+
   _results.clear();
   for( size_t i=0; i<_evaluators.size(); i++ ) {
     _results[ _evaluators[i]->getName() ] = _evaluators[i]->getResults();
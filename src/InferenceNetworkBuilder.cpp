@@ -30,6 +30,7 @@
 #include "indri/OrderedWindowNode.hpp"
 #include "indri/UnorderedWindowNode.hpp"
 #include "indri/FieldIteratorNode.hpp"
+#include "indri/PhraseListIteratorNode.hpp"
 #include "indri/ListBeliefNode.hpp"
 #include "indri/ScoredExtentAccumulator.hpp"
 #include "indri/WeightedAndNode.hpp"
@@ -435,10 +436,54 @@ static indri::infnet::ListIteratorNode* inferencenetworkbuilder_build_ordered_wi
   return result;
 }
 
+//
+// _phraseName
+//
+// The stored list name of a #1 window of two index terms (see
+// IndexWriter::setPhrases), or "" if the window isn't one.
+//
+
+std::string indri::infnet::InferenceNetworkBuilder::_phraseName( indri::lang::ODNode* odNode ) {
+  const std::vector<indri::lang::RawExtentNode*>& children = odNode->getChildren();
+
+  if( odNode->getWindowSize() != 1 || children.size() != 2 )
+    return "";
+
+  std::string words[2];
+
+  for( size_t i=0; i<2; i++ ) {
+    indri::lang::IndexTerm* term = dynamic_cast<indri::lang::IndexTerm*>( children[i] );
+
+    if( !term )
+      return "";
+
+    words[i] = term->getText();
+
+    if( term->getStemmed() == false )
+      words[i] = _repository.processTerm( words[i] );
+
+    if( words[i].length() == 0 )
+      return "";
+  }
+
+  return words[0] + " " + words[1];
+}
+
 void indri::infnet::InferenceNetworkBuilder::after( indri::lang::ODNode* odNode ) {
   if( _nodeMap.find( odNode ) == _nodeMap.end() ) {
     std::vector<ListIteratorNode*> translation = _translate<ListIteratorNode>( odNode->getChildren() );
-    ListIteratorNode* orderedNode = inferencenetworkbuilder_build_ordered_window( _network, odNode->nodeName(), translation, odNode->getWindowSize() ); 
+    std::string phrase = _phraseName( odNode );
+    ListIteratorNode* orderedNode = 0;
+
+    if( phrase.length() ) {
+      // the window is only matched in indexes that don't store the phrase
+      OrderedWindowNode* window = new OrderedWindowNode( odNode->nodeName(), translation, 1 );
+      int listID = _network->addPhraseIterator( phrase );
+      orderedNode = new PhraseListIteratorNode( odNode->nodeName(), *_network, listID, window );
+      _network->addListNode( orderedNode );
+    } else {
+      orderedNode = inferencenetworkbuilder_build_ordered_window( _network, odNode->nodeName(), translation, odNode->getWindowSize() ); 
+    }
 
     _nodeMap[odNode] = orderedNode;
   }
@@ -622,13 +667,27 @@ void indri::infnet::InferenceNetworkBuilder::after( indri::lang::ContextCounterN
     InferenceNetworkNode* untypedRawExtent = _nodeMap[ contextCounterNode->getRawExtent() ];
     InferenceNetworkNode* untypedContext = _nodeMap[ contextCounterNode->getContext() ];
     ContextCountAccumulator* contextCount = 0;
+    indri::lang::ListCache::CachedList* list = 0;
 
-    contextCount = new ContextCountAccumulator( contextCounterNode->nodeName(),
-                                                dynamic_cast<ListIteratorNode*>(untypedRawExtent),
-                                                dynamic_cast<ListIteratorNode*>(untypedContext) );
+    if( !contextCounterNode->getContext() )
+      list = _cache.find( contextCounterNode->getRawExtent(), 0 );
+
+    if( list ) {
+      // these counts were computed by an earlier query, so they don't need evaluation
+      contextCount = new ContextCountAccumulator( contextCounterNode->nodeName(), *list );
+      _cache.release( list );
+
+      _network->addEvaluatorNode( contextCount );
+    } else {
+      contextCount = new ContextCountAccumulator( contextCounterNode->nodeName(),
+                                                  dynamic_cast<ListIteratorNode*>(untypedRawExtent),
+                                                  dynamic_cast<ListIteratorNode*>(untypedContext) );
+      contextCount->setCache( _cache, contextCounterNode->getRawExtent() );
+
+      _network->addEvaluatorNode( contextCount );
+      _network->addComplexEvaluatorNode( contextCount );
+    }
 
-    _network->addEvaluatorNode( contextCount );
-    _network->addComplexEvaluatorNode( contextCount );
     _nodeMap[ contextCounterNode ] = contextCount;
   }
 }
@@ -686,8 +745,28 @@ void indri::infnet::InferenceNetworkBuilder::after( indri::lang::AnnotatorNode*
 }
 
 void indri::infnet::InferenceNetworkBuilder::after( indri::lang::CachedFrequencyScorerNode* cachedScorerNode ) {
-  // TODO: either remove this or fix it
-  LEMUR_THROW( LEMUR_RUNTIME_ERROR, "For the time being, InferenceNetworkBuilder does not support CachedFrequencyScorerNodes" );
+  if( _nodeMap.find( cachedScorerNode ) == _nodeMap.end() ) {
+    BeliefNode* belief;
+    indri::lang::ListCache::CachedList* list = (indri::lang::ListCache::CachedList*) cachedScorerNode->getList();
+    indri::query::TermScoreFunction* function = 0;
+
+    function = _buildTermScoreFunction( cachedScorerNode->getSmoothing(),
+                                        cachedScorerNode->getOccurrences(),
+                                        cachedScorerNode->getContextSize(),
+                                        cachedScorerNode->getDocumentOccurrences(),
+                                        cachedScorerNode->getDocumentCount() );
+
+    if( cachedScorerNode->getOccurrences() > 0 ) {
+      // max-score is turned off, as it is for other lists
+      belief = new CachedFrequencyBeliefNode( cachedScorerNode->nodeName(), list, *function, INDRI_HUGE_SCORE, INDRI_HUGE_SCORE );
+    } else {
+      belief = new NullScorerNode( cachedScorerNode->nodeName(), *function );
+    }
+
+    _network->addScoreFunction( function );
+    _network->addBeliefNode( belief );
+    _nodeMap[cachedScorerNode] = belief;
+  }
 }
 
 void indri::infnet::InferenceNetworkBuilder::after( indri::lang::TermFrequencyScorerNode* termScorerNode ) {
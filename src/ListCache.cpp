@@ -0,0 +1,276 @@
+/*==========================================================================
+ * Copyright (c) 2004 University of Massachusetts.  All Rights Reserved.
+ *
+ * Use of the Lemur Toolkit for Language Modeling and Information Retrieval
+ * is subject to the terms of the software license set forth in the LICENSE
+ * file included with this software, and also available at
+ * http://www.lemurproject.org/license.html
+ *
+ *==========================================================================
+ */
+
+//
+// ListCache
+//
+
+#include "indri/ListCache.hpp"
+#include "indri/Repository.hpp"
+#include "indri/HashTable.hpp"
+#include "indri/Mutex.hpp"
+#include "indri/ScopedLock.hpp"
+#include "indri/Parameters.hpp"
+#include <map>
+#include <string.h>
+
+//
+// Store
+//
+// The lists shared by every ListCache open on one repository path.
+//
+
+struct indri::lang::ListCache::Store {
+  Store() : lists(1024) {}
+
+  std::string path;
+  int users;
+
+  indri::thread::Mutex lock;
+  indri::utility::HashTable<std::string, CachedList*> lists;
+  // most recently used lists first
+  std::list<CachedList*> recent;
+  Statistics statistics;
+};
+
+static std::map<std::string, indri::lang::ListCache::Store*> list_cache_stores;
+static indri::thread::Mutex list_cache_stores_lock;
+
+//
+// list_cache_evict
+//
+
+static void list_cache_evict( indri::lang::ListCache::CachedList* list ) {
+  list->evicted = true;
+
+  if( list->references == 0 )
+    delete list;
+}
+
+//
+// CachedList
+//
+
+indri::lang::ListCache::CachedList::CachedList() :
+  occurrences(0),
+  contextSize(0),
+  documentOccurrences(0),
+  documentCount(0),
+  documentAdds(0),
+  indexCount(0),
+  deletedCount(0),
+  references(0),
+  evicted(false)
+{
+}
+
+//
+// memorySize
+//
+
+size_t indri::lang::ListCache::CachedList::memorySize() const {
+  return sizeof(CachedList) + key.size() + entries.size() * sizeof(indri::index::DocumentContextCount);
+}
+
+//
+// ListCache
+//
+
+indri::lang::ListCache::ListCache( indri::collection::Repository& repository ) :
+  _repository(repository)
+{
+  indri::thread::ScopedLock lock( list_cache_stores_lock );
+  Store*& store = list_cache_stores[ repository.path() ];
+
+  if( !store ) {
+    store = new Store;
+    store->path = repository.path();
+    store->users = 0;
+
+    memset( &store->statistics, 0, sizeof(Statistics) );
+    store->statistics.maximumMemory = indri::api::Parameters::instance().get( "listCacheMemory", INT64(64*1024*1024) );
+  }
+
+  store->users++;
+  _store = store;
+}
+
+//
+// ~ListCache
+//
+
+indri::lang::ListCache::~ListCache() {
+  indri::thread::ScopedLock lock( list_cache_stores_lock );
+
+  if( --_store->users > 0 )
+    return;
+
+  list_cache_stores.erase( _store->path );
+
+  std::list<CachedList*>::iterator iter;
+  for( iter = _store->recent.begin(); iter != _store->recent.end(); iter++ )
+    list_cache_evict( *iter );
+
+  delete _store;
+}
+
+//
+// _key
+//
+// The canonical form of an expression: the type and query text of
+// the raw extent, then of the context.
+//
+
+std::string indri::lang::ListCache::_key( indri::lang::Node* raw, indri::lang::Node* context ) {
+  std::string key = raw->typeName() + ":" + raw->queryText();
+
+  if( context )
+    key += "\n" + context->typeName() + ":" + context->queryText();
+
+  return key;
+}
+
+//
+// _current
+//
+
+bool indri::lang::ListCache::_current( CachedList* list ) {
+  indri::collection::Repository::index_state indexes = _repository.indexes();
+
+  // documents may be added to any index, not just the last one, when
+  // documents are added to several shards at once
+  return list->documentAdds == _repository.documentAdds() &&
+    list->indexCount == indexes->size() &&
+    list->deletedCount == _repository.deletedList().deletedCount();
+}
+
+//
+// newList
+//
+
+indri::lang::ListCache::CachedList* indri::lang::ListCache::newList() {
+  CachedList* list = new CachedList;
+  indri::collection::Repository::index_state indexes = _repository.indexes();
+
+  list->documentAdds = _repository.documentAdds();
+  list->indexCount = indexes->size();
+  list->deletedCount = _repository.deletedList().deletedCount();
+
+  return list;
+}
+
+//
+// add
+//
+
+void indri::lang::ListCache::add( CachedList* list ) {
+  list->key = _key( list->raw.root(), list->context.root() );
+  size_t memory = list->memorySize();
+
+  if( !_current( list ) ) {
+    delete list;
+    return;
+  }
+
+  indri::thread::ScopedLock lock( _store->lock );
+
+  if( memory > _store->statistics.maximumMemory ) {
+    delete list;
+    return;
+  }
+
+  CachedList** existing = _store->lists.find( list->key );
+
+  if( existing ) {
+    // replace a list made from older repository contents
+    if( _current( *existing ) ) {
+      delete list;
+      return;
+    }
+
+    _store->statistics.memory -= (*existing)->memorySize();
+    _store->statistics.evictions++;
+    _store->recent.erase( (*existing)->recent );
+    list_cache_evict( *existing );
+    _store->lists.remove( list->key );
+  }
+
+  // evict least recently used lists until this one fits
+  while( _store->recent.size() &&
+         _store->statistics.memory + memory > _store->statistics.maximumMemory ) {
+    CachedList* victim = _store->recent.back();
+    _store->recent.pop_back();
+    _store->lists.remove( victim->key );
+
+    _store->statistics.memory -= victim->memorySize();
+    _store->statistics.evictions++;
+    list_cache_evict( victim );
+  }
+
+  _store->recent.push_front( list );
+  list->recent = _store->recent.begin();
+  _store->lists.insert( list->key, list );
+
+  _store->statistics.memory += memory;
+  _store->statistics.additions++;
+}
+
+//
+// find
+//
+
+indri::lang::ListCache::CachedList* indri::lang::ListCache::find( indri::lang::Node* raw, indri::lang::Node* context ) {
+  std::string key = _key( raw, context );
+  indri::thread::ScopedLock lock( _store->lock );
+  CachedList** list = _store->lists.find( key );
+
+  if( !list || !_current( *list ) ) {
+    _store->statistics.misses++;
+    return 0;
+  }
+
+  _store->recent.splice( _store->recent.begin(), _store->recent, (*list)->recent );
+  _store->statistics.hits++;
+  (*list)->references++;
+
+  return *list;
+}
+
+//
+// release
+//
+
+void indri::lang::ListCache::release( CachedList* list ) {
+  indri::thread::ScopedLock lock( _store->lock );
+  list->references--;
+
+  if( list->evicted && list->references == 0 )
+    delete list;
+}
+
+//
+// maximumMemory
+//
+
+UINT64 indri::lang::ListCache::maximumMemory() const {
+  return _store->statistics.maximumMemory;
+}
+
+//
+// statistics
+//
+
+indri::lang::ListCache::Statistics indri::lang::ListCache::statistics() {
+  indri::thread::ScopedLock lock( _store->lock );
+  Statistics result = _store->statistics;
+  result.lists = _store->recent.size();
+  return result;
+}
@@ -40,6 +40,9 @@
 #include "indri/TreePrinterWalker.hpp"
 
 #include "indri/DocumentStructure.hpp"
+#include "indri/ScoredExtentAccumulator.hpp"
+#include "indri/TopResults.hpp"
+#include <algorithm>
 
 //
 // Response objects
@@ -98,6 +101,7 @@ namespace indri
     class LocalQueryServerVectorsResponse : public QueryServerVectorsResponse {
     private:
       std::vector<indri::api::DocumentVector*> _vectors;
+      std::vector<std::string> _stems;
 
     public:
       LocalQueryServerVectorsResponse( int vectorCount ) {
@@ -112,6 +116,10 @@ namespace indri
       std::vector<indri::api::DocumentVector*>& getResults() {
         return _vectors;
       }
+
+      std::vector<std::string>& getStems() {
+        return _stems;
+      }
     };
 
     class LocalQueryServerDocumentIDsResponse : public QueryServerDocumentIDsResponse {
@@ -128,6 +136,134 @@ namespace indri
         return _documentIDs;
       }
     };
+
+    //
+    // LocalQueryServerPartitionTask
+    //
+    // Evaluates one copy of a query's inference network against
+    // partitions taken from a list shared with the other copies.
+    //
+
+    class LocalQueryServerPartitionTask : public indri::thread::ThreadPool::Task {
+    private:
+      indri::infnet::InferenceNetwork* _network;
+      const std::vector<indri::infnet::InferenceNetwork::Partition>& _partitions;
+      size_t& _nextPartition;
+      indri::thread::Mutex& _lock;
+      indri::infnet::InferenceNetwork::MAllResults _results;
+
+    public:
+      LocalQueryServerPartitionTask( indri::infnet::InferenceNetwork* network,
+                                     const std::vector<indri::infnet::InferenceNetwork::Partition>& partitions,
+                                     size_t& nextPartition,
+                                     indri::thread::Mutex& lock ) :
+        _network(network),
+        _partitions(partitions),
+        _nextPartition(nextPartition),
+        _lock(lock)
+      {
+      }
+
+      void run() {
+        std::vector<indri::infnet::InferenceNetwork::Partition> partition(1);
+
+        while( true ) {
+          {
+            indri::thread::ScopedLock lock( _lock );
+            if( _nextPartition == _partitions.size() )
+              break;
+            partition[0] = _partitions[_nextPartition++];
+          }
+
+          _results = _network->evaluate( partition );
+        }
+      }
+
+      const indri::infnet::InferenceNetwork::MAllResults& getResults() {
+        return _results;
+      }
+    };
+  }
+}
+
+//
+// local_query_server_ranking_only
+//
+// Partitions can only be scored separately and merged if every evaluator
+// just keeps the best scoring documents.
+//
+
+static bool local_query_server_ranking_only( indri::infnet::InferenceNetwork* network ) {
+  const std::vector<indri::infnet::EvaluatorNode*>& evaluators = network->getEvaluators();
+
+  if( !evaluators.size() )
+    return false;
+
+  for( size_t i=0; i<evaluators.size(); i++ ) {
+    if( !dynamic_cast<indri::infnet::ScoredExtentAccumulator*>( evaluators[i] ) )
+      return false;
+  }
+
+  return true;
+}
+
+//
+// local_query_server_statistics_only
+//
+// The statistics pass of a query sends only ContextCounterNodes, whose
+// counts can be cached between queries.
+//
+
+static bool local_query_server_statistics_only( std::vector<indri::lang::Node*>& roots ) {
+  if( roots.size() == 0 )
+    return false;
+
+  for( size_t i=0; i<roots.size(); i++ ) {
+    if( !dynamic_cast<indri::lang::ContextCounterNode*>( roots[i] ) )
+      return false;
+  }
+
+  return true;
+}
+
+//
+// local_query_server_partition
+//
+// Splits the indexes into document ranges so that each query thread gets a
+// couple of ranges to work through; small indexes aren't split at all.
+//
+
+static void local_query_server_partition( indri::collection::Repository::index_state& indexes,
+                                          int threads,
+                                          std::vector<indri::infnet::InferenceNetwork::Partition>& partitions ) {
+  const INT64 minimumPartitionSize = 1<<14;
+  const int partitionsPerThread = 2;
+  std::vector<lemur::api::DOCID_T> bases;
+  std::vector<lemur::api::DOCID_T> maximums;
+  INT64 totalDocuments = 0;
+
+  for( size_t i=0; i<indexes->size(); i++ ) {
+    indri::thread::ScopedLock lock( (*indexes)[i]->statisticsLock() );
+    bases.push_back( (*indexes)[i]->documentBase() );
+    maximums.push_back( (*indexes)[i]->documentMaximum() );
+    totalDocuments += maximums.back() - bases.back();
+  }
+
+  INT64 partitionSize = lemur_compat::max<INT64>( minimumPartitionSize, totalDocuments / (threads * partitionsPerThread) );
+
+  for( size_t i=0; i<indexes->size(); i++ ) {
+    INT64 documents = maximums[i] - bases[i];
+    INT64 pieces = lemur_compat::max<INT64>( 1, (documents + partitionSize - 1) / partitionSize );
+    INT64 pieceSize = (documents + pieces - 1) / pieces;
+
+    for( INT64 j=0; j<pieces; j++ ) {
+      indri::infnet::InferenceNetwork::Partition partition;
+      partition.index = (*indexes)[i];
+      partition.firstDocument = lemur::api::DOCID_T( bases[i] + j*pieceSize );
+      // the final piece runs to documentMaximum, as a whole-index evaluation does
+      partition.lastDocument = ( j == pieces-1 ) ? maximums[i] : lemur::api::DOCID_T( bases[i] + (j+1)*pieceSize - 1 );
+      partitions.push_back( partition );
+    }
   }
 }
 
@@ -136,10 +272,28 @@ namespace indri
 //
 
 indri::server::LocalQueryServer::LocalQueryServer( indri::collection::Repository& repository ) :
-  _repository(repository), _maxWildcardMatchesPerTerm(indri::infnet::InferenceNetworkBuilder::DEFAULT_MAX_WILDCARD_TERMS)
+  _repository(repository), _cache(repository), _statistics(repository), _maxWildcardMatchesPerTerm(indri::infnet::InferenceNetworkBuilder::DEFAULT_MAX_WILDCARD_TERMS)
 {
   // if supplied and false, turn off optimization for all queries.
   _optimizeParameter = indri::api::Parameters::instance().get( "optimize", true );
+
+  _queryThreads = indri::api::Parameters::instance().get( "queryThreads", 1 );
+  _queryPool = 0;
+
+  if( _queryThreads > 1 )
+    _queryPool = new indri::thread::ThreadPool( _queryThreads );
+
+  _budget.postings = indri::api::Parameters::instance().get( "queryBudget.postings", INT64(0) );
+  _budget.documents = indri::api::Parameters::instance().get( "queryBudget.documents", INT64(0) );
+  _budget.milliseconds = indri::api::Parameters::instance().get( "queryBudget.milliseconds", INT64(0) );
+}
+
+//
+// ~LocalQueryServer
+//
+
+indri::server::LocalQueryServer::~LocalQueryServer() {
+  delete _queryPool;
 }
 
 //
@@ -176,25 +330,9 @@ std::string indri::server::LocalQueryServer::documentMetadatum( lemur::api::DOCI
 }
 
 indri::server::QueryServerMetadataResponse* indri::server::LocalQueryServer::documentMetadata( const std::vector<lemur::api::DOCID_T>& documentIDs, const std::string& attributeName ) {
-  std::vector<std::string> result;
-
-  std::vector<std::pair<lemur::api::DOCID_T, int> > docSorted;
-  for( size_t i=0; i<documentIDs.size(); i++ ) {
-    docSorted.push_back( std::make_pair( documentIDs[i], i ) );
-  }
-  std::sort( docSorted.begin(), docSorted.end() );
-
-  for( size_t i=0; i<docSorted.size(); i++ ) {
-    result.push_back( documentMetadatum(docSorted[i].first, attributeName) );
-  }
-
-  std::vector<std::string> actual;
-  actual.resize( documentIDs.size() );
-  for( size_t i=0; i<docSorted.size(); i++ ) {
-    actual[docSorted[i].second] = result[i];
-  }
-
-  return new indri::server::LocalQueryServerMetadataResponse( actual );
+  indri::collection::CompressedCollection* collection = _repository.collection();
+  std::vector<std::string> result = collection->retrieveMetadata( documentIDs, attributeName );
+  return new indri::server::LocalQueryServerMetadataResponse( result );
 }
 
 indri::server::QueryServerDocumentsResponse* indri::server::LocalQueryServer::documents( const std::vector<lemur::api::DOCID_T>& documentIDs ) {
@@ -374,7 +512,113 @@ INT64 indri::server::LocalQueryServer::documentStemCount( const std::string& ste
   return total;
 }
 
-indri::server::QueryServerResponse* indri::server::LocalQueryServer::runQuery( std::vector<indri::lang::Node*>& roots, int resultsRequested, bool optimize ) {
+//
+// runQuery
+//
+
+indri::server::QueryServerResponse* indri::server::LocalQueryServer::runQuery( std::vector<indri::lang::Node*>& roots, int resultsRequested, bool optimize, const indri::api::QueryBudget& budget ) {
+  if( local_query_server_statistics_only( roots ) )
+    return _runStatisticsQuery( roots, resultsRequested, optimize );
+
+  return _runQuery( roots, resultsRequested, optimize, budget );
+}
+
+//
+// _runStatisticsQuery
+//
+// Answers a statistics pass from the statistics cache, evaluating
+// only the expressions that haven't been counted since the repository
+// last changed.
+//
+
+indri::server::QueryServerResponse* indri::server::LocalQueryServer::_runStatisticsQuery( std::vector<indri::lang::Node*>& roots, int resultsRequested, bool optimize ) {
+  indri::infnet::InferenceNetwork::MAllResults result;
+  std::vector<indri::lang::Node*> uncounted;
+  indri::lang::StatisticsCache::Stamp stamp = _statistics.stamp();
+
+  for( size_t i=0; i<roots.size(); i++ ) {
+    indri::lang::ContextCounterNode* counter = (indri::lang::ContextCounterNode*) roots[i];
+    indri::lang::StatisticsCache::Counts counts;
+
+    if( _statistics.find( counter, counts ) ) {
+      indri::infnet::EvaluatorNode::MResults& lists = result[ counter->nodeName() ];
+
+      lists[ "occurrences" ].push_back( indri::api::ScoredExtentResult( counts.occurrences, 0 ) );
+      lists[ "contextSize" ].push_back( indri::api::ScoredExtentResult( counts.contextSize, 0 ) );
+      lists[ "documentOccurrences" ].push_back( indri::api::ScoredExtentResult( UINT64(counts.documentOccurrences), 0 ) );
+      lists[ "documentCount" ].push_back( indri::api::ScoredExtentResult( UINT64(counts.documentCount), 0 ) );
+    } else {
+      uncounted.push_back( roots[i] );
+    }
+  }
+
+  if( uncounted.size() == 0 )
+    return new indri::server::LocalQueryServerResponse( result );
+
+  // A network visits every document that any of its expressions might
+  // match, and evaluates all of them there, so a long batch of phrases
+  // (such as the grams of a relevance model) is much cheaper counted one
+  // expression to a network.  Single terms are only vocabulary lookups,
+  // so they stay together.
+  std::vector< std::vector<indri::lang::Node*> > groups;
+  std::vector<indri::lang::Node*> terms;
+
+  for( size_t i=0; i<uncounted.size(); i++ ) {
+    indri::lang::ContextCounterNode* counter = (indri::lang::ContextCounterNode*) uncounted[i];
+
+    if( !counter->getContext() && dynamic_cast<indri::lang::IndexTerm*>( counter->getRawExtent() ) ) {
+      terms.push_back( counter );
+    } else {
+      groups.push_back( std::vector<indri::lang::Node*>( 1, counter ) );
+    }
+  }
+
+  if( terms.size() )
+    groups.push_back( terms );
+
+  indri::infnet::InferenceNetwork::MAllResults counted;
+
+  for( size_t i=0; i<groups.size(); i++ ) {
+    QueryServerResponse* response = _runQuery( groups[i], resultsRequested, optimize );
+    indri::infnet::InferenceNetwork::MAllResults& results = response->getResults();
+    indri::infnet::InferenceNetwork::MAllResults::iterator iter;
+
+    for( iter = results.begin(); iter != results.end(); iter++ )
+      counted[ iter->first ] = iter->second;
+
+    delete response;
+  }
+
+  for( size_t i=0; i<uncounted.size(); i++ ) {
+    indri::lang::ContextCounterNode* counter = (indri::lang::ContextCounterNode*) uncounted[i];
+    indri::infnet::EvaluatorNode::MResults& lists = counted[ counter->nodeName() ];
+    std::vector<indri::api::ScoredExtentResult>& occurrences = lists[ "occurrences" ];
+    std::vector<indri::api::ScoredExtentResult>& contextSize = lists[ "contextSize" ];
+    std::vector<indri::api::ScoredExtentResult>& documentOccurrences = lists[ "documentOccurrences" ];
+    std::vector<indri::api::ScoredExtentResult>& documentCount = lists[ "documentCount" ];
+
+    if( occurrences.size() && contextSize.size() && documentOccurrences.size() && documentCount.size() ) {
+      indri::lang::StatisticsCache::Counts counts;
+
+      counts.occurrences = occurrences[0].score;
+      counts.contextSize = contextSize[0].score;
+      counts.documentOccurrences = int(documentOccurrences[0].score);
+      counts.documentCount = int(documentCount[0].score);
+
+      _statistics.add( counter, counts, stamp );
+    }
+
+    result[ counter->nodeName() ] = lists;
+  }
+
+  return new indri::server::LocalQueryServerResponse( result );
+}
+
+//
+// _runQuery
+//
+
+indri::server::QueryServerResponse* indri::server::LocalQueryServer::_runQuery( std::vector<indri::lang::Node*>& roots, int resultsRequested, bool optimize, const indri::api::QueryBudget& budget ) {
 
   indri::lang::TreePrinterWalker printer;
 
@@ -414,15 +658,111 @@ indri::server::QueryServerResponse* indri::server::LocalQueryServer::runQuery( s
 
   indri::infnet::InferenceNetwork* network = builder.getNetwork();
   indri::infnet::InferenceNetwork::MAllResults result;
-  result = network->evaluate();
 
+  std::vector<indri::infnet::InferenceNetwork::Partition> partitions;
+  indri::collection::Repository::index_state indexes = _repository.indexes();
+  bool ranking = local_query_server_ranking_only( network );
+
+  // only ranked queries are budgeted; statistics and annotations must be complete
+  indri::api::QueryBudget networkBudget;
+
+  if( ranking ) {
+    networkBudget = budget;
+    networkBudget.restrict( _budget );
+  }
+
+  if( _queryPool && ranking )
+    local_query_server_partition( indexes, _queryThreads, partitions );
+
+  if( partitions.size() <= 1 ) {
+    network->setBudget( networkBudget );
+    result = network->evaluate();
+    indri::infnet::InferenceNetwork::storeWork( result, network->getWork() );
+    return new indri::server::LocalQueryServerResponse( result );
+  }
+
+  // build one network per thread; each keeps its own top-k list
+  // over the partitions it evaluates
+  int threads = lemur_compat::min<int>( _queryThreads, (int)partitions.size() );
+  std::vector<indri::infnet::InferenceNetworkBuilder*> builders;
+  std::vector<indri::infnet::InferenceNetwork*> networks;
+  std::vector<indri::thread::ThreadPool::Task*> tasks;
+  size_t nextPartition = 0;
+  indri::thread::Mutex partitionLock;
+
+  // the postings and documents of the budget are shared out between the threads
+  networkBudget.postings = (networkBudget.postings + threads - 1) / threads;
+  networkBudget.documents = (networkBudget.documents + threads - 1) / threads;
+
+  networks.push_back( network );
+
+  for( int i=1; i<threads; i++ ) {
+    indri::infnet::InferenceNetworkBuilder* copy = new indri::infnet::InferenceNetworkBuilder( _repository, _cache, resultsRequested, _maxWildcardMatchesPerTerm );
+    indri::lang::ApplyWalker<indri::infnet::InferenceNetworkBuilder> copyWalker( networkRoots, copy );
+    builders.push_back( copy );
+    networks.push_back( copy->getNetwork() );
+  }
+
+  for( size_t i=0; i<networks.size(); i++ ) {
+    networks[i]->setBudget( networkBudget );
+    tasks.push_back( new LocalQueryServerPartitionTask( networks[i], partitions, nextPartition, partitionLock ) );
+  }
+
+  _repository.countQuery();
+
+  try {
+    _queryPool->execute( tasks );
+  } catch( lemur::api::Exception& e ) {
+    indri::utility::delete_vector_contents( tasks );
+    indri::utility::delete_vector_contents( builders );
+    LEMUR_RETHROW( e, "Couldn't evaluate query partitions" );
+  }
+
+  // merge the per-thread lists, keeping the best resultsRequested of each
+  for( size_t i=0; i<tasks.size(); i++ ) {
+    const indri::infnet::InferenceNetwork::MAllResults& taskResults = ((LocalQueryServerPartitionTask*) tasks[i])->getResults();
+    indri::infnet::InferenceNetwork::MAllResults::const_iterator node;
+
+    for( node = taskResults.begin(); node != taskResults.end(); node++ ) {
+      indri::infnet::EvaluatorNode::MResults::const_iterator list;
+
+      for( list = node->second.begin(); list != node->second.end(); list++ ) {
+        std::vector<indri::api::ScoredExtentResult>& merged = result[node->first][list->first];
+        merged.insert( merged.end(), list->second.begin(), list->second.end() );
+      }
+    }
+  }
+
+  indri::infnet::InferenceNetwork::MAllResults::iterator node;
+
+  for( node = result.begin(); node != result.end(); node++ ) {
+    indri::infnet::EvaluatorNode::MResults::iterator list;
+
+    for( list = node->second.begin(); list != node->second.end(); list++ ) {
+      indri::utility::TopResults top( resultsRequested );
+
+      for( size_t i=0; i<list->second.size(); i++ )
+        top.push( list->second[i] );
+
+      top.sorted( list->second );
+    }
+  }
+
+  indri::api::QueryWork work;
+  for( size_t i=0; i<networks.size(); i++ )
+    work.add( networks[i]->getWork() );
+  indri::infnet::InferenceNetwork::storeWork( result, work );
+
+  indri::utility::delete_vector_contents( tasks );
+  indri::utility::delete_vector_contents( builders );
   return new indri::server::LocalQueryServerResponse( result );
 }
 
-indri::server::QueryServerVectorsResponse* indri::server::LocalQueryServer::documentVectors( const std::vector<lemur::api::DOCID_T>& documentIDs ) {
+indri::server::QueryServerVectorsResponse* indri::server::LocalQueryServer::documentVectors( const std::vector<lemur::api::DOCID_T>& documentIDs, bool sharedStems ) {
   indri::server::LocalQueryServerVectorsResponse* response = new indri::server::LocalQueryServerVectorsResponse( (int)documentIDs.size() );
   indri::collection::Repository::index_state indexes = _repository.indexes();
   std::map<int, std::string> termIDStringMap;
+  indri::api::DocumentVector::Dictionary dictionary;
 
   for( size_t i=0; i<documentIDs.size(); i++ ) {
     indri::index::Index* index = _indexWithDocument( indexes, documentIDs[i] );
@@ -431,12 +771,21 @@ indri::server::QueryServerVectorsResponse* indri::server::LocalQueryServer::docu
       indri::thread::ScopedLock lock( index->statisticsLock() );
   
       const indri::index::TermList* termList = index->termList( documentIDs[i] );
-      indri::api::DocumentVector* result = new indri::api::DocumentVector( index, termList, termIDStringMap );
+      indri::api::DocumentVector* result;
+
+      if( sharedStems )
+        result = new indri::api::DocumentVector( index, termList, dictionary );
+      else
+        result = new indri::api::DocumentVector( index, termList, termIDStringMap );
+
       delete termList;
       response->addVector( result );
     }
   }
 
+  if( sharedStems )
+    response->getStems().swap( dictionary.stems() );
+
   return response;
 }
 
@@ -492,3 +841,19 @@ indri::server::QueryServerMetadataResponse* indri::server::LocalQueryServer::pat
 void indri::server::LocalQueryServer::setMaxWildcardTerms(int maxTerms) {
   _maxWildcardMatchesPerTerm = maxTerms;
 }
+
+//
+// listCacheStatistics
+//
+
+indri::lang::ListCache::Statistics indri::server::LocalQueryServer::listCacheStatistics() {
+  return _cache.statistics();
+}
+
+//
+// statisticsCacheStatistics
+//
+
+indri::lang::StatisticsCache::Statistics indri::server::LocalQueryServer::statisticsCacheStatistics() {
+  return _statistics.statistics();
+}
@@ -650,6 +650,24 @@ lemur::api::DOCID_T indri::index::MemoryIndex::addDocument( indri::api::ParsedDo
   return documentID;
 }
 
+//
+// seal
+//
+
+void indri::index::MemoryIndex::seal( lemur::api::DOCID_T documentMaximum ) {
+  indri::thread::ScopedLock sl( _writeLock );
+  indri::index::TermList empty;
+
+  while( _corpusStatistics.maximumDocument < documentMaximum ) {
+    UINT64 offset;
+    int byteLength;
+
+    _writeDocumentTermList( offset, byteLength, _corpusStatistics.maximumDocument, 0, empty );
+    _writeDocumentStatistics( offset, byteLength, 0, 0, 0 );
+    _corpusStatistics.maximumDocument++;
+  }
+}
+
 //
 // docListIterator
 //
@@ -21,6 +21,7 @@
 #include "indri/XMLWriter.hpp"
 #include "indri/XMLReader.hpp"
 #include "indri/indri-platform.h"
+#include "indri/ScopedLock.hpp"
 #include "lemur/Exception.hpp"
 #include <iostream>
 
@@ -56,6 +57,85 @@ int indri::net::NetworkMessageStream::_bufferLength() {
   return _writePosition - _readPosition;
 }
 
+//
+// _fill
+//
+// Reads until at least length bytes are buffered; returns false,
+// closing the stream, if the other side closed the connection first.
+//
+
+bool indri::net::NetworkMessageStream::_fill( int length ) {
+  if( _bufferLength() >= length )
+    return true;
+
+  _cleanBuffer();
+  _buffer.grow( length );
+
+  while( _bufferLength() < length ) {
+    int bytesRead = _stream->read( _buffer.front() + _writePosition, _buffer.size() - _writePosition );
+
+    if( bytesRead <= 0 ) {
+      _stream->close();
+      return false;
+    }
+
+    _buffer.write( bytesRead );
+    _writePosition += bytesRead;
+  }
+
+  return true;
+}
+
+//
+// message_is_frame
+//
+
+static bool message_is_frame( const char* header ) {
+  return !strncmp( "PREQ", header, 4 ) ||
+         !strncmp( "PRPY", header, 4 ) ||
+         !strncmp( "PERR", header, 4 );
+}
+
+//
+// _readFrame
+//
+
+void indri::net::NetworkMessageStream::_readFrame( MessageStreamHandler& handler ) {
+  if( !_fill( FRAME_HEADER_SIZE ) )
+    return;
+
+  const char* header = _buffer.front() + _readPosition;
+  UINT32 id, kind, length;
+  char type[4];
+
+  memcpy( type, header, 4 );
+  memcpy( &id, header + 4, sizeof(UINT32) );
+  memcpy( &kind, header + 8, sizeof(UINT32) );
+  memcpy( &length, header + 12, sizeof(UINT32) );
+
+  id = ntohl(id);
+  kind = ntohl(kind);
+  length = ntohl(length);
+
+  if( length > 0x7fffffff - FRAME_HEADER_SIZE )
+    LEMUR_THROW( LEMUR_NETWORK_ERROR, "Malformed network packet: binary frame is too long" );
+
+  if( !_fill( FRAME_HEADER_SIZE + length ) )
+    return;
+
+  const char* body = _buffer.front() + _readPosition + FRAME_HEADER_SIZE;
+  _readPosition += FRAME_HEADER_SIZE + length;
+
+  // the handler may read the body until the next call to read
+  if( !strncmp( "PREQ", type, 4 ) ) {
+    handler.binaryRequest( id, kind, body, length );
+  } else if( !strncmp( "PRPY", type, 4 ) ) {
+    handler.binaryReply( id, kind, body, length );
+  } else {
+    handler.binaryError( id, std::string( body, length ) );
+  }
+}
+
 indri::net::NetworkMessageStream::NetworkMessageStream( indri::net::NetworkStream* stream ) :
   _stream(stream)
 {
@@ -71,7 +151,20 @@ bool indri::net::NetworkMessageStream::alive() {
   return _stream->alive();
 }
 
+void indri::net::NetworkMessageStream::setNoDelay() {
+  _stream->setNoDelay();
+}
+
 void indri::net::NetworkMessageStream::read( MessageStreamHandler& handler ) {
+  // every header line is at least 4 bytes long, as is a frame type
+  if( !_fill( 4 ) )
+    return;
+
+  if( message_is_frame( _buffer.front() + _readPosition ) ) {
+    _readFrame( handler );
+    return;
+  }
+
   int endOfLine = _findEOL();
   int bytesRead = -1;
 
@@ -199,6 +292,7 @@ void indri::net::NetworkMessageStream::read( MessageStreamHandler& handler ) {
 }
 
 void indri::net::NetworkMessageStream::request( indri::xml::XMLNode* messageNode ) {
+  indri::thread::ScopedLock lock( _writeLock );
   indri::xml::XMLWriter writer(messageNode);
   std::string body;
   writer.write( body );
@@ -212,6 +306,7 @@ void indri::net::NetworkMessageStream::request( indri::xml::XMLNode* messageNode
 }
 
 void indri::net::NetworkMessageStream::reply( indri::xml::XMLNode* replyNode ) {
+  indri::thread::ScopedLock lock( _writeLock );
   indri::xml::XMLWriter writer(replyNode);
   std::string body;
   writer.write(body);
@@ -225,6 +320,7 @@ void indri::net::NetworkMessageStream::reply( indri::xml::XMLNode* replyNode ) {
 }
 
 void indri::net::NetworkMessageStream::reply( const std::string& name, const void* buffer, unsigned int size ) {
+  indri::thread::ScopedLock lock( _writeLock );
   std::string header = "BRPY ";
   header += i64_to_string( size );
   header += " ";
@@ -236,6 +332,7 @@ void indri::net::NetworkMessageStream::reply( const std::string& name, const voi
 }
 
 void indri::net::NetworkMessageStream::replyDone() {
+  indri::thread::ScopedLock lock( _writeLock );
   _stream->write( "RFIN\n", 5 );
 }
 
@@ -245,9 +342,53 @@ void indri::net::NetworkMessageStream::error( const std::string& errorMessage )
   fullMessage += errorMessage;
   fullMessage += "\n";
 
+  indri::thread::ScopedLock lock( _writeLock );
   _stream->write( fullMessage.c_str(), fullMessage.length() );
 }
 
+//
+// _writeFrame
+//
+
+void indri::net::NetworkMessageStream::_writeFrame( const char* type, UINT32 id, UINT32 kind, const void* buffer, unsigned int length ) {
+  // one write per frame, so small frames go out in a single packet
+  indri::utility::Buffer frame( FRAME_HEADER_SIZE + length );
+  char* header = frame.write( FRAME_HEADER_SIZE + length );
+  UINT32 fields[3] = { htonl(id), htonl(kind), htonl(length) };
+
+  memcpy( header, type, 4 );
+  memcpy( header + 4, fields, sizeof fields );
+  if( length )
+    memcpy( header + FRAME_HEADER_SIZE, buffer, length );
+
+  indri::thread::ScopedLock lock( _writeLock );
+  _stream->blockingWrite( frame.front(), (unsigned int)frame.position() );
+}
+
+//
+// binaryRequest
+//
+
+void indri::net::NetworkMessageStream::binaryRequest( UINT32 id, UINT32 kind, const void* buffer, unsigned int length ) {
+  _writeFrame( "PREQ", id, kind, buffer, length );
+}
+
+//
+// binaryReply
+//
+
+void indri::net::NetworkMessageStream::binaryReply( UINT32 id, UINT32 kind, const void* buffer, unsigned int length ) {
+  _writeFrame( "PRPY", id, kind, buffer, length );
+}
+
+//
+// binaryError
+//
+
+void indri::net::NetworkMessageStream::binaryError( UINT32 id, UINT32 kind, const std::string& errorMessage ) {
+  _writeFrame( "PERR", id, kind, errorMessage.c_str(), (unsigned int)errorMessage.length() );
+}
+
 indri::thread::Lockable& indri::net::NetworkMessageStream::mutex() {
   return _lock;
 }
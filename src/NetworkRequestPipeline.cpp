@@ -0,0 +1,206 @@
+/*==========================================================================
+ * Copyright (c) 2004 University of Massachusetts.  All Rights Reserved.
+ *
+ * Use of the Lemur Toolkit for Language Modeling and Information Retrieval
+ * is subject to the terms of the software license set forth in the LICENSE
+ * file included with this software, and also available at
+ * http://www.lemurproject.org/license.html
+ *
+ *==========================================================================
+ */
+
+
+//
+// NetworkRequestPipeline
+//
+
+#include "indri/NetworkRequestPipeline.hpp"
+#include "indri/ScopedLock.hpp"
+#include "lemur/Exception.hpp"
+
+//
+// NetworkRequestPipeline
+//
+
+indri::net::NetworkRequestPipeline::NetworkRequestPipeline( NetworkMessageStream* stream ) :
+  _stream(stream),
+  _nextID(0)
+{
+}
+
+//
+// ~NetworkRequestPipeline
+//
+
+indri::net::NetworkRequestPipeline::~NetworkRequestPipeline() {
+  std::map<UINT32, reply_type*>::iterator iter;
+
+  for( iter = _replies.begin(); iter != _replies.end(); iter++ )
+    delete iter->second;
+}
+
+//
+// _take
+//
+// Called with _lock held; returns true, or throws, if the reply
+// to request id has arrived.
+//
+
+bool indri::net::NetworkRequestPipeline::_take( UINT32 id, std::string& reply ) {
+  std::map<UINT32, reply_type*>::iterator iter = _replies.find( id );
+
+  if( iter == _replies.end() )
+    return false;
+
+  reply_type* entry = iter->second;
+  _replies.erase( iter );
+  reply.swap( entry->body );
+  bool failed = entry->failed;
+  delete entry;
+
+  if( failed )
+    LEMUR_THROW( LEMUR_NETWORK_ERROR, "The server failed to process a request: " + reply );
+
+  return true;
+}
+
+//
+// send
+//
+
+UINT32 indri::net::NetworkRequestPipeline::send( UINT32 kind, const void* body, unsigned int length ) {
+  UINT32 id;
+
+  {
+    indri::thread::ScopedLock lock( _lock );
+    id = ++_nextID;
+  }
+
+  _stream->binaryRequest( id, kind, body, length );
+  return id;
+}
+
+//
+// receive
+//
+
+void indri::net::NetworkRequestPipeline::receive( UINT32 id, std::string& reply ) {
+  while( true ) {
+    {
+      indri::thread::ScopedLock lock( _lock );
+
+      if( _take( id, reply ) )
+        return;
+    }
+
+    indri::thread::ScopedLock readLock( _stream->mutex() );
+
+    {
+      // the last thread to read may have read this reply
+      indri::thread::ScopedLock lock( _lock );
+
+      if( _take( id, reply ) )
+        return;
+
+      if( _failure.length() )
+        LEMUR_THROW( LEMUR_NETWORK_ERROR, _failure );
+
+      if( !_stream->alive() )
+        LEMUR_THROW( LEMUR_NETWORK_ERROR, "The connection to the server was closed" );
+    }
+
+    _stream->read( *this );
+  }
+}
+
+//
+// abandon
+//
+
+void indri::net::NetworkRequestPipeline::abandon( UINT32 id ) {
+  indri::thread::ScopedLock lock( _lock );
+  std::map<UINT32, reply_type*>::iterator iter = _replies.find( id );
+
+  if( iter != _replies.end() ) {
+    delete iter->second;
+    _replies.erase( iter );
+  } else {
+    _abandoned.insert( id );
+  }
+}
+
+//
+// binaryReply
+//
+
+void indri::net::NetworkRequestPipeline::binaryReply( UINT32 id, UINT32 kind, const void* buffer, unsigned int length ) {
+  indri::thread::ScopedLock lock( _lock );
+
+  if( _abandoned.erase( id ) )
+    return;
+
+  reply_type* entry = new reply_type;
+  entry->failed = false;
+  entry->body.assign( (const char*) buffer, length );
+  _replies[id] = entry;
+}
+
+//
+// binaryError
+//
+
+void indri::net::NetworkRequestPipeline::binaryError( UINT32 id, const std::string& e ) {
+  indri::thread::ScopedLock lock( _lock );
+
+  if( _abandoned.erase( id ) )
+    return;
+
+  reply_type* entry = new reply_type;
+  entry->failed = true;
+  entry->body = e;
+  _replies[id] = entry;
+}
+
+//
+// request
+//
+
+void indri::net::NetworkRequestPipeline::request( indri::xml::XMLNode* node ) {
+  error( "NetworkRequestPipeline: doesn't accept requests" );
+}
+
+//
+// reply
+//
+
+void indri::net::NetworkRequestPipeline::reply( indri::xml::XMLNode* node ) {
+  delete node;
+  error( "NetworkRequestPipeline: should only get binary replies" );
+}
+
+//
+// reply
+//
+
+void indri::net::NetworkRequestPipeline::reply( const std::string& name, const void* buffer, unsigned int length ) {
+  error( "NetworkRequestPipeline: should only get binary replies" );
+}
+
+//
+// replyDone
+//
+
+void indri::net::NetworkRequestPipeline::replyDone() {
+  error( "NetworkRequestPipeline: should only get binary replies" );
+}
+
+//
+// error
+//
+
+void indri::net::NetworkRequestPipeline::error( const std::string& e ) {
+  indri::thread::ScopedLock lock( _lock );
+
+  if( !_failure.length() )
+    _failure = e;
+}
@@ -224,9 +224,19 @@ namespace indri
     class NetworkServerProxyVectorsResponse : public QueryServerVectorsResponse {
     public:
       std::vector<indri::api::DocumentVector*> _vectors;
+      std::vector<std::string> _stems;
       indri::net::NetworkMessageStream* _stream;
       bool _readResponse;
 
+      static void _decodeStems( const indri::xml::XMLNode* stems, std::vector<std::string>& output ) {
+        for( size_t j=0; j<stems->getChildren().size(); j++ ) {
+          // have to use base64 coding, in case the stem contains '<', '>', etc.
+          std::string stem;
+          base64_decode_string(stem, stems->getChildren()[j]->getValue());
+          output.push_back( stem );
+        }
+      }
+
     public:
       NetworkServerProxyVectorsResponse( indri::net::NetworkMessageStream* stream ) 
         :
@@ -248,18 +258,20 @@ namespace indri
           const std::vector<indri::xml::XMLNode*>& children = reply->getChildren();
 
           for( size_t i=0; i<children.size(); i++ ) {
+            // stems shared by all the vectors
+            if( children[i]->getName() == "stems" ) {
+              _decodeStems( children[i], _stems );
+              continue;
+            }
+
             const indri::xml::XMLNode* stems = children[i]->getChild("stems");
             const indri::xml::XMLNode* positions = children[i]->getChild("positions");
             const indri::xml::XMLNode* fields = children[i]->getChild("fields");
 
             indri::api::DocumentVector* result = new indri::api::DocumentVector;
 
-            for( size_t j=0; j<stems->getChildren().size(); j++ ) {
-              // have to use base64 coding, in case the stem contains '<', '>', etc.
-              std::string stem;
-              base64_decode_string(stem, stems->getChildren()[j]->getValue());
-              result->stems().push_back( stem );
-            }
+            if( stems )
+              _decodeStems( stems, result->stems() );
 
             std::vector<int>& positionsVector = result->positions();
 
@@ -301,6 +313,11 @@ namespace indri
 
         return _vectors;
       }
+
+      std::vector<std::string>& getStems() {
+        getResults();
+        return _stems;
+      }
     };
 
     //
@@ -342,6 +359,334 @@ namespace indri
         return _documentIDs;
       }
     };
+
+    //
+    // NetworkServerProxyBinaryReply
+    //
+    // The reply to one binary request, read when it is first needed and
+    // discarded on arrival if it never is.
+    //
+
+    class NetworkServerProxyBinaryReply {
+    public:
+      /// Decodes the body of a reply.
+      class Reader {
+      public:
+        virtual ~Reader() {}
+        virtual void readReply( indri::net::BinaryMessageReader& message ) = 0;
+      };
+
+    private:
+      enum {
+        WAITING,
+        READ,
+        FAILED
+      };
+
+      indri::net::NetworkRequestPipeline* _pipeline;
+      UINT32 _id;
+      int _state;
+      lemur::api::Exception _error;
+
+    public:
+      NetworkServerProxyBinaryReply( indri::net::NetworkRequestPipeline* pipeline, UINT32 id ) :
+        _pipeline(pipeline),
+        _id(id),
+        _state(WAITING)
+      {
+      }
+
+      ~NetworkServerProxyBinaryReply() {
+        // once receive has thrown, the server has either answered this
+        // request with an error or can no longer answer it at all
+        if( _state == WAITING )
+          _pipeline->abandon( _id );
+      }
+
+      /// Waits for the reply and passes it to reader, the first time it is called.
+      /// If the reply can't be received or read, every call throws the same error.
+      void read( Reader& reader ) {
+        if( _state == READ )
+          return;
+
+        if( _state == FAILED )
+          throw _error;
+
+        try {
+          std::string body;
+          _pipeline->receive( _id, body );
+
+          indri::net::BinaryMessageReader message( body.data(), body.length() );
+          reader.readReply( message );
+          _state = READ;
+        } catch( lemur::api::Exception& e ) {
+          _state = FAILED;
+          _error = e;
+          throw;
+        }
+      }
+    };
+
+    //
+    // NetworkServerProxyBinaryResponse
+    //
+
+    class NetworkServerProxyBinaryResponse : public QueryServerResponse, private NetworkServerProxyBinaryReply::Reader {
+    private:
+      NetworkServerProxyBinaryReply _reply;
+      indri::infnet::InferenceNetwork::MAllResults _results;
+
+      void readReply( indri::net::BinaryMessageReader& reader ) {
+        indri::net::QueryResponseUnpacker::read( reader, _results );
+      }
+
+    public:
+      NetworkServerProxyBinaryResponse( indri::net::NetworkRequestPipeline* pipeline, UINT32 id ) :
+        _reply( pipeline, id )
+      {
+      }
+
+      indri::infnet::InferenceNetwork::MAllResults& getResults() {
+        _reply.read( *this );
+        return _results;
+      }
+    };
+
+    //
+    // NetworkServerProxyBinaryDocumentsResponse
+    //
+
+    class NetworkServerProxyBinaryDocumentsResponse : public QueryServerDocumentsResponse, private NetworkServerProxyBinaryReply::Reader {
+    private:
+      NetworkServerProxyBinaryReply _reply;
+      std::vector<indri::api::ParsedDocument*> _documents;
+
+      // the document and everything it points to share one allocation, as in the XML protocol
+      static indri::api::ParsedDocument* _readDocument( indri::net::BinaryMessageReader& reader ) {
+        indri::utility::Buffer buffer;
+        indri::utility::greedy_vector<size_t> keyOffsets;
+        indri::utility::greedy_vector<size_t> valueOffsets;
+        indri::utility::greedy_vector<size_t> valueLengths;
+
+        // allocate room for the ParsedDocument
+        buffer.write( sizeof(indri::api::ParsedDocument) );
+        int metadataCount = reader.readInt32();
+
+        for( int i=0; i<metadataCount; i++ ) {
+          const char* key;
+          const char* value;
+          size_t keyLength = reader.readString( key );
+
+          keyOffsets.push_back( buffer.position() );
+          char* keyCopy = buffer.write( keyLength+1 );
+          memcpy( keyCopy, key, keyLength );
+          keyCopy[keyLength] = 0;
+
+          size_t valueLength = reader.readString( value );
+          valueOffsets.push_back( buffer.position() );
+          valueLengths.push_back( valueLength );
+          memcpy( buffer.write( valueLength ), value, valueLength );
+        }
+
+        bool hasText = reader.readInt32() != 0;
+        size_t textOffset = 0;
+        size_t textLength = 0;
+        INT64 contentOffset = 0;
+        INT64 contentLength = 0;
+
+        if( hasText ) {
+          const char* text;
+          textLength = reader.readString( text );
+          textOffset = buffer.position();
+          memcpy( buffer.write( textLength ), text, textLength );
+
+          contentOffset = reader.readInt64();
+          contentLength = reader.readInt64();
+
+          if( contentOffset < 0 || contentLength < 0 || UINT64(contentOffset + contentLength) > textLength )
+            LEMUR_THROW( LEMUR_NETWORK_ERROR, "Malformed binary message: document content lies outside its text" );
+        }
+
+        // now all of our data is in the buffer, so we can allocate a return structure
+        new(buffer.front()) indri::api::ParsedDocument;
+        indri::api::ParsedDocument* parsedDocument = (indri::api::ParsedDocument*) buffer.front();
+        int positionCount = reader.readInt32();
+
+        for( int i=0; i<positionCount; i++ ) {
+          indri::parse::TermExtent extent;
+          extent.begin = reader.readInt32();
+          extent.end = reader.readInt32();
+          parsedDocument->positions.push_back( extent );
+        }
+
+        for( size_t i=0; i<keyOffsets.size(); i++ ) {
+          indri::parse::MetadataPair pair;
+
+          pair.key = buffer.front() + keyOffsets[i];
+          pair.value = buffer.front() + valueOffsets[i];
+          pair.valueLength = (int)valueLengths[i];
+
+          parsedDocument->metadata.push_back( pair );
+        }
+
+        parsedDocument->text = hasText ? buffer.front() + textOffset : 0;
+        parsedDocument->textLength = textLength;
+        parsedDocument->content = hasText ? parsedDocument->text + contentOffset : 0;
+        parsedDocument->contentLength = (size_t) contentLength;
+        buffer.detach();
+
+        return parsedDocument;
+      }
+
+      void readReply( indri::net::BinaryMessageReader& reader ) {
+        int count = reader.readInt32();
+
+        for( int i=0; i<count; i++ )
+          _documents.push_back( _readDocument( reader ) );
+      }
+
+    public:
+      NetworkServerProxyBinaryDocumentsResponse( indri::net::NetworkRequestPipeline* pipeline, UINT32 id ) :
+        _reply( pipeline, id )
+      {
+      }
+
+      // caller deletes the ParsedDocuments
+      std::vector<indri::api::ParsedDocument*>& getResults() {
+        _reply.read( *this );
+        return _documents;
+      }
+    };
+
+    //
+    // NetworkServerProxyBinaryMetadataResponse
+    //
+
+    class NetworkServerProxyBinaryMetadataResponse : public QueryServerMetadataResponse, private NetworkServerProxyBinaryReply::Reader {
+    private:
+      NetworkServerProxyBinaryReply _reply;
+      std::vector<std::string> _metadata;
+
+      void readReply( indri::net::BinaryMessageReader& reader ) {
+        int count = reader.readInt32();
+
+        for( int i=0; i<count; i++ )
+          _metadata.push_back( reader.readString() );
+      }
+
+    public:
+      NetworkServerProxyBinaryMetadataResponse( indri::net::NetworkRequestPipeline* pipeline, UINT32 id ) :
+        _reply( pipeline, id )
+      {
+      }
+
+      std::vector<std::string>& getResults() {
+        _reply.read( *this );
+        return _metadata;
+      }
+    };
+
+    //
+    // NetworkServerProxyBinaryVectorsResponse
+    //
+
+    class NetworkServerProxyBinaryVectorsResponse : public QueryServerVectorsResponse, private NetworkServerProxyBinaryReply::Reader {
+    private:
+      NetworkServerProxyBinaryReply _reply;
+      std::vector<indri::api::DocumentVector*> _vectors;
+      std::vector<std::string> _stems;
+
+      static void _readStems( indri::net::BinaryMessageReader& reader, std::vector<std::string>& output ) {
+        int count = reader.readInt32();
+
+        for( int i=0; i<count; i++ )
+          output.push_back( reader.readString() );
+      }
+
+      void readReply( indri::net::BinaryMessageReader& reader ) {
+        bool sharedStems = reader.readInt32() != 0;
+
+        if( sharedStems )
+          _readStems( reader, _stems );
+
+        int count = reader.readInt32();
+
+        for( int i=0; i<count; i++ ) {
+          indri::api::DocumentVector* result = new indri::api::DocumentVector;
+          _vectors.push_back( result );
+
+          if( !sharedStems )
+            _readStems( reader, result->stems() );
+
+          std::vector<int>& positions = result->positions();
+          int positionCount = reader.readInt32();
+          positions.reserve( positionCount > 0 ? positionCount : 0 );
+
+          for( int j=0; j<positionCount; j++ )
+            positions.push_back( reader.readInt32() );
+
+          std::vector<indri::api::DocumentVector::Field>& fields = result->fields();
+          int fieldCount = reader.readInt32();
+
+          for( int j=0; j<fieldCount; j++ ) {
+            indri::api::DocumentVector::Field f;
+
+            f.name = reader.readString();
+            f.number = reader.readInt64();
+            f.begin = reader.readInt32();
+            f.end = reader.readInt32();
+            f.ordinal = reader.readInt32();
+            f.parentOrdinal = reader.readInt32();
+
+            fields.push_back( f );
+          }
+        }
+      }
+
+    public:
+      NetworkServerProxyBinaryVectorsResponse( indri::net::NetworkRequestPipeline* pipeline, UINT32 id ) :
+        _reply( pipeline, id )
+      {
+      }
+
+      std::vector<indri::api::DocumentVector*>& getResults() {
+        _reply.read( *this );
+        return _vectors;
+      }
+
+      std::vector<std::string>& getStems() {
+        getResults();
+        return _stems;
+      }
+    };
+
+    //
+    // NetworkServerProxyBinaryDocumentIDsResponse
+    //
+
+    class NetworkServerProxyBinaryDocumentIDsResponse : public QueryServerDocumentIDsResponse, private NetworkServerProxyBinaryReply::Reader {
+    private:
+      NetworkServerProxyBinaryReply _reply;
+      std::vector<lemur::api::DOCID_T> _documentIDs;
+
+      void readReply( indri::net::BinaryMessageReader& reader ) {
+        int count = reader.readInt32();
+
+        for( int i=0; i<count; i++ )
+          _documentIDs.push_back( reader.readInt32() );
+      }
+
+    public:
+      NetworkServerProxyBinaryDocumentIDsResponse( indri::net::NetworkRequestPipeline* pipeline, UINT32 id ) :
+        _reply( pipeline, id )
+      {
+      }
+
+      std::vector<lemur::api::DOCID_T>& getResults() {
+        _reply.read( *this );
+        return _documentIDs;
+      }
+    };
   }
 }
 
@@ -351,10 +696,73 @@ namespace indri
 
 
 indri::server::NetworkServerProxy::NetworkServerProxy( indri::net::NetworkMessageStream* stream ) :
-  _stream(stream)
+  _stream(stream),
+  _pipeline(0)
 {
 }
 
+indri::server::NetworkServerProxy::~NetworkServerProxy() {
+  delete _pipeline;
+}
+
+//
+// useBinaryProtocol
+//
+
+bool indri::server::NetworkServerProxy::useBinaryProtocol() {
+  if( _pipeline )
+    return true;
+
+  try {
+    INT64 version = _numericRequest( new indri::xml::XMLNode( "binary-protocol" ) );
+
+    if( version != indri::net::BinaryMessage::VERSION )
+      return false;
+  } catch( lemur::api::Exception& ) {
+    return false;
+  }
+
+  _stream->setNoDelay();
+  _pipeline = new indri::net::NetworkRequestPipeline( _stream );
+  return true;
+}
+
+//
+// _binaryRequest
+//
+// Sends a binary request and returns its id without waiting for the reply
+//
+
+UINT32 indri::server::NetworkServerProxy::_binaryRequest( UINT32 kind, indri::utility::Buffer& body ) {
+  return _pipeline->send( kind, body.front(), (unsigned int)body.position() );
+}
+
+//
+// _binaryNumericRequest
+//
+
+INT64 indri::server::NetworkServerProxy::_binaryNumericRequest( UINT32 kind, indri::utility::Buffer& body ) {
+  UINT32 id = _binaryRequest( kind, body );
+  std::string reply;
+
+  _pipeline->receive( id, reply );
+  indri::net::BinaryMessageReader reader( reply.data(), reply.length() );
+  return reader.readInt64();
+}
+
+//
+// _binaryStringRequest
+//
+
+std::string indri::server::NetworkServerProxy::_binaryStringRequest( UINT32 kind, indri::utility::Buffer& body ) {
+  UINT32 id = _binaryRequest( kind, body );
+  std::string reply;
+
+  _pipeline->receive( id, reply );
+  indri::net::BinaryMessageReader reader( reply.data(), reply.length() );
+  return reader.readString();
+}
+
 //
 // _numericRequest
 //
@@ -397,17 +805,42 @@ std::string indri::server::NetworkServerProxy::_stringRequest( indri::xml::XMLNo
 // runQuery
 //
 
-indri::server::QueryServerResponse* indri::server::NetworkServerProxy::runQuery( std::vector<indri::lang::Node*>& roots, int resultsRequested, bool optimize ) {
+indri::server::QueryServerResponse* indri::server::NetworkServerProxy::runQuery( std::vector<indri::lang::Node*>& roots, int resultsRequested, bool optimize, const indri::api::QueryBudget& budget ) {
   indri::lang::Packer packer;
 
   for( size_t i=0; i<roots.size(); i++ ) {
     packer.pack( roots[i] );
   }
 
+  if( _pipeline ) {
+    // the query trees stay in the form Packer writes
+    indri::xml::XMLWriter writer( packer.xml() );
+    std::string text;
+    writer.write( text );
+
+    indri::utility::Buffer body;
+    indri::net::BinaryMessageWriter request( body );
+    request.writeString( text );
+    request.writeInt32( resultsRequested );
+    request.writeInt32( optimize ? 1 : 0 );
+    request.writeInt64( budget.postings );
+    request.writeInt64( budget.documents );
+    request.writeInt64( budget.milliseconds );
+
+    UINT32 id = _binaryRequest( indri::net::BinaryMessage::QUERY, body );
+    return new indri::server::NetworkServerProxyBinaryResponse( _pipeline, id );
+  }
+
   indri::xml::XMLNode* query = packer.xml();
   query->addAttribute( "resultsRequested", i64_to_string(resultsRequested) );
   query->addAttribute( "optimize", optimize ? "1" : "0" );
 
+  if( !budget.unlimited() ) {
+    query->addAttribute( "budgetPostings", i64_to_string(budget.postings) );
+    query->addAttribute( "budgetDocuments", i64_to_string(budget.documents) );
+    query->addAttribute( "budgetMilliseconds", i64_to_string(budget.milliseconds) );
+  }
+
   _stream->mutex().lock();
   _stream->request( query );
 
@@ -419,6 +852,19 @@ indri::server::QueryServerResponse* indri::server::NetworkServerProxy::runQuery(
 //
 
 indri::server::QueryServerMetadataResponse* indri::server::NetworkServerProxy::documentMetadata( const std::vector<lemur::api::DOCID_T>& documentIDs, const std::string& attributeName ) {
+  if( _pipeline ) {
+    indri::utility::Buffer body;
+    indri::net::BinaryMessageWriter request( body );
+    request.writeString( attributeName );
+    request.writeInt32( (INT32)documentIDs.size() );
+
+    for( size_t i=0; i<documentIDs.size(); i++ )
+      request.writeInt32( documentIDs[i] );
+
+    UINT32 id = _binaryRequest( indri::net::BinaryMessage::DOCUMENT_METADATA, body );
+    return new indri::server::NetworkServerProxyBinaryMetadataResponse( _pipeline, id );
+  }
+
   indri::xml::XMLNode* request = new indri::xml::XMLNode( "document-metadata" );
   indri::xml::XMLNode* field = new indri::xml::XMLNode( "field", attributeName );
   indri::xml::XMLNode* documents = new indri::xml::XMLNode( "documents" );
@@ -443,6 +889,21 @@ indri::server::QueryServerMetadataResponse* indri::server::NetworkServerProxy::d
 //
 
 indri::server::QueryServerMetadataResponse* indri::server::NetworkServerProxy::pathNames( const std::vector<lemur::api::DOCID_T>& documentIDs, const std::vector<int>& begins, const std::vector<int>& ends ) {
+  if( _pipeline ) {
+    indri::utility::Buffer body;
+    indri::net::BinaryMessageWriter request( body );
+    request.writeInt32( (INT32)documentIDs.size() );
+
+    for( size_t i=0; i<documentIDs.size(); i++ ) {
+      request.writeInt32( documentIDs[i] );
+      request.writeInt32( begins[i] );
+      request.writeInt32( ends[i] );
+    }
+
+    UINT32 id = _binaryRequest( indri::net::BinaryMessage::PATH_NAMES, body );
+    return new indri::server::NetworkServerProxyBinaryMetadataResponse( _pipeline, id );
+  }
+
   indri::xml::XMLNode* request = new indri::xml::XMLNode( "path-names" );
   indri::xml::XMLNode* documents = new indri::xml::XMLNode( "paths" );
 
@@ -467,6 +928,18 @@ indri::server::QueryServerMetadataResponse* indri::server::NetworkServerProxy::p
 //
 
 indri::server::QueryServerDocumentsResponse* indri::server::NetworkServerProxy::documents( const std::vector<lemur::api::DOCID_T>& documentIDs ) {
+  if( _pipeline ) {
+    indri::utility::Buffer body;
+    indri::net::BinaryMessageWriter request( body );
+    request.writeInt32( (INT32)documentIDs.size() );
+
+    for( size_t i=0; i<documentIDs.size(); i++ )
+      request.writeInt32( documentIDs[i] );
+
+    UINT32 id = _binaryRequest( indri::net::BinaryMessage::DOCUMENTS, body );
+    return new indri::server::NetworkServerProxyBinaryDocumentsResponse( _pipeline, id );
+  }
+
   indri::xml::XMLNode* docRequest = new indri::xml::XMLNode( "documents" );
 
   for( size_t i=0; i<documentIDs.size(); i++ ) {
@@ -485,6 +958,19 @@ indri::server::QueryServerDocumentsResponse* indri::server::NetworkServerProxy::
 //
 
 indri::server::QueryServerDocumentsResponse* indri::server::NetworkServerProxy::documentsFromMetadata( const std::string& attributeName, const std::vector<std::string>& attributeValues ) {
+  if( _pipeline ) {
+    indri::utility::Buffer body;
+    indri::net::BinaryMessageWriter request( body );
+    request.writeString( attributeName );
+    request.writeInt32( (INT32)attributeValues.size() );
+
+    for( size_t i=0; i<attributeValues.size(); i++ )
+      request.writeString( attributeValues[i] );
+
+    UINT32 id = _binaryRequest( indri::net::BinaryMessage::DOCUMENTS_FROM_METADATA, body );
+    return new indri::server::NetworkServerProxyBinaryDocumentsResponse( _pipeline, id );
+  }
+
   indri::xml::XMLNode* docRequest = new indri::xml::XMLNode( "documents-from-metadata" );
 
   // store the attribute name
@@ -510,6 +996,19 @@ indri::server::QueryServerDocumentsResponse* indri::server::NetworkServerProxy::
 //
 
 indri::server::QueryServerDocumentIDsResponse* indri::server::NetworkServerProxy::documentIDsFromMetadata( const std::string& attributeName, const std::vector<std::string>& attributeValues ) {
+  if( _pipeline ) {
+    indri::utility::Buffer body;
+    indri::net::BinaryMessageWriter request( body );
+    request.writeString( attributeName );
+    request.writeInt32( (INT32)attributeValues.size() );
+
+    for( size_t i=0; i<attributeValues.size(); i++ )
+      request.writeString( attributeValues[i] );
+
+    UINT32 id = _binaryRequest( indri::net::BinaryMessage::DOCUMENT_IDS_FROM_METADATA, body );
+    return new indri::server::NetworkServerProxyBinaryDocumentIDsResponse( _pipeline, id );
+  }
+
   indri::xml::XMLNode* docRequest = new indri::xml::XMLNode( "docids-from-metadata" );
  
   // store the attribute name
@@ -535,6 +1034,11 @@ indri::server::QueryServerDocumentIDsResponse* indri::server::NetworkServerProxy
 //
 
 INT64 indri::server::NetworkServerProxy::termCount() {
+  if( _pipeline ) {
+    indri::utility::Buffer body;
+    return _binaryNumericRequest( indri::net::BinaryMessage::TERM_COUNT, body );
+  }
+
   //  std::auto_ptr<indri::xml::XMLNode> request( new indri::xml::XMLNode( "term-count" ) );
   indri::xml::XMLNode *request = new indri::xml::XMLNode( "term-count" ) ;
   return _numericRequest( request );
@@ -545,36 +1049,84 @@ INT64 indri::server::NetworkServerProxy::termCount() {
 //
 
 INT64 indri::server::NetworkServerProxy::termCount( const std::string& term ) {
+  if( _pipeline ) {
+    indri::utility::Buffer body;
+    indri::net::BinaryMessageWriter request( body );
+    request.writeString( term );
+    return _binaryNumericRequest( indri::net::BinaryMessage::TERM_COUNT_TEXT, body );
+  }
+
   indri::xml::XMLNode* request = new indri::xml::XMLNode( "term-count-text", term );
   return _numericRequest( request );
 }
 
 INT64 indri::server::NetworkServerProxy::termCountUnique( ) {
+  if( _pipeline ) {
+    indri::utility::Buffer body;
+    return _binaryNumericRequest( indri::net::BinaryMessage::TERM_COUNT_UNIQUE, body );
+  }
+
   indri::xml::XMLNode* request = new indri::xml::XMLNode( "term-count-unique" );
   return _numericRequest( request );
 }
 
 INT64 indri::server::NetworkServerProxy::stemCount( const std::string& term ) {
+  if( _pipeline ) {
+    indri::utility::Buffer body;
+    indri::net::BinaryMessageWriter request( body );
+    request.writeString( term );
+    return _binaryNumericRequest( indri::net::BinaryMessage::STEM_COUNT_TEXT, body );
+  }
+
   indri::xml::XMLNode* request = new indri::xml::XMLNode( "stem-count-text", term );
   return _numericRequest( request );
 }
 
 std::string indri::server::NetworkServerProxy::termName( lemur::api::TERMID_T term ) {
+  if( _pipeline ) {
+    indri::utility::Buffer body;
+    indri::net::BinaryMessageWriter request( body );
+    request.writeInt32( term );
+    return _binaryStringRequest( indri::net::BinaryMessage::TERM_NAME, body );
+  }
+
   indri::xml::XMLNode* request = new indri::xml::XMLNode( "term-name", i64_to_string(term) );
   return _stringRequest( request );
 }
 
 std::string indri::server::NetworkServerProxy::stemTerm( const std::string & term ) {
+  if( _pipeline ) {
+    indri::utility::Buffer body;
+    indri::net::BinaryMessageWriter request( body );
+    request.writeString( term );
+    return _binaryStringRequest( indri::net::BinaryMessage::TERM_STEM, body );
+  }
+
   indri::xml::XMLNode* request = new indri::xml::XMLNode( "term-stem", term );
   return _stringRequest( request );
 }
 
 lemur::api::TERMID_T indri::server::NetworkServerProxy::termID( const std::string& term ) {
+  if( _pipeline ) {
+    indri::utility::Buffer body;
+    indri::net::BinaryMessageWriter request( body );
+    request.writeString( term );
+    return _binaryNumericRequest( indri::net::BinaryMessage::TERM_ID, body );
+  }
+
   indri::xml::XMLNode* request = new indri::xml::XMLNode( "term-id", term );
   return _numericRequest( request );
 }
 
 INT64 indri::server::NetworkServerProxy::termFieldCount( const std::string& term, const std::string& field ) {
+  if( _pipeline ) {
+    indri::utility::Buffer body;
+    indri::net::BinaryMessageWriter request( body );
+    request.writeString( term );
+    request.writeString( field );
+    return _binaryNumericRequest( indri::net::BinaryMessage::TERM_FIELD_COUNT, body );
+  }
+
   indri::xml::XMLNode* request = new indri::xml::XMLNode( "term-field-count" );
   indri::xml::XMLNode* termNode = new indri::xml::XMLNode( "term-text", term );
   indri::xml::XMLNode* fieldNode = new indri::xml::XMLNode( "field", field );
@@ -585,6 +1137,14 @@ INT64 indri::server::NetworkServerProxy::termFieldCount( const std::string& term
 }
 
 INT64 indri::server::NetworkServerProxy::stemFieldCount( const std::string& stem, const std::string& field ) {
+  if( _pipeline ) {
+    indri::utility::Buffer body;
+    indri::net::BinaryMessageWriter request( body );
+    request.writeString( stem );
+    request.writeString( field );
+    return _binaryNumericRequest( indri::net::BinaryMessage::STEM_FIELD_COUNT, body );
+  }
+
   indri::xml::XMLNode* request = new indri::xml::XMLNode( "stem-field-count" );
   indri::xml::XMLNode* stemNode = new indri::xml::XMLNode( "stem-text", stem );
   indri::xml::XMLNode* fieldNode = new indri::xml::XMLNode( "field", field );
@@ -595,6 +1155,22 @@ INT64 indri::server::NetworkServerProxy::stemFieldCount( const std::string& stem
 }
 
 std::vector<std::string> indri::server::NetworkServerProxy::fieldList() {
+  if( _pipeline ) {
+    indri::utility::Buffer body;
+    UINT32 id = _binaryRequest( indri::net::BinaryMessage::FIELD_LIST, body );
+    std::vector<std::string> result;
+    std::string reply;
+
+    _pipeline->receive( id, reply );
+    indri::net::BinaryMessageReader reader( reply.data(), reply.length() );
+    int count = reader.readInt32();
+
+    for( int i=0; i<count; i++ )
+      result.push_back( reader.readString() );
+
+    return result;
+  }
+
   std::auto_ptr<indri::xml::XMLNode> request( new indri::xml::XMLNode( "field-list" ) );
   indri::thread::ScopedLock( _stream->mutex() );
   _stream->request( request.get() );
@@ -614,28 +1190,70 @@ std::vector<std::string> indri::server::NetworkServerProxy::fieldList() {
 }
 
 int indri::server::NetworkServerProxy::documentLength( lemur::api::DOCID_T documentID ) {
+  if( _pipeline ) {
+    indri::utility::Buffer body;
+    indri::net::BinaryMessageWriter request( body );
+    request.writeInt32( documentID );
+    return (int) _binaryNumericRequest( indri::net::BinaryMessage::DOCUMENT_LENGTH, body );
+  }
+
   indri::xml::XMLNode* request = new indri::xml::XMLNode( "document-length", i64_to_string(documentID) );
   return (int) _numericRequest( request );
 }
 
 INT64 indri::server::NetworkServerProxy::documentCount() {
+  if( _pipeline ) {
+    indri::utility::Buffer body;
+    return _binaryNumericRequest( indri::net::BinaryMessage::DOCUMENT_COUNT, body );
+  }
+
   indri::xml::XMLNode* request = new indri::xml::XMLNode( "document-count" );
   return _numericRequest( request );
 }
 
 INT64 indri::server::NetworkServerProxy::documentCount( const std::string& term ) {
+  if( _pipeline ) {
+    indri::utility::Buffer body;
+    indri::net::BinaryMessageWriter request( body );
+    request.writeString( term );
+    return _binaryNumericRequest( indri::net::BinaryMessage::DOCUMENT_TERM_COUNT, body );
+  }
+
   indri::xml::XMLNode* request = new indri::xml::XMLNode( "document-term-count", term );
   return _numericRequest( request );
 }
 
 INT64 indri::server::NetworkServerProxy::documentStemCount( const std::string& term ) {
+  if( _pipeline ) {
+    indri::utility::Buffer body;
+    indri::net::BinaryMessageWriter request( body );
+    request.writeString( term );
+    return _binaryNumericRequest( indri::net::BinaryMessage::DOCUMENT_STEM_COUNT, body );
+  }
+
   indri::xml::XMLNode* request = new indri::xml::XMLNode( "document-stem-count", term );
   return _numericRequest( request );
 }
 
-indri::server::QueryServerVectorsResponse* indri::server::NetworkServerProxy::documentVectors( const std::vector<lemur::api::DOCID_T>& documentIDs ) {
+indri::server::QueryServerVectorsResponse* indri::server::NetworkServerProxy::documentVectors( const std::vector<lemur::api::DOCID_T>& documentIDs, bool sharedStems ) {
+  if( _pipeline ) {
+    indri::utility::Buffer body;
+    indri::net::BinaryMessageWriter request( body );
+    request.writeInt32( sharedStems ? 1 : 0 );
+    request.writeInt32( (INT32)documentIDs.size() );
+
+    for( size_t i=0; i<documentIDs.size(); i++ )
+      request.writeInt32( documentIDs[i] );
+
+    UINT32 id = _binaryRequest( indri::net::BinaryMessage::DOCUMENT_VECTORS, body );
+    return new indri::server::NetworkServerProxyBinaryVectorsResponse( _pipeline, id );
+  }
+
   indri::xml::XMLNode* request = new indri::xml::XMLNode( "document-vectors" );
 
+  if( sharedStems )
+    request->addAttribute( "sharedStems", "1" );
+
   for( size_t i=0; i<documentIDs.size(); i++ ) {
     request->addChild( new indri::xml::XMLNode( "document", i64_to_string(documentIDs[i]) ) );
   }
@@ -651,6 +1269,14 @@ indri::server::QueryServerVectorsResponse* indri::server::NetworkServerProxy::do
 // setMaxWildcardTerms
 //
 void indri::server::NetworkServerProxy::setMaxWildcardTerms(int maxTerms) {
+  if( _pipeline ) {
+    indri::utility::Buffer body;
+    indri::net::BinaryMessageWriter request( body );
+    request.writeInt32( maxTerms );
+    _binaryNumericRequest( indri::net::BinaryMessage::MAX_WILDCARD_TERMS, body );
+    return;
+  }
+
   indri::xml::XMLNode* request = new indri::xml::XMLNode( "max-wildcard-terms", i64_to_string(maxTerms) );
   INT64 termMax=_numericRequest( request );
 }
@@ -22,14 +22,59 @@
 #include "indri/QueryServer.hpp"
 #include "indri/QueryResponsePacker.hpp"
 #include "indri/ParsedDocument.hpp"
+#include "indri/XMLReader.hpp"
+#include "indri/ScopedLock.hpp"
 #include "lemur/Exception.hpp"
 
-indri::net::NetworkServerStub::NetworkServerStub( indri::server::QueryServer* server, indri::net::NetworkMessageStream* stream ) :
+//
+// BinaryRequestTask
+//
+
+class indri::net::NetworkServerStub::BinaryRequestTask : public indri::thread::ThreadPool::Task {
+private:
+  NetworkServerStub* _stub;
+  UINT32 _id;
+  UINT32 _kind;
+  std::string _body;
+
+public:
+  BinaryRequestTask( NetworkServerStub* stub, UINT32 id, UINT32 kind, const void* body, unsigned int length ) :
+    _stub(stub),
+    _id(id),
+    _kind(kind),
+    _body( (const char*) body, length )
+  {
+  }
+
+  void run() {
+    // the stub's destructor waits for every pending request, so this one
+    // must finish even if replying throws (the pool drops the exception)
+    try {
+      _stub->_handleBinaryRequest( _id, _kind, _body.data(), (unsigned int)_body.length() );
+    } catch( ... ) {
+      _stub->_finishBinaryRequest();
+      throw;
+    }
+
+    _stub->_finishBinaryRequest();
+  }
+};
+
+indri::net::NetworkServerStub::NetworkServerStub( indri::server::QueryServer* server, indri::net::NetworkMessageStream* stream, indri::thread::ThreadPool* pool ) :
   _server(server),
-  _stream(stream)
+  _stream(stream),
+  _pool(pool),
+  _pending(0)
 {
 }
 
+indri::net::NetworkServerStub::~NetworkServerStub() {
+  indri::thread::ScopedLock lock( _pendingLock );
+
+  while( _pending )
+    _pendingChanged.wait( _pendingLock );
+}
+
 void indri::net::NetworkServerStub::_decodeMetadataRequest( const class indri::xml::XMLNode* request,
                                                             std::string& attributeName,
                                                             std::vector<std::string>& attributeValues )
@@ -140,8 +185,15 @@ void indri::net::NetworkServerStub::_handleQuery( indri::xml::XMLNode* request )
   std::vector<indri::lang::Node*> nodes = unpacker.unpack();
   int resultsRequested = (int) string_to_i64( request->getAttribute( "resultsRequested" ) );
   bool optimize = request->getAttribute("optimize") == "1";
+  indri::api::QueryBudget budget;
+
+  if( request->getAttribute( "budgetPostings" ).length() ) {
+    budget.postings = string_to_i64( request->getAttribute( "budgetPostings" ) );
+    budget.documents = string_to_i64( request->getAttribute( "budgetDocuments" ) );
+    budget.milliseconds = string_to_i64( request->getAttribute( "budgetMilliseconds" ) );
+  }
 
-  indri::server::QueryServerResponse* response = _server->runQuery( nodes, resultsRequested, optimize );
+  indri::server::QueryServerResponse* response = _server->runQuery( nodes, resultsRequested, optimize, budget );
   indri::infnet::InferenceNetwork::MAllResults results = response->getResults();
 
   QueryResponsePacker packer( results );
@@ -222,6 +274,14 @@ void indri::net::NetworkServerStub::_handleDocumentMetadata( indri::xml::XMLNode
   delete response;
 }
 
+void indri::net::NetworkServerStub::_encodeStems( indri::xml::XMLNode* stems, const std::vector<std::string>& stemsVector ) {
+  for( size_t j=0; j<stemsVector.size(); j++ ) {
+    const std::string& stem = stemsVector[j];
+    std::string encoded = base64_encode( stem.c_str(), (int)stem.length() );
+    stems->addChild( new indri::xml::XMLNode( "stem", encoded ) );
+  }
+}
+
 void indri::net::NetworkServerStub::_handleDocumentVectors( indri::xml::XMLNode* request ) {
   const std::vector<indri::xml::XMLNode*>& children = request->getChildren();
   indri::xml::XMLNode* response = new indri::xml::XMLNode( "document-vector" );
@@ -233,22 +293,27 @@ void indri::net::NetworkServerStub::_handleDocumentVectors( indri::xml::XMLNode*
   }
 
   // get the document vectors from the index
-  indri::server::QueryServerVectorsResponse* vectorsResponse = _server->documentVectors( documentIDs );
+  bool sharedStems = request->getAttribute( "sharedStems" ) == "1";
+  indri::server::QueryServerVectorsResponse* vectorsResponse = _server->documentVectors( documentIDs, sharedStems );
+
+  if( sharedStems ) {
+    // one list of stems, sent before the documents
+    indri::xml::XMLNode* stems = new indri::xml::XMLNode( "stems" );
+    _encodeStems( stems, vectorsResponse->getStems() );
+    response->addChild( stems );
+  }
 
   for( size_t i=0; i<vectorsResponse->getResults().size(); i++ ) {
     indri::api::DocumentVector* docVector = vectorsResponse->getResults()[i];
 
     indri::xml::XMLNode* docResponse = new indri::xml::XMLNode( "document" );
-    indri::xml::XMLNode* stems = new indri::xml::XMLNode( "stems" );
     indri::xml::XMLNode* positions = new indri::xml::XMLNode( "positions" );
     indri::xml::XMLNode* fields = new indri::xml::XMLNode( "fields" );
 
-    const std::vector<std::string>& stemsVector = docVector->stems();
-
-    for( size_t j=0; j<stemsVector.size(); j++ ) {
-      const std::string& stem = stemsVector[j];
-      std::string encoded = base64_encode( stem.c_str(), (int)stem.length() );
-      stems->addChild( new indri::xml::XMLNode( "stem", encoded ) );
+    if( !sharedStems ) {
+      indri::xml::XMLNode* stems = new indri::xml::XMLNode( "stems" );
+      _encodeStems( stems, docVector->stems() );
+      docResponse->addChild(stems);
     }
 
     const std::vector<int>& positionsVector = docVector->positions();
@@ -277,7 +342,6 @@ void indri::net::NetworkServerStub::_handleDocumentVectors( indri::xml::XMLNode*
       fields->addChild( field );
     }
 
-    docResponse->addChild(stems);
     docResponse->addChild(positions);
     docResponse->addChild(fields);
 
@@ -439,6 +503,379 @@ void indri::net::NetworkServerStub::_handleSetMaxWildcardTerms( indri::xml::XMLN
   _sendNumericResponse( "max-wildcard-terms", nTerms );
 }
 
+void indri::net::NetworkServerStub::_handleBinaryProtocol( indri::xml::XMLNode* request ) {
+  // the client may send binary requests from now on; servers that
+  // predate them answer this request with an error
+  _stream->setNoDelay();
+  _sendNumericResponse( "binary-protocol", BinaryMessage::VERSION );
+}
+
+//
+// _readDocumentIDs
+//
+
+void indri::net::NetworkServerStub::_readDocumentIDs( BinaryMessageReader& request, std::vector<lemur::api::DOCID_T>& documentIDs ) {
+  int count = request.readInt32();
+
+  for( int i=0; i<count; i++ )
+    documentIDs.push_back( request.readInt32() );
+}
+
+//
+// _readMetadataRequest
+//
+
+void indri::net::NetworkServerStub::_readMetadataRequest( BinaryMessageReader& request, std::string& attributeName, std::vector<std::string>& attributeValues ) {
+  attributeName = request.readString();
+  int count = request.readInt32();
+
+  for( int i=0; i<count; i++ )
+    attributeValues.push_back( request.readString() );
+}
+
+//
+// _writeStrings
+//
+
+void indri::net::NetworkServerStub::_writeStrings( BinaryMessageWriter& reply, const std::vector<std::string>& strings ) {
+  reply.writeInt32( (INT32)strings.size() );
+
+  for( size_t i=0; i<strings.size(); i++ )
+    reply.writeString( strings[i] );
+}
+
+//
+// _writeDocuments
+//
+// For each document: its metadata count, then each key and value; a flag
+// saying whether there is text, followed by the text, the content offset
+// and the content length if there is; then the position count, and the
+// begin and end of each position.
+//
+
+void indri::net::NetworkServerStub::_writeDocuments( BinaryMessageWriter& reply, indri::server::QueryServerDocumentsResponse* response ) {
+  std::vector<indri::api::ParsedDocument*> documents = response->getResults();
+  delete response;
+
+  reply.writeInt32( (INT32)documents.size() );
+
+  for( size_t i=0; i<documents.size(); i++ ) {
+    const indri::api::ParsedDocument* document = documents[i];
+
+    reply.writeInt32( (INT32)document->metadata.size() );
+
+    for( size_t j=0; j<document->metadata.size(); j++ ) {
+      reply.writeString( document->metadata[j].key, strlen( document->metadata[j].key ) );
+      reply.writeString( (const char*) document->metadata[j].value, document->metadata[j].valueLength );
+    }
+
+    reply.writeInt32( document->text ? 1 : 0 );
+
+    if( document->text ) {
+      reply.writeString( document->text, document->textLength );
+      reply.writeInt64( document->content ? document->content - document->text : 0 );
+      reply.writeInt64( document->content ? document->contentLength : 0 );
+    }
+
+    reply.writeInt32( (INT32)document->positions.size() );
+
+    for( size_t j=0; j<document->positions.size(); j++ ) {
+      reply.writeInt32( document->positions[j].begin );
+      reply.writeInt32( document->positions[j].end );
+    }
+  }
+
+  for( size_t i=0; i<documents.size(); i++ )
+    delete documents[i];
+}
+
+//
+// _binaryQuery
+//
+// Request: the query trees as written by Packer, the number of results,
+// the optimize flag, and the budget's postings, documents and milliseconds.
+// Reply: the results, as written by QueryResponsePacker.
+//
+
+void indri::net::NetworkServerStub::_binaryQuery( BinaryMessageReader& request, BinaryMessageWriter& reply ) {
+  const char* text;
+  size_t textLength = request.readString( text );
+
+  indri::xml::XMLReader reader;
+  std::auto_ptr<indri::xml::XMLNode> queryNode( reader.read( text, textLength ) );
+  indri::lang::Unpacker unpacker( queryNode.get() );
+  std::vector<indri::lang::Node*> nodes = unpacker.unpack();
+
+  int resultsRequested = request.readInt32();
+  bool optimize = request.readInt32() != 0;
+  indri::api::QueryBudget budget;
+  budget.postings = request.readInt64();
+  budget.documents = request.readInt64();
+  budget.milliseconds = request.readInt64();
+
+  indri::server::QueryServerResponse* response = _server->runQuery( nodes, resultsRequested, optimize, budget );
+  std::auto_ptr<indri::server::QueryServerResponse> responseOwner( response );
+
+  QueryResponsePacker packer( response->getResults() );
+  packer.write( reply );
+}
+
+//
+// _binaryDocumentVectors
+//
+// Request: the shared stems flag and the document IDs.
+// Reply: the shared stems flag, the shared stems if it is set, then the
+// number of vectors; for each vector its own stems unless they are shared,
+// its positions, and its fields: the field count, then each name, number,
+// begin, end, ordinal and parent ordinal.
+//
+
+void indri::net::NetworkServerStub::_binaryDocumentVectors( BinaryMessageReader& request, BinaryMessageWriter& reply ) {
+  std::vector<lemur::api::DOCID_T> documentIDs;
+  bool sharedStems = request.readInt32() != 0;
+  _readDocumentIDs( request, documentIDs );
+
+  indri::server::QueryServerVectorsResponse* vectorsResponse = _server->documentVectors( documentIDs, sharedStems );
+  std::auto_ptr<indri::server::QueryServerVectorsResponse> responseOwner( vectorsResponse );
+  std::vector<indri::api::DocumentVector*>& vectors = vectorsResponse->getResults();
+
+  reply.writeInt32( sharedStems ? 1 : 0 );
+
+  if( sharedStems )
+    _writeStrings( reply, vectorsResponse->getStems() );
+
+  reply.writeInt32( (INT32)vectors.size() );
+
+  for( size_t i=0; i<vectors.size(); i++ ) {
+    indri::api::DocumentVector* docVector = vectors[i];
+
+    if( !sharedStems )
+      _writeStrings( reply, docVector->stems() );
+
+    const std::vector<int>& positions = docVector->positions();
+    reply.writeInt32( (INT32)positions.size() );
+
+    for( size_t j=0; j<positions.size(); j++ )
+      reply.writeInt32( positions[j] );
+
+    const std::vector<indri::api::DocumentVector::Field>& fields = docVector->fields();
+    reply.writeInt32( (INT32)fields.size() );
+
+    for( size_t j=0; j<fields.size(); j++ ) {
+      reply.writeString( fields[j].name );
+      reply.writeInt64( fields[j].number );
+      reply.writeInt32( fields[j].begin );
+      reply.writeInt32( fields[j].end );
+      reply.writeInt32( fields[j].ordinal );
+      reply.writeInt32( fields[j].parentOrdinal );
+    }
+  }
+
+  for( size_t i=0; i<vectors.size(); i++ )
+    delete vectors[i];
+}
+
+//
+// _binaryPathNames
+//
+// Request: the number of paths, then each document ID, begin and end.
+// Reply: the path names.
+//
+
+void indri::net::NetworkServerStub::_binaryPathNames( BinaryMessageReader& request, BinaryMessageWriter& reply ) {
+  std::vector<lemur::api::DOCID_T> documentIDs;
+  std::vector<int> begins;
+  std::vector<int> ends;
+  int count = request.readInt32();
+
+  for( int i=0; i<count; i++ ) {
+    documentIDs.push_back( request.readInt32() );
+    begins.push_back( request.readInt32() );
+    ends.push_back( request.readInt32() );
+  }
+
+  std::auto_ptr<indri::server::QueryServerMetadataResponse> response( _server->pathNames( documentIDs, begins, ends ) );
+  _writeStrings( reply, response->getResults() );
+}
+
+//
+// _handleBinaryRequest
+//
+// Requests not described by one of the functions above are laid out as follows.
+// Documents: the document IDs; reply: the documents, as in _writeDocuments.
+// Documents from metadata: the attribute name and values; reply: the documents.
+// Document IDs from metadata: the attribute name and values; reply: the document IDs.
+// Document metadata: the attribute name and the document IDs; reply: the values.
+// Field list: empty; reply: the field names.
+// Term name: the term ID; reply: the name.  Term stem: the term; reply: the stem.
+// Term and stem field counts: the term or stem, then the field; reply: the count.
+// Document length and maximum wildcard terms: a 4 byte number; reply: an 8 byte number.
+// The remaining counts: empty, or the term or stem; reply: an 8 byte number.
+// Lists of document IDs and of strings are written as their length, then each element.
+//
+
+void indri::net::NetworkServerStub::_handleBinaryRequest( UINT32 id, UINT32 kind, const char* body, unsigned int length ) {
+  indri::utility::Buffer replyBuffer;
+
+  try {
+    BinaryMessageReader request( body, length );
+    BinaryMessageWriter reply( replyBuffer );
+    std::vector<lemur::api::DOCID_T> documentIDs;
+    std::string attributeName;
+    std::vector<std::string> attributeValues;
+
+    switch( kind ) {
+      case BinaryMessage::QUERY:
+        _binaryQuery( request, reply );
+        break;
+
+      case BinaryMessage::DOCUMENTS:
+        _readDocumentIDs( request, documentIDs );
+        _writeDocuments( reply, _server->documents( documentIDs ) );
+        break;
+
+      case BinaryMessage::DOCUMENTS_FROM_METADATA:
+        _readMetadataRequest( request, attributeName, attributeValues );
+        _writeDocuments( reply, _server->documentsFromMetadata( attributeName, attributeValues ) );
+        break;
+
+      case BinaryMessage::DOCUMENT_IDS_FROM_METADATA: {
+        _readMetadataRequest( request, attributeName, attributeValues );
+        std::auto_ptr<indri::server::QueryServerDocumentIDsResponse> response( _server->documentIDsFromMetadata( attributeName, attributeValues ) );
+        documentIDs = response->getResults();
+
+        reply.writeInt32( (INT32)documentIDs.size() );
+
+        for( size_t i=0; i<documentIDs.size(); i++ )
+          reply.writeInt32( documentIDs[i] );
+      } break;
+
+      case BinaryMessage::DOCUMENT_METADATA: {
+        attributeName = request.readString();
+        _readDocumentIDs( request, documentIDs );
+        std::auto_ptr<indri::server::QueryServerMetadataResponse> response( _server->documentMetadata( documentIDs, attributeName ) );
+        _writeStrings( reply, response->getResults() );
+      } break;
+
+      case BinaryMessage::DOCUMENT_VECTORS:
+        _binaryDocumentVectors( request, reply );
+        break;
+
+      case BinaryMessage::PATH_NAMES:
+        _binaryPathNames( request, reply );
+        break;
+
+      case BinaryMessage::FIELD_LIST:
+        _writeStrings( reply, _server->fieldList() );
+        break;
+
+      case BinaryMessage::TERM_NAME:
+        reply.writeString( _server->termName( request.readInt32() ) );
+        break;
+
+      case BinaryMessage::TERM_STEM:
+        reply.writeString( _server->stemTerm( request.readString() ) );
+        break;
+
+      case BinaryMessage::TERM_FIELD_COUNT: {
+        std::string term = request.readString();
+        reply.writeInt64( _server->termFieldCount( term, request.readString() ) );
+      } break;
+
+      case BinaryMessage::STEM_FIELD_COUNT: {
+        std::string stem = request.readString();
+        reply.writeInt64( _server->stemFieldCount( stem, request.readString() ) );
+      } break;
+
+      case BinaryMessage::TERM_COUNT:
+        reply.writeInt64( _server->termCount() );
+        break;
+
+      case BinaryMessage::TERM_COUNT_UNIQUE:
+        reply.writeInt64( _server->termCountUnique() );
+        break;
+
+      case BinaryMessage::TERM_COUNT_TEXT:
+        reply.writeInt64( _server->termCount( request.readString() ) );
+        break;
+
+      case BinaryMessage::STEM_COUNT_TEXT:
+        reply.writeInt64( _server->stemCount( request.readString() ) );
+        break;
+
+      case BinaryMessage::TERM_ID:
+        reply.writeInt64( _server->termID( request.readString() ) );
+        break;
+
+      case BinaryMessage::DOCUMENT_LENGTH:
+        reply.writeInt64( _server->documentLength( request.readInt32() ) );
+        break;
+
+      case BinaryMessage::DOCUMENT_COUNT:
+        reply.writeInt64( _server->documentCount() );
+        break;
+
+      case BinaryMessage::DOCUMENT_TERM_COUNT:
+        reply.writeInt64( _server->documentCount( request.readString() ) );
+        break;
+
+      case BinaryMessage::DOCUMENT_STEM_COUNT:
+        reply.writeInt64( _server->documentStemCount( request.readString() ) );
+        break;
+
+      case BinaryMessage::MAX_WILDCARD_TERMS: {
+        int maxTerms = request.readInt32();
+        _server->setMaxWildcardTerms( maxTerms );
+        reply.writeInt64( maxTerms );
+      } break;
+
+      default:
+        LEMUR_THROW( LEMUR_NETWORK_ERROR, "Unknown binary request kind: " + i64_to_string( kind ) );
+    }
+  } catch( lemur::api::Exception& e ) {
+    _stream->binaryError( id, kind, e.what() );
+    return;
+  } catch( ... ) {
+    _stream->binaryError( id, kind, "Caught unknown exception while processing request" );
+    return;
+  }
+
+  _stream->binaryReply( id, kind, replyBuffer.front(), (unsigned int)replyBuffer.position() );
+}
+
+//
+// _finishBinaryRequest
+//
+
+void indri::net::NetworkServerStub::_finishBinaryRequest() {
+  indri::thread::ScopedLock lock( _pendingLock );
+  _pending--;
+  _pendingChanged.notifyAll();
+}
+
+//
+// binaryRequest
+//
+
+void indri::net::NetworkServerStub::binaryRequest( UINT32 id, UINT32 kind, const void* buffer, unsigned int length ) {
+  if( !_pool ) {
+    _handleBinaryRequest( id, kind, (const char*) buffer, length );
+    return;
+  }
+
+  {
+    // a client that sends faster than we can answer waits in its socket
+    indri::thread::ScopedLock lock( _pendingLock );
+
+    while( _pending >= MAXIMUM_PENDING )
+      _pendingChanged.wait( _pendingLock );
+
+    _pending++;
+  }
+
+  _pool->post( new BinaryRequestTask( this, id, kind, buffer, length ) );
+}
+
 void indri::net::NetworkServerStub::request( indri::xml::XMLNode* input ) {
   try {
     const std::string& type = input->getName();
@@ -487,6 +924,8 @@ void indri::net::NetworkServerStub::request( indri::xml::XMLNode* input ) {
       _handlePathNames( input );
     } else if( type == "max-wildcard-terms" ) {
       _handleSetMaxWildcardTerms( input );
+    } else if( type == "binary-protocol" ) {
+      _handleBinaryProtocol( input );
     } else {
       _stream->error( std::string() + "Unknown XML message type: " + input->getName() );
     }
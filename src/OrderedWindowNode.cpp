@@ -121,6 +121,14 @@ void indri::infnet::OrderedWindowNode::prepare( lemur::api::DOCID_T documentID )
   //          sort incoming words by the number of times they occur
   //          do initial matching with the infrequent terms
   //          check the candidate matches with the more frequent ones.
+
+  // if one word doesn't appear, then there's no use decoding
+  // the positions of the others
+  for( size_t i=0; i<_children.size(); i++ ) {
+    if( !_children[i]->hasExtents() )
+      return;
+  }
+
   // initialize children indices
   for( size_t i=0; i<_children.size(); i++ ) {
     const indri::utility::greedy_vector<indri::index::Extent>& childPositions = _children[i]->extents();
@@ -0,0 +1,100 @@
+/*==========================================================================
+ * Copyright (c) 2004 University of Massachusetts.  All Rights Reserved.
+ *
+ * Use of the Lemur Toolkit for Language Modeling and Information Retrieval
+ * is subject to the terms of the software license set forth in the LICENSE
+ * file included with this software, and also available at
+ * http://www.lemurproject.org/license.html
+ *
+ *==========================================================================
+ */
+
+
+//
+// PhraseListIteratorNode
+//
+
+#include "indri/PhraseListIteratorNode.hpp"
+#include "indri/InferenceNetwork.hpp"
+#include "indri/Annotator.hpp"
+
+indri::infnet::PhraseListIteratorNode::PhraseListIteratorNode( const std::string& name, InferenceNetwork& network, int listID, ListIteratorNode* window ) :
+  _name(name),
+  _network(network),
+  _listID(listID),
+  _window(window),
+  _windowDocument(0),
+  _list(0)
+{
+}
+
+indri::infnet::PhraseListIteratorNode::~PhraseListIteratorNode() {
+  delete _window;
+}
+
+void indri::infnet::PhraseListIteratorNode::indexChanged( indri::index::Index& index ) {
+  // the network starts the list
+  _list = _network.getPhraseIterator( _listID );
+  _windowDocument = 0;
+  _window->indexChanged( index );
+}
+
+void indri::infnet::PhraseListIteratorNode::prepare( lemur::api::DOCID_T documentID ) {
+  // initialize the child / sibling pointer
+  initpointer();
+  _extents.clear();
+  _windowDocument = 0;
+
+  if( !_list ) {
+    _window->prepare( documentID );
+    return;
+  }
+
+  const indri::index::DocExtentListIterator::DocumentExtentData* info = _list->currentEntry();
+
+  if( info && info->document == documentID )
+    _extents = info->extents;
+}
+
+/// returns a list of intervals describing positions of children
+const indri::utility::greedy_vector<indri::index::Extent>& indri::infnet::PhraseListIteratorNode::extents() {
+  if( !_list )
+    return _window->extents();
+
+  return _extents;
+}
+
+bool indri::infnet::PhraseListIteratorNode::hasExtents() {
+  if( !_list )
+    return _window->hasExtents();
+
+  return _extents.size() > 0;
+}
+
+lemur::api::DOCID_T indri::infnet::PhraseListIteratorNode::nextCandidateDocument() {
+  if( !_list )
+    return _window->nextCandidateDocument();
+
+  const indri::index::DocExtentListIterator::DocumentExtentData* info = _list->currentEntry();
+
+  if( !info ) {
+    return MAX_INT32;
+  } else {
+    return info->document;
+  }
+}
+
+const std::string& indri::infnet::PhraseListIteratorNode::getName() const {
+  return _name;
+}
+
+void indri::infnet::PhraseListIteratorNode::annotate( indri::infnet::Annotator& annotator, lemur::api::DOCID_T documentID, indri::index::Extent &extent ) {
+  // the window also annotates the matching terms, so it is matched
+  // here even when the extents came from the stored list
+  if( _list && _windowDocument != documentID ) {
+    _window->prepare( documentID );
+    _windowDocument = documentID;
+  }
+
+  _window->annotate( annotator, documentID, extent );
+}
@@ -0,0 +1,363 @@
+/*==========================================================================
+ * Copyright (c) 2004 University of Massachusetts.  All Rights Reserved.
+ *
+ * Use of the Lemur Toolkit for Language Modeling and Information Retrieval
+ * is subject to the terms of the software license set forth in the LICENSE
+ * file included with this software, and also available at
+ * http://www.lemurproject.org/license.html
+ *
+ *==========================================================================
+ */
+
+//
+// PostingBlockCache
+//
+
+#include "indri/PostingBlockCache.hpp"
+#include "indri/Mutex.hpp"
+#include "indri/ScopedLock.hpp"
+#include "indri/Parameters.hpp"
+#include <list>
+#include <vector>
+#include <string.h>
+#include <stdlib.h>
+
+// block offsets must fit below the index number in a key
+static const int POSTING_BLOCK_OFFSET_BITS = 44;
+
+typedef indri::index::PostingBlockCache::Block posting_block;
+
+//
+// Shard
+//
+
+struct indri::index::PostingBlockCache::Shard {
+  Shard() : memory(0), additions(0), evictions(0), generation(0), hits(0), misses(0) {
+    for( int i=0; i<BUCKETS; i++ )
+      buckets[i] = 0;
+    readers[0] = readers[1] = 0;
+  }
+
+  indri::thread::Mutex lock;
+  posting_block* volatile buckets[BUCKETS];
+  // cached blocks, oldest first
+  std::list<posting_block*> blocks;
+  // blocks taken out of the buckets, by the generation that took them out
+  std::vector<posting_block*> retired[2];
+
+  UINT64 memory;
+  UINT64 additions;
+  UINT64 evictions;
+
+  // readers enter generation & 1; only changed under the lock
+  indri::atomic::value_type generation;
+  indri::atomic::value_type readers[2];
+  indri::atomic::value_type hits;
+  indri::atomic::value_type misses;
+};
+
+static indri::index::PostingBlockCache* posting_block_cache = 0;
+static bool posting_block_cache_created = false;
+static UINT64 posting_block_cache_indexes = 0;
+static indri::thread::Mutex posting_block_cache_lock;
+
+//
+// posting_block_key
+//
+
+static UINT64 posting_block_key( UINT64 index, UINT64 offset ) {
+  return (index << POSTING_BLOCK_OFFSET_BITS) | offset;
+}
+
+//
+// posting_block_bucket
+//
+
+static int posting_block_bucket( UINT64 key ) {
+  return int( ((key * 0x9E3779B97F4A7C15ULL) >> 20) % indri::index::PostingBlockCache::BUCKETS );
+}
+
+//
+// posting_block_memory
+//
+
+static size_t posting_block_memory( const posting_block* block ) {
+  return sizeof(posting_block) + 2*block->entries*sizeof(UINT32);
+}
+
+//
+// posting_block_load
+//
+
+static indri::atomic::value_type posting_block_load( indri::atomic::value_type& variable ) {
+  return *(volatile indri::atomic::value_type*) &variable;
+}
+
+//
+// posting_block_lookup
+//
+
+static posting_block* posting_block_lookup( indri::index::PostingBlockCache::Shard& shard, UINT64 key ) {
+  posting_block* block = shard.buckets[ posting_block_bucket( key ) ];
+
+  while( block && block->key != key )
+    block = block->next;
+
+  return block;
+}
+
+//
+// posting_block_unlink
+//
+
+static void posting_block_unlink( indri::index::PostingBlockCache::Shard& shard, posting_block* block ) {
+  posting_block* volatile* link = &shard.buckets[ posting_block_bucket( block->key ) ];
+
+  while( *link != block )
+    link = &(*link)->next;
+
+  // a reader standing on the block can still follow its next pointer
+  *link = block->next;
+}
+
+//
+// posting_block_reclaim
+//
+
+static void posting_block_reclaim( indri::index::PostingBlockCache::Shard& shard ) {
+  int current = shard.generation & 1;
+  int previous = 1 - current;
+
+  // blocks retired in the previous generation may still be in a reader's hands
+  if( posting_block_load( shard.readers[previous] ) )
+    return;
+
+  for( size_t i=0; i<shard.retired[previous].size(); i++ )
+    indri::index::PostingBlockCache::release( shard.retired[previous][i] );
+  shard.retired[previous].clear();
+
+  // new readers enter the other generation, so that this one can drain
+  if( shard.retired[current].size() )
+    indri::atomic::increment( shard.generation );
+}
+
+//
+// PostingBlockCache
+//
+
+indri::index::PostingBlockCache::PostingBlockCache( UINT64 maximumMemory, UINT64 minimumDocuments ) :
+  _maximumMemory(maximumMemory),
+  _minimumDocuments(minimumDocuments)
+{
+  _shards = new Shard[SHARDS];
+}
+
+//
+// ~PostingBlockCache
+//
+
+indri::index::PostingBlockCache::~PostingBlockCache() {
+  for( int i=0; i<SHARDS; i++ ) {
+    Shard& shard = _shards[i];
+    std::list<posting_block*>::iterator iter;
+
+    for( iter = shard.blocks.begin(); iter != shard.blocks.end(); iter++ )
+      release( *iter );
+
+    for( int j=0; j<2; j++ ) {
+      for( size_t k=0; k<shard.retired[j].size(); k++ )
+        release( shard.retired[j][k] );
+    }
+  }
+
+  delete[] _shards;
+}
+
+//
+// instance
+//
+
+indri::index::PostingBlockCache* indri::index::PostingBlockCache::instance() {
+  indri::thread::ScopedLock lock( posting_block_cache_lock );
+
+  if( !posting_block_cache_created ) {
+    UINT64 memory = indri::api::Parameters::instance().get( "postingCacheMemory", INT64(64*1024*1024) );
+    UINT64 documents = indri::api::Parameters::instance().get( "postingCacheMinimumDocuments", INT64(1024) );
+
+    if( memory )
+      posting_block_cache = new PostingBlockCache( memory, documents );
+
+    posting_block_cache_created = true;
+  }
+
+  return posting_block_cache;
+}
+
+//
+// indexID
+//
+
+UINT64 indri::index::PostingBlockCache::indexID() {
+  indri::thread::ScopedLock lock( posting_block_cache_lock );
+  return ++posting_block_cache_indexes;
+}
+
+//
+// admits
+//
+
+bool indri::index::PostingBlockCache::admits( UINT64 documentCount ) const {
+  return documentCount >= _minimumDocuments;
+}
+
+//
+// _shard
+//
+
+indri::index::PostingBlockCache::Shard& indri::index::PostingBlockCache::_shard( UINT64 key ) {
+  // high bits of the product, so the shard says nothing about the bucket within it
+  return _shards[ ((key * 0x9E3779B97F4A7C15ULL) >> 40) % SHARDS ];
+}
+
+//
+// find
+//
+
+indri::index::PostingBlockCache::Block* indri::index::PostingBlockCache::find( UINT64 index, UINT64 offset ) {
+  if( offset >> POSTING_BLOCK_OFFSET_BITS )
+    return 0;
+
+  UINT64 key = posting_block_key( index, offset );
+  Shard& shard = _shard( key );
+  int generation;
+
+  // if the generation moved on before we were counted, a writer may not wait for us
+  while( true ) {
+    generation = posting_block_load( shard.generation ) & 1;
+    indri::atomic::increment( shard.readers[generation] );
+
+    if( (posting_block_load( shard.generation ) & 1) == generation )
+      break;
+
+    indri::atomic::decrement( shard.readers[generation] );
+  }
+
+  posting_block* block = posting_block_lookup( shard, key );
+
+  if( block ) {
+    indri::atomic::increment( block->references );
+    block->used = true;
+  }
+
+  indri::atomic::decrement( shard.readers[generation] );
+  indri::atomic::increment( block ? shard.hits : shard.misses );
+  return block;
+}
+
+//
+// release
+//
+
+void indri::index::PostingBlockCache::release( Block* block ) {
+  if( indri::atomic::decrement_and_test( block->references ) )
+    free( block );
+}
+
+//
+// add
+//
+
+void indri::index::PostingBlockCache::add( UINT64 index, UINT64 offset,
+                                           const indri::utility::greedy_vector<UINT32>& documents,
+                                           const indri::utility::greedy_vector<UINT32>& counts,
+                                           UINT32 positionsOffset ) {
+  if( (offset >> POSTING_BLOCK_OFFSET_BITS) || !documents.size() )
+    return;
+
+  UINT64 key = posting_block_key( index, offset );
+  int entries = (int)documents.size();
+
+  // documents, then counts, follow the block itself
+  posting_block* block = (posting_block*) malloc( sizeof(posting_block) + 2*entries*sizeof(UINT32) );
+  UINT32* values = (UINT32*) (block + 1);
+  memcpy( values, &documents[0], entries*sizeof(UINT32) );
+  memcpy( values + entries, &counts[0], entries*sizeof(UINT32) );
+
+  block->key = key;
+  block->entries = entries;
+  block->positionsOffset = positionsOffset;
+  block->documents = values;
+  block->counts = values + entries;
+  block->next = 0;
+  block->used = false;
+  block->references = 0;
+
+  size_t memory = posting_block_memory( block );
+  UINT64 maximumMemory = _maximumMemory / SHARDS;
+  Shard& shard = _shard( key );
+  indri::thread::ScopedLock lock( shard.lock );
+
+  // another query may have decoded the same block
+  if( memory > maximumMemory || posting_block_lookup( shard, key ) ) {
+    free( block );
+    return;
+  }
+
+  // evict the oldest blocks until this one fits, giving a second chance to those hit since
+  // the last pass; a bounded number of chances, since readers keep marking blocks
+  size_t chances = shard.blocks.size();
+
+  while( shard.blocks.size() && shard.memory + memory > maximumMemory ) {
+    posting_block* victim = shard.blocks.front();
+
+    if( victim->used && chances ) {
+      victim->used = false;
+      chances--;
+      shard.blocks.splice( shard.blocks.end(), shard.blocks, shard.blocks.begin() );
+      continue;
+    }
+
+    shard.blocks.pop_front();
+    posting_block_unlink( shard, victim );
+    shard.retired[ shard.generation & 1 ].push_back( victim );
+
+    shard.memory -= posting_block_memory( victim );
+    shard.evictions++;
+  }
+
+  // the cache's own reference; the atomic add also orders the contents before the block is published
+  indri::atomic::increment( block->references );
+  int bucket = posting_block_bucket( key );
+  block->next = shard.buckets[bucket];
+  shard.buckets[bucket] = block;
+  shard.blocks.push_back( block );
+
+  shard.memory += memory;
+  shard.additions++;
+
+  posting_block_reclaim( shard );
+}
+
+//
+// statistics
+//
+
+indri::index::PostingBlockCache::Statistics indri::index::PostingBlockCache::statistics() {
+  Statistics result;
+  memset( &result, 0, sizeof(Statistics) );
+  result.maximumMemory = _maximumMemory;
+
+  for( int i=0; i<SHARDS; i++ ) {
+    indri::thread::ScopedLock lock( _shards[i].lock );
+
+    // the atomic counters wrap; reading them unsigned doubles their range
+    result.hits += (UINT32) posting_block_load( _shards[i].hits );
+    result.misses += (UINT32) posting_block_load( _shards[i].misses );
+    result.additions += _shards[i].additions;
+    result.evictions += _shards[i].evictions;
+    result.entries += _shards[i].blocks.size();
+    result.memory += _shards[i].memory;
+  }
+
+  return result;
+}
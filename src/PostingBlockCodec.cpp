@@ -0,0 +1,197 @@
+/*==========================================================================
+ * Copyright (c) 2004 University of Massachusetts.  All Rights Reserved.
+ *
+ * Use of the Lemur Toolkit for Language Modeling and Information Retrieval
+ * is subject to the terms of the software license set forth in the LICENSE
+ * file included with this software, and also available at
+ * http://www.lemurproject.org/license.html
+ *
+ *==========================================================================
+ */
+
+//
+// PostingBlockCodec
+//
+
+#include "indri/PostingBlockCodec.hpp"
+#include <string.h>
+#include <assert.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+//
+// Packed run format:
+//   (1b) bit width b
+//   ceil(count*b/32) 32-bit words in native byte order, like the other
+//   binary data in an index, values packed least significant bit first.
+//
+
+static inline int _packedWords( int count, int bits ) {
+  return (count * bits + 31) / 32;
+}
+
+//
+// _unpack
+//
+// With the bit width fixed at compile time every shift and mask below is
+// a constant, so the loop unrolls into straight-line code (and vectorises
+// where the compiler is able to).
+//
+
+template<int BITS>
+static void _unpack( const UINT32* words, UINT32* values, int count ) {
+  const UINT32 mask = (BITS == 32) ? 0xffffffff : ((1U << BITS) - 1);
+
+  for( int i=0; i<count; i++ ) {
+    int bit = i * BITS;
+    int word = bit >> 5;
+    int shift = bit & 31;
+
+    UINT32 value = words[word] >> shift;
+    if( shift + BITS > 32 )
+      value |= words[word+1] << (32 - shift);
+
+    values[i] = value & mask;
+  }
+}
+
+template<>
+void _unpack<0>( const UINT32* words, UINT32* values, int count ) {
+  memset( values, 0, count * sizeof(UINT32) );
+}
+
+template<>
+void _unpack<32>( const UINT32* words, UINT32* values, int count ) {
+  memcpy( values, words, count * sizeof(UINT32) );
+}
+
+typedef void (*unpack_function)( const UINT32*, UINT32*, int );
+
+static const unpack_function _unpackers[] = {
+  _unpack<0>,  _unpack<1>,  _unpack<2>,  _unpack<3>,
+  _unpack<4>,  _unpack<5>,  _unpack<6>,  _unpack<7>,
+  _unpack<8>,  _unpack<9>,  _unpack<10>, _unpack<11>,
+  _unpack<12>, _unpack<13>, _unpack<14>, _unpack<15>,
+  _unpack<16>, _unpack<17>, _unpack<18>, _unpack<19>,
+  _unpack<20>, _unpack<21>, _unpack<22>, _unpack<23>,
+  _unpack<24>, _unpack<25>, _unpack<26>, _unpack<27>,
+  _unpack<28>, _unpack<29>, _unpack<30>, _unpack<31>,
+  _unpack<32>
+};
+
+//
+// bitsRequired
+//
+
+int indri::index::PostingBlockCodec::bitsRequired( const UINT32* values, int count ) {
+  UINT32 accumulated = 0;
+
+  for( int i=0; i<count; i++ )
+    accumulated |= values[i];
+
+  int bits = 0;
+  while( accumulated ) {
+    bits++;
+    accumulated >>= 1;
+  }
+
+  return bits;
+}
+
+//
+// encode
+//
+
+void indri::index::PostingBlockCodec::encode( indri::utility::Buffer& output, const UINT32* values, int count ) {
+  UINT32 words[BLOCK_SIZE];
+
+  for( int start=0; start<count; start += BLOCK_SIZE ) {
+    int runLength = lemur_compat::min<int>( BLOCK_SIZE, count - start );
+    const UINT32* run = values + start;
+    int bits = bitsRequired( run, runLength );
+    int wordCount = _packedWords( runLength, bits );
+
+    memset( words, 0, wordCount * sizeof(UINT32) );
+
+    for( int i=0; i<runLength && bits; i++ ) {
+      int bit = i * bits;
+      int word = bit >> 5;
+      int shift = bit & 31;
+
+      words[word] |= run[i] << shift;
+      if( shift + bits > 32 )
+        words[word+1] |= run[i] >> (32 - shift);
+    }
+
+    *output.write(1) = (char) bits;
+    memcpy( output.write( wordCount * sizeof(UINT32) ), words, wordCount * sizeof(UINT32) );
+  }
+}
+
+//
+// decode
+//
+
+const char* indri::index::PostingBlockCodec::decode( const char* input, UINT32* values, int count ) {
+  UINT32 words[BLOCK_SIZE];
+
+  for( int start=0; start<count; start += BLOCK_SIZE ) {
+    int runLength = lemur_compat::min<int>( BLOCK_SIZE, count - start );
+    int bits = (UINT8) *input++;
+    int wordCount = _packedWords( runLength, bits );
+
+    assert( bits <= 32 );
+
+    // the input is only byte aligned, so copy it out before unpacking
+    memcpy( words, input, wordCount * sizeof(UINT32) );
+    _unpackers[bits]( words, values + start, runLength );
+    input += wordCount * sizeof(UINT32);
+  }
+
+  return input;
+}
+
+//
+// skip
+//
+
+const char* indri::index::PostingBlockCodec::skip( const char* input, int count ) {
+  for( int start=0; start<count; start += BLOCK_SIZE ) {
+    int runLength = lemur_compat::min<int>( BLOCK_SIZE, count - start );
+    int bits = (UINT8) *input++;
+    input += _packedWords( runLength, bits ) * sizeof(UINT32);
+  }
+
+  return input;
+}
+
+//
+// prefixSum
+//
+
+void indri::index::PostingBlockCodec::prefixSum( UINT32* values, int count, UINT32 base ) {
+  int i = 0;
+
+#ifdef __SSE2__
+  __m128i running = _mm_set1_epi32( base );
+
+  for( ; i + 4 <= count; i += 4 ) {
+    __m128i x = _mm_loadu_si128( (const __m128i*) (values + i) );
+    x = _mm_add_epi32( x, _mm_slli_si128( x, 4 ) );
+    x = _mm_add_epi32( x, _mm_slli_si128( x, 8 ) );
+    x = _mm_add_epi32( x, running );
+    _mm_storeu_si128( (__m128i*) (values + i), x );
+    running = _mm_shuffle_epi32( x, 0xff );
+  }
+
+  if( i )
+    base = values[i-1];
+#endif
+
+  for( ; i < count; i++ ) {
+    base += values[i];
+    values[i] = base;
+  }
+}
@@ -26,6 +26,7 @@
 #include "indri/InferenceNetwork.hpp"
 #include "indri/QuerySpec.hpp"
 #include "indri/ScoredExtentResult.hpp"
+#include "indri/TopResults.hpp"
 
 #include "indri/LocalQueryServer.hpp"
 #include "indri/NetworkServerProxy.hpp"
@@ -77,6 +78,22 @@ using namespace lemur::api;
 #define PRINT_TIMER(s)
 #endif
 
+//
+// qenv_remaining_budget
+//
+// The time limit covers the whole query, so the scoring pass only
+// gets what is left of it.
+//
+
+static indri::api::QueryBudget qenv_remaining_budget( indri::api::QueryBudget budget, UINT64 start ) {
+  if( budget.milliseconds ) {
+    INT64 elapsed = INT64( (indri::utility::IndriTimer::currentTime() - start) / 1000 );
+    budget.milliseconds = lemur_compat::max<INT64>( budget.milliseconds - elapsed, 1 );
+  }
+
+  return budget;
+}
+
 // for debugging; this class prints a query tree
 namespace indri
 {
@@ -141,6 +158,42 @@ void qenv_gather_document_results( const std::vector< std::vector<DOCID_T> >& do
   }
 }
 
+// add the stems of one server, or of one vector, to a merged stem list;
+// serverIDs[j] is set to the merged id of serverStems[j]
+static void qenv_merge_stems( const std::vector<std::string>& serverStems,
+                              std::vector<std::string>& stems,
+                              indri::utility::HashTable<std::string, int>& stemIDs,
+                              std::vector<int>& serverIDs ) {
+  serverIDs.resize( serverStems.size() );
+
+  if( serverIDs.size() )
+    serverIDs[0] = 0;
+
+  for( size_t j=1; j<serverStems.size(); j++ ) {
+    int* found = stemIDs.find( serverStems[j] );
+
+    if( found ) {
+      serverIDs[j] = *found;
+    } else {
+      serverIDs[j] = (int)stems.size();
+      stems.push_back( serverStems[j] );
+      stemIDs.insert( serverStems[j], serverIDs[j] );
+    }
+  }
+}
+
+// rewrite stem ids in positions as merged ids; ids with no stem become [OOV]
+static void qenv_translate_positions( std::vector<int>& positions, const std::vector<int>& serverIDs ) {
+  for( size_t k=0; k<positions.size(); k++ ) {
+    int position = positions[k];
+
+    if( position > 0 && size_t(position) < serverIDs.size() )
+      positions[k] = serverIDs[position];
+    else
+      positions[k] = 0;
+  }
+}
+
 //
 // QueryEnvironment definition
 //
@@ -157,6 +210,14 @@ void indri::api::QueryEnvironment::setMemory( UINT64 memory ) {
   _parameters.set( "memory", memory );
 }
 
+void indri::api::QueryEnvironment::setMappedIndexes( bool mapped ) {
+  _parameters.set( "mappedIndexes", mapped );
+}
+
+void indri::api::QueryEnvironment::setBinaryProtocol( bool binary ) {
+  _parameters.set( "binaryProtocol", binary );
+}
+
 void indri::api::QueryEnvironment::setSingleBackgroundModel( bool background ) {
   _parameters.set( "singleBackgroundModel", background );
 }
@@ -383,6 +444,21 @@ void indri::api::QueryEnvironment::removeIndex( const std::string& pathname ) {
   }
 }
 
+//
+// connect_server
+//
+
+static indri::net::NetworkStream* connect_server( const std::string& host, unsigned int port ) {
+  indri::net::NetworkStream* stream = new indri::net::NetworkStream;
+
+  if( !stream->connect( host.c_str(), port ) ) {
+    delete stream;
+    throw Exception( "QueryEnvironment", "Failed to connect to server" );
+  }
+
+  return stream;
+}
+
 //
 // addServer
 //
@@ -392,7 +468,6 @@ void indri::api::QueryEnvironment::addServer( const std::string& hostname ) {
   iter = _serverNameMap.find(hostname);
   if (iter == _serverNameMap.end()) { // only add if not present
 
-    indri::net::NetworkStream* stream = new indri::net::NetworkStream;
     unsigned int port = INDRID_PORT;
     std::string host = hostname;
     int colon = (int)hostname.find(':');
@@ -402,15 +477,22 @@ void indri::api::QueryEnvironment::addServer( const std::string& hostname ) {
       port = atoi( hostname.substr( colon+1 ).c_str() );
     }
 
-    if( !stream->connect( host.c_str(), port ) ) {
+    indri::net::NetworkStream* stream = connect_server( host, port );
+    indri::net::NetworkMessageStream* messageStream = new indri::net::NetworkMessageStream( stream );
+    indri::server::NetworkServerProxy* proxy = new indri::server::NetworkServerProxy( messageStream );
+
+    if( _parameters.get( "binaryProtocol", true ) && !proxy->useBinaryProtocol() && !messageStream->alive() ) {
+      // older servers close the connection when asked for the binary protocol
+      delete proxy;
+      delete messageStream;
       delete stream;
-      throw Exception( "QueryEnvironment", "Failed to connect to server" );
+
+      stream = connect_server( host, port );
+      messageStream = new indri::net::NetworkMessageStream( stream );
+      proxy = new indri::server::NetworkServerProxy( messageStream );
     }
 
     _streams.push_back( stream );
-    indri::net::NetworkMessageStream* messageStream = new indri::net::NetworkMessageStream( stream );
-    indri::server::NetworkServerProxy* proxy = new indri::server::NetworkServerProxy( messageStream );
-
     _messageStreams.push_back( messageStream );
     _servers.push_back( proxy );
     _serverNameMap[hostname] = std::make_pair(proxy, stream);
@@ -669,7 +751,7 @@ std::vector<DOCID_T> indri::api::QueryEnvironment::documentIDsFromMetadata( cons
 // _scoredQuery
 //
 
-void indri::api::QueryEnvironment::_scoredQuery( indri::infnet::InferenceNetwork::MAllResults& results, indri::lang::Node* queryRoot, std::string& accumulatorName, int resultsRequested, const std::vector<DOCID_T>* documentSet ) {
+void indri::api::QueryEnvironment::_scoredQuery( indri::infnet::InferenceNetwork::MAllResults& results, indri::lang::Node* queryRoot, std::string& accumulatorName, int resultsRequested, const std::vector<DOCID_T>* documentSet, const QueryBudget& budget ) {
   // add a FilterNode, unique to each server
   // send off each query for evaluation
   std::vector< std::vector<DOCID_T> > docIDLists;
@@ -726,12 +808,22 @@ void indri::api::QueryEnvironment::_scoredQuery( indri::infnet::InferenceNetwork
     root.push_back( accumulatorNode );
 
     // don't optimize these queries, otherwise we won't be able to distinguish some annotations from others
-    indri::server::QueryServerResponse* response = _servers[i]->runQuery( root, resultsRequested, true );
+    indri::server::QueryServerResponse* response = _servers[i]->runQuery( root, resultsRequested, true, budget );
     queryResponses.push_back(response);
   }
 
   // now, gather up all the responses, merge them into some kind of output structure, and return them
   _mergeQueryResults( results, queryResponses );
+  _work = indri::infnet::InferenceNetwork::loadWork( results );
+
+  // keep the best resultsRequested of the servers' lists, best first
+  std::vector<indri::api::ScoredExtentResult>& scores = results[accumulatorName]["scores"];
+  indri::utility::TopResults top( resultsRequested );
+
+  for( size_t i=0; i<scores.size(); i++ )
+    top.push( scores[i] );
+
+  top.sorted( scores );
 }
 
 void indri::api::QueryEnvironment::_annotateQuery( indri::infnet::InferenceNetwork::MAllResults& results,
@@ -867,6 +959,107 @@ double indri::api::QueryEnvironment::documentExpressionCount( const std::string&
   return _expCount(expression, "documentOccurrences", queryType);
 }
 
+//
+// _counterCounts
+//
+// Evaluates a batch of ContextCounterNodes with one statistics
+// query to each server.
+//
+
+std::vector<double> indri::api::QueryEnvironment::_counterCounts( std::vector<indri::lang::Node*>& counters,
+                                                                  const std::string& whichOccurrences ) {
+  std::vector<double> counts;
+
+  if( counters.size() == 0 )
+    return counts;
+
+  indri::infnet::InferenceNetwork::MAllResults statisticsResults;
+  _sumServerQuery( statisticsResults, counters, MAX_INT32 );
+
+  for( size_t i=0; i<counters.size(); i++ ) {
+    std::vector<ScoredExtentResult>& occurrencesList = statisticsResults[ counters[i]->nodeName() ][ whichOccurrences ];
+    counts.push_back( occurrencesList[0].score );
+  }
+
+  return counts;
+}
+
+//
+// expressionCounts
+//
+
+std::vector<double> indri::api::QueryEnvironment::expressionCounts( const std::vector<std::string>& expressions, const std::string& queryType ) {
+  std::vector<QueryParserWrapper*> parsers;
+  std::vector<indri::lang::Node*> counters;
+  indri::utility::VectorDeleter<QueryParserWrapper*> pd(parsers);
+  indri::utility::VectorDeleter<indri::lang::Node*> cd(counters);
+
+  for( size_t i=0; i<expressions.size(); i++ ) {
+    QueryParserWrapper* parser = QueryParserFactory::get(expressions[i], queryType);
+    indri::lang::ScoredExtentNode* rootNode;
+    parsers.push_back( parser );
+
+    try {
+      rootNode = parser->query();
+    } catch( antlr::ANTLRException e ) {
+      LEMUR_THROW( LEMUR_PARSE_ERROR, "Couldn't understand this query: " + e.getMessage() );
+    }
+
+    indri::lang::RawScorerNode* rootScorer = dynamic_cast<indri::lang::RawScorerNode*>(rootNode);
+  
+    if( rootScorer == 0 ) {
+      LEMUR_THROW( LEMUR_PARSE_ERROR, "This query does not appear to be a proximity expression: " + expressions[i] );
+    }
+
+    indri::lang::ContextCounterNode* contextCounter = new indri::lang::ContextCounterNode( rootScorer->getRawExtent(),
+                                                                                           rootScorer->getContext() );
+    contextCounter->setNodeName( rootScorer->nodeName() );
+    counters.push_back( contextCounter );
+  }
+
+  return _counterCounts( counters, "occurrences" );
+}
+
+//
+// stemCounts
+//
+// The query trees are built directly, so there is no parsing and no
+// quoting of the stems.  Single stems are counted from the vocabulary
+// by each server (see ContextSimpleCountCollectorCopier).
+//
+
+std::vector<double> indri::api::QueryEnvironment::stemCounts( const std::vector< std::vector<std::string> >& stems ) {
+  std::vector<indri::lang::Node*> nodes;
+  std::vector<indri::lang::Node*> counters;
+  indri::utility::VectorDeleter<indri::lang::Node*> nd(nodes);
+  indri::utility::VectorDeleter<indri::lang::Node*> cd(counters);
+
+  for( size_t i=0; i<stems.size(); i++ ) {
+    std::vector<indri::lang::RawExtentNode*> terms;
+
+    for( size_t j=0; j<stems[i].size(); j++ ) {
+      indri::lang::IndexTerm* term = new indri::lang::IndexTerm( stems[i][j], true );
+      nodes.push_back( term );
+      terms.push_back( term );
+    }
+
+    if( terms.size() == 0 )
+      LEMUR_THROW( LEMUR_BAD_PARAMETER_ERROR, "stemCounts: a stem sequence is empty" );
+
+    indri::lang::RawExtentNode* raw = terms[0];
+
+    if( terms.size() > 1 ) {
+      indri::lang::ODNode* window = new indri::lang::ODNode( 1, terms );
+      nodes.push_back( window );
+      raw = window;
+    }
+
+    counters.push_back( new indri::lang::ContextCounterNode( raw, 0 ) );
+  }
+
+  return _counterCounts( counters, "occurrences" );
+}
+
 // run a query (Indri query language)
 std::vector<indri::api::ScoredExtentResult> indri::api::QueryEnvironment::_runQuery( indri::infnet::InferenceNetwork::MAllResults& results,
                                                                                      const std::string& q,
@@ -875,6 +1068,7 @@ std::vector<indri::api::ScoredExtentResult> indri::api::QueryEnvironment::_runQu
                                                                                      indri::api::QueryAnnotation** annotation,
                                                                                      const std::string &queryType) {
   INIT_TIMER
+  UINT64 start = indri::utility::IndriTimer::currentTime();
     QueryParserWrapper *parser = QueryParserFactory::get(q, queryType);
 
   PRINT_TIMER( "Initialization complete" );
@@ -981,11 +1175,9 @@ std::vector<indri::api::ScoredExtentResult> indri::api::QueryEnvironment::_runQu
   
   // run a scored query (possibly including a document set)
   std::string accumulatorName;
-  _scoredQuery( results, rootNode, accumulatorName, resultsRequested, documentSet );
-  std::vector<indri::api::ScoredExtentResult> queryResults = results[accumulatorName]["scores"];
-  std::stable_sort( queryResults.begin(), queryResults.end(), indri::api::ScoredExtentResult::score_greater() );
-  if( (int)queryResults.size() > resultsRequested )
-    queryResults.resize( resultsRequested );
+  _scoredQuery( results, rootNode, accumulatorName, resultsRequested, documentSet, qenv_remaining_budget( _budget, start ) );
+  std::vector<indri::api::ScoredExtentResult> queryResults;
+  queryResults.swap( results[accumulatorName]["scores"] );
 
   PRINT_TIMER( "Query complete" );
 
@@ -1028,6 +1220,9 @@ indri::api::QueryResults indri::api::QueryEnvironment::runQuery( indri::api::Que
   const float million = 1000000.0;
   indri::utility::IndriTimer timer; 
   timer.start();
+  UINT64 start = indri::utility::IndriTimer::currentTime();
+  QueryBudget budget = request.budget;
+  budget.restrict( _budget );
 
   // need the other options, formulators in here
   QueryParserWrapper *parser = QueryParserFactory::get(request.query, queryType);
@@ -1043,6 +1238,7 @@ indri::api::QueryResults indri::api::QueryEnvironment::runQuery( indri::api::Que
   
   timer.stop(); 
   queryResult.parseTime = timer.elapsedTime()/million; 
+  timer.reset();
   timer.start();
 
   // push down language models from ExtentRestriction nodes
@@ -1077,6 +1273,11 @@ indri::api::QueryResults indri::api::QueryEnvironment::runQuery( indri::api::Que
   // feed the statistics we found back into the query network
   _copyStatistics( scorerNodes, statisticsResults );
 
+  timer.stop(); 
+  queryResult.statisticsTime = timer.elapsedTime()/million; 
+  timer.reset();
+  timer.start();
+
   // annotate the graph with smoothing parameters
   indri::lang::SmoothingAnnotatorWalker smoother( _parameters );
   rootNode->walk(smoother);
@@ -1086,9 +1287,10 @@ indri::api::QueryResults indri::api::QueryEnvironment::runQuery( indri::api::Que
   if (request.docSet.size() > 0) documentSet = &request.docSet;
   
   std::string accumulatorName;
-  _scoredQuery( results, rootNode, accumulatorName, request.resultsRequested + request.startNum, documentSet );
-  std::vector<indri::api::ScoredExtentResult> queryResults = results[accumulatorName]["scores"];
-  std::stable_sort( queryResults.begin(), queryResults.end(), indri::api::ScoredExtentResult::score_greater() );
+  _scoredQuery( results, rootNode, accumulatorName, request.resultsRequested + request.startNum, documentSet, qenv_remaining_budget( budget, start ) );
+  queryResult.work = _work;
+  std::vector<indri::api::ScoredExtentResult> queryResults;
+  queryResults.swap( results[accumulatorName]["scores"] );
   // prune the list
   if (request.startNum > 0) {
     queryResults.erase(queryResults.begin(), queryResults.begin() + request.startNum);
@@ -1097,20 +1299,37 @@ indri::api::QueryResults indri::api::QueryEnvironment::runQuery( indri::api::Que
   if( (int)queryResults.size() > request.resultsRequested )
     queryResults.resize( request.resultsRequested );
 
-  std::string annotatorName;
-  std::vector<DOCID_T> docSet;
+  timer.stop(); 
+  queryResult.scoreTime = timer.elapsedTime()/million; 
+  timer.reset();
+  timer.start();
 
-  for( size_t i=0; i<queryResults.size(); i++ ) {
-    docSet.push_back( queryResults[i].document );
-  }
+  // matches are only needed to build snippets, and finding them means
+  // evaluating the query again over the top documents; any option but
+  // NoSnippet, including an unset 0, gets snippets as it always has
+  bool snippets = request.options != QueryRequest::NoSnippet;
+
+  if( snippets ) {
+    std::string annotatorName;
+    std::vector<DOCID_T> docSet;
 
-  _annotateQuery( results, docSet, annotatorName, rootNode );
-  annotation = new indri::api::QueryAnnotation( rootNode, results[annotatorName], queryResults );
+    for( size_t i=0; i<queryResults.size(); i++ ) {
+      docSet.push_back( queryResults[i].document );
+    }
+
+    _annotateQuery( results, docSet, annotatorName, rootNode );
+    annotation = new indri::api::QueryAnnotation( rootNode, results[annotatorName], queryResults );
+  } else {
+    indri::infnet::EvaluatorNode::MResults noMatches;
+    annotation = new indri::api::QueryAnnotation( rootNode, noMatches, queryResults );
+  }
   
   delete(parser);
 
   timer.stop(); 
-  queryResult.executeTime = timer.elapsedTime()/million; 
+  queryResult.annotateTime = timer.elapsedTime()/million; 
+  queryResult.executeTime = queryResult.statisticsTime + queryResult.scoreTime + queryResult.annotateTime;
+  timer.reset();
   timer.start();
 
   // fill in the results bits
@@ -1146,7 +1365,8 @@ indri::api::QueryResults indri::api::QueryEnvironment::runQuery( indri::api::Que
       res.docid = resultSubset[i].document;
       res.begin = resultSubset[i].begin;
       res.end = resultSubset[i].end;
-      res.snippet = builder.build( resultSubset[i].document, docs[i], annotation );
+      if( snippets )
+        res.snippet = builder.build( resultSubset[i].document, docs[i], annotation );
 
       for (size_t j = 0; j < request.metadata.size(); j++ ) {
         std::string &key = request.metadata[j];
@@ -1178,6 +1398,7 @@ indri::api::QueryResults indri::api::QueryEnvironment::runQuery( indri::api::Que
     if (count > estCount) estCount = count;
   }
   queryResult.estimatedMatches = estCount;
+  delete annotation;
 
   timer.stop(); 
   queryResult.documentsTime = timer.elapsedTime()/million; 
@@ -1387,6 +1608,84 @@ std::vector<indri::api::DocumentVector*> indri::api::QueryEnvironment::documentV
   return results;
 }
 
+std::vector<indri::api::DocumentVector*> indri::api::QueryEnvironment::documentVectors( const std::vector<DOCID_T>& documentIDs, std::vector<std::string>& stems ) {
+  std::vector< std::vector<DOCID_T> > docIDLists;
+  docIDLists.resize( _servers.size() );
+  std::vector< std::vector<DOCID_T> > docIDPositions;
+  docIDPositions.resize( _servers.size() );
+  std::vector< indri::api::DocumentVector* > results;
+  results.resize( documentIDs.size() );
+
+  // split document numbers into lists for each query server
+  qenv_scatter_document_ids( documentIDs, docIDLists, docIDPositions, (int)_servers.size() );
+
+  indri::utility::greedy_vector<indri::server::QueryServerVectorsResponse*> responses;
+
+  // send out requests for processing
+  for( size_t i=0; i<docIDLists.size(); i++ ) {
+    indri::server::QueryServerVectorsResponse* response = 0;
+
+    if( docIDLists[i].size() )
+      response = _servers[i]->documentVectors( docIDLists[i], true );
+    
+    responses.push_back(response);
+  }
+
+  indri::utility::HashTable<std::string, int> stemIDs( 1<<18 );
+  std::vector<int> serverIDs;
+  stems.clear();
+  stems.push_back( "[OOV]" );
+
+  // each server has its own stem ids, so translate them into ids in stems
+  for( size_t i=0; i<responses.size(); i++ ) {
+    if( !responses[i] )
+      continue;
+
+    std::vector<indri::api::DocumentVector*>& vectors = responses[i]->getResults();
+    std::vector<std::string>& serverStems = responses[i]->getStems();
+
+    if( serverStems.size() ) {
+      qenv_merge_stems( serverStems, stems, stemIDs, serverIDs );
+
+      for( size_t j=0; j<vectors.size(); j++ )
+        qenv_translate_positions( vectors[j]->positions(), serverIDs );
+    } else {
+      // a server older than sharedStems sends each vector with its own stems
+      for( size_t j=0; j<vectors.size(); j++ ) {
+        qenv_merge_stems( vectors[j]->stems(), stems, stemIDs, serverIDs );
+        qenv_translate_positions( vectors[j]->positions(), serverIDs );
+        vectors[j]->stems().clear();
+      }
+    }
+  }
+
+  // fold the results back into one master list (this method will delete the responses)
+  qenv_gather_document_results( docIDLists, docIDPositions, responses, results );
+
+  return results;
+}
+
+//
+// collectionCacheStatistics
+//
+
+indri::collection::CompressedCollection::CacheStatistics indri::api::QueryEnvironment::collectionCacheStatistics() {
+  indri::collection::CompressedCollection::CacheStatistics total;
+  memset( &total, 0, sizeof total );
+
+  for( size_t i=0; i<_repositories.size(); i++ ) {
+    indri::collection::CompressedCollection::CacheStatistics statistics = _repositories[i]->collection()->cacheStatistics();
+
+    total.hits += statistics.hits;
+    total.misses += statistics.misses;
+    total.documents += statistics.documents;
+    total.memory += statistics.memory;
+    total.maximumMemory += statistics.maximumMemory;
+  }
+
+  return total;
+}
+
 int indri::api::QueryEnvironment::documentLength(lemur::api::DOCID_T documentID) {
   int length = 0;
   int serverCount = (int)_servers.size();
@@ -1407,6 +1706,22 @@ void indri::api::QueryEnvironment::setMaxWildcardTerms(int maxTerms) {
 
 }
 
+//
+// setQueryBudget
+//
+
+void indri::api::QueryEnvironment::setQueryBudget( const QueryBudget& budget ) {
+  _budget = budget;
+}
+
+//
+// lastQueryWork
+//
+
+indri::api::QueryWork indri::api::QueryEnvironment::lastQueryWork() const {
+  return _work;
+}
+
 void indri::api::QueryEnvironment::setFormulationParameters(Parameters &p) {
   reformulatorParams = p;
   reformulator->setParameters(p);
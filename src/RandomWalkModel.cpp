@@ -105,7 +105,7 @@ void indri::query::RandomWalkModel::_countGrams() {
     indri::api::ScoredExtentResult& result = _results[i];
     indri::api::DocumentVector* v = _vectors[i];
     std::vector<int>& positions = v->positions();
-    std::vector<std::string>& stems = v->stems();
+    std::vector<std::string>& stems = _stems;
     if (result.end == 0) result.end = positions.size();
 
     // for each word position in the text
@@ -267,9 +267,23 @@ void indri::query::RandomWalkModel::_scoreGrams() {
   HGram::iterator iter;
   double collectionCount = (double)_environment.termCount();
   indri::query::TermScoreFunction* function = 0;
+  std::vector<double> collectionGramCounts;
+  size_t g;
+
+  if( _smoothing.length() != 0 ) {
+    // it's only important to get background frequencies if
+    // we're smoothing with them; otherwise we don't care.
+    // the grams are all counted together, in one query
+    std::vector< std::vector<std::string> > stems;
+
+    for( iter = _gramTable.begin(); iter != _gramTable.end(); iter++ )
+      stems.push_back( (*iter->first)->terms );
+
+    collectionGramCounts = _environment.stemCounts( stems );
+  }
 
   // for each gram we've seen
-  for( iter = _gramTable.begin(); iter != _gramTable.end(); iter++ ) {
+  for( iter = _gramTable.begin(), g = 0; iter != _gramTable.end(); iter++, g++ ) {
     // gather the number of times this gram occurs in the collection
     double gramCount = 0;
 
@@ -277,25 +291,7 @@ void indri::query::RandomWalkModel::_scoreGrams() {
     GramCounts* gramCounts = *iter->second;
 
     if( _smoothing.length() != 0 ) {
-      // it's only important to get background frequencies if
-      // we're smoothing with them; otherwise we don't care.
-
-      if( gram->terms.size() == 1 ) {
-        gramCount = (double)_environment.stemCount( gram->terms[0] );
-      } else {
-        // notice that we're running a query here;
-        // this is likely to be slow. (be warned)
-
-        std::stringstream s;
-        s << "#1( ";
-
-        for( size_t i=0; i< gram->terms.size(); i++ ) {
-          s << " \"" << gram->terms[i] << "\"" << std::endl;
-        }
-
-        s << ") ";
-        gramCount = _environment.expressionCount( s.str() );
-      }
+      gramCount = collectionGramCounts[g];
 
       double gramFrequency = gramCount / collectionCount;
       //      function = indri::query::TermScoreFunctionFactory::get( _smoothing, gramFrequency );
@@ -392,7 +388,7 @@ void indri::query::RandomWalkModel::generate( const std::string& query ) {
     _logtoposterior(_results);
     _grams.clear();
     _extractDocuments();
-    _vectors = _environment.documentVectors( _documentIDs );
+    _vectors = _environment.documentVectors( _documentIDs, _stems );
 
     _countGrams();
     fprintf(stderr, "here Amit \n");
@@ -509,7 +505,7 @@ void indri::query::RandomWalkModel::generate( const std::string& query, const st
     _logtoposterior(_results);
     _grams.clear();
     _extractDocuments();
-    _vectors = _environment.documentVectors( _documentIDs );
+    _vectors = _environment.documentVectors( _documentIDs, _stems );
     _queryGrams = find_query_grams(query);
     fprintf(stderr, "here Amit2 \n");
     _countGrams();
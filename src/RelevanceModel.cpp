@@ -99,62 +99,84 @@ bool isValidWord(const string & word)
 }
 
 void indri::query::RelevanceModel::_countGrams() {
+  // the vectors share one list of stems, so whether a stem can be
+  // part of a gram is decided once, and grams are found by stem id
+  std::vector<char> valid( _stems.size() );
+  for( size_t i=1; i<_stems.size(); i++ )
+    valid[i] = isValidWord( _stems[i] );
+
+  indri::utility::HashTable< UINT64, size_t, gram_key_hash > gramNumbers( 1<<20 );
+  std::vector<GramCounts*> grams;
+
   // for each query result
   for( size_t i=0; i<_results.size(); i++ ) {
     // run through the text, extracting n-grams
     indri::api::ScoredExtentResult& result = _results[i];
     indri::api::DocumentVector* v = _vectors[i];
     std::vector<int>& positions = v->positions();
-    std::vector<std::string>& stems = v->stems();
     if (result.end == 0) result.end = positions.size();
     
     // for each word position in the text
     for( int j = result.begin; j < result.end; j++ ) {
       int maxGram = std::min( _maxGrams, result.end - j );
+      size_t prefix = 0;
 
       // extract every possible n-gram that starts at this position
       // up to _maxGrams in length
       for( int n = 1; n <= maxGram; n++ ) {
-        GramCounts* newCounts = new GramCounts;
-        bool containsOOV = false;
-
-        // build the gram
-        for( int k = 0; k < n; k++ ) {
-          if( positions[ k + j ] == 0 || (! isValidWord(stems[ positions[ k + j ] ])) ) {
-            containsOOV = true;
-            break;
-          }
+        int stem = positions[ j + n - 1 ];
 
-          newCounts->gram.terms.push_back( stems[ positions[ k + j ] ] );
-        }
-
-        if( containsOOV ) {
-          // if this contanied OOV, all larger n-grams
+        if( !valid[stem] ) {
+          // if this contains OOV, all larger n-grams
           // starting at this point also will
-          delete newCounts;
           break;
         }
 
-        GramCounts** gramCounts = 0;        
-        gramCounts = _gramTable.find( &newCounts->gram );
+        UINT64 key = (UINT64(prefix) << 32) | UINT32(stem);
+        size_t* number = gramNumbers.find( key );
+        GramCounts* gramCounts;
 
-        if( gramCounts == 0 ) {
-          _gramTable.insert( &newCounts->gram, newCounts );
-          gramCounts = &newCounts;
+        if( number ) {
+          gramCounts = grams[ *number - 1 ];
+          prefix = *number;
         } else {
-          delete newCounts;
+          gramCounts = new GramCounts;
+
+          if( prefix )
+            gramCounts->gram.terms = grams[ prefix - 1 ]->gram.terms;
+          gramCounts->gram.terms.push_back( _stems[stem] );
+
+          grams.push_back( gramCounts );
+          prefix = grams.size();
+          gramNumbers.insert( key, prefix );
         }
 
-        if( (*gramCounts)->counts.size() && (*gramCounts)->counts.back().first == i ) {
+        if( gramCounts->counts.size() && gramCounts->counts.back().first == i ) {
           // we already have some counts going for this query result, so just add this one
-          (*gramCounts)->counts.back().second++;
+          gramCounts->counts.back().second++;
         } else {
           // no counts yet in this document, so add an entry
-          (*gramCounts)->counts.push_back( std::make_pair( i, 1 ) );
+          gramCounts->counts.push_back( std::make_pair( i, 1 ) );
         }
       }
     }
   }
+
+  // in the order they were found, so ties are broken as before
+  bool empty = _gramTable.size() == 0;
+
+  for( size_t i=0; i<grams.size(); i++ ) {
+    GramCounts** existing = empty ? 0 : _gramTable.find( &grams[i]->gram );
+
+    if( existing ) {
+      // counted by an earlier generate
+      for( size_t j=0; j<grams[i]->counts.size(); j++ )
+        (*existing)->counts.push_back( grams[i]->counts[j] );
+      delete grams[i];
+    } else {
+      _gramTable.insert( &grams[i]->gram, grams[i] );
+    }
+  }
 }
 
 //
@@ -164,10 +186,24 @@ void indri::query::RelevanceModel::_countGrams() {
 void indri::query::RelevanceModel::_scoreGrams() {
   HGram::iterator iter;
   double collectionCount = (double)_environment.termCount();
-  indri::query::TermScoreFunction* function = 0;  
+  indri::query::TermScoreFunction* function = 0;
+  std::vector<double> collectionGramCounts;
+  size_t g;
+
+  if( _smoothing.length() != 0 ) {
+    // it's only important to get background frequencies if
+    // we're smoothing with them; otherwise we don't care.
+    // the grams are all counted together, in one query
+    std::vector< std::vector<std::string> > stems;
+
+    for( iter = _gramTable.begin(); iter != _gramTable.end(); iter++ )
+      stems.push_back( (*iter->first)->terms );
+
+    collectionGramCounts = _environment.stemCounts( stems );
+  }
 
   // for each gram we've seen
-  for( iter = _gramTable.begin(); iter != _gramTable.end(); iter++ ) {
+  for( iter = _gramTable.begin(), g = 0; iter != _gramTable.end(); iter++, g++ ) {
     // gather the number of times this gram occurs in the collection
     double gramCount = 0;
 
@@ -175,25 +211,7 @@ void indri::query::RelevanceModel::_scoreGrams() {
     GramCounts* gramCounts = *iter->second;
 
     if( _smoothing.length() != 0 ) {
-      // it's only important to get background frequencies if
-      // we're smoothing with them; otherwise we don't care.
-
-      if( gram->terms.size() == 1 ) {
-        gramCount = (double)_environment.stemCount( gram->terms[0] );
-      } else {
-        // notice that we're running a query here;
-        // this is likely to be slow. (be warned)
-
-        std::stringstream s;
-        s << "#1( ";
-
-        for( size_t i=0; i< gram->terms.size(); i++ ) {
-          s << " \"" << gram->terms[i] << "\"" << std::endl;
-        }
-
-        s << ") ";
-        gramCount = _environment.expressionCount( s.str() );
-      }
+      gramCount = collectionGramCounts[g];
 
       double gramFrequency = gramCount / collectionCount;
       //      function = indri::query::TermScoreFunctionFactory::get( _smoothing, gramFrequency );
@@ -290,7 +308,7 @@ void indri::query::RelevanceModel::generate( const std::string& query ) {
     _logtoposterior(_results);
     _grams.clear();
     _extractDocuments();
-    _vectors = _environment.documentVectors( _documentIDs );
+    _vectors = _environment.documentVectors( _documentIDs, _stems );
 
     _countGrams();
     _scoreGrams();
@@ -312,7 +330,7 @@ void indri::query::RelevanceModel::generate( const std::string& query, const std
     _logtoposterior(_results);
     _grams.clear();
     _extractDocuments();
-    _vectors = _environment.documentVectors( _documentIDs );
+    _vectors = _environment.documentVectors( _documentIDs, _stems );
 
     _countGrams();
     _scoreGrams();
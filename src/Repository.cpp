@@ -42,8 +42,10 @@
 #include <math.h>
 #include <string>
 #include <algorithm>
+#include <sstream>
 
 const static int defaultMemory = 100*1024*1024;
+const static int defaultBlockDocuments = 8192;
 
 //
 // _openPriors
@@ -135,47 +137,108 @@ void indri::collection::Repository::_buildFields() {
 //
 
 void indri::collection::Repository::_buildChain( indri::api::Parameters& parameters, indri::api::Parameters* options ) {
+  // the transient chain stopwords are kept so that
+  // createTransformations can build the same chain later
+  _transientStopwords.clear();
+
+  if( options && options->exists("stopper.word") ) {
+    indri::api::Parameters stop = (*options)["stopper.word"];
+
+    for( size_t i=0; i<stop.size(); i++ )
+      _transientStopwords.push_back( stop[i] );
+  }
+
+  _createChain( _transformations, parameters );
+  _buildPhrases();
+}
+
+//
+// _buildPhrases
+//
+// Phrase lists are stored under index terms, so the phrases
+// parameter goes through the transformation chain once here.
+// Phrases that lose a word to the stopper are dropped.
+//
+
+void indri::collection::Repository::_buildPhrases() {
+  _phrases.clear();
+
+  if( !_parameters.exists( "phrases.phrase" ) )
+    return;
+
+  indri::api::Parameters phrases = _parameters["phrases.phrase"];
+
+  for( size_t i=0; i<phrases.size(); i++ ) {
+    std::string phrase = phrases[i];
+    std::istringstream words( phrase );
+    std::string first, second, extra;
+
+    words >> first >> second;
+
+    if( second.empty() || (words >> extra) )
+      LEMUR_THROW( LEMUR_BAD_PARAMETER_ERROR, "A phrase must be two words separated by a space: " + phrase );
+
+    first = processTerm( first );
+    second = processTerm( second );
+
+    if( first.length() && second.length() )
+      _phrases.push_back( first + " " + second );
+  }
+}
+
+//
+// _createChain
+//
+
+void indri::collection::Repository::_createChain( std::vector<indri::parse::Transformation*>& chain, indri::api::Parameters& parameters ) {
   // Extract url from metadata before case normalizing.
   // this could be parameterized.
 
   if (parameters.get("injectURL", true))
-    _transformations.push_back(new indri::parse::URLTextAnnotator());
+    chain.push_back(new indri::parse::URLTextAnnotator());
 
   bool dontNormalize = parameters.exists( "normalize" ) && ( false == (bool) parameters["normalize"] );
 
   if( dontNormalize == false ) {
-    _transformations.push_back( new indri::parse::NormalizationTransformation() );
-    _transformations.push_back( new indri::parse::UTF8CaseNormalizationTransformation() );
+    chain.push_back( new indri::parse::NormalizationTransformation() );
+    chain.push_back( new indri::parse::UTF8CaseNormalizationTransformation() );
   }
 
   for( size_t i=0; i<_fields.size(); i++ ) {
     if( _fields[i].parserName == "NumericFieldAnnotator" ) {
-      _transformations.push_back( new indri::parse::NumericFieldAnnotator( _fields[i].name ) );
+      chain.push_back( new indri::parse::NumericFieldAnnotator( _fields[i].name ) );
     }
     else if( _fields[i].parserName == "DateFieldAnnotator" ) {
-      _transformations.push_back( new indri::parse::DateFieldAnnotator( _fields[i].name ) );
+      chain.push_back( new indri::parse::DateFieldAnnotator( _fields[i].name ) );
     }
   }
 
   if( _parameters.exists("stopper.word") ) {
     indri::api::Parameters stop = _parameters["stopper.word"];
-    _transformations.push_back( new indri::parse::StopperTransformation( stop ) );
+    chain.push_back( new indri::parse::StopperTransformation( stop ) );
   }
   // the transient chain stopwords need to precede the stemmer.
-  if (options) {
-    if( options->exists("stopper.word") ) {
-      indri::api::Parameters stop = (*options)["stopper.word"];
-      _transformations.push_back( new indri::parse::StopperTransformation( stop ) );
-    }
+  if( _transientStopwords.size() ) {
+    chain.push_back( new indri::parse::StopperTransformation( _transientStopwords ) );
   }
 
   if( _parameters.exists("stemmer.name") ) {
     std::string stemmerName = std::string(_parameters["stemmer.name"]);
     indri::api::Parameters stemmerParams = _parameters["stemmer"];
-    _transformations.push_back( indri::parse::StemmerFactory::get( stemmerName, stemmerParams ) );
+    chain.push_back( indri::parse::StemmerFactory::get( stemmerName, stemmerParams ) );
   }
 }
 
+//
+// createTransformations
+//
+
+std::vector<indri::parse::Transformation*> indri::collection::Repository::createTransformations() {
+  std::vector<indri::parse::Transformation*> chain;
+  _createChain( chain, _parameters );
+  return chain;
+}
+
 //
 // _copyParameters
 //
@@ -187,6 +250,12 @@ void indri::collection::Repository::_copyParameters( indri::api::Parameters& opt
   if( options.exists( "injectURL" ) ) {
     _parameters.set( "injectURL", (std::string) options["injectURL"] );
   }
+  if( options.exists( "invertedListCodec" ) ) {
+    _parameters.set( "invertedListCodec", (std::string) options["invertedListCodec"] );
+  }
+  if( options.exists( "impactLists" ) ) {
+    _parameters.set( "impactLists", (bool) options["impactLists"] );
+  }
 
   if( options.exists("field") ) {
     _parameters.set( "field", "" );
@@ -203,6 +272,11 @@ void indri::collection::Repository::_copyParameters( indri::api::Parameters& opt
     _parameters["stemmer"] = options["stemmer"];
   }
 
+  if( options.exists("phrases") ) {
+    _parameters.set( "phrases", "" );
+    _parameters["phrases"] = options["phrases"];
+  }
+
 }
 
 //
@@ -236,7 +310,7 @@ void indri::collection::Repository::_openIndexes( indri::api::Parameters& params
         indri::index::DiskIndex* diskIndex = new indri::index::DiskIndex();
         std::string indexName = (std::string) indexSpec;
 
-        diskIndex->open( parentPath, indexName );
+        diskIndex->open( parentPath, indexName, _mappedIndexes );
         _active->push_back( diskIndex );
       }
     }
@@ -263,6 +337,15 @@ void indri::collection::Repository::countQuery() {
 
 void indri::collection::Repository::_countDocumentAdd() {
   indri::atomic::increment( _documentLoad[0] );
+  indri::atomic::increment( _documentAdds );
+}
+
+//
+// documentAdds
+//
+
+indri::atomic::value_type indri::collection::Repository::documentAdds() {
+  return _documentAdds;
 }
 
 //
@@ -336,6 +419,8 @@ void indri::collection::Repository::create( const std::string& path, indri::api:
     if( options )
       _memory = options->get( "memory", _memory );
 
+    _blockDocuments = indri::api::Parameters::instance().get( "shardBlockDocuments", defaultBlockDocuments );
+
     float queryProportion = 0.15f;
     if( options )
       queryProportion = static_cast<float>(options->get( "queryProportion", queryProportion ));
@@ -411,6 +496,9 @@ void indri::collection::Repository::openRead( const std::string& path, indri::ap
     if( options )
       queryProportion = static_cast<float>(options->get( "queryProportion", queryProportion ));
 
+    if( options )
+      _mappedIndexes = options->get( "mappedIndexes", false );
+
     _parameters.loadFile( indri::file::Path::combine( path, "manifest" ) );
 
     _buildFields();
@@ -451,10 +539,15 @@ void indri::collection::Repository::open( const std::string& path, indri::api::P
     if( options )
       _memory = options->get( "memory", _memory );
 
+    _blockDocuments = indri::api::Parameters::instance().get( "shardBlockDocuments", defaultBlockDocuments );
+
     float queryProportion = 0.75;
     if( options )
       queryProportion = static_cast<float>(options->get( "queryProportion", queryProportion ));
 
+    if( options )
+      _mappedIndexes = options->get( "mappedIndexes", false );
+
     std::string indexPath = indri::file::Path::combine( path, "index" );
     std::string collectionPath = indri::file::Path::combine( path, "collection" );
     std::string indexName = indri::file::Path::combine( indexPath, "index" );
@@ -525,12 +618,49 @@ int indri::collection::Repository::addDocument( indri::api::ParsedDocument* docu
     indri::thread::Thread::sleep( 100 );
   }
 
+  // documents added to shards since the last MemoryIndex was made
+  // are in blocks at the end of the state; start a new index after them
+  if( _blockEnd )
+    _addMemoryIndex( true );
+
   indri::thread::ScopedLock lock( _addLock );
 
   for( size_t i=0; i<_transformations.size(); i++ ) {
     document = _transformations[i]->transform( document );
   }
 
+  return _addTransformedDocument( document, inCollection );
+}
+
+//
+// addTransformedDocument
+//
+
+int indri::collection::Repository::addTransformedDocument( indri::api::ParsedDocument* document, bool inCollection, int shard ) {
+  if( _readOnly )
+    LEMUR_THROW( LEMUR_RUNTIME_ERROR, "addDocument: Cannot add documents to a repository that is opened for read-only access." ); 
+
+  while( _thrashing ) {
+    indri::thread::Thread::sleep( 100 );
+  }
+
+  if( shard >= 0 )
+    return _addShardDocument( document, inCollection, shard );
+
+  if( _blockEnd )
+    _addMemoryIndex( true );
+
+  indri::thread::ScopedLock lock( _addLock );
+  return _addTransformedDocument( document, inCollection );
+}
+
+//
+// _addTransformedDocument
+//
+// Requires _addLock to be held.
+//
+
+int indri::collection::Repository::_addTransformedDocument( indri::api::ParsedDocument* document, bool inCollection ) {
   index_state state;
 
   { 
@@ -547,44 +677,164 @@ int indri::collection::Repository::addDocument( indri::api::ParsedDocument* docu
 }
 
 //
-// deleteDocument
+// _addShardDocument
+//
+// Adds a document to the MemoryIndex of one shard.  Only the shard's
+// own lock is held while the document is indexed.
 //
 
-void indri::collection::Repository::deleteDocument( int documentID ) {
-  _deletedList.markDeleted( documentID );
+int indri::collection::Repository::_addShardDocument( indri::api::ParsedDocument* document, bool inCollection, int shard ) {
+  memory_shard* memoryShard = _memoryShard( shard );
+  lemur::api::DOCID_T documentID;
+
+  {
+    indri::thread::ScopedLock lock( memoryShard->lock );
+
+    if( !memoryShard->index )
+      _openBlock( memoryShard );
+
+    documentID = memoryShard->index->addDocument( *document );
+
+    // a full block is left in the state for the maintenance thread to write
+    if( documentID + 1 >= memoryShard->end )
+      memoryShard->index = 0;
+  }
+
+  if (inCollection) _collection->addDocument( documentID, document );
+
+  _countDocumentAdd();
+  return documentID;
 }
 
 //
-// _addMemoryIndex
+// _memoryShard
 //
-// Add a new MemoryIndex to accept all new updates.  This allows
-// the current MemoryIndex to be written to disk.
+
+indri::collection::Repository::memory_shard* indri::collection::Repository::_memoryShard( int shard ) {
+  indri::thread::ScopedLock lock( _shardLock );
+
+  while( (int)_memoryShards.size() <= shard ) {
+    memory_shard* memoryShard = new memory_shard;
+    memoryShard->index = 0;
+    memoryShard->end = 0;
+    _memoryShards.push_back( memoryShard );
+  }
+
+  return _memoryShards[shard];
+}
+
+//
+// _openBlock
+//
+// Reserves the next block of document IDs for a shard, and gives
+// the shard a MemoryIndex that starts at the block.  Requires the
+// shard lock to be held.
 //
 
-void indri::collection::Repository::_addMemoryIndex() {
+void indri::collection::Repository::_openBlock( memory_shard* shard ) {
   indri::thread::ScopedLock alock( _addLock );
   indri::thread::ScopedLock slock( _stateLock );
 
-  // build a new memory index
-  int documentBase = 1;
+  indri::index::MemoryIndex* active = dynamic_cast<indri::index::MemoryIndex*>( _active->back() );
 
-  if( _active->size() > 0 ) {
-    indri::index::Index* activeIndex = _active->back();
-    documentBase = activeIndex->documentMaximum();
+  // the first block can use the empty MemoryIndex at the end of the state
+  if( !_blockEnd && active && active->documentMaximum() == active->documentBase() ) {
+    shard->index = active;
+    shard->end = _blockEnd = active->documentBase() + _blockDocuments;
+    return;
   }
 
-  indri::index::MemoryIndex* newMemoryIndex = new indri::index::MemoryIndex( documentBase, _indexFields );
+  lemur::api::DOCID_T documentBase = _blockEnd ? _blockEnd : _active->back()->documentMaximum();
+  shard->index = new indri::index::MemoryIndex( documentBase, _indexFields );
+  shard->end = _blockEnd = documentBase + _blockDocuments;
 
-  // build a new state vector
   index_state newState = new index_vector;
   newState->assign( _active->begin(), _active->end() );
-  newState->push_back( newMemoryIndex );
+  newState->push_back( shard->index );
 
-  // add the new state vector to the active states
   _states.push_back( newState );
   _active = newState;
 }
 
+//
+// _closeShards
+//
+
+void indri::collection::Repository::_closeShards() {
+  indri::utility::delete_vector_contents( _memoryShards );
+  _blockEnd = 0;
+}
+
+//
+// deleteDocument
+//
+
+void indri::collection::Repository::deleteDocument( int documentID ) {
+  _deletedList.markDeleted( documentID );
+  _collection->evict( documentID );
+}
+
+//
+// _addMemoryIndex
+//
+// Add a new MemoryIndex to accept all new updates.  This allows
+// the current MemoryIndex, and any shard MemoryIndexes, to be
+// written to disk.  The shard indexes are sealed at the end of
+// their blocks.  If afterBlocks is true, the index is only added
+// when shards have reserved document IDs since the last one.
+// Returns the state from before the new index was added.
+//
+
+indri::collection::Repository::index_state indri::collection::Repository::_addMemoryIndex( bool afterBlocks ) {
+  indri::thread::ScopedLock shardLock( _shardLock );
+  index_state previous;
+
+  for( size_t i=0; i<_memoryShards.size(); i++ )
+    _memoryShards[i]->lock.lock();
+
+  {
+    indri::thread::ScopedLock alock( _addLock );
+    indri::thread::ScopedLock slock( _stateLock );
+    previous = _active;
+
+    if( !afterBlocks || _blockEnd ) {
+      for( size_t i=0; i<_memoryShards.size(); i++ ) {
+        memory_shard* shard = _memoryShards[i];
+
+        if( shard->index ) {
+          shard->index->seal( shard->end );
+          shard->index = 0;
+        }
+      }
+
+      // build a new memory index
+      int documentBase = 1;
+
+      if( _active->size() > 0 ) {
+        indri::index::Index* activeIndex = _active->back();
+        documentBase = activeIndex->documentMaximum();
+      }
+
+      indri::index::MemoryIndex* newMemoryIndex = new indri::index::MemoryIndex( documentBase, _indexFields );
+
+      // build a new state vector
+      index_state newState = new index_vector;
+      newState->assign( _active->begin(), _active->end() );
+      newState->push_back( newMemoryIndex );
+
+      // add the new state vector to the active states
+      _states.push_back( newState );
+      _active = newState;
+      _blockEnd = 0;
+    }
+  }
+
+  for( size_t i=0; i<_memoryShards.size(); i++ )
+    _memoryShards[i]->lock.unlock();
+
+  return previous;
+}
+
 //
 // _swapState
 //
@@ -724,24 +974,42 @@ void indri::collection::Repository::_write() {
 
   // grab a copy of the current state
   index_state state = indexes();
+  bool hasDocuments = false;
+
+  for( size_t i=0; i<state->size(); i++ ) {
+    indri::index::MemoryIndex* memoryIndex = dynamic_cast<indri::index::MemoryIndex*>( (*state)[i] );
+    hasDocuments = hasDocuments || ( memoryIndex && memoryIndex->documentMaximum() > memoryIndex->documentBase() );
+  }
   
-  // if the current index is empty, don't need to write it
-  if( state->size() && state->back()->documentCount() == 0 )
+  // if the current indexes are empty, don't need to write them
+  if( state->size() && !hasDocuments )
     return;
 
-  // make a new MemoryIndex, cutting off the old one from updates
-  _addMemoryIndex();
+  // make a new MemoryIndex, cutting off the old ones from updates
+  state = _addMemoryIndex();
 
   // if we just added the first, no need to write the "old" one
   if( state->size() == 0 )
     return;
 
-  // write out the last index
-  index_state lastState = new std::vector<indri::index::Index*>;
-  lastState->push_back( state->back() );
+  // the old active index, and every shard block, is written on its own
+  std::vector<indri::index::Index*> memoryIndexes;
+
+  for( size_t i=0; i<state->size(); i++ ) {
+    indri::index::MemoryIndex* memoryIndex = dynamic_cast<indri::index::MemoryIndex*>( (*state)[i] );
+
+    if( memoryIndex && memoryIndex->documentMaximum() > memoryIndex->documentBase() )
+      memoryIndexes.push_back( memoryIndex );
+  }
   state = 0;
 
-  _merge( lastState );
+  for( size_t i=0; i<memoryIndexes.size(); i++ ) {
+    index_state lastState = new std::vector<indri::index::Index*>;
+    lastState->push_back( memoryIndexes[i] );
+
+    _merge( lastState );
+  }
+
   _checkpoint();
 }
 
@@ -895,12 +1163,15 @@ indri::index::Index* indri::collection::Repository::_mergeStage( index_state& st
   std::string indexPath = indri::file::Path::combine( _path, "index" );
   std::string newIndexPath = indri::file::Path::combine( indexPath, indexNumber.str() );
   indri::index::IndexWriter writer;
+  writer.setListCodec( _parameters.get( "invertedListCodec", "block" ) );
+  writer.setImpactLists( _parameters.get( "impactLists", true ) );
+  writer.setPhrases( _parameters.get( "phrases.minimumCount", 0 ), _phrases );
   
   writer.write( indexes, _indexFields, _deletedList, newIndexPath );
 
   // open the index we just wrote
   indri::index::DiskIndex* diskIndex = new indri::index::DiskIndex();
-  diskIndex->open( indexPath, indexNumber.str() );
+  diskIndex->open( indexPath, indexNumber.str(), _mappedIndexes );
 
   // make a new state, replacing the old index for the new one
   _swapState( indexes, diskIndex );
@@ -1014,8 +1285,14 @@ void indri::collection::Repository::_merge() {
   // grab a copy of the current state
   index_state state = indexes();
   index_state mergers = state;
+  bool sharded;
 
-  if( state->size() && state->back()->documentCount() == 0 ) {
+  {
+    indri::thread::ScopedLock lock( _addLock );
+    sharded = _blockEnd != 0;
+  }
+
+  if( !sharded && state->size() && state->back()->documentCount() == 0 ) {
     // if the current index is empty, don't need to add a new one; write the others
     mergers = new index_vector;
     mergers->assign( state->begin(), state->end() - 1 );
@@ -1119,6 +1396,14 @@ indri::collection::CompressedCollection* indri::collection::Repository::collecti
   return _collection;
 }
 
+//
+// path
+//
+
+const std::string& indri::collection::Repository::path() const {
+  return _path;
+}
+
 //
 // deletedList
 //
@@ -1179,6 +1464,7 @@ void indri::collection::Repository::close() {
     }
 
     _closeIndexes();
+    _closeShards();
     
     _closePriors();
 
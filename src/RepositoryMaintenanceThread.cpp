@@ -120,11 +120,16 @@ UINT64 indri::collection::RepositoryMaintenanceThread::work() {
       indri::index::MemoryIndex* index = dynamic_cast<indri::index::MemoryIndex*>(state->back());
 
       if( index ) {
-        // if the index is too big, we'd better get to work
-        memorySize = index->memorySize();
-	// account for the size of the DiskIndexes (~22M)
-        for( size_t i=0; i<state->size()-1; i++ ) {
-          memorySize += lemur_compat::min<size_t>(4*((*state)[i]->documentCount()),indri::index::DiskIndex::MAX_DOCLENGTHS_CACHE);
+        // if the indexes are too big, we'd better get to work
+        for( size_t i=0; i<state->size(); i++ ) {
+          indri::index::MemoryIndex* memoryIndex = dynamic_cast<indri::index::MemoryIndex*>((*state)[i]);
+
+          if( memoryIndex ) {
+            memorySize += memoryIndex->memorySize();
+          } else {
+            // account for the size of the DiskIndexes (~22M)
+            memorySize += lemur_compat::min<size_t>(4*((*state)[i]->documentCount()),indri::index::DiskIndex::MAX_DOCLENGTHS_CACHE);
+          }
         }
 
         if( _memory < memorySize ) {
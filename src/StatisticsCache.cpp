@@ -0,0 +1,241 @@
+/*==========================================================================
+ * Copyright (c) 2004 University of Massachusetts.  All Rights Reserved.
+ *
+ * Use of the Lemur Toolkit for Language Modeling and Information Retrieval
+ * is subject to the terms of the software license set forth in the LICENSE
+ * file included with this software, and also available at
+ * http://www.lemurproject.org/license.html
+ *
+ *==========================================================================
+ */
+
+//
+// StatisticsCache
+//
+
+#include "indri/StatisticsCache.hpp"
+#include "indri/Repository.hpp"
+#include "indri/HashTable.hpp"
+#include "indri/Mutex.hpp"
+#include "indri/ScopedLock.hpp"
+#include "indri/Parameters.hpp"
+#include <map>
+#include <list>
+#include <string.h>
+
+//
+// statistics_cache_entry
+//
+
+struct statistics_cache_entry {
+  indri::lang::StatisticsCache::Counts counts;
+  indri::lang::StatisticsCache::Stamp stamp;
+
+  std::string key;
+  std::list<statistics_cache_entry*>::iterator recent;
+
+  size_t memorySize() const {
+    return sizeof(statistics_cache_entry) + key.size();
+  }
+};
+
+//
+// Store
+//
+// The entries shared by every StatisticsCache open on one repository path.
+//
+
+struct indri::lang::StatisticsCache::Store {
+  Store() : entries(1024) {}
+
+  std::string path;
+  int users;
+
+  indri::thread::Mutex lock;
+  indri::utility::HashTable<std::string, statistics_cache_entry*> entries;
+  // most recently used entries first
+  std::list<statistics_cache_entry*> recent;
+  Statistics statistics;
+};
+
+static std::map<std::string, indri::lang::StatisticsCache::Store*> statistics_cache_stores;
+static indri::thread::Mutex statistics_cache_stores_lock;
+
+//
+// statistics_cache_same_stamp
+//
+
+static bool statistics_cache_same_stamp( const indri::lang::StatisticsCache::Stamp& one, const indri::lang::StatisticsCache::Stamp& two ) {
+  return one.indexCount == two.indexCount &&
+    one.deletedCount == two.deletedCount &&
+    one.documentAdds == two.documentAdds;
+}
+
+//
+// StatisticsCache
+//
+
+indri::lang::StatisticsCache::StatisticsCache( indri::collection::Repository& repository ) :
+  _repository(repository)
+{
+  indri::thread::ScopedLock lock( statistics_cache_stores_lock );
+  Store*& store = statistics_cache_stores[ repository.path() ];
+
+  if( !store ) {
+    store = new Store;
+    store->path = repository.path();
+    store->users = 0;
+
+    memset( &store->statistics, 0, sizeof(Statistics) );
+    store->statistics.maximumMemory = indri::api::Parameters::instance().get( "statisticsCacheMemory", INT64(8*1024*1024) );
+  }
+
+  store->users++;
+  _store = store;
+}
+
+//
+// ~StatisticsCache
+//
+
+indri::lang::StatisticsCache::~StatisticsCache() {
+  indri::thread::ScopedLock lock( statistics_cache_stores_lock );
+
+  if( --_store->users > 0 )
+    return;
+
+  statistics_cache_stores.erase( _store->path );
+
+  std::list<statistics_cache_entry*>::iterator iter;
+  for( iter = _store->recent.begin(); iter != _store->recent.end(); iter++ )
+    delete *iter;
+
+  delete _store;
+}
+
+//
+// _key
+//
+// The canonical form of an expression, as in the ListCache: the type
+// and query text of the raw extent, then of the context.
+//
+
+std::string indri::lang::StatisticsCache::_key( indri::lang::ContextCounterNode* counter ) {
+  indri::lang::Node* raw = counter->getRawExtent();
+  indri::lang::Node* context = counter->getContext();
+  std::string key = raw->typeName() + ":" + raw->queryText();
+
+  if( context )
+    key += "\n" + context->typeName() + ":" + context->queryText();
+
+  return key;
+}
+
+//
+// stamp
+//
+
+indri::lang::StatisticsCache::Stamp indri::lang::StatisticsCache::stamp() {
+  indri::collection::Repository::index_state indexes = _repository.indexes();
+  Stamp result;
+
+  // documents may be added to any index, not just the last one, when
+  // documents are added to several shards at once
+  result.documentAdds = _repository.documentAdds();
+  result.indexCount = indexes->size();
+  result.deletedCount = _repository.deletedList().deletedCount();
+
+  return result;
+}
+
+//
+// add
+//
+
+void indri::lang::StatisticsCache::add( indri::lang::ContextCounterNode* counter, const Counts& counts, const Stamp& stamp ) {
+  Stamp current = this->stamp();
+
+  if( !statistics_cache_same_stamp( stamp, current ) )
+    return;
+
+  statistics_cache_entry* entry = new statistics_cache_entry;
+  entry->counts = counts;
+  entry->stamp = stamp;
+  entry->key = _key( counter );
+  size_t memory = entry->memorySize();
+
+  indri::thread::ScopedLock lock( _store->lock );
+
+  if( memory > _store->statistics.maximumMemory ) {
+    delete entry;
+    return;
+  }
+
+  statistics_cache_entry** existing = _store->entries.find( entry->key );
+
+  if( existing ) {
+    // replace counts made from older repository contents
+    if( statistics_cache_same_stamp( (*existing)->stamp, current ) ) {
+      delete entry;
+      return;
+    }
+
+    _store->statistics.memory -= (*existing)->memorySize();
+    _store->statistics.evictions++;
+    _store->recent.erase( (*existing)->recent );
+    delete *existing;
+    _store->entries.remove( entry->key );
+  }
+
+  // evict least recently used entries until this one fits
+  while( _store->recent.size() &&
+         _store->statistics.memory + memory > _store->statistics.maximumMemory ) {
+    statistics_cache_entry* victim = _store->recent.back();
+    _store->recent.pop_back();
+    _store->entries.remove( victim->key );
+
+    _store->statistics.memory -= victim->memorySize();
+    _store->statistics.evictions++;
+    delete victim;
+  }
+
+  _store->recent.push_front( entry );
+  entry->recent = _store->recent.begin();
+  _store->entries.insert( entry->key, entry );
+
+  _store->statistics.memory += memory;
+  _store->statistics.additions++;
+}
+
+//
+// find
+//
+
+bool indri::lang::StatisticsCache::find( indri::lang::ContextCounterNode* counter, Counts& counts ) {
+  std::string key = _key( counter );
+  Stamp current = stamp();
+  indri::thread::ScopedLock lock( _store->lock );
+  statistics_cache_entry** entry = _store->entries.find( key );
+
+  if( !entry || !statistics_cache_same_stamp( (*entry)->stamp, current ) ) {
+    _store->statistics.misses++;
+    return false;
+  }
+
+  _store->recent.splice( _store->recent.begin(), _store->recent, (*entry)->recent );
+  _store->statistics.hits++;
+  counts = (*entry)->counts;
+
+  return true;
+}
+
+//
+// statistics
+//
+
+indri::lang::StatisticsCache::Statistics indri::lang::StatisticsCache::statistics() {
+  indri::thread::ScopedLock lock( _store->lock );
+  Statistics result = _store->statistics;
+  result.entries = _store->recent.size();
+  return result;
+}
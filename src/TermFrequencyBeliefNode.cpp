@@ -25,6 +25,9 @@ indri::infnet::TermFrequencyBeliefNode::TermFrequencyBeliefNode( const std::stri
 {
   _maximumBackgroundScore = INDRI_HUGE_SCORE;
   _maximumScore = INDRI_HUGE_SCORE;
+  _blockFirstDocument = MAX_INT32;
+  _blockLastDocument = -1;
+  _blockMaximumScore = INDRI_HUGE_SCORE;
 }
 
 indri::infnet::TermFrequencyBeliefNode::~TermFrequencyBeliefNode() {
@@ -38,12 +41,8 @@ const indri::utility::greedy_vector<indri::index::DocListIterator::TopDocument>&
 }
 
 lemur::api::DOCID_T indri::infnet::TermFrequencyBeliefNode::nextCandidateDocument() {
-  if( _list ) {
-    const indri::index::DocListIterator::DocumentData* entry = _list->currentEntry();
-    
-    if( entry ) {
-      return entry->document;
-    }
+  if( _list && !_list->finished() ) {
+    return _list->currentDocument();
   }
 
   return MAX_INT32;
@@ -57,6 +56,55 @@ double indri::infnet::TermFrequencyBeliefNode::maximumScore() {
   return _maximumScore;
 }
 
+//
+// blockMaximumScore
+//
+// Returns an upper bound on the score of documentID and every document after
+// it up to lastDocument.  A document of length L in the block holds at most
+// min(L * fraction, maximumCount) occurrences.  The score functions are
+// monotonic in L on either side of the point where the two limits cross, so
+// the bound is the largest score at that point and at the block's shortest
+// and longest documents.
+//
+
+double indri::infnet::TermFrequencyBeliefNode::blockMaximumScore( lemur::api::DOCID_T documentID, lemur::api::DOCID_T& lastDocument ) {
+  if( !_list ) {
+    lastDocument = MAX_INT32;
+    return _maximumScore;
+  }
+
+  if( documentID < _blockFirstDocument || documentID > _blockLastDocument ) {
+    indri::index::DocListIterator::BlockBound bound;
+
+    if( _list->blockBound( documentID, bound ) ) {
+      _blockFirstDocument = bound.firstDocument;
+      _blockLastDocument = bound.lastDocument;
+      _blockMaximumScore = _maximumBackgroundScore;
+
+      if( bound.count ) {
+        double fraction = double(bound.count) / double(bound.length);
+        int crossLength = int( bound.maximumCount / fraction );
+        int lengths[] = { bound.minimumLength,
+                          bound.maximumLength,
+                          lemur_compat::max( bound.minimumLength, lemur_compat::min( bound.maximumLength, crossLength ) ),
+                          lemur_compat::max( bound.minimumLength, lemur_compat::min( bound.maximumLength, crossLength + 1 ) ) };
+
+        for( int i=0; i<4; i++ ) {
+          double occurrences = lemur_compat::min<double>( lengths[i] * fraction, bound.maximumCount );
+          _blockMaximumScore = lemur_compat::max( _blockMaximumScore, _function.scoreOccurrence( occurrences, lengths[i] ) );
+        }
+      }
+    } else {
+      _blockFirstDocument = 0;
+      _blockLastDocument = MAX_INT32;
+      _blockMaximumScore = _maximumScore;
+    }
+  }
+
+  lastDocument = _blockLastDocument;
+  return _blockMaximumScore;
+}
+
 const indri::utility::greedy_vector<indri::api::ScoredExtentResult>& indri::infnet::TermFrequencyBeliefNode::score( lemur::api::DOCID_T documentID, indri::index::Extent &extent, int documentLength ) {
   assert( extent.begin == 0 && extent.end == documentLength ); // FrequencyListCopier ensures this condition
   _extents.clear();
@@ -64,8 +112,8 @@ const indri::utility::greedy_vector<indri::api::ScoredExtentResult>& indri::infn
   double score = 0;
   
   if( _list ) {
-    const indri::index::DocListIterator::DocumentData* entry = _list->currentEntry();
-    int count = ( entry && entry->document == documentID ) ? (int)entry->positions.size() : 0;
+    // only the count is needed here, so the positions are never decoded
+    int count = ( !_list->finished() && _list->currentDocument() == documentID ) ? _list->currentCount() : 0;
     score = _function.scoreOccurrence( count, documentLength );
 
     assert( score <= _maximumScore || _list->topDocuments().size() > 0 );
@@ -84,8 +132,7 @@ const indri::utility::greedy_vector<indri::api::ScoredExtentResult>& indri::infn
 
 bool indri::infnet::TermFrequencyBeliefNode::hasMatch( lemur::api::DOCID_T documentID ) {
   if( _list ) {
-    const indri::index::DocListIterator::DocumentData* entry = _list->currentEntry();
-    return ( entry && entry->document == documentID );
+    return ( !_list->finished() && _list->currentDocument() == documentID );
   }
 
   return false;
@@ -105,6 +152,8 @@ const std::string& indri::infnet::TermFrequencyBeliefNode::getName() const {
 void indri::infnet::TermFrequencyBeliefNode::indexChanged( indri::index::Index& index ) {
   // fetch the next inverted list
   _list = _network.getDocIterator( _listID );
+  _blockFirstDocument = MAX_INT32;
+  _blockLastDocument = -1;
 
   if( !_list ) {
     _maximumBackgroundScore = INDRI_HUGE_SCORE;
@@ -0,0 +1,281 @@
+/*==========================================================================
+ * Copyright (c) 2004 University of Massachusetts.  All Rights Reserved.
+ *
+ * Use of the Lemur Toolkit for Language Modeling and Information Retrieval
+ * is subject to the terms of the software license set forth in the LICENSE
+ * file included with this software, and also available at
+ * http://www.lemurproject.org/license.html
+ *
+ *==========================================================================
+ */
+
+//
+// TermTable
+//
+
+#include "indri/TermTable.hpp"
+#include "indri/RVLDecompressStream.hpp"
+#include "lemur/Exception.hpp"
+#include <string.h>
+
+//
+// hash
+//
+
+UINT64 indri::index::TermTable::hash( const char* term ) {
+  UINT64 result = 0xcbf29ce484222325ULL;
+
+  for( const unsigned char* c = (const unsigned char*) term; *c; c++ ) {
+    result ^= *c;
+    result *= 0x100000001b3ULL;
+  }
+
+  return result;
+}
+
+//
+// TermTableWriter
+//
+
+indri::index::TermTableWriter::TermTableWriter() :
+  _output(0)
+{
+}
+
+//
+// ~TermTableWriter
+//
+
+indri::index::TermTableWriter::~TermTableWriter() {
+  delete _output;
+}
+
+//
+// create
+//
+
+void indri::index::TermTableWriter::create( const std::string& path ) {
+  _file.create( path );
+  _output = new indri::file::SequentialWriteBuffer( _file, 1024*1024 );
+
+  // the header is written by close, once the counts are known
+  _output->seek( TermTable::HEADER_SIZE );
+  _offsets.clear();
+  _hashes.clear();
+  _offsets.push_back( 0 );
+}
+
+//
+// add
+//
+
+void indri::index::TermTableWriter::add( lemur::api::TERMID_T termID, const char* term, const char* record, int length ) {
+  if( termID != lemur::api::TERMID_T(_hashes.size()) + 1 )
+    LEMUR_THROW( LEMUR_RUNTIME_ERROR, "Terms must be added to a TermTable in termID order" );
+
+  _output->write( record, length );
+  _offsets.push_back( _offsets.back() + length );
+  _hashes.push_back( TermTable::hash( term ) );
+}
+
+//
+// close
+//
+
+void indri::index::TermTableWriter::close() {
+  if( !_output )
+    return;
+
+  UINT64 termCount = _hashes.size();
+  UINT64 recordsLength = (_offsets.back() + 7) & ~UINT64(7);
+  UINT64 bucketCount = 16;
+
+  // at most half full, so probe sequences stay short
+  while( bucketCount < termCount * 2 )
+    bucketCount *= 2;
+
+  std::vector<TermTable::Bucket> buckets( (size_t) bucketCount );
+  memset( &buckets[0], 0, buckets.size() * sizeof(TermTable::Bucket) );
+
+  for( UINT64 i=0; i<termCount; i++ ) {
+    UINT64 bucket = _hashes[i] & (bucketCount - 1);
+
+    while( buckets[bucket].termID )
+      bucket = (bucket + 1) & (bucketCount - 1);
+
+    buckets[bucket].termID = UINT32(i + 1);
+    buckets[bucket].check = UINT32(_hashes[i] >> 32);
+  }
+
+  UINT64 padding = recordsLength - _offsets.back();
+  memset( _output->write( (size_t) padding ), 0, (size_t) padding );
+  _output->write( &_offsets[0], _offsets.size() * sizeof(UINT64) );
+  _output->write( &buckets[0], buckets.size() * sizeof(TermTable::Bucket) );
+
+  UINT32 magic = TermTable::MAGIC;
+  UINT32 version = TermTable::VERSION;
+
+  _output->seek( 0 );
+  _output->write( &magic, sizeof(UINT32) );
+  _output->write( &version, sizeof(UINT32) );
+  _output->write( &termCount, sizeof(UINT64) );
+  _output->write( &bucketCount, sizeof(UINT64) );
+  _output->write( &recordsLength, sizeof(UINT64) );
+  _output->flush();
+
+  delete _output;
+  _output = 0;
+  _file.close();
+
+  _offsets.clear();
+  _hashes.clear();
+}
+
+//
+// TermTableReader
+//
+
+indri::index::TermTableReader::TermTableReader() :
+  _buffer(0),
+  _fieldCount(0),
+  _termCount(0),
+  _bucketCount(0),
+  _records(0),
+  _offsets(0),
+  _buckets(0)
+{
+}
+
+//
+// ~TermTableReader
+//
+
+indri::index::TermTableReader::~TermTableReader() {
+  close();
+}
+
+//
+// openRead
+//
+
+void indri::index::TermTableReader::openRead( const std::string& path, int fieldCount ) {
+  _file.openRead( path );
+  _fieldCount = fieldCount;
+
+  UINT64 length = _file.size();
+  const char* data = _file.map();
+
+  if( !data ) {
+    _buffer = new char[ (size_t) length ];
+
+    if( _file.read( _buffer, 0, (size_t) length ) != length ) {
+      close();
+      LEMUR_THROW( LEMUR_IO_ERROR, "Couldn't read the term table: " + path );
+    }
+
+    data = _buffer;
+  }
+
+  UINT32 magic = 0;
+  UINT32 version = 0;
+  UINT64 recordsLength = 0;
+
+  if( length >= TermTable::HEADER_SIZE ) {
+    memcpy( &magic, data, sizeof(UINT32) );
+    memcpy( &version, data + 4, sizeof(UINT32) );
+    memcpy( &_termCount, data + 8, sizeof(UINT64) );
+    memcpy( &_bucketCount, data + 16, sizeof(UINT64) );
+    memcpy( &recordsLength, data + 24, sizeof(UINT64) );
+  }
+
+  UINT64 expected = TermTable::HEADER_SIZE + recordsLength +
+                    (_termCount + 1) * sizeof(UINT64) +
+                    _bucketCount * sizeof(TermTable::Bucket);
+
+  if( magic != TermTable::MAGIC || version != TermTable::VERSION || length != expected ||
+      !_bucketCount || (_bucketCount & (_bucketCount - 1)) || _bucketCount <= _termCount ) {
+    close();
+    LEMUR_THROW( LEMUR_IO_ERROR, "The term table is damaged or was written by another version: " + path );
+  }
+
+  _records = data + TermTable::HEADER_SIZE;
+  _offsets = (const UINT64*) (_records + recordsLength);
+  _buckets = (const TermTable::Bucket*) (_offsets + _termCount + 1);
+}
+
+//
+// close
+//
+
+void indri::index::TermTableReader::close() {
+  _file.close();
+  delete[] _buffer;
+  _buffer = 0;
+
+  _termCount = 0;
+  _bucketCount = 0;
+  _records = 0;
+  _offsets = 0;
+  _buckets = 0;
+}
+
+//
+// isOpen
+//
+
+bool indri::index::TermTableReader::isOpen() const {
+  return _buckets != 0;
+}
+
+//
+// _decode
+//
+
+indri::index::DiskTermData* indri::index::TermTableReader::_decode( lemur::api::TERMID_T termID ) const {
+  UINT64 start = _offsets[termID-1];
+  UINT64 end = _offsets[termID];
+
+  indri::utility::RVLDecompressStream stream( _records + start, int(end - start) );
+  indri::index::DiskTermData* diskTermData = ::disktermdata_decompress( stream, _fieldCount,
+                                                                        DiskTermData::WithString | DiskTermData::WithOffsets );
+  diskTermData->termID = termID;
+  return diskTermData;
+}
+
+//
+// get
+//
+
+indri::index::DiskTermData* indri::index::TermTableReader::get( lemur::api::TERMID_T termID ) const {
+  if( termID <= 0 || UINT64(termID) > _termCount )
+    return 0;
+
+  return _decode( termID );
+}
+
+//
+// get
+//
+
+indri::index::DiskTermData* indri::index::TermTableReader::get( const char* term ) const {
+  if( !_buckets )
+    return 0;
+
+  UINT64 hash = TermTable::hash( term );
+  UINT32 check = UINT32(hash >> 32);
+  UINT64 bucket = hash & (_bucketCount - 1);
+
+  for( ; _buckets[bucket].termID; bucket = (bucket + 1) & (_bucketCount - 1) ) {
+    if( _buckets[bucket].check != check )
+      continue;
+
+    indri::index::DiskTermData* diskTermData = _decode( _buckets[bucket].termID );
+
+    if( !strcmp( diskTermData->termData->term, term ) )
+      return diskTermData;
+
+    ::disktermdata_delete( diskTermData );
+  }
+
+  return 0;
+}
@@ -8,18 +8,12 @@
 
 #define yy_create_buffer tok_create_buffer
 #define yy_delete_buffer tok_delete_buffer
-#define yy_flex_debug tok_flex_debug
 #define yy_init_buffer tok_init_buffer
 #define yy_flush_buffer tok_flush_buffer
 #define yy_load_buffer_state tok_load_buffer_state
 #define yy_switch_to_buffer tok_switch_to_buffer
-#define yyin tokin
-#define yyleng tokleng
 #define yylex toklex
-#define yylineno toklineno
-#define yyout tokout
 #define yyrestart tokrestart
-#define yytext toktext
 #define yywrap tokwrap
 #define yyalloc tokalloc
 #define yyrealloc tokrealloc
@@ -138,24 +132,41 @@ typedef unsigned int flex_uint32_t;
  */
 #define YY_SC_TO_UI(c) ((unsigned int) (unsigned char) c)
 
+/* An opaque pointer. */
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void* yyscan_t;
+#endif
+
+/* For convenience, these vars (plus the bison vars far below)
+   are macros in the reentrant scanner. */
+#define yyin yyg->yyin_r
+#define yyout yyg->yyout_r
+#define yyextra yyg->yyextra_r
+#define yyleng yyg->yyleng_r
+#define yytext yyg->yytext_r
+#define yylineno (YY_CURRENT_BUFFER_LVALUE->yy_bs_lineno)
+#define yycolumn (YY_CURRENT_BUFFER_LVALUE->yy_bs_column)
+#define yy_flex_debug yyg->yy_flex_debug_r
+
 /* Enter a start condition.  This macro really ought to take a parameter,
  * but we do it the disgusting crufty way forced on us by the ()-less
  * definition of BEGIN.
  */
-#define BEGIN (yy_start) = 1 + 2 *
+#define BEGIN yyg->yy_start = 1 + 2 *
 
 /* Translate the current start state into a value that can be later handed
  * to BEGIN to return to the state.  The YYSTATE alias is for lex
  * compatibility.
  */
-#define YY_START (((yy_start) - 1) / 2)
+#define YY_START ((yyg->yy_start - 1) / 2)
 #define YYSTATE YY_START
 
 /* Action number for EOF rule of a given start state. */
 #define YY_STATE_EOF(state) (YY_END_OF_BUFFER + state + 1)
 
 /* Special action meaning "start processing a new file". */
-#define YY_NEW_FILE tokrestart(tokin  )
+#define YY_NEW_FILE tokrestart(yyin ,yyscanner )
 
 #define YY_END_OF_BUFFER_CHAR 0
 
@@ -178,10 +189,6 @@ typedef struct yy_buffer_state *YY_BUFFER_STATE;
 typedef size_t yy_size_t;
 #endif
 
-extern yy_size_t tokleng;
-
-extern FILE *tokin, *tokout;
-
 #define EOB_ACT_CONTINUE_SCAN 0
 #define EOB_ACT_END_OF_FILE 1
 #define EOB_ACT_LAST_MATCH 2
@@ -195,14 +202,14 @@ extern FILE *tokin, *tokout;
 		/* Undo effects of setting up toktext. */ \
         int yyless_macro_arg = (n); \
         YY_LESS_LINENO(yyless_macro_arg);\
-		*yy_cp = (yy_hold_char); \
+		*yy_cp = yyg->yy_hold_char; \
 		YY_RESTORE_YY_MORE_OFFSET \
-		(yy_c_buf_p) = yy_cp = yy_bp + yyless_macro_arg - YY_MORE_ADJ; \
+		yyg->yy_c_buf_p = yy_cp = yy_bp + yyless_macro_arg - YY_MORE_ADJ; \
 		YY_DO_BEFORE_ACTION; /* set up toktext again */ \
 		} \
 	while ( 0 )
 
-#define unput(c) yyunput( c, (yytext_ptr)  )
+#define unput(c) yyunput( c, yyg->yytext_ptr ,yyscanner )
 
 #ifndef YY_STRUCT_YY_BUFFER_STATE
 #define YY_STRUCT_YY_BUFFER_STATE
@@ -269,71 +276,51 @@ struct yy_buffer_state
 	};
 #endif /* !YY_STRUCT_YY_BUFFER_STATE */
 
-/* Stack of input buffers. */
-static size_t yy_buffer_stack_top = 0; /**< index of top of stack. */
-static size_t yy_buffer_stack_max = 0; /**< capacity of stack. */
-static YY_BUFFER_STATE * yy_buffer_stack = 0; /**< Stack as an array. */
-
 /* We provide macros for accessing buffer states in case in the
  * future we want to put the buffer states in a more general
  * "scanner state".
  *
  * Returns the top of the stack, or NULL.
  */
-#define YY_CURRENT_BUFFER ( (yy_buffer_stack) \
-                          ? (yy_buffer_stack)[(yy_buffer_stack_top)] \
+#define YY_CURRENT_BUFFER ( yyg->yy_buffer_stack \
+                          ? yyg->yy_buffer_stack[yyg->yy_buffer_stack_top] \
                           : NULL)
 
 /* Same as previous macro, but useful when we know that the buffer stack is not
  * NULL or when we need an lvalue. For internal use only.
  */
-#define YY_CURRENT_BUFFER_LVALUE (yy_buffer_stack)[(yy_buffer_stack_top)]
-
-/* yy_hold_char holds the character lost when toktext is formed. */
-static char yy_hold_char;
-static yy_size_t yy_n_chars;		/* number of characters read into yy_ch_buf */
-yy_size_t tokleng;
+#define YY_CURRENT_BUFFER_LVALUE yyg->yy_buffer_stack[yyg->yy_buffer_stack_top]
 
-/* Points to current character in buffer. */
-static char *yy_c_buf_p = (char *) 0;
-static int yy_init = 0;		/* whether we need to initialize */
-static int yy_start = 0;	/* start state number */
-
-/* Flag which is used to allow tokwrap()'s to do buffer switches
- * instead of setting up a fresh tokin.  A bit of a hack ...
- */
-static int yy_did_buffer_switch_on_eof;
+void tokrestart (FILE *input_file ,yyscan_t yyscanner );
+void tok_switch_to_buffer (YY_BUFFER_STATE new_buffer ,yyscan_t yyscanner );
+YY_BUFFER_STATE tok_create_buffer (FILE *file,int size ,yyscan_t yyscanner );
+void tok_delete_buffer (YY_BUFFER_STATE b ,yyscan_t yyscanner );
+void tok_flush_buffer (YY_BUFFER_STATE b ,yyscan_t yyscanner );
+void tokpush_buffer_state (YY_BUFFER_STATE new_buffer ,yyscan_t yyscanner );
+void tokpop_buffer_state (yyscan_t yyscanner );
 
-void tokrestart (FILE *input_file  );
-void tok_switch_to_buffer (YY_BUFFER_STATE new_buffer  );
-YY_BUFFER_STATE tok_create_buffer (FILE *file,int size  );
-void tok_delete_buffer (YY_BUFFER_STATE b  );
-void tok_flush_buffer (YY_BUFFER_STATE b  );
-void tokpush_buffer_state (YY_BUFFER_STATE new_buffer  );
-void tokpop_buffer_state (void );
+static void tokensure_buffer_stack (yyscan_t yyscanner );
+static void tok_load_buffer_state (yyscan_t yyscanner );
+static void tok_init_buffer (YY_BUFFER_STATE b,FILE *file ,yyscan_t yyscanner );
 
-static void tokensure_buffer_stack (void );
-static void tok_load_buffer_state (void );
-static void tok_init_buffer (YY_BUFFER_STATE b,FILE *file  );
+#define YY_FLUSH_BUFFER tok_flush_buffer(YY_CURRENT_BUFFER ,yyscanner )
 
-#define YY_FLUSH_BUFFER tok_flush_buffer(YY_CURRENT_BUFFER )
+YY_BUFFER_STATE tok_scan_buffer (char *base,yy_size_t size ,yyscan_t yyscanner );
+YY_BUFFER_STATE tok_scan_string (yyconst char *yy_str ,yyscan_t yyscanner );
+YY_BUFFER_STATE tok_scan_bytes (yyconst char *bytes,yy_size_t len ,yyscan_t yyscanner );
 
-YY_BUFFER_STATE tok_scan_buffer (char *base,yy_size_t size  );
-YY_BUFFER_STATE tok_scan_string (yyconst char *yy_str  );
-YY_BUFFER_STATE tok_scan_bytes (yyconst char *bytes,yy_size_t len  );
-
-void *tokalloc (yy_size_t  );
-void *tokrealloc (void *,yy_size_t  );
-void tokfree (void *  );
+void *tokalloc (yy_size_t ,yyscan_t yyscanner );
+void *tokrealloc (void *,yy_size_t ,yyscan_t yyscanner );
+void tokfree (void * ,yyscan_t yyscanner );
 
 #define yy_new_buffer tok_create_buffer
 
 #define yy_set_interactive(is_interactive) \
 	{ \
 	if ( ! YY_CURRENT_BUFFER ){ \
-        tokensure_buffer_stack (); \
+        tokensure_buffer_stack (yyscanner ); \
 		YY_CURRENT_BUFFER_LVALUE =    \
-            tok_create_buffer(tokin,YY_BUF_SIZE ); \
+            tok_create_buffer(yyin,YY_BUF_SIZE ,yyscanner ); \
 	} \
 	YY_CURRENT_BUFFER_LVALUE->yy_is_interactive = is_interactive; \
 	}
@@ -341,9 +328,9 @@ void tokfree (void *  );
 #define yy_set_bol(at_bol) \
 	{ \
 	if ( ! YY_CURRENT_BUFFER ){\
-        tokensure_buffer_stack (); \
+        tokensure_buffer_stack (yyscanner ); \
 		YY_CURRENT_BUFFER_LVALUE =    \
-            tok_create_buffer(tokin,YY_BUF_SIZE ); \
+            tok_create_buffer(yyin,YY_BUF_SIZE ,yyscanner ); \
 	} \
 	YY_CURRENT_BUFFER_LVALUE->yy_at_bol = at_bol; \
 	}
@@ -357,16 +344,9 @@ void tokfree (void *  );
 
 typedef unsigned char YY_CHAR;
 
-FILE *tokin = (FILE *) 0, *tokout = (FILE *) 0;
-
 typedef int yy_state_type;
 
-extern int toklineno;
-
-int toklineno = 1;
-
-extern char *toktext;
-#define yytext_ptr toktext
+#define yytext_ptr yytext_r
 static yyconst flex_int16_t yy_nxt[][256] =
     {
     {
@@ -2109,20 +2089,20 @@ static yyconst flex_int16_t yy_nxt[][256] =
 
     } ;
 
-static yy_state_type yy_get_previous_state (void );
-static yy_state_type yy_try_NUL_trans (yy_state_type current_state  );
-static int yy_get_next_buffer (void );
-static void yy_fatal_error (yyconst char msg[]  );
+static yy_state_type yy_get_previous_state (yyscan_t yyscanner );
+static yy_state_type yy_try_NUL_trans (yy_state_type current_state ,yyscan_t yyscanner );
+static int yy_get_next_buffer (yyscan_t yyscanner );
+static void yy_fatal_error (yyconst char msg[] ,yyscan_t yyscanner );
 
 /* Done after the current pattern has been matched and before the
  * corresponding action - sets up toktext.
  */
 #define YY_DO_BEFORE_ACTION \
-	(yytext_ptr) = yy_bp; \
-	tokleng = (yy_size_t) (yy_cp - yy_bp); \
-	(yy_hold_char) = *yy_cp; \
+	yyg->yytext_ptr = yy_bp; \
+	yyleng = (yy_size_t) (yy_cp - yy_bp); \
+	yyg->yy_hold_char = *yy_cp; \
 	*yy_cp = '\0'; \
-	(yy_c_buf_p) = yy_cp;
+	yyg->yy_c_buf_p = yy_cp;
 
 #define YY_NUM_RULES 16
 #define YY_END_OF_BUFFER 17
@@ -2143,9 +2123,6 @@ static yyconst flex_int16_t yy_accept[55] =
         6,    0,    0,    7
     } ;
 
-static yy_state_type yy_last_accepting_state;
-static char *yy_last_accepting_cpos;
-
 static yyconst yy_state_type yy_NUL_trans[55] =
     {   0,
         6,    6,   15,   15,    0,    0,    0,    0,    0,    0,
@@ -2156,9 +2133,6 @@ static yyconst yy_state_type yy_NUL_trans[55] =
         0,   53,   53,    0
     } ;
 
-extern int tok_flex_debug;
-int tok_flex_debug = 0;
-
 /* The intent behind this definition is that it'll catch
  * any uses of REJECT which flex missed.
  */
@@ -2166,9 +2140,8 @@ int tok_flex_debug = 0;
 #define yymore() yymore_used_but_not_detected
 #define YY_MORE_ADJ 0
 #define YY_RESTORE_YY_MORE_OFFSET
-char *toktext;
 #line 1 "../src/TextTokenizer.l"
-#line 6 "../src/TextTokenizer.l"
+#line 8 "../src/TextTokenizer.l"
 
 /*==========================================================================
  * Copyright (c) 2004 University of Massachusetts.  All Rights Reserved.
@@ -2198,53 +2171,96 @@ char *toktext;
 #include "indri/UTF8Transcoder.hpp"
 #include "indri/AttributeValuePair.hpp"
 
-static long byte_position;
+// each tokenizer has its own scanner; yyextra points at its byte position
 
 #define ZAP           1
 #define TAG           2
 #define ASCII_TOKEN   3
 #define UTF8_TOKEN    4
 
-
-#line 2210 "../src/TextTokenizer.cpp"
+#line 2182 "../src/TextTokenizer.cpp"
 
 #define INITIAL 0
 #define COMMENT 1
 
+#define YY_EXTRA_TYPE long*
+
 #ifndef YY_EXTRA_TYPE
 #define YY_EXTRA_TYPE void *
 #endif
 
-static int yy_init_globals (void );
+/* Holds the entire state of the reentrant scanner. */
+struct yyguts_t
+    {
+
+    /* User-defined. Not touched by flex. */
+    YY_EXTRA_TYPE yyextra_r;
+
+    /* The rest are the same as the globals declared in the non-reentrant scanner. */
+    FILE *yyin_r, *yyout_r;
+    size_t yy_buffer_stack_top; /**< index of top of stack. */
+    size_t yy_buffer_stack_max; /**< capacity of stack. */
+    YY_BUFFER_STATE * yy_buffer_stack; /**< Stack as an array. */
+    char yy_hold_char;
+    yy_size_t yy_n_chars;
+    yy_size_t yyleng_r;
+    char *yy_c_buf_p;
+    int yy_init;
+    int yy_start;
+    int yy_did_buffer_switch_on_eof;
+    int yy_start_stack_ptr;
+    int yy_start_stack_depth;
+    int *yy_start_stack;
+    yy_state_type yy_last_accepting_state;
+    char* yy_last_accepting_cpos;
+
+    int yylineno_r;
+    int yy_flex_debug_r;
+
+    char *yytext_r;
+    int yy_more_flag;
+    int yy_more_len;
+
+    }; /* end struct yyguts_t */
+
+static int yy_init_globals (yyscan_t yyscanner );
+
+int toklex_init (yyscan_t* scanner);
+
+int toklex_init_extra (YY_EXTRA_TYPE user_defined,yyscan_t* scanner);
 
 /* Accessor methods to globals.
    These are made visible to non-reentrant scanners for convenience. */
 
-int toklex_destroy (void );
+int toklex_destroy (yyscan_t yyscanner );
+
+int tokget_debug (yyscan_t yyscanner );
 
-int tokget_debug (void );
+void tokset_debug (int debug_flag ,yyscan_t yyscanner );
 
-void tokset_debug (int debug_flag  );
+YY_EXTRA_TYPE tokget_extra (yyscan_t yyscanner );
 
-YY_EXTRA_TYPE tokget_extra (void );
+void tokset_extra (YY_EXTRA_TYPE user_defined ,yyscan_t yyscanner );
 
-void tokset_extra (YY_EXTRA_TYPE user_defined  );
+FILE *tokget_in (yyscan_t yyscanner );
 
-FILE *tokget_in (void );
+void tokset_in  (FILE * in_str ,yyscan_t yyscanner );
 
-void tokset_in  (FILE * in_str  );
+FILE *tokget_out (yyscan_t yyscanner );
 
-FILE *tokget_out (void );
+void tokset_out  (FILE * out_str ,yyscan_t yyscanner );
 
-void tokset_out  (FILE * out_str  );
+yy_size_t tokget_leng (yyscan_t yyscanner );
 
-yy_size_t tokget_leng (void );
+char *tokget_text (yyscan_t yyscanner );
 
-char *tokget_text (void );
+int tokget_lineno (yyscan_t yyscanner );
 
-int tokget_lineno (void );
+void tokset_lineno (int line_number ,yyscan_t yyscanner );
 
-void tokset_lineno (int line_number  );
+int tokget_column  (yyscan_t yyscanner );
+
+void tokset_column (int column_no ,yyscan_t yyscanner );
 
 /* Macros after this point can all be overridden by user definitions in
  * section 1.
@@ -2252,28 +2268,28 @@ void tokset_lineno (int line_number  );
 
 #ifndef YY_SKIP_YYWRAP
 #ifdef __cplusplus
-extern "C" int tokwrap (void );
+extern "C" int tokwrap (yyscan_t yyscanner );
 #else
-extern int tokwrap (void );
+extern int tokwrap (yyscan_t yyscanner );
 #endif
 #endif
 
-    static void yyunput (int c,char *buf_ptr  );
+    static void yyunput (int c,char *buf_ptr ,yyscan_t yyscanner );
     
 #ifndef yytext_ptr
-static void yy_flex_strncpy (char *,yyconst char *,int );
+static void yy_flex_strncpy (char *,yyconst char *,int ,yyscan_t yyscanner );
 #endif
 
 #ifdef YY_NEED_STRLEN
-static int yy_flex_strlen (yyconst char * );
+static int yy_flex_strlen (yyconst char * ,yyscan_t yyscanner );
 #endif
 
 #ifndef YY_NO_INPUT
 
 #ifdef __cplusplus
-static int yyinput (void );
+static int yyinput (yyscan_t yyscanner );
 #else
-static int input (void );
+static int input (yyscan_t yyscanner );
 #endif
 
 #endif
@@ -2288,7 +2304,7 @@ static int input (void );
 /* This used to be an fputs(), but since the string might contain NUL's,
  * we now use fwrite().
  */
-#define ECHO fwrite( toktext, tokleng, 1, tokout )
+#define ECHO fwrite( yytext, yyleng, 1, yyout )
 #endif
 
 /* Gets input and stuffs it into "buf".  number of characters read, or YY_NULL,
@@ -2301,18 +2317,18 @@ static int input (void );
 		int c = '*'; \
 		yy_size_t n; \
 		for ( n = 0; n < max_size && \
-			     (c = getc( tokin )) != EOF && c != '\n'; ++n ) \
+			     (c = getc( yyin )) != EOF && c != '\n'; ++n ) \
 			buf[n] = (char) c; \
 		if ( c == '\n' ) \
 			buf[n++] = (char) c; \
-		if ( c == EOF && ferror( tokin ) ) \
+		if ( c == EOF && ferror( yyin ) ) \
 			YY_FATAL_ERROR( "input in flex scanner failed" ); \
 		result = n; \
 		} \
 	else \
 		{ \
 		errno=0; \
-		while ( (result = fread(buf, 1, max_size, tokin))==0 && ferror(tokin)) \
+		while ( (result = fread(buf, 1, max_size, yyin))==0 && ferror(yyin)) \
 			{ \
 			if( errno != EINTR) \
 				{ \
@@ -2320,7 +2336,7 @@ static int input (void );
 				break; \
 				} \
 			errno=0; \
-			clearerr(tokin); \
+			clearerr(yyin); \
 			} \
 		}\
 \
@@ -2342,7 +2358,7 @@ static int input (void );
 
 /* Report a fatal error. */
 #ifndef YY_FATAL_ERROR
-#define YY_FATAL_ERROR(msg) yy_fatal_error( msg )
+#define YY_FATAL_ERROR(msg) yy_fatal_error( msg ,yyscanner )
 #endif
 
 /* end tables serialization structures and prototypes */
@@ -2353,9 +2369,9 @@ static int input (void );
 #ifndef YY_DECL
 #define YY_DECL_IS_OURS 1
 
-extern int toklex (void);
+extern int toklex (yyscan_t yyscanner);
 
-#define YY_DECL int toklex (void)
+#define YY_DECL int toklex (yyscan_t yyscanner)
 #endif /* !YY_DECL */
 
 /* Code executed at the beginning of each rule, after toktext and tokleng
@@ -2380,58 +2396,58 @@ YY_DECL
 	register yy_state_type yy_current_state;
 	register char *yy_cp, *yy_bp;
 	register int yy_act;
-    
-#line 44 "../src/TextTokenizer.l"
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+#line 46 "../src/TextTokenizer.l"
 
 
-#line 2396 "../src/TextTokenizer.cpp"
+#line 2404 "../src/TextTokenizer.cpp"
 
-	if ( !(yy_init) )
+	if ( !yyg->yy_init )
 		{
-		(yy_init) = 1;
+		yyg->yy_init = 1;
 
 #ifdef YY_USER_INIT
 		YY_USER_INIT;
 #endif
 
-		if ( ! (yy_start) )
-			(yy_start) = 1;	/* first start state */
+		if ( ! yyg->yy_start )
+			yyg->yy_start = 1;	/* first start state */
 
-		if ( ! tokin )
-			tokin = stdin;
+		if ( ! yyin )
+			yyin = stdin;
 
-		if ( ! tokout )
-			tokout = stdout;
+		if ( ! yyout )
+			yyout = stdout;
 
 		if ( ! YY_CURRENT_BUFFER ) {
-			tokensure_buffer_stack ();
+			tokensure_buffer_stack (yyscanner );
 			YY_CURRENT_BUFFER_LVALUE =
-				tok_create_buffer(tokin,YY_BUF_SIZE );
+				tok_create_buffer(yyin,YY_BUF_SIZE ,yyscanner );
 		}
 
-		tok_load_buffer_state( );
+		tok_load_buffer_state(yyscanner );
 		}
 
 	while ( 1 )		/* loops until end-of-file is reached */
 		{
-		yy_cp = (yy_c_buf_p);
+		yy_cp = yyg->yy_c_buf_p;
 
 		/* Support of toktext. */
-		*yy_cp = (yy_hold_char);
+		*yy_cp = yyg->yy_hold_char;
 
 		/* yy_bp points to the position in yy_ch_buf of the start of
 		 * the current run.
 		 */
 		yy_bp = yy_cp;
 
-		yy_current_state = (yy_start);
+		yy_current_state = yyg->yy_start;
 yy_match:
 		while ( (yy_current_state = yy_nxt[yy_current_state][ YY_SC_TO_UI(*yy_cp) ]) > 0 )
 			{
 			if ( yy_accept[yy_current_state] )
 				{
-				(yy_last_accepting_state) = yy_current_state;
-				(yy_last_accepting_cpos) = yy_cp;
+				yyg->yy_last_accepting_state = yy_current_state;
+				yyg->yy_last_accepting_cpos = yy_cp;
 				}
 
 			++yy_cp;
@@ -2450,99 +2466,99 @@ do_action:	/* This label is used only to access EOF actions. */
 	{ /* beginning of action switch */
 			case 0: /* must back up */
 			/* undo the effects of YY_DO_BEFORE_ACTION */
-			*yy_cp = (yy_hold_char);
-			yy_cp = (yy_last_accepting_cpos) + 1;
-			yy_current_state = (yy_last_accepting_state);
+			*yy_cp = yyg->yy_hold_char;
+			yy_cp = yyg->yy_last_accepting_cpos + 1;
+			yy_current_state = yyg->yy_last_accepting_state;
 			goto yy_find_action;
 
 case 1:
 YY_RULE_SETUP
-#line 46 "../src/TextTokenizer.l"
-{ BEGIN(COMMENT); byte_position += tokleng; return ZAP; }
+#line 48 "../src/TextTokenizer.l"
+{ BEGIN(COMMENT); *yyextra += yyleng; return ZAP; }
 	YY_BREAK
 case 2:
 /* rule 2 can match eol */
 YY_RULE_SETUP
-#line 47 "../src/TextTokenizer.l"
-{ byte_position += tokleng; return ZAP; }
+#line 49 "../src/TextTokenizer.l"
+{ *yyextra += yyleng; return ZAP; }
 	YY_BREAK
 case 3:
 YY_RULE_SETUP
-#line 48 "../src/TextTokenizer.l"
-{ BEGIN(INITIAL); byte_position += tokleng; return ZAP; }
+#line 50 "../src/TextTokenizer.l"
+{ BEGIN(INITIAL); *yyextra += yyleng; return ZAP; }
 	YY_BREAK
 case 4:
 /* rule 4 can match eol */
 YY_RULE_SETUP
-#line 49 "../src/TextTokenizer.l"
-{ byte_position += tokleng; return ZAP; }
+#line 51 "../src/TextTokenizer.l"
+{ *yyextra += yyleng; return ZAP; }
 	YY_BREAK
 case 5:
 /* rule 5 can match eol */
 YY_RULE_SETUP
-#line 50 "../src/TextTokenizer.l"
-{ byte_position += tokleng; return ZAP; }
+#line 52 "../src/TextTokenizer.l"
+{ *yyextra += yyleng; return ZAP; }
 	YY_BREAK
 case 6:
 /* rule 6 can match eol */
 YY_RULE_SETUP
-#line 51 "../src/TextTokenizer.l"
-{ byte_position += tokleng; return ZAP; }
+#line 53 "../src/TextTokenizer.l"
+{ *yyextra += yyleng; return ZAP; }
 	YY_BREAK
 case 7:
 /* rule 7 can match eol */
 YY_RULE_SETUP
-#line 52 "../src/TextTokenizer.l"
-{ byte_position += tokleng; return ZAP; }
+#line 54 "../src/TextTokenizer.l"
+{ *yyextra += yyleng; return ZAP; }
 	YY_BREAK
 case 8:
 /* rule 8 can match eol */
 YY_RULE_SETUP
-#line 53 "../src/TextTokenizer.l"
-{ byte_position += tokleng; return TAG; }
+#line 55 "../src/TextTokenizer.l"
+{ *yyextra += yyleng; return TAG; }
 	YY_BREAK
 case 9:
 YY_RULE_SETUP
-#line 54 "../src/TextTokenizer.l"
-{ byte_position += tokleng; return ZAP; /* symbols */ }
+#line 56 "../src/TextTokenizer.l"
+{ *yyextra += yyleng; return ZAP; /* symbols */ }
 	YY_BREAK
 case 10:
 YY_RULE_SETUP
-#line 55 "../src/TextTokenizer.l"
-{ byte_position += tokleng; return ASCII_TOKEN; }
+#line 57 "../src/TextTokenizer.l"
+{ *yyextra += yyleng; return ASCII_TOKEN; }
 	YY_BREAK
 case 11:
 YY_RULE_SETUP
-#line 56 "../src/TextTokenizer.l"
-{ byte_position += tokleng; return ASCII_TOKEN; }
+#line 58 "../src/TextTokenizer.l"
+{ *yyextra += yyleng; return ASCII_TOKEN; }
 	YY_BREAK
 case 12:
 YY_RULE_SETUP
-#line 57 "../src/TextTokenizer.l"
-{ byte_position += tokleng; return ASCII_TOKEN; }
+#line 59 "../src/TextTokenizer.l"
+{ *yyextra += yyleng; return ASCII_TOKEN; }
 	YY_BREAK
 case 13:
 YY_RULE_SETUP
-#line 58 "../src/TextTokenizer.l"
-{ byte_position += tokleng; return UTF8_TOKEN; }
+#line 60 "../src/TextTokenizer.l"
+{ *yyextra += yyleng; return UTF8_TOKEN; }
 	YY_BREAK
 case 14:
 /* rule 14 can match eol */
 YY_RULE_SETUP
-#line 60 "../src/TextTokenizer.l"
-{ byte_position += tokleng; return ZAP; }
+#line 62 "../src/TextTokenizer.l"
+{ *yyextra += yyleng; return ZAP; }
 	YY_BREAK
 case 15:
 YY_RULE_SETUP
-#line 61 "../src/TextTokenizer.l"
-{ byte_position += tokleng; return ZAP; }
+#line 63 "../src/TextTokenizer.l"
+{ *yyextra += yyleng; return ZAP; }
 	YY_BREAK
 case 16:
 YY_RULE_SETUP
-#line 63 "../src/TextTokenizer.l"
+#line 65 "../src/TextTokenizer.l"
 ECHO;
 	YY_BREAK
-#line 2554 "../src/TextTokenizer.cpp"
+#line 2562 "../src/TextTokenizer.cpp"
 case YY_STATE_EOF(INITIAL):
 case YY_STATE_EOF(COMMENT):
 	yyterminate();
@@ -2550,10 +2566,10 @@ case YY_STATE_EOF(COMMENT):
 	case YY_END_OF_BUFFER:
 		{
 		/* Amount of text matched not including the EOB char. */
-		int yy_amount_of_matched_text = (int) (yy_cp - (yytext_ptr)) - 1;
+		int yy_amount_of_matched_text = (int) (yy_cp - yyg->yytext_ptr) - 1;
 
 		/* Undo the effects of YY_DO_BEFORE_ACTION. */
-		*yy_cp = (yy_hold_char);
+		*yy_cp = yyg->yy_hold_char;
 		YY_RESTORE_YY_MORE_OFFSET
 
 		if ( YY_CURRENT_BUFFER_LVALUE->yy_buffer_status == YY_BUFFER_NEW )
@@ -2567,8 +2583,8 @@ case YY_STATE_EOF(COMMENT):
 			 * this is the first action (other than possibly a
 			 * back-up) that will match for the new input source.
 			 */
-			(yy_n_chars) = YY_CURRENT_BUFFER_LVALUE->yy_n_chars;
-			YY_CURRENT_BUFFER_LVALUE->yy_input_file = tokin;
+			yyg->yy_n_chars = YY_CURRENT_BUFFER_LVALUE->yy_n_chars;
+			YY_CURRENT_BUFFER_LVALUE->yy_input_file = yyin;
 			YY_CURRENT_BUFFER_LVALUE->yy_buffer_status = YY_BUFFER_NORMAL;
 			}
 
@@ -2579,13 +2595,13 @@ case YY_STATE_EOF(COMMENT):
 		 * end-of-buffer state).  Contrast this with the test
 		 * in input().
 		 */
-		if ( (yy_c_buf_p) <= &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[(yy_n_chars)] )
+		if ( yyg->yy_c_buf_p <= &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[yyg->yy_n_chars] )
 			{ /* This was really a NUL. */
 			yy_state_type yy_next_state;
 
-			(yy_c_buf_p) = (yytext_ptr) + yy_amount_of_matched_text;
+			yyg->yy_c_buf_p = yyg->yytext_ptr + yy_amount_of_matched_text;
 
-			yy_current_state = yy_get_previous_state(  );
+			yy_current_state = yy_get_previous_state(yyscanner );
 
 			/* Okay, we're now positioned to make the NUL
 			 * transition.  We couldn't have
@@ -2596,32 +2612,32 @@ case YY_STATE_EOF(COMMENT):
 			 * will run more slowly).
 			 */
 
-			yy_next_state = yy_try_NUL_trans( yy_current_state );
+			yy_next_state = yy_try_NUL_trans( yy_current_state ,yyscanner );
 
-			yy_bp = (yytext_ptr) + YY_MORE_ADJ;
+			yy_bp = yyg->yytext_ptr + YY_MORE_ADJ;
 
 			if ( yy_next_state )
 				{
 				/* Consume the NUL. */
-				yy_cp = ++(yy_c_buf_p);
+				yy_cp = ++yyg->yy_c_buf_p;
 				yy_current_state = yy_next_state;
 				goto yy_match;
 				}
 
 			else
 				{
-				yy_cp = (yy_c_buf_p);
+				yy_cp = yyg->yy_c_buf_p;
 				goto yy_find_action;
 				}
 			}
 
-		else switch ( yy_get_next_buffer(  ) )
+		else switch ( yy_get_next_buffer(yyscanner ) )
 			{
 			case EOB_ACT_END_OF_FILE:
 				{
-				(yy_did_buffer_switch_on_eof) = 0;
+				yyg->yy_did_buffer_switch_on_eof = 0;
 
-				if ( tokwrap( ) )
+				if ( tokwrap(yyscanner ) )
 					{
 					/* Note: because we've taken care in
 					 * yy_get_next_buffer() to have set up
@@ -2632,7 +2648,7 @@ case YY_STATE_EOF(COMMENT):
 					 * YY_NULL, it'll still work - another
 					 * YY_NULL will get returned.
 					 */
-					(yy_c_buf_p) = (yytext_ptr) + YY_MORE_ADJ;
+					yyg->yy_c_buf_p = yyg->yytext_ptr + YY_MORE_ADJ;
 
 					yy_act = YY_STATE_EOF(YY_START);
 					goto do_action;
@@ -2640,30 +2656,30 @@ case YY_STATE_EOF(COMMENT):
 
 				else
 					{
-					if ( ! (yy_did_buffer_switch_on_eof) )
+					if ( ! yyg->yy_did_buffer_switch_on_eof )
 						YY_NEW_FILE;
 					}
 				break;
 				}
 
 			case EOB_ACT_CONTINUE_SCAN:
-				(yy_c_buf_p) =
-					(yytext_ptr) + yy_amount_of_matched_text;
+				yyg->yy_c_buf_p =
+					yyg->yytext_ptr + yy_amount_of_matched_text;
 
-				yy_current_state = yy_get_previous_state(  );
+				yy_current_state = yy_get_previous_state(yyscanner );
 
-				yy_cp = (yy_c_buf_p);
-				yy_bp = (yytext_ptr) + YY_MORE_ADJ;
+				yy_cp = yyg->yy_c_buf_p;
+				yy_bp = yyg->yytext_ptr + YY_MORE_ADJ;
 				goto yy_match;
 
 			case EOB_ACT_LAST_MATCH:
-				(yy_c_buf_p) =
-				&YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[(yy_n_chars)];
+				yyg->yy_c_buf_p =
+				&YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[yyg->yy_n_chars];
 
-				yy_current_state = yy_get_previous_state(  );
+				yy_current_state = yy_get_previous_state(yyscanner );
 
-				yy_cp = (yy_c_buf_p);
-				yy_bp = (yytext_ptr) + YY_MORE_ADJ;
+				yy_cp = yyg->yy_c_buf_p;
+				yy_bp = yyg->yytext_ptr + YY_MORE_ADJ;
 				goto yy_find_action;
 			}
 		break;
@@ -2683,20 +2699,21 @@ case YY_STATE_EOF(COMMENT):
  *	EOB_ACT_CONTINUE_SCAN - continue scanning from current position
  *	EOB_ACT_END_OF_FILE - end of file
  */
-static int yy_get_next_buffer (void)
+static int yy_get_next_buffer (yyscan_t yyscanner)
 {
-    	register char *dest = YY_CURRENT_BUFFER_LVALUE->yy_ch_buf;
-	register char *source = (yytext_ptr);
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+	register char *dest = YY_CURRENT_BUFFER_LVALUE->yy_ch_buf;
+	register char *source = yyg->yytext_ptr;
 	register int number_to_move, i;
 	int ret_val;
 
-	if ( (yy_c_buf_p) > &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[(yy_n_chars) + 1] )
+	if ( yyg->yy_c_buf_p > &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[yyg->yy_n_chars + 1] )
 		YY_FATAL_ERROR(
 		"fatal flex scanner internal error--end of buffer missed" );
 
 	if ( YY_CURRENT_BUFFER_LVALUE->yy_fill_buffer == 0 )
 		{ /* Don't try to fill the buffer, so this is an EOF. */
-		if ( (yy_c_buf_p) - (yytext_ptr) - YY_MORE_ADJ == 1 )
+		if ( yyg->yy_c_buf_p - yyg->yytext_ptr - YY_MORE_ADJ == 1 )
 			{
 			/* We matched a single character, the EOB, so
 			 * treat this as a final EOF.
@@ -2716,7 +2733,7 @@ static int yy_get_next_buffer (void)
 	/* Try to read more data. */
 
 	/* First move last chars to start of buffer. */
-	number_to_move = (int) ((yy_c_buf_p) - (yytext_ptr)) - 1;
+	number_to_move = (int) (yyg->yy_c_buf_p - yyg->yytext_ptr) - 1;
 
 	for ( i = 0; i < number_to_move; ++i )
 		*(dest++) = *(source++);
@@ -2725,7 +2742,7 @@ static int yy_get_next_buffer (void)
 		/* don't do the read, it's not guaranteed to return an EOF,
 		 * just force an EOF
 		 */
-		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = (yy_n_chars) = 0;
+		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = yyg->yy_n_chars = 0;
 
 	else
 		{
@@ -2739,7 +2756,7 @@ static int yy_get_next_buffer (void)
 			YY_BUFFER_STATE b = YY_CURRENT_BUFFER;
 
 			int yy_c_buf_p_offset =
-				(int) ((yy_c_buf_p) - b->yy_ch_buf);
+				(int) (yyg->yy_c_buf_p - b->yy_ch_buf);
 
 			if ( b->yy_is_our_buffer )
 				{
@@ -2752,7 +2769,7 @@ static int yy_get_next_buffer (void)
 
 				b->yy_ch_buf = (char *)
 					/* Include room in for 2 EOB chars. */
-					tokrealloc((void *) b->yy_ch_buf,b->yy_buf_size + 2  );
+					tokrealloc((void *) b->yy_ch_buf,b->yy_buf_size + 2 ,yyscanner );
 				}
 			else
 				/* Can't grow it, we don't own it. */
@@ -2762,7 +2779,7 @@ static int yy_get_next_buffer (void)
 				YY_FATAL_ERROR(
 				"fatal error - scanner input buffer overflow" );
 
-			(yy_c_buf_p) = &b->yy_ch_buf[yy_c_buf_p_offset];
+			yyg->yy_c_buf_p = &b->yy_ch_buf[yy_c_buf_p_offset];
 
 			num_to_read = YY_CURRENT_BUFFER_LVALUE->yy_buf_size -
 						number_to_move - 1;
@@ -2774,17 +2791,17 @@ static int yy_get_next_buffer (void)
 
 		/* Read in more data. */
 		YY_INPUT( (&YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[number_to_move]),
-			(yy_n_chars), num_to_read );
+			yyg->yy_n_chars, num_to_read );
 
-		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = (yy_n_chars);
+		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = yyg->yy_n_chars;
 		}
 
-	if ( (yy_n_chars) == 0 )
+	if ( yyg->yy_n_chars == 0 )
 		{
 		if ( number_to_move == YY_MORE_ADJ )
 			{
 			ret_val = EOB_ACT_END_OF_FILE;
-			tokrestart(tokin  );
+			tokrestart(yyin ,yyscanner );
 			}
 
 		else
@@ -2798,33 +2815,33 @@ static int yy_get_next_buffer (void)
 	else
 		ret_val = EOB_ACT_CONTINUE_SCAN;
 
-	if ((yy_size_t) ((yy_n_chars) + number_to_move) > YY_CURRENT_BUFFER_LVALUE->yy_buf_size) {
+	if ((yy_size_t) (yyg->yy_n_chars + number_to_move) > YY_CURRENT_BUFFER_LVALUE->yy_buf_size) {
 		/* Extend the array by 50%, plus the number we really need. */
-		yy_size_t new_size = (yy_n_chars) + number_to_move + ((yy_n_chars) >> 1);
-		YY_CURRENT_BUFFER_LVALUE->yy_ch_buf = (char *) tokrealloc((void *) YY_CURRENT_BUFFER_LVALUE->yy_ch_buf,new_size  );
+		yy_size_t new_size = yyg->yy_n_chars + number_to_move + (yyg->yy_n_chars >> 1);
+		YY_CURRENT_BUFFER_LVALUE->yy_ch_buf = (char *) tokrealloc((void *) YY_CURRENT_BUFFER_LVALUE->yy_ch_buf,new_size ,yyscanner );
 		if ( ! YY_CURRENT_BUFFER_LVALUE->yy_ch_buf )
 			YY_FATAL_ERROR( "out of dynamic memory in yy_get_next_buffer()" );
 	}
 
-	(yy_n_chars) += number_to_move;
-	YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[(yy_n_chars)] = YY_END_OF_BUFFER_CHAR;
-	YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[(yy_n_chars) + 1] = YY_END_OF_BUFFER_CHAR;
+	yyg->yy_n_chars += number_to_move;
+	YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[yyg->yy_n_chars] = YY_END_OF_BUFFER_CHAR;
+	YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[yyg->yy_n_chars + 1] = YY_END_OF_BUFFER_CHAR;
 
-	(yytext_ptr) = &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[0];
+	yyg->yytext_ptr = &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[0];
 
 	return ret_val;
 }
 
 /* yy_get_previous_state - get the state just before the EOB char was reached */
 
-    static yy_state_type yy_get_previous_state (void)
+    static yy_state_type yy_get_previous_state (yyscan_t yyscanner)
 {
 	register yy_state_type yy_current_state;
 	register char *yy_cp;
-    
-	yy_current_state = (yy_start);
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+	yy_current_state = yyg->yy_start;
 
-	for ( yy_cp = (yytext_ptr) + YY_MORE_ADJ; yy_cp < (yy_c_buf_p); ++yy_cp )
+	for ( yy_cp = yyg->yytext_ptr + YY_MORE_ADJ; yy_cp < yyg->yy_c_buf_p; ++yy_cp )
 		{
 		if ( *yy_cp )
 			{
@@ -2834,8 +2851,8 @@ static int yy_get_next_buffer (void)
 			yy_current_state = yy_NUL_trans[yy_current_state];
 		if ( yy_accept[yy_current_state] )
 			{
-			(yy_last_accepting_state) = yy_current_state;
-			(yy_last_accepting_cpos) = yy_cp;
+			yyg->yy_last_accepting_state = yy_current_state;
+			yyg->yy_last_accepting_cpos = yy_cp;
 			}
 		}
 
@@ -2847,10 +2864,11 @@ static int yy_get_next_buffer (void)
  * synopsis
  *	next_state = yy_try_NUL_trans( current_state );
  */
-    static yy_state_type yy_try_NUL_trans  (yy_state_type yy_current_state )
+    static yy_state_type yy_try_NUL_trans  (yy_state_type yy_current_state ,yyscan_t yyscanner )
 {
 	register int yy_is_jam;
-    	register char *yy_cp = (yy_c_buf_p);
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+	register char *yy_cp = yyg->yy_c_buf_p;
 
 	yy_current_state = yy_NUL_trans[yy_current_state];
 	yy_is_jam = (yy_current_state == 0);
@@ -2859,27 +2877,27 @@ static int yy_get_next_buffer (void)
 		{
 		if ( yy_accept[yy_current_state] )
 			{
-			(yy_last_accepting_state) = yy_current_state;
-			(yy_last_accepting_cpos) = yy_cp;
+			yyg->yy_last_accepting_state = yy_current_state;
+			yyg->yy_last_accepting_cpos = yy_cp;
 			}
 		}
 
 	return yy_is_jam ? 0 : yy_current_state;
 }
 
-    static void yyunput (int c, register char * yy_bp )
+    static void yyunput (int c, register char * yy_bp ,yyscan_t yyscanner )
 {
 	register char *yy_cp;
-    
-    yy_cp = (yy_c_buf_p);
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    yy_cp = yyg->yy_c_buf_p;
 
 	/* undo effects of setting up toktext */
-	*yy_cp = (yy_hold_char);
+	*yy_cp = yyg->yy_hold_char;
 
 	if ( yy_cp < YY_CURRENT_BUFFER_LVALUE->yy_ch_buf + 2 )
 		{ /* need to shift things up to make room */
 		/* +2 for EOB chars. */
-		register yy_size_t number_to_move = (yy_n_chars) + 2;
+		register yy_size_t number_to_move = yyg->yy_n_chars + 2;
 		register char *dest = &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[
 					YY_CURRENT_BUFFER_LVALUE->yy_buf_size + 2];
 		register char *source =
@@ -2891,7 +2909,7 @@ static int yy_get_next_buffer (void)
 		yy_cp += (int) (dest - source);
 		yy_bp += (int) (dest - source);
 		YY_CURRENT_BUFFER_LVALUE->yy_n_chars =
-			(yy_n_chars) = YY_CURRENT_BUFFER_LVALUE->yy_buf_size;
+			yyg->yy_n_chars = YY_CURRENT_BUFFER_LVALUE->yy_buf_size;
 
 		if ( yy_cp < YY_CURRENT_BUFFER_LVALUE->yy_ch_buf + 2 )
 			YY_FATAL_ERROR( "flex scanner push-back overflow" );
@@ -2899,39 +2917,39 @@ static int yy_get_next_buffer (void)
 
 	*--yy_cp = (char) c;
 
-	(yytext_ptr) = yy_bp;
-	(yy_hold_char) = *yy_cp;
-	(yy_c_buf_p) = yy_cp;
+	yyg->yytext_ptr = yy_bp;
+	yyg->yy_hold_char = *yy_cp;
+	yyg->yy_c_buf_p = yy_cp;
 }
 
 #ifndef YY_NO_INPUT
 #ifdef __cplusplus
-    static int yyinput (void)
+    static int yyinput (yyscan_t yyscanner)
 #else
-    static int input  (void)
+    static int input  (yyscan_t yyscanner)
 #endif
 
 {
 	int c;
-    
-	*(yy_c_buf_p) = (yy_hold_char);
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+	*yyg->yy_c_buf_p = yyg->yy_hold_char;
 
-	if ( *(yy_c_buf_p) == YY_END_OF_BUFFER_CHAR )
+	if ( *yyg->yy_c_buf_p == YY_END_OF_BUFFER_CHAR )
 		{
 		/* yy_c_buf_p now points to the character we want to return.
 		 * If this occurs *before* the EOB characters, then it's a
 		 * valid NUL; if not, then we've hit the end of the buffer.
 		 */
-		if ( (yy_c_buf_p) < &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[(yy_n_chars)] )
+		if ( yyg->yy_c_buf_p < &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[yyg->yy_n_chars] )
 			/* This was really a NUL. */
-			*(yy_c_buf_p) = '\0';
+			*yyg->yy_c_buf_p = '\0';
 
 		else
 			{ /* need more input */
-			yy_size_t offset = (yy_c_buf_p) - (yytext_ptr);
-			++(yy_c_buf_p);
+			yy_size_t offset = yyg->yy_c_buf_p - yyg->yytext_ptr;
+			++yyg->yy_c_buf_p;
 
-			switch ( yy_get_next_buffer(  ) )
+			switch ( yy_get_next_buffer(yyscanner ) )
 				{
 				case EOB_ACT_LAST_MATCH:
 					/* This happens because yy_g_n_b()
@@ -2945,34 +2963,34 @@ static int yy_get_next_buffer (void)
 					 */
 
 					/* Reset buffer status. */
-					tokrestart(tokin );
+					tokrestart(yyin ,yyscanner );
 
 					/*FALLTHROUGH*/
 
 				case EOB_ACT_END_OF_FILE:
 					{
-					if ( tokwrap( ) )
+					if ( tokwrap(yyscanner ) )
 						return 0;
 
-					if ( ! (yy_did_buffer_switch_on_eof) )
+					if ( ! yyg->yy_did_buffer_switch_on_eof )
 						YY_NEW_FILE;
 #ifdef __cplusplus
-					return yyinput();
+					return yyinput(yyscanner );
 #else
-					return input();
+					return input(yyscanner );
 #endif
 					}
 
 				case EOB_ACT_CONTINUE_SCAN:
-					(yy_c_buf_p) = (yytext_ptr) + offset;
+					yyg->yy_c_buf_p = yyg->yytext_ptr + offset;
 					break;
 				}
 			}
 		}
 
-	c = *(unsigned char *) (yy_c_buf_p);	/* cast for 8-bit char's */
-	*(yy_c_buf_p) = '\0';	/* preserve toktext */
-	(yy_hold_char) = *++(yy_c_buf_p);
+	c = *(unsigned char *) yyg->yy_c_buf_p;	/* cast for 8-bit char's */
+	*yyg->yy_c_buf_p = '\0';	/* preserve toktext */
+	yyg->yy_hold_char = *++yyg->yy_c_buf_p;
 
 	return c;
 }
@@ -2983,60 +3001,61 @@ static int yy_get_next_buffer (void)
  * 
  * @note This function does not reset the start condition to @c INITIAL .
  */
-    void tokrestart  (FILE * input_file )
+    void tokrestart  (FILE * input_file ,yyscan_t yyscanner )
 {
-    
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
 	if ( ! YY_CURRENT_BUFFER ){
-        tokensure_buffer_stack ();
+        tokensure_buffer_stack (yyscanner );
 		YY_CURRENT_BUFFER_LVALUE =
-            tok_create_buffer(tokin,YY_BUF_SIZE );
+            tok_create_buffer(yyin,YY_BUF_SIZE ,yyscanner );
 	}
 
-	tok_init_buffer(YY_CURRENT_BUFFER,input_file );
-	tok_load_buffer_state( );
+	tok_init_buffer(YY_CURRENT_BUFFER,input_file ,yyscanner );
+	tok_load_buffer_state(yyscanner );
 }
 
 /** Switch to a different input buffer.
  * @param new_buffer The new input buffer.
  * 
  */
-    void tok_switch_to_buffer  (YY_BUFFER_STATE  new_buffer )
+    void tok_switch_to_buffer  (YY_BUFFER_STATE  new_buffer ,yyscan_t yyscanner )
 {
-    
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
 	/* TODO. We should be able to replace this entire function body
 	 * with
 	 *		tokpop_buffer_state();
 	 *		tokpush_buffer_state(new_buffer);
      */
-	tokensure_buffer_stack ();
+	tokensure_buffer_stack (yyscanner );
 	if ( YY_CURRENT_BUFFER == new_buffer )
 		return;
 
 	if ( YY_CURRENT_BUFFER )
 		{
 		/* Flush out information for old buffer. */
-		*(yy_c_buf_p) = (yy_hold_char);
-		YY_CURRENT_BUFFER_LVALUE->yy_buf_pos = (yy_c_buf_p);
-		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = (yy_n_chars);
+		*yyg->yy_c_buf_p = yyg->yy_hold_char;
+		YY_CURRENT_BUFFER_LVALUE->yy_buf_pos = yyg->yy_c_buf_p;
+		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = yyg->yy_n_chars;
 		}
 
 	YY_CURRENT_BUFFER_LVALUE = new_buffer;
-	tok_load_buffer_state( );
+	tok_load_buffer_state(yyscanner );
 
 	/* We don't actually know whether we did this switch during
 	 * EOF (tokwrap()) processing, but the only time this flag
 	 * is looked at is after tokwrap() is called, so it's safe
 	 * to go ahead and always set it.
 	 */
-	(yy_did_buffer_switch_on_eof) = 1;
+	yyg->yy_did_buffer_switch_on_eof = 1;
 }
 
-static void tok_load_buffer_state  (void)
+static void tok_load_buffer_state  (yyscan_t yyscanner)
 {
-    	(yy_n_chars) = YY_CURRENT_BUFFER_LVALUE->yy_n_chars;
-	(yytext_ptr) = (yy_c_buf_p) = YY_CURRENT_BUFFER_LVALUE->yy_buf_pos;
-	tokin = YY_CURRENT_BUFFER_LVALUE->yy_input_file;
-	(yy_hold_char) = *(yy_c_buf_p);
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+	yyg->yy_n_chars = YY_CURRENT_BUFFER_LVALUE->yy_n_chars;
+	yyg->yytext_ptr = yyg->yy_c_buf_p = YY_CURRENT_BUFFER_LVALUE->yy_buf_pos;
+	yyin = YY_CURRENT_BUFFER_LVALUE->yy_input_file;
+	yyg->yy_hold_char = *yyg->yy_c_buf_p;
 }
 
 /** Allocate and initialize an input buffer state.
@@ -3045,11 +3064,11 @@ static void tok_load_buffer_state  (void)
  * 
  * @return the allocated buffer state.
  */
-    YY_BUFFER_STATE tok_create_buffer  (FILE * file, int  size )
+    YY_BUFFER_STATE tok_create_buffer  (FILE * file, int  size ,yyscan_t yyscanner )
 {
 	YY_BUFFER_STATE b;
-    
-	b = (YY_BUFFER_STATE) tokalloc(sizeof( struct yy_buffer_state )  );
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+	b = (YY_BUFFER_STATE) tokalloc(sizeof( struct yy_buffer_state ) ,yyscanner );
 	if ( ! b )
 		YY_FATAL_ERROR( "out of dynamic memory in tok_create_buffer()" );
 
@@ -3058,13 +3077,13 @@ static void tok_load_buffer_state  (void)
 	/* yy_ch_buf has to be 2 characters longer than the size given because
 	 * we need to put in 2 end-of-buffer characters.
 	 */
-	b->yy_ch_buf = (char *) tokalloc(b->yy_buf_size + 2  );
+	b->yy_ch_buf = (char *) tokalloc(b->yy_buf_size + 2 ,yyscanner );
 	if ( ! b->yy_ch_buf )
 		YY_FATAL_ERROR( "out of dynamic memory in tok_create_buffer()" );
 
 	b->yy_is_our_buffer = 1;
 
-	tok_init_buffer(b,file );
+	tok_init_buffer(b,file ,yyscanner );
 
 	return b;
 }
@@ -3073,9 +3092,9 @@ static void tok_load_buffer_state  (void)
  * @param b a buffer created with tok_create_buffer()
  * 
  */
-    void tok_delete_buffer (YY_BUFFER_STATE  b )
+    void tok_delete_buffer (YY_BUFFER_STATE  b ,yyscan_t yyscanner )
 {
-    
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
 	if ( ! b )
 		return;
 
@@ -3083,21 +3102,21 @@ static void tok_load_buffer_state  (void)
 		YY_CURRENT_BUFFER_LVALUE = (YY_BUFFER_STATE) 0;
 
 	if ( b->yy_is_our_buffer )
-		tokfree((void *) b->yy_ch_buf  );
+		tokfree((void *) b->yy_ch_buf ,yyscanner );
 
-	tokfree((void *) b  );
+	tokfree((void *) b ,yyscanner );
 }
 
 /* Initializes or reinitializes a buffer.
  * This function is sometimes called more than once on the same buffer,
  * such as during a tokrestart() or at EOF.
  */
-    static void tok_init_buffer  (YY_BUFFER_STATE  b, FILE * file )
+    static void tok_init_buffer  (YY_BUFFER_STATE  b, FILE * file ,yyscan_t yyscanner )
 
 {
 	int oerrno = errno;
-    
-	tok_flush_buffer(b );
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+	tok_flush_buffer(b ,yyscanner );
 
 	b->yy_input_file = file;
 	b->yy_fill_buffer = 1;
@@ -3120,9 +3139,10 @@ static void tok_load_buffer_state  (void)
  * @param b the buffer state to be flushed, usually @c YY_CURRENT_BUFFER.
  * 
  */
-    void tok_flush_buffer (YY_BUFFER_STATE  b )
+    void tok_flush_buffer (YY_BUFFER_STATE  b ,yyscan_t yyscanner )
 {
-    	if ( ! b )
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+	if ( ! b )
 		return;
 
 	b->yy_n_chars = 0;
@@ -3140,7 +3160,7 @@ static void tok_load_buffer_state  (void)
 	b->yy_buffer_status = YY_BUFFER_NEW;
 
 	if ( b == YY_CURRENT_BUFFER )
-		tok_load_buffer_state( );
+		tok_load_buffer_state(yyscanner );
 }
 
 /** Pushes the new state onto the stack. The new state becomes
@@ -3149,95 +3169,95 @@ static void tok_load_buffer_state  (void)
  *  @param new_buffer The new state.
  *  
  */
-void tokpush_buffer_state (YY_BUFFER_STATE new_buffer )
+void tokpush_buffer_state (YY_BUFFER_STATE new_buffer ,yyscan_t yyscanner )
 {
-    	if (new_buffer == NULL)
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+	if (new_buffer == NULL)
 		return;
 
-	tokensure_buffer_stack();
+	tokensure_buffer_stack(yyscanner );
 
 	/* This block is copied from tok_switch_to_buffer. */
 	if ( YY_CURRENT_BUFFER )
 		{
 		/* Flush out information for old buffer. */
-		*(yy_c_buf_p) = (yy_hold_char);
-		YY_CURRENT_BUFFER_LVALUE->yy_buf_pos = (yy_c_buf_p);
-		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = (yy_n_chars);
+		*yyg->yy_c_buf_p = yyg->yy_hold_char;
+		YY_CURRENT_BUFFER_LVALUE->yy_buf_pos = yyg->yy_c_buf_p;
+		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = yyg->yy_n_chars;
 		}
 
 	/* Only push if top exists. Otherwise, replace top. */
 	if (YY_CURRENT_BUFFER)
-		(yy_buffer_stack_top)++;
+		yyg->yy_buffer_stack_top++;
 	YY_CURRENT_BUFFER_LVALUE = new_buffer;
 
 	/* copied from tok_switch_to_buffer. */
-	tok_load_buffer_state( );
-	(yy_did_buffer_switch_on_eof) = 1;
+	tok_load_buffer_state(yyscanner );
+	yyg->yy_did_buffer_switch_on_eof = 1;
 }
 
 /** Removes and deletes the top of the stack, if present.
  *  The next element becomes the new top.
  *  
  */
-void tokpop_buffer_state (void)
+void tokpop_buffer_state (yyscan_t yyscanner)
 {
-    	if (!YY_CURRENT_BUFFER)
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+	if (!YY_CURRENT_BUFFER)
 		return;
 
-	tok_delete_buffer(YY_CURRENT_BUFFER );
+	tok_delete_buffer(YY_CURRENT_BUFFER ,yyscanner );
 	YY_CURRENT_BUFFER_LVALUE = NULL;
-	if ((yy_buffer_stack_top) > 0)
-		--(yy_buffer_stack_top);
+	if (yyg->yy_buffer_stack_top > 0)
+		--yyg->yy_buffer_stack_top;
 
 	if (YY_CURRENT_BUFFER) {
-		tok_load_buffer_state( );
-		(yy_did_buffer_switch_on_eof) = 1;
+		tok_load_buffer_state(yyscanner );
+		yyg->yy_did_buffer_switch_on_eof = 1;
 	}
 }
 
 /* Allocates the stack if it does not exist.
  *  Guarantees space for at least one push.
  */
-static void tokensure_buffer_stack (void)
+static void tokensure_buffer_stack (yyscan_t yyscanner)
 {
 	yy_size_t num_to_alloc;
-    
-	if (!(yy_buffer_stack)) {
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+	if (!yyg->yy_buffer_stack) {
 
 		/* First allocation is just for 2 elements, since we don't know if this
 		 * scanner will even need a stack. We use 2 instead of 1 to avoid an
 		 * immediate realloc on the next call.
          */
 		num_to_alloc = 1;
-		(yy_buffer_stack) = (struct yy_buffer_state**)tokalloc
-								(num_to_alloc * sizeof(struct yy_buffer_state*)
-								);
-		if ( ! (yy_buffer_stack) )
+		yyg->yy_buffer_stack = (struct yy_buffer_state**)tokalloc
+								(num_to_alloc * sizeof(struct yy_buffer_state*) ,yyscanner );
+		if ( ! yyg->yy_buffer_stack )
 			YY_FATAL_ERROR( "out of dynamic memory in tokensure_buffer_stack()" );
 								  
-		memset((yy_buffer_stack), 0, num_to_alloc * sizeof(struct yy_buffer_state*));
+		memset(yyg->yy_buffer_stack, 0, num_to_alloc * sizeof(struct yy_buffer_state*));
 				
-		(yy_buffer_stack_max) = num_to_alloc;
-		(yy_buffer_stack_top) = 0;
+		yyg->yy_buffer_stack_max = num_to_alloc;
+		yyg->yy_buffer_stack_top = 0;
 		return;
 	}
 
-	if ((yy_buffer_stack_top) >= ((yy_buffer_stack_max)) - 1){
+	if (yyg->yy_buffer_stack_top >= (yyg->yy_buffer_stack_max) - 1){
 
 		/* Increase the buffer to prepare for a possible push. */
 		int grow_size = 8 /* arbitrary grow size */;
 
-		num_to_alloc = (yy_buffer_stack_max) + grow_size;
-		(yy_buffer_stack) = (struct yy_buffer_state**)tokrealloc
-								((yy_buffer_stack),
-								num_to_alloc * sizeof(struct yy_buffer_state*)
-								);
-		if ( ! (yy_buffer_stack) )
+		num_to_alloc = yyg->yy_buffer_stack_max + grow_size;
+		yyg->yy_buffer_stack = (struct yy_buffer_state**)tokrealloc
+								(yyg->yy_buffer_stack,
+								num_to_alloc * sizeof(struct yy_buffer_state*) ,yyscanner );
+		if ( ! yyg->yy_buffer_stack )
 			YY_FATAL_ERROR( "out of dynamic memory in tokensure_buffer_stack()" );
 
 		/* zero only the new slots.*/
-		memset((yy_buffer_stack) + (yy_buffer_stack_max), 0, grow_size * sizeof(struct yy_buffer_state*));
-		(yy_buffer_stack_max) = num_to_alloc;
+		memset(yyg->yy_buffer_stack + yyg->yy_buffer_stack_max, 0, grow_size * sizeof(struct yy_buffer_state*));
+		yyg->yy_buffer_stack_max = num_to_alloc;
 	}
 }
 
@@ -3247,17 +3267,17 @@ static void tokensure_buffer_stack (void)
  * 
  * @return the newly allocated buffer state object. 
  */
-YY_BUFFER_STATE tok_scan_buffer  (char * base, yy_size_t  size )
+YY_BUFFER_STATE tok_scan_buffer  (char * base, yy_size_t  size ,yyscan_t yyscanner )
 {
 	YY_BUFFER_STATE b;
-    
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
 	if ( size < 2 ||
 	     base[size-2] != YY_END_OF_BUFFER_CHAR ||
 	     base[size-1] != YY_END_OF_BUFFER_CHAR )
 		/* They forgot to leave room for the EOB's. */
 		return 0;
 
-	b = (YY_BUFFER_STATE) tokalloc(sizeof( struct yy_buffer_state )  );
+	b = (YY_BUFFER_STATE) tokalloc(sizeof( struct yy_buffer_state ) ,yyscanner );
 	if ( ! b )
 		YY_FATAL_ERROR( "out of dynamic memory in tok_scan_buffer()" );
 
@@ -3271,7 +3291,7 @@ YY_BUFFER_STATE tok_scan_buffer  (char * base, yy_size_t  size )
 	b->yy_fill_buffer = 0;
 	b->yy_buffer_status = YY_BUFFER_NEW;
 
-	tok_switch_to_buffer(b  );
+	tok_switch_to_buffer(b ,yyscanner );
 
 	return b;
 }
@@ -3284,10 +3304,10 @@ YY_BUFFER_STATE tok_scan_buffer  (char * base, yy_size_t  size )
  * @note If you want to scan bytes that may contain NUL values, then use
  *       tok_scan_bytes() instead.
  */
-YY_BUFFER_STATE tok_scan_string (yyconst char * yystr )
+YY_BUFFER_STATE tok_scan_string (yyconst char * yystr ,yyscan_t yyscanner )
 {
     
-	return tok_scan_bytes(yystr,strlen(yystr) );
+	return tok_scan_bytes(yystr,strlen(yystr) ,yyscanner );
 }
 
 /** Setup the input buffer state to scan the given bytes. The next call to toklex() will
@@ -3297,15 +3317,15 @@ YY_BUFFER_STATE tok_scan_string (yyconst char * yystr )
  * 
  * @return the newly allocated buffer state object.
  */
-YY_BUFFER_STATE tok_scan_bytes  (yyconst char * yybytes, yy_size_t  _yybytes_len )
+YY_BUFFER_STATE tok_scan_bytes  (yyconst char * yybytes, yy_size_t  _yybytes_len ,yyscan_t yyscanner )
 {
 	YY_BUFFER_STATE b;
 	char *buf;
 	yy_size_t n, i;
-    
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
 	/* Get memory for full buffer, including space for trailing EOB's. */
 	n = _yybytes_len + 2;
-	buf = (char *) tokalloc(n  );
+	buf = (char *) tokalloc(n ,yyscanner );
 	if ( ! buf )
 		YY_FATAL_ERROR( "out of dynamic memory in tok_scan_bytes()" );
 
@@ -3314,7 +3334,7 @@ YY_BUFFER_STATE tok_scan_bytes  (yyconst char * yybytes, yy_size_t  _yybytes_len
 
 	buf[_yybytes_len] = buf[_yybytes_len+1] = YY_END_OF_BUFFER_CHAR;
 
-	b = tok_scan_buffer(buf,n );
+	b = tok_scan_buffer(buf,n ,yyscanner );
 	if ( ! b )
 		YY_FATAL_ERROR( "bad buffer in tok_scan_bytes()" );
 
@@ -3330,9 +3350,10 @@ YY_BUFFER_STATE tok_scan_bytes  (yyconst char * yybytes, yy_size_t  _yybytes_len
 #define YY_EXIT_FAILURE 2
 #endif
 
-static void yy_fatal_error (yyconst char* msg )
+static void yy_fatal_error (yyconst char* msg ,yyscan_t yyscanner )
 {
-    	(void) fprintf( stderr, "%s\n", msg );
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+	(void) fprintf( stderr, "%s\n", msg );
 	exit( YY_EXIT_FAILURE );
 }
 
@@ -3345,66 +3366,126 @@ static void yy_fatal_error (yyconst char* msg )
 		/* Undo effects of setting up toktext. */ \
         int yyless_macro_arg = (n); \
         YY_LESS_LINENO(yyless_macro_arg);\
-		toktext[tokleng] = (yy_hold_char); \
-		(yy_c_buf_p) = toktext + yyless_macro_arg; \
-		(yy_hold_char) = *(yy_c_buf_p); \
-		*(yy_c_buf_p) = '\0'; \
-		tokleng = yyless_macro_arg; \
+		yytext[yyleng] = yyg->yy_hold_char; \
+		yyg->yy_c_buf_p = yytext + yyless_macro_arg; \
+		yyg->yy_hold_char = *yyg->yy_c_buf_p; \
+		*yyg->yy_c_buf_p = '\0'; \
+		yyleng = yyless_macro_arg; \
 		} \
 	while ( 0 )
 
 /* Accessor  methods (get/set functions) to struct members. */
 
+/** Get the user-defined data for this scanner.
+ * @param yyscanner The scanner object.
+ */
+YY_EXTRA_TYPE tokget_extra  (yyscan_t yyscanner)
+{
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    return yyextra;
+}
+
 /** Get the current line number.
- * 
+ * @param yyscanner The scanner object.
  */
-int tokget_lineno  (void)
+int tokget_lineno  (yyscan_t yyscanner)
 {
-        
-    return toklineno;
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    
+        if (! YY_CURRENT_BUFFER)
+            return 0;
+    
+    return yylineno;
+}
+
+/** Get the current column number.
+ * @param yyscanner The scanner object.
+ */
+int tokget_column  (yyscan_t yyscanner)
+{
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    
+        if (! YY_CURRENT_BUFFER)
+            return 0;
+    
+    return yycolumn;
 }
 
 /** Get the input stream.
  * 
  */
-FILE *tokget_in  (void)
+FILE *tokget_in  (yyscan_t yyscanner)
 {
-        return tokin;
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    return yyin;
 }
 
 /** Get the output stream.
  * 
  */
-FILE *tokget_out  (void)
+FILE *tokget_out  (yyscan_t yyscanner)
 {
-        return tokout;
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    return yyout;
 }
 
 /** Get the length of the current token.
  * 
  */
-yy_size_t tokget_leng  (void)
+yy_size_t tokget_leng  (yyscan_t yyscanner)
 {
-        return tokleng;
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    return yyleng;
 }
 
 /** Get the current token.
  * 
  */
 
-char *tokget_text  (void)
+char *tokget_text  (yyscan_t yyscanner)
 {
-        return toktext;
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    return yytext;
+}
+
+/** Set the user-defined data. This data is never touched by the scanner.
+ * @param user_defined The data to be associated with this scanner.
+ * @param yyscanner The scanner object.
+ */
+void tokset_extra (YY_EXTRA_TYPE  user_defined ,yyscan_t yyscanner )
+{
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    yyextra = user_defined ;
 }
 
 /** Set the current line number.
  * @param line_number
- * 
+ * @param yyscanner The scanner object.
+ */
+void tokset_lineno (int  line_number ,yyscan_t yyscanner )
+{
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+
+        /* lineno is only valid if an input buffer exists. */
+        if (! YY_CURRENT_BUFFER )
+           yy_fatal_error( "tokset_lineno called with no buffer" , yyscanner); 
+    
+    yylineno = line_number;
+}
+
+/** Set the current column.
+ * @param column_no
+ * @param yyscanner The scanner object.
  */
-void tokset_lineno (int  line_number )
+void tokset_column (int  column_no ,yyscan_t yyscanner )
 {
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+
+        /* column is only valid if an input buffer exists. */
+        if (! YY_CURRENT_BUFFER )
+           yy_fatal_error( "tokset_column called with no buffer" , yyscanner); 
     
-    toklineno = line_number;
+    yycolumn = column_no;
 }
 
 /** Set the input stream. This does not discard the current
@@ -3413,46 +3494,121 @@ void tokset_lineno (int  line_number )
  * 
  * @see tok_switch_to_buffer
  */
-void tokset_in (FILE *  in_str )
+void tokset_in (FILE *  in_str ,yyscan_t yyscanner )
+{
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    yyin = in_str ;
+}
+
+void tokset_out (FILE *  out_str ,yyscan_t yyscanner )
+{
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    yyout = out_str ;
+}
+
+int tokget_debug  (yyscan_t yyscanner)
 {
-        tokin = in_str ;
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    return yy_flex_debug;
 }
 
-void tokset_out (FILE *  out_str )
+void tokset_debug (int  bdebug ,yyscan_t yyscanner )
 {
-        tokout = out_str ;
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    yy_flex_debug = bdebug ;
 }
 
-int tokget_debug  (void)
+/* Accessor methods for yylval and yylloc */
+
+/* User-visible API */
+
+/* toklex_init is special because it creates the scanner itself, so it is
+ * the ONLY reentrant function that doesn't take the scanner as the last argument.
+ * That's why we explicitly handle the declaration, instead of using our macros.
+ */
+
+int toklex_init(yyscan_t* ptr_yy_globals)
+
 {
-        return tok_flex_debug;
+    if (ptr_yy_globals == NULL){
+        errno = EINVAL;
+        return 1;
+    }
+
+    *ptr_yy_globals = (yyscan_t) tokalloc ( sizeof( struct yyguts_t ), NULL );
+
+    if (*ptr_yy_globals == NULL){
+        errno = ENOMEM;
+        return 1;
+    }
+
+    /* By setting to 0xAA, we expose bugs in yy_init_globals. Leave at 0x00 for releases. */
+    memset(*ptr_yy_globals,0x00,sizeof(struct yyguts_t));
+
+    return yy_init_globals ( *ptr_yy_globals );
 }
 
-void tokset_debug (int  bdebug )
+/* toklex_init_extra has the same functionality as toklex_init, but follows the
+ * convention of taking the scanner as the last argument. Note however, that
+ * this is a *pointer* to a scanner, as it will be allocated by this call (and
+ * is the reason, too, why this function also must handle its own declaration).
+ * The user defined value in the first argument will be available to tokalloc in
+ * the yyextra field.
+ */
+
+int toklex_init_extra(YY_EXTRA_TYPE yy_user_defined,yyscan_t* ptr_yy_globals )
+
 {
-        tok_flex_debug = bdebug ;
+    struct yyguts_t dummy_yyguts;
+
+    tokset_extra (yy_user_defined, &dummy_yyguts);
+
+    if (ptr_yy_globals == NULL){
+        errno = EINVAL;
+        return 1;
+    }
+	
+    *ptr_yy_globals = (yyscan_t) tokalloc ( sizeof( struct yyguts_t ), &dummy_yyguts );
+	
+    if (*ptr_yy_globals == NULL){
+        errno = ENOMEM;
+        return 1;
+    }
+    
+    /* By setting to 0xAA, we expose bugs in
+    yy_init_globals. Leave at 0x00 for releases. */
+    memset(*ptr_yy_globals,0x00,sizeof(struct yyguts_t));
+    
+    tokset_extra (yy_user_defined, *ptr_yy_globals);
+    
+    return yy_init_globals ( *ptr_yy_globals );
 }
 
-static int yy_init_globals (void)
+static int yy_init_globals (yyscan_t yyscanner)
 {
-        /* Initialization is the same as for the non-reentrant scanner.
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    /* Initialization is the same as for the non-reentrant scanner.
      * This function is called from toklex_destroy(), so don't allocate here.
      */
 
-    (yy_buffer_stack) = 0;
-    (yy_buffer_stack_top) = 0;
-    (yy_buffer_stack_max) = 0;
-    (yy_c_buf_p) = (char *) 0;
-    (yy_init) = 0;
-    (yy_start) = 0;
+    yyg->yy_buffer_stack = 0;
+    yyg->yy_buffer_stack_top = 0;
+    yyg->yy_buffer_stack_max = 0;
+    yyg->yy_c_buf_p = (char *) 0;
+    yyg->yy_init = 0;
+    yyg->yy_start = 0;
+
+    yyg->yy_start_stack_ptr = 0;
+    yyg->yy_start_stack_depth = 0;
+    yyg->yy_start_stack =  NULL;
 
 /* Defined in main.c */
 #ifdef YY_STDINIT
-    tokin = stdin;
-    tokout = stdout;
+    yyin = stdin;
+    yyout = stdout;
 #else
-    tokin = (FILE *) 0;
-    tokout = (FILE *) 0;
+    yyin = (FILE *) 0;
+    yyout = (FILE *) 0;
 #endif
 
     /* For future reference: Set errno on error, since we are called by
@@ -3462,24 +3618,31 @@ static int yy_init_globals (void)
 }
 
 /* toklex_destroy is for both reentrant and non-reentrant scanners. */
-int toklex_destroy  (void)
+int toklex_destroy  (yyscan_t yyscanner)
 {
-    
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
     /* Pop the buffer stack, destroying each element. */
 	while(YY_CURRENT_BUFFER){
-		tok_delete_buffer(YY_CURRENT_BUFFER  );
+		tok_delete_buffer(YY_CURRENT_BUFFER ,yyscanner );
 		YY_CURRENT_BUFFER_LVALUE = NULL;
-		tokpop_buffer_state();
+		tokpop_buffer_state(yyscanner );
 	}
 
 	/* Destroy the stack itself. */
-	tokfree((yy_buffer_stack) );
-	(yy_buffer_stack) = NULL;
+	tokfree(yyg->yy_buffer_stack ,yyscanner );
+	yyg->yy_buffer_stack = NULL;
+
+    /* Destroy the start condition stack. */
+        tokfree(yyg->yy_start_stack ,yyscanner );
+        yyg->yy_start_stack = NULL;
 
     /* Reset the globals. This is important in a non-reentrant scanner so the next time
      * toklex() is called, initialization will occur. */
-    yy_init_globals( );
+    yy_init_globals( yyscanner);
 
+    /* Destroy the main struct (reentrant only). */
+    tokfree ( yyscanner , yyscanner );
+    yyscanner = NULL;
     return 0;
 }
 
@@ -3488,7 +3651,7 @@ int toklex_destroy  (void)
  */
 
 #ifndef yytext_ptr
-static void yy_flex_strncpy (char* s1, yyconst char * s2, int n )
+static void yy_flex_strncpy (char* s1, yyconst char * s2, int n ,yyscan_t yyscanner )
 {
 	register int i;
 	for ( i = 0; i < n; ++i )
@@ -3497,7 +3660,7 @@ static void yy_flex_strncpy (char* s1, yyconst char * s2, int n )
 #endif
 
 #ifdef YY_NEED_STRLEN
-static int yy_flex_strlen (yyconst char * s )
+static int yy_flex_strlen (yyconst char * s ,yyscan_t yyscanner )
 {
 	register int n;
 	for ( n = 0; s[n]; ++n )
@@ -3507,12 +3670,12 @@ static int yy_flex_strlen (yyconst char * s )
 }
 #endif
 
-void *tokalloc (yy_size_t  size )
+void *tokalloc (yy_size_t  size ,yyscan_t yyscanner )
 {
 	return (void *) malloc( size );
 }
 
-void *tokrealloc  (void * ptr, yy_size_t  size )
+void *tokrealloc  (void * ptr, yy_size_t  size ,yyscan_t yyscanner )
 {
 	/* The cast to (char *) in the following accommodates both
 	 * implementations that use char* generic pointers, and those
@@ -3524,18 +3687,31 @@ void *tokrealloc  (void * ptr, yy_size_t  size )
 	return (void *) realloc( (char *) ptr, size );
 }
 
-void tokfree (void * ptr )
+void tokfree (void * ptr ,yyscan_t yyscanner )
 {
 	free( (char *) ptr );	/* see tokrealloc() for (char *) cast */
 }
 
 #define YYTABLES_NAME "yytables"
 
-#line 63 "../src/TextTokenizer.l"
+#line 65 "../src/TextTokenizer.l"
+
 
 
+// Starts a document in the initial state, whatever state the last one ended in.
+static void tok_begin_document( yyscan_t yyscanner ) {
+  struct yyguts_t* yyg = (struct yyguts_t*) yyscanner;
+  BEGIN(INITIAL);
+}
+
+indri::parse::TextTokenizer::~TextTokenizer() {
+  if ( _scanner )
+    toklex_destroy( _scanner );
+}
 
 indri::parse::TokenizedDocument* indri::parse::TextTokenizer::tokenize( indri::parse::UnparsedDocument* document ) {
+  if ( !_scanner )
+    toklex_init_extra( &_bytePosition, &_scanner );
 
   _termBuffer.clear();
   if ( _tokenize_entire_words)
@@ -3553,17 +3729,20 @@ indri::parse::TokenizedDocument* indri::parse::TextTokenizer::tokenize( indri::p
   _document.content = document->content;
   _document.contentLength = document->contentLength;
 
-  BEGIN(INITIAL);
+  tok_begin_document( _scanner );
   // byte offset
-  byte_position = document->content - document->text;
+  _bytePosition = document->content - document->text;
 
-  tok_scan_bytes( document->content, document->contentLength );
+  YY_BUFFER_STATE buffer = tok_scan_bytes( document->content, document->contentLength, _scanner );
 
   // Main Tokenizer loop
 
   int type;
 
-  while ( (type = toklex()) ) {
+  while ( (type = toklex( _scanner )) ) {
+
+    _token = tokget_text( _scanner );
+    _tokenLength = (int) tokget_leng( _scanner );
 
     switch ( type ) {
 
@@ -3581,7 +3760,7 @@ indri::parse::TokenizedDocument* indri::parse::TextTokenizer::tokenize( indri::p
 
   }
 
-  tok_delete_buffer( YY_CURRENT_BUFFER );
+  tok_delete_buffer( buffer, _scanner );
 
   return &_document;
 }
@@ -3592,20 +3771,20 @@ indri::parse::TokenizedDocument* indri::parse::TextTokenizer::tokenize( indri::p
 void indri::parse::TextTokenizer::processTag() {
 
   // Here, we parse the tag in a fashion that is relatively robust to
-  // malformed markup.  toktext matches this pattern: <[^>]+>
+  // malformed markup.  _token matches this pattern: <[^>]+>
 
-  if ( toktext[1] == '?' || toktext[1] == '!' ) { 
+  if ( _token[1] == '?' || _token[1] == '!' ) { 
     
     // XML declaration like <? ... ?> and <!DOCTYPE ... >
     return; // ignore
 
-  } else if ( toktext[1] == '/' ) { // close tag, eg. </FOO>
+  } else if ( _token[1] == '/' ) { // close tag, eg. </FOO>
 
     // Downcase the tag name.
 
     int len = 0;
 
-    for ( char *c = toktext + 2; 
+    for ( char *c = _token + 2; 
 #ifndef WIN32
           isalnum( *c ) || *c == '-' || *c == '_' || *c == ':' ; c++ ) {
 #else
@@ -3623,29 +3802,29 @@ void indri::parse::TextTokenizer::processTag() {
 
     // We need to write len characters, plus a NULL
     char* write_loc = _termBuffer.write( len + 1 );
-    strncpy( write_loc, toktext + 2, len );
+    strncpy( write_loc, _token + 2, len );
     write_loc[len] = '\0';
     te.name = write_loc;
 
     // token position of tag event w/r/t token string
     te.pos = _document.terms.size();
 
-    te.begin = byte_position - tokleng;
-    te.end = byte_position;
+    te.begin = _bytePosition - _tokenLength;
+    te.end = _bytePosition;
 
     _document.tags.push_back( te );
     
 #ifndef WIN32
-    } else if ( isalpha( toktext[1] ) ) {
+    } else if ( isalpha( _token[1] ) ) {
 #else
-    } else if ( (toktext[1]  >= 0) && (isalpha( toktext[1] ) )) {
+    } else if ( (_token[1]  >= 0) && (isalpha( _token[1] ) )) {
 #endif
 
     // Try to extract the tag name:
 
-    char* c = toktext + 1;
+    char* c = _token + 1;
     int i = 0;
-    int offset = 1; // current offset w/r/t byte_position - tokleng
+    int offset = 1; // current offset w/r/t _bytePosition - _tokenLength
     // it starts at one because it is incremented when c is, and c starts at one.
     char* write_loc;
 
@@ -3676,8 +3855,8 @@ void indri::parse::TextTokenizer::processTag() {
 
       te.pos = _document.terms.size();
 
-      te.begin = byte_position - tokleng;
-      te.end = byte_position;
+      te.begin = _bytePosition - _tokenLength;
+      te.end = _bytePosition;
       
       _document.tags.push_back( te );
 
@@ -3715,8 +3894,8 @@ void indri::parse::TextTokenizer::processTag() {
 
       te.pos = _document.terms.size();
 
-      te.begin = byte_position - tokleng;
-      te.end = byte_position;
+      te.begin = _bytePosition - _tokenLength;
+      te.end = _bytePosition;
 
       // Now search for attributes:
 
@@ -3776,8 +3955,8 @@ void indri::parse::TextTokenizer::processTag() {
             write_loc = _termBuffer.write( 1 );
             write_loc[0] = '\0';
             avp.value = write_loc;
-            avp.begin = byte_position - tokleng + offset;
-            avp.end = byte_position - tokleng + offset;
+            avp.begin = _bytePosition - _tokenLength + offset;
+            avp.end = _bytePosition - _tokenLength + offset;
 
           } else {
 
@@ -3805,8 +3984,8 @@ void indri::parse::TextTokenizer::processTag() {
             strncpy( write_loc, c, i );
             write_loc[i] = '\0';
             avp.value = write_loc;
-            avp.begin = byte_position - tokleng + offset;
-            avp.end = byte_position - tokleng + offset + i;
+            avp.begin = _bytePosition - _tokenLength + offset;
+            avp.end = _bytePosition - _tokenLength + offset + i;
             c += i;
             offset += i;
 
@@ -3818,8 +3997,8 @@ void indri::parse::TextTokenizer::processTag() {
           write_loc = _termBuffer.write( 1 );
           write_loc[0] = '\0';
           avp.value = write_loc;
-          avp.begin = byte_position - tokleng + offset;
-          avp.end = byte_position - tokleng + offset;
+          avp.begin = _bytePosition - _tokenLength + offset;
+          avp.end = _bytePosition - _tokenLength + offset;
         }
 #ifndef WIN32
         while ( isspace( *c ) || *c == '"' ) { c++; offset++; }
@@ -3850,20 +4029,20 @@ void indri::parse::TextTokenizer::processUTF8Token() {
 
   indri::utility::HashTable<UINT64,const int>& unicode = _transcoder.unicode();
 
-  int len = strlen( toktext );
+  int len = strlen( _token );
 
   UINT64* unicode_chars = new UINT64[len + 1];
   int* offsets = new int[len + 1];
   int* lengths = new int[len + 1];
-  _transcoder.utf8_decode( toktext, &unicode_chars, NULL, NULL,
+  _transcoder.utf8_decode( _token, &unicode_chars, NULL, NULL,
                            &offsets, &lengths );
 
   const int* p;
   int cls;             // Character class of current UTF-8 character
-  // offset of current UTF-8 character w/r/t toktext stored in offsets[i]
+  // offset of current UTF-8 character w/r/t _token stored in offsets[i]
   // byte length of current UTF-8 character stored in lengths[i]
 
-  int offset = 0;      // Position of start of current *token* (not character) w/r/t toktext
+  int offset = 0;      // Position of start of current *token* (not character) w/r/t _token
   int extent = 0;      // Extent for this *token* including trailing punct
   int token_len = 0;   // Same as above, minus the trailing punctuation
 
@@ -3886,15 +4065,15 @@ void indri::parse::TextTokenizer::processUTF8Token() {
 
       if ( cls != 0 && cls != 3 && cls != 5 && cls != 9 ) {
 
-        writeToken( toktext + offsets[i], lengths[i],
-                    byte_position - tokleng + offsets[i], 
-                    byte_position - tokleng + offsets[i] + lengths[i] );
+        writeToken( _token + offsets[i], lengths[i],
+                    _bytePosition - _tokenLength + offsets[i], 
+                    _bytePosition - _tokenLength + offsets[i] + lengths[i] );
       }
       continue;
     }
 
     // If this is not the first time through this loop, we need
-    // to check to see if any bytes in toktext were skipped 
+    // to check to see if any bytes in _token were skipped 
     // during the UTF-8 analysis:
 
     if ( i != 0 && offset + token_len != offsets[i] ) {
@@ -3903,9 +4082,9 @@ void indri::parse::TextTokenizer::processUTF8Token() {
 
       if ( token_len > 0 ) {
 
-        writeToken( toktext + offset, token_len,
-                    byte_position - tokleng + offset,
-                    byte_position - tokleng + offset + extent );
+        writeToken( _token + offset, token_len,
+                    _bytePosition - _tokenLength + offset,
+                    _bytePosition - _tokenLength + offset + extent );
       }
 
       extent = 0;
@@ -3921,15 +4100,15 @@ void indri::parse::TextTokenizer::processUTF8Token() {
     case 4: // Currency symbol: always extracted alone
       // Action: write the token we are working on,
       // and write this symbol as a separate token
-      writeToken( toktext + offset, extent,
-                  byte_position - tokleng + offset,
-                  byte_position - tokleng + offset + extent );
+      writeToken( _token + offset, extent,
+                  _bytePosition - _tokenLength + offset,
+                  _bytePosition - _tokenLength + offset + extent );
 
       offset += extent;
 
-      writeToken( toktext + offset, lengths[i], 
-                  byte_position - tokleng + offset, 
-                  byte_position - tokleng + offset + lengths[i] );
+      writeToken( _token + offset, lengths[i], 
+                  _bytePosition - _tokenLength + offset, 
+                  _bytePosition - _tokenLength + offset + lengths[i] );
 
       offset += lengths[i];
       token_len = 0;
@@ -3944,9 +4123,9 @@ void indri::parse::TextTokenizer::processUTF8Token() {
       // Action: add this character to the end of the token we are
       // working on
       if ( no_letter ) { // This is a token boundary
-        writeToken( toktext + offset, token_len,
-                    byte_position - tokleng + offset,
-                    byte_position - tokleng + offset + extent );
+        writeToken( _token + offset, token_len,
+                    _bytePosition - _tokenLength + offset,
+                    _bytePosition - _tokenLength + offset + extent );
 
         offset += extent;
         extent = 0;
@@ -3976,9 +4155,9 @@ void indri::parse::TextTokenizer::processUTF8Token() {
     default:
       // Action: write the token we are working on.  Do not include
       // this character in any future token.
-      writeToken( toktext + offset, token_len,
-                  byte_position - tokleng + offset,
-                  byte_position - tokleng + offset + extent );
+      writeToken( _token + offset, token_len,
+                  _bytePosition - _tokenLength + offset,
+                  _bytePosition - _tokenLength + offset + extent );
 
       offset += (extent + lengths[i]); // Include current character
       extent = 0;
@@ -3991,9 +4170,9 @@ void indri::parse::TextTokenizer::processUTF8Token() {
 
   // Write out last token
   if ( token_len > 0 )
-    writeToken( toktext + offset, token_len,
-                byte_position - tokleng + offset,
-                byte_position - tokleng + offset + extent );
+    writeToken( _token + offset, token_len,
+                _bytePosition - _tokenLength + offset,
+                _bytePosition - _tokenLength + offset + extent );
   
   delete[] unicode_chars;
   delete[] offsets;
@@ -4002,14 +4181,14 @@ void indri::parse::TextTokenizer::processUTF8Token() {
 
 void indri::parse::TextTokenizer::processASCIIToken() {
 
-  int token_len = strlen( toktext );
+  int token_len = strlen( _token );
 
   // token_len here is the length of the token without
   // any trailing punctuation.
 
   for ( int i = token_len - 1; i > 0; i-- ) {
 
-    if ( ! ispunct( toktext[i] ) )
+    if ( ! ispunct( _token[i] ) )
       break;
     else
       token_len--;
@@ -4017,13 +4196,13 @@ void indri::parse::TextTokenizer::processASCIIToken() {
 
   if ( _tokenize_entire_words ) {
 
-    writeToken( toktext, token_len, byte_position - tokleng, byte_position );
+    writeToken( _token, token_len, _bytePosition - _tokenLength, _bytePosition );
 
   } else {
 
     for ( int i = 0; i < token_len; i++ )
-      writeToken( toktext + i, 1, byte_position - tokleng + i, 
-                  byte_position - tokleng + i + 1 );
+      writeToken( _token + i, 1, _bytePosition - _tokenLength + i, 
+                  _bytePosition - _tokenLength + i + 1 );
   }
 }
 
@@ -0,0 +1,178 @@
+/*==========================================================================
+ * Copyright (c) 2005 University of Massachusetts.  All Rights Reserved.
+ *
+ * Use of the Lemur Toolkit for Language Modeling and Information Retrieval
+ * is subject to the terms of the software license set forth in the LICENSE
+ * file included with this software, and also available at
+ * http://www.lemurproject.org/license.html
+ *
+ *==========================================================================
+ */
+
+//
+// ThreadPool
+//
+
+#include "indri/ThreadPool.hpp"
+#include "indri/ScopedLock.hpp"
+#include "indri/delete_range.hpp"
+#include "lemur/Exception.hpp"
+#include <exception>
+
+//
+// batch_type
+//
+// Tracks the tasks of one call to execute().
+//
+
+struct indri::thread::ThreadPool::batch_type {
+  int pending;
+  bool failed;
+  lemur::api::Exception error;
+};
+
+//
+// _start
+//
+
+void indri::thread::ThreadPool::_start( void* pointer ) {
+  ( (indri::thread::ThreadPool*) pointer )->_run();
+}
+
+//
+// ThreadPool
+//
+
+indri::thread::ThreadPool::ThreadPool( int threadCount ) :
+  _quit(false)
+{
+  for( int i=0; i<threadCount; i++ )
+    _threads.push_back( new Thread( _start, this ) );
+}
+
+//
+// ~ThreadPool
+//
+
+indri::thread::ThreadPool::~ThreadPool() {
+  {
+    indri::thread::ScopedLock lock( _lock );
+    _quit = true;
+    _workAvailable.notifyAll();
+  }
+
+  for( size_t i=0; i<_threads.size(); i++ )
+    _threads[i]->join();
+
+  indri::utility::delete_vector_contents<Thread*>( _threads );
+}
+
+//
+// _run
+//
+
+void indri::thread::ThreadPool::_run() {
+  _lock.lock();
+
+  while( true ) {
+    while( !_quit && _queue.empty() )
+      _workAvailable.wait( _lock );
+
+    if( _queue.empty() )
+      break;
+
+    queue_entry entry = _queue.front();
+    _queue.pop_front();
+    _lock.unlock();
+
+    bool failed = false;
+    lemur::api::Exception error;
+
+    try {
+      entry.task->run();
+    } catch( lemur::api::Exception& e ) {
+      failed = true;
+      error = e;
+    } catch( std::exception& e ) {
+      // an exception must not leave a worker thread, or the process ends
+      failed = true;
+      error = lemur::api::Exception( __FILE__, __LINE__, std::string() + "Unexpected exception: " + e.what(), LEMUR_RUNTIME_ERROR );
+    } catch( ... ) {
+      failed = true;
+      error = lemur::api::Exception( __FILE__, __LINE__, "Unexpected exception of unknown type", LEMUR_RUNTIME_ERROR );
+    }
+
+    // posted tasks belong to the pool
+    if( !entry.batch ) {
+      delete entry.task;
+      _lock.lock();
+      continue;
+    }
+
+    _lock.lock();
+
+    if( failed && !entry.batch->failed ) {
+      entry.batch->failed = true;
+      entry.batch->error = error;
+    }
+
+    if( --entry.batch->pending == 0 )
+      _workFinished.notifyAll();
+  }
+
+  _lock.unlock();
+}
+
+//
+// execute
+//
+
+void indri::thread::ThreadPool::execute( const std::vector<Task*>& tasks ) {
+  if( tasks.empty() )
+    return;
+
+  batch_type batch;
+  batch.pending = (int)tasks.size();
+  batch.failed = false;
+
+  indri::thread::ScopedLock lock( _lock );
+
+  for( size_t i=0; i<tasks.size(); i++ ) {
+    queue_entry entry;
+    entry.task = tasks[i];
+    entry.batch = &batch;
+    _queue.push_back( entry );
+  }
+
+  _workAvailable.notifyAll();
+
+  while( batch.pending )
+    _workFinished.wait( _lock );
+
+  lock.unlock();
+
+  if( batch.failed )
+    LEMUR_RETHROW( batch.error, "A thread pool task failed" );
+}
+
+//
+// post
+//
+
+void indri::thread::ThreadPool::post( Task* task ) {
+  queue_entry entry;
+  entry.task = task;
+  entry.batch = 0;
+
+  indri::thread::ScopedLock lock( _lock );
+  _queue.push_back( entry );
+  _workAvailable.notifyOne();
+}
+
+//
+// size
+//
+
+int indri::thread::ThreadPool::size() const {
+  return (int)_threads.size();
+}
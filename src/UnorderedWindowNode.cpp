@@ -74,8 +74,16 @@ void indri::infnet::UnorderedWindowNode::prepare( lemur::api::DOCID_T documentID
   _lastExtent.end = -1;
 
   assert( _children.size() >= 2 );
-  indri::utility::greedy_vector<term_position> allPositions;
-  int termsSeen = 0;
+  indri::utility::greedy_vector<term_position>& allPositions = _allPositions;
+
+  // if one term doesn't appear, then there's no use decoding
+  // the positions of the others
+  for( size_t i=0; i<_children.size(); i++ ) {
+    if( !_children[i]->hasExtents() )
+      return;
+  }
+
+  allPositions.clear();
 
   // sort the children by size if not already sorted
   if (!_childrenAlreadySorted) {
@@ -83,40 +91,81 @@ void indri::infnet::UnorderedWindowNode::prepare( lemur::api::DOCID_T documentID
     _childrenAlreadySorted=true;
   }
 
-  // add every term position from every list
+  // every child must have at least one extent; note whether
+  // each child's extents are in <begin> order, as term positions are
+  bool sorted = true;
+  size_t totalPositions = 0;
+  _childExtents.resize( _children.size() );
+
   for( size_t i=0; i<_children.size(); i++ ) {
     const indri::utility::greedy_vector<indri::index::Extent>& childPositions = _children[i]->extents();
 
-    if( childPositions.size() ) {
-      termsSeen++;
-    } else {
-      // every item must have at least one child!
+    if( childPositions.size() == 0 ) {
       // if we have an extent w/out one, we can
       // exit early
       return;
     }
 
-    for( size_t j=0; j<childPositions.size(); j++ ) {
+    for( size_t j=1; j<childPositions.size() && sorted; j++ ) {
+      if( childPositions[j].begin < childPositions[j-1].begin )
+        sorted = false;
+    }
+
+    _childExtents[i] = &childPositions;
+    totalPositions += childPositions.size();
+  }
+
+  if( sorted ) {
+    // merge the children's positions into <begin> order
+    _mergeCursors.resize( _children.size() );
+    std::fill( _mergeCursors.begin(), _mergeCursors.end(), 0 );
+
+    while( allPositions.size() < totalPositions ) {
+      int next = -1;
+      int nextBegin = 0;
+
+      for( size_t i=0; i<_children.size(); i++ ) {
+        if( _mergeCursors[i] < _childExtents[i]->size() &&
+            (next < 0 || (*_childExtents[i])[_mergeCursors[i]].begin < nextBegin) ) {
+          next = i;
+          nextBegin = (*_childExtents[i])[_mergeCursors[i]].begin;
+        }
+      }
+
+      const indri::index::Extent& extent = (*_childExtents[next])[_mergeCursors[next]++];
       term_position p;
 
-      p.type = i;
-      p.begin = childPositions[j].begin;
-      p.end = childPositions[j].end;
+      p.type = next;
+      p.begin = extent.begin;
+      p.end = extent.end;
       p.last = -1;
-      p.weight = childPositions[j].weight;
+      p.weight = extent.weight;
 
       allPositions.push_back( p );
     }
-  }
+  } else {
+    // add every term position from every list
+    for( size_t i=0; i<_children.size(); i++ ) {
+      const indri::utility::greedy_vector<indri::index::Extent>& childPositions = *_childExtents[i];
+
+      for( size_t j=0; j<childPositions.size(); j++ ) {
+        term_position p;
 
-  // if not all the terms appear in this document,
-  // there's no use looking for a window
-  if( termsSeen != _children.size() )
-    return;
+        p.type = i;
+        p.begin = childPositions[j].begin;
+        p.end = childPositions[j].end;
+        p.last = -1;
+        p.weight = childPositions[j].weight;
+
+        allPositions.push_back( p );
+      }
+    }
+
+    // sort all positions by <begin> index
+    std::sort( allPositions.begin(), allPositions.end() );
+  }
 
-  // sort all positions by <begin> index
-  std::sort( allPositions.begin(), allPositions.end() );
-  indri::utility::greedy_vector<int> lastPositions;
+  indri::utility::greedy_vector<int>& lastPositions = _lastPositions;
   lastPositions.resize(_children.size());
   std::fill( lastPositions.begin(), lastPositions.end(), -1 );
 
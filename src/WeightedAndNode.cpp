@@ -47,6 +47,60 @@ double indri::infnet::WeightedAndNode::_computeMaxScore( unsigned int start ) {
   return maxScoreSum + minScoreSum;
 }
 
+//
+// _computeBlockMaxScore
+//
+// Sums the block-level score bounds of the children at documentID.  Children
+// without block bounds contribute their list-wide maximum.  lastDocument is set
+// to the last document the returned bound holds for.
+//
+
+double indri::infnet::WeightedAndNode::_computeBlockMaxScore( lemur::api::DOCID_T documentID, lemur::api::DOCID_T& lastDocument ) {
+  double maxScoreSum = 0;
+  lastDocument = MAX_INT32;
+
+  for( size_t i=0; i<_children.size(); i++ ) {
+    if( _children[i].termNode ) {
+      lemur::api::DOCID_T childLast;
+      maxScoreSum += _children[i].weight * _children[i].termNode->blockMaximumScore( documentID, childLast );
+      lastDocument = lemur_compat::min( lastDocument, childLast );
+    } else {
+      maxScoreSum += _children[i].maximumWeightedScore;
+    }
+  }
+
+  return maxScoreSum;
+}
+
+//
+// _skipBlocks
+//
+// Block-max WAND: while the block bounds at the candidate can't reach the
+// threshold, skip past the end of the shortest block in play.  The returned
+// document may not match any child; the network moves the lists there with
+// nextEntry(), which uses the skip tables instead of reading the blocks.
+//
+
+lemur::api::DOCID_T indri::infnet::WeightedAndNode::_skipBlocks( lemur::api::DOCID_T candidate ) {
+  // leave a little room for rounding differences against score()
+  const double slack = 1e-9;
+
+  while( candidate != MAX_INT32 ) {
+    lemur::api::DOCID_T lastDocument;
+    double bound = _computeBlockMaxScore( candidate, lastDocument );
+
+    if( bound + fabs(bound) * slack >= _threshold )
+      break;
+
+    if( lastDocument == MAX_INT32 )
+      return MAX_INT32;
+
+    candidate = lastDocument + 1;
+  }
+
+  return candidate;
+}
+
 void indri::infnet::WeightedAndNode::setSiblingsFlag(int f){
   // set flag for child nodes
   for(int i=0;i<_children.size();i++) {
@@ -77,7 +131,10 @@ void indri::infnet::WeightedAndNode::addChild( double weight, BeliefNode* node )
   child_type child;
 
   child.node = node;
+  child.termNode = dynamic_cast<indri::infnet::TermFrequencyBeliefNode*>(node);
   child.weight = weight;
+  child.lengthOffset = 0;
+  child.splitsLength = child.termNode && child.termNode->scoreFunction().splitsLength( child.lengthOffset );
   child.backgroundWeightedScore = node->maximumBackgroundScore() * weight;
   child.maximumWeightedScore = node->maximumScore() * weight;
 
@@ -181,6 +238,14 @@ void indri::infnet::WeightedAndNode::indexChanged( indri::index::Index& index )
   for( size_t i=0; i<lists.size(); i++ )
     delete lists[i];
 
+  // block bounds are only safe to sum when every weight is positive
+  _blockMax = indri::api::Parameters::instance().get( "blockMax", true );
+
+  for( size_t i=0; i<_children.size(); i++ ) {
+    if( _children[i].weight < 0 )
+      _blockMax = false;
+  }
+
   // compute quorum
   _computeQuorum();
 }
@@ -211,6 +276,9 @@ lemur::api::DOCID_T indri::infnet::WeightedAndNode::nextCandidateDocument() {
     }
   }
 
+  if( _blockMax && _threshold > -DBL_MAX )
+    minDocument = _skipBlocks( minDocument );
+
   return minDocument;
 }
 
@@ -245,22 +313,83 @@ double indri::infnet::WeightedAndNode::maximumScore() {
   return maximum;
 }
 
+//
+// termChildren
+//
+
+bool indri::infnet::WeightedAndNode::termChildren( std::vector<indri::infnet::TermFrequencyBeliefNode*>& terms, std::vector<double>& weights ) {
+  double sumWeight = 0;
+
+  terms.clear();
+  weights.clear();
+
+  for( size_t i=0; i<_children.size(); i++ ) {
+    if( !_children[i].splitsLength )
+      return false;
+
+    sumWeight += fabs(_children[i].weight);
+  }
+
+  for( size_t i=0; i<_children.size(); i++ ) {
+    terms.push_back( _children[i].termNode );
+    weights.push_back( _children[i].weight / sumWeight );
+  }
+
+  return _children.size() > 0;
+}
+
+//
+// score
+//
+// Term children whose score functions split off the document length are
+// scored here directly: they always return one result for the whole
+// document, and children that share a length offset share one log of
+// the document length.
+//
+
 indri::utility::greedy_vector<indri::api::ScoredExtentResult>& indri::infnet::WeightedAndNode::score( lemur::api::DOCID_T documentID, indri::index::Extent &extent, int documentLength ) {
   std::vector<child_type>::iterator iter;
   double score = 0;
   double sumWeight = 0;
   bool scored = false;
-  indri::utility::greedy_vector< indri::utility::greedy_vector<indri::api::ScoredExtentResult> > scores;
+  double lengthOffset = 0;
+  double lengthScore = 0;
+  bool haveLengthScore = false;
+
+  _termScores.resize( _children.size() );
+  _childScores.clear();
+
   for( iter = _children.begin(); iter != _children.end(); iter++ ) {
+    if( (*iter).splitsLength ) {
+      if( !haveLengthScore || lengthOffset != (*iter).lengthOffset ) {
+        lengthOffset = (*iter).lengthOffset;
+        lengthScore = log( double(documentLength) + lengthOffset );
+        haveLengthScore = true;
+      }
+
+      int count = (*iter).termNode->count( documentID );
+      _termScores[ iter - _children.begin() ] = (*iter).termNode->scoreFunction().occurrenceScore( count ) - lengthScore;
+      sumWeight += fabs((*iter).weight);
+      continue;
+    }
+
     const indri::utility::greedy_vector<indri::api::ScoredExtentResult>& childResults = (*iter).node->score( documentID, extent, documentLength );
-    scores.push_back(childResults);
+    _childScores.push_back(childResults);
     // normalize over absolute values
     sumWeight += fabs((*iter).weight) * childResults.size();
   }
   int i = 0;
   for( iter = _children.begin(); iter != _children.end(); iter++ ) {
     double childScore = 0;
-    indri::utility::greedy_vector<indri::api::ScoredExtentResult>& childResults = scores[i];
+
+    if( (*iter).splitsLength ) {
+      scored = true;
+      childScore += (*iter).weight * _termScores[ iter - _children.begin() ]/sumWeight;
+      score += childScore;
+      continue;
+    }
+
+    indri::utility::greedy_vector<indri::api::ScoredExtentResult>& childResults = _childScores[i];
     for( size_t j=0; j<childResults.size(); j++ ) {
       scored = true;
       childScore += (*iter).weight * childResults[j].score/sumWeight;
@@ -15,6 +15,9 @@
   jfieldID resultsRequestedField = jenv->GetFieldID(qrClazz, "resultsRequested", "I");
   jfieldID startNumField = jenv->GetFieldID(qrClazz, "startNum", "I");
   jfieldID optionsField = jenv->GetFieldID(qrClazz, "options", "I");
+  jfieldID budgetPostingsField = jenv->GetFieldID(qrClazz, "budgetPostings", "J");
+  jfieldID budgetDocumentsField = jenv->GetFieldID(qrClazz, "budgetDocuments", "J");
+  jfieldID budgetMillisecondsField = jenv->GetFieldID(qrClazz, "budgetMilliseconds", "J");
 
   jstring query = (jstring) jenv->GetObjectField($input, queryField);
 
@@ -24,6 +27,9 @@
   jint resultsRequested = jenv->GetIntField($input, resultsRequestedField);
   jint startNum = jenv->GetIntField($input, startNumField);
   jint options = jenv->GetIntField($input, optionsField);
+  jlong budgetPostings = jenv->GetLongField($input, budgetPostingsField);
+  jlong budgetDocuments = jenv->GetLongField($input, budgetDocumentsField);
+  jlong budgetMilliseconds = jenv->GetLongField($input, budgetMillisecondsField);
 
   // fill in the values
   const char *queryString = jenv->GetStringUTFChars(query, 0);
@@ -48,6 +54,9 @@
   req.resultsRequested = resultsRequested;
   req.startNum = startNum;
   req.options = (indri::api::QueryRequest::Options) options;
+  req.budget.postings = budgetPostings;
+  req.budget.documents = budgetDocuments;
+  req.budget.milliseconds = budgetMilliseconds;
 }
 
 %typemap(javain) indri::api::QueryRequest & "$javainput";
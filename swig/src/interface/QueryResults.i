@@ -12,15 +12,29 @@
       jmethodID constructor = jenv->GetMethodID(clazz, "<init>", "()V" );
       jfieldID parseTimeField = jenv->GetFieldID(clazz, "parseTime", "D" );
       jfieldID executeTimeField = jenv->GetFieldID(clazz, "executeTime", "D" );
+      jfieldID statisticsTimeField = jenv->GetFieldID(clazz, "statisticsTime", "D" );
+      jfieldID scoreTimeField = jenv->GetFieldID(clazz, "scoreTime", "D" );
+      jfieldID annotateTimeField = jenv->GetFieldID(clazz, "annotateTime", "D" );
       jfieldID documentsTimeField = jenv->GetFieldID(clazz, "documentsTime", "D" );
       jfieldID estMatchesField = jenv->GetFieldID(clazz, "estimatedMatches", "I" );
+      jfieldID workPostingsField = jenv->GetFieldID(clazz, "workPostings", "J" );
+      jfieldID workDocumentsField = jenv->GetFieldID(clazz, "workDocuments", "J" );
+      jfieldID workMillisecondsField = jenv->GetFieldID(clazz, "workMilliseconds", "J" );
+      jfieldID partialField = jenv->GetFieldID(clazz, "partial", "Z" );
       jfieldID resultsField = jenv->GetFieldID(clazz, "results", "[Llemurproject/indri/QueryResult;" );
 
       result = jenv->NewObject(clazz, constructor);
       jenv->SetDoubleField(result, parseTimeField, results.parseTime );
       jenv->SetDoubleField(result, executeTimeField, results.executeTime );
+      jenv->SetDoubleField(result, statisticsTimeField, results.statisticsTime );
+      jenv->SetDoubleField(result, scoreTimeField, results.scoreTime );
+      jenv->SetDoubleField(result, annotateTimeField, results.annotateTime );
       jenv->SetDoubleField(result, documentsTimeField, results.documentsTime );
       jenv->SetIntField(result, estMatchesField, results.estimatedMatches );
+      jenv->SetLongField(result, workPostingsField, results.work.postings );
+      jenv->SetLongField(result, workDocumentsField, results.work.documents );
+      jenv->SetLongField(result, workMillisecondsField, results.work.milliseconds );
+      jenv->SetBooleanField(result, partialField, results.work.partial );
 
       jclass qrClazz = jenv->FindClass("lemurproject/indri/QueryResult");
       jmethodID qrConstructor = jenv->GetMethodID(qrClazz, "<init>", "()V" );
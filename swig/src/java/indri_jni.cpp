@@ -1063,15 +1063,29 @@ SWIGINTERN void SWIG_JavaException(JNIEnv *jenv, int code, const char *msg) {
       jmethodID constructor = jenv->GetMethodID(clazz, "<init>", "()V" );
       jfieldID parseTimeField = jenv->GetFieldID(clazz, "parseTime", "D" );
       jfieldID executeTimeField = jenv->GetFieldID(clazz, "executeTime", "D" );
+      jfieldID statisticsTimeField = jenv->GetFieldID(clazz, "statisticsTime", "D" );
+      jfieldID scoreTimeField = jenv->GetFieldID(clazz, "scoreTime", "D" );
+      jfieldID annotateTimeField = jenv->GetFieldID(clazz, "annotateTime", "D" );
       jfieldID documentsTimeField = jenv->GetFieldID(clazz, "documentsTime", "D" );
       jfieldID estMatchesField = jenv->GetFieldID(clazz, "estimatedMatches", "I" );
+      jfieldID workPostingsField = jenv->GetFieldID(clazz, "workPostings", "J" );
+      jfieldID workDocumentsField = jenv->GetFieldID(clazz, "workDocuments", "J" );
+      jfieldID workMillisecondsField = jenv->GetFieldID(clazz, "workMilliseconds", "J" );
+      jfieldID partialField = jenv->GetFieldID(clazz, "partial", "Z" );
       jfieldID resultsField = jenv->GetFieldID(clazz, "results", "[Llemurproject/indri/QueryResult;" );
 
       result = jenv->NewObject(clazz, constructor);
       jenv->SetDoubleField(result, parseTimeField, results.parseTime );
       jenv->SetDoubleField(result, executeTimeField, results.executeTime );
+      jenv->SetDoubleField(result, statisticsTimeField, results.statisticsTime );
+      jenv->SetDoubleField(result, scoreTimeField, results.scoreTime );
+      jenv->SetDoubleField(result, annotateTimeField, results.annotateTime );
       jenv->SetDoubleField(result, documentsTimeField, results.documentsTime );
       jenv->SetIntField(result, estMatchesField, results.estimatedMatches );
+      jenv->SetLongField(result, workPostingsField, results.work.postings );
+      jenv->SetLongField(result, workDocumentsField, results.work.documents );
+      jenv->SetLongField(result, workMillisecondsField, results.work.milliseconds );
+      jenv->SetBooleanField(result, partialField, results.work.partial );
 
       jclass qrClazz = jenv->FindClass("lemurproject/indri/QueryResult");
       jmethodID qrConstructor = jenv->GetMethodID(qrClazz, "<init>", "()V" );
@@ -1902,6 +1916,9 @@ SWIGEXPORT jobject JNICALL Java_lemurproject_indri_indriJNI_QueryEnvironment_1ru
     jfieldID resultsRequestedField = jenv->GetFieldID(qrClazz, "resultsRequested", "I");
     jfieldID startNumField = jenv->GetFieldID(qrClazz, "startNum", "I");
     jfieldID optionsField = jenv->GetFieldID(qrClazz, "options", "I");
+    jfieldID budgetPostingsField = jenv->GetFieldID(qrClazz, "budgetPostings", "J");
+    jfieldID budgetDocumentsField = jenv->GetFieldID(qrClazz, "budgetDocuments", "J");
+    jfieldID budgetMillisecondsField = jenv->GetFieldID(qrClazz, "budgetMilliseconds", "J");
     
     jstring query = (jstring) jenv->GetObjectField(jarg2, queryField);
     
@@ -1911,6 +1928,9 @@ SWIGEXPORT jobject JNICALL Java_lemurproject_indri_indriJNI_QueryEnvironment_1ru
     jint resultsRequested = jenv->GetIntField(jarg2, resultsRequestedField);
     jint startNum = jenv->GetIntField(jarg2, startNumField);
     jint options = jenv->GetIntField(jarg2, optionsField);
+    jlong budgetPostings = jenv->GetLongField(jarg2, budgetPostingsField);
+    jlong budgetDocuments = jenv->GetLongField(jarg2, budgetDocumentsField);
+    jlong budgetMilliseconds = jenv->GetLongField(jarg2, budgetMillisecondsField);
     
     // fill in the values
     const char *queryString = jenv->GetStringUTFChars(query, 0);
@@ -1935,6 +1955,9 @@ SWIGEXPORT jobject JNICALL Java_lemurproject_indri_indriJNI_QueryEnvironment_1ru
     req2.resultsRequested = resultsRequested;
     req2.startNum = startNum;
     req2.options = (indri::api::QueryRequest::Options) options;
+    req2.budget.postings = budgetPostings;
+    req2.budget.documents = budgetDocuments;
+    req2.budget.milliseconds = budgetMilliseconds;
   }
   {
     try {
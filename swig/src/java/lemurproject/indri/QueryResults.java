@@ -3,7 +3,14 @@ package lemurproject.indri;
 public class QueryResults {
     public double parseTime;
     public double executeTime;
+    public double statisticsTime;
+    public double scoreTime;
+    public double annotateTime;
     public double documentsTime;
     public int estimatedMatches;
+    public long workPostings;
+    public long workDocuments;
+    public long workMilliseconds;
+    public boolean partial;
     public QueryResult[] results;
 }